@@ -15,6 +15,7 @@
 
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/keys.h>
+#include <xmlsec/keysmngr.h>
 #include <xmlsec/transforms.h>
 #include <xmlsec/errors.h>
 
@@ -79,6 +80,26 @@ xmlSecAppCryptoSimpleKeysMngrLoad(xmlSecKeysMngrPtr mngr, const char *filename)
     return(xmlSecCryptoAppDefaultKeysMngrLoad(mngr, filename));
 }
 
+int
+xmlSecAppCryptoSimpleKeysMngrReload(xmlSecKeysMngrPtr mngr, const char *filename) {
+    xmlSecKeyStorePtr store;
+
+    xmlSecAssert2(mngr != NULL, -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    store = xmlSecKeysMngrGetKeysStore(mngr);
+    if(!xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeysMngrGetKeysStore",
+                    XMLSEC_ERRORS_R_INVALID_TYPE,
+                    "keys can only be reloaded in the simple keys store");
+        return(-1);
+    }
+
+    return(xmlSecSimpleKeysStoreReload(store, filename, mngr));
+}
+
 int 
 xmlSecAppCryptoSimpleKeysMngrSave(xmlSecKeysMngrPtr mngr, const char *filename, xmlSecKeyDataType type) {
     xmlSecAssert2(mngr != NULL, -1);
@@ -87,6 +108,67 @@ xmlSecAppCryptoSimpleKeysMngrSave(xmlSecKeysMngrPtr mngr, const char *filename,
     return(xmlSecCryptoAppDefaultKeysMngrSave(mngr, filename, type));
 }
 
+int
+xmlSecAppCryptoSimpleKeysMngrSaveBinary(xmlSecKeysMngrPtr mngr, const char *filename, xmlSecKeyDataType type) {
+    xmlSecKeyStorePtr store;
+
+    xmlSecAssert2(mngr != NULL, -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    store = xmlSecKeysMngrGetKeysStore(mngr);
+    if(!xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeysMngrGetKeysStore",
+                    XMLSEC_ERRORS_R_INVALID_TYPE,
+                    "binary keys file can only be created from the simple keys store");
+        return(-1);
+    }
+
+    return(xmlSecBinaryKeysStoreSaveKeys(xmlSecSimpleKeysStoreGetKeys(store), filename, type, mngr));
+}
+
+int
+xmlSecAppCryptoKeysMngrBinaryKeysLoad(xmlSecKeysMngrPtr mngr, const char *filename) {
+    xmlSecKeyStorePtr store;
+
+    xmlSecAssert2(mngr != NULL, -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    store = xmlSecKeyStoreCreate(xmlSecBinaryKeysStoreId);
+    if(store == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeyStoreCreate",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "xmlSecBinaryKeysStoreId");
+        return(-1);
+    }
+
+    if(xmlSecBinaryKeysStoreLoad(store, filename) < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecBinaryKeysStoreLoad",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "filename=%s",
+                    xmlSecErrorsSafeString(filename));
+        xmlSecKeyStoreDestroy(store);
+        return(-1);
+    }
+
+    /* the binary keys store replaces the simple keys store */
+    if(xmlSecKeysMngrAdoptKeysStore(mngr, store) < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeysMngrAdoptKeysStore",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecKeyStoreDestroy(store);
+        return(-1);
+    }
+    return(0);
+}
+
 int 
 xmlSecAppCryptoSimpleKeysMngrCertLoad(xmlSecKeysMngrPtr mngr, const char *filename, 
                                       xmlSecKeyDataFormat format, xmlSecKeyDataType type) {
@@ -100,6 +182,19 @@ xmlSecAppCryptoSimpleKeysMngrCertLoad(xmlSecKeysMngrPtr mngr, const char *filena
 #endif /* XMLSEC_NO_X509 */    
 }
 
+int
+xmlSecAppCryptoSimpleKeysMngrCrlLoad(xmlSecKeysMngrPtr mngr, const char *filename,
+                                     xmlSecKeyDataFormat format) {
+    xmlSecAssert2(mngr != NULL, -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+#ifndef XMLSEC_NO_X509
+    return(xmlSecCryptoAppKeysMngrCrlLoad(mngr, filename, format));
+#else /* XMLSEC_NO_X509 */
+    return(-1);
+#endif /* XMLSEC_NO_X509 */
+}
+
 int 
 xmlSecAppCryptoSimpleKeysMngrKeyAndCertsLoad(xmlSecKeysMngrPtr mngr, 
                                              const char* files, const char* pwd, 
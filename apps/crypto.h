@@ -35,13 +35,23 @@ xmlSecKeyPtr xmlSecAppCryptoKeyGenerate                         (const char* key
 int     xmlSecAppCryptoSimpleKeysMngrInit                       (xmlSecKeysMngrPtr mngr);
 int     xmlSecAppCryptoSimpleKeysMngrLoad                       (xmlSecKeysMngrPtr mngr, 
                                                                  const char *filename);
+int     xmlSecAppCryptoSimpleKeysMngrReload                     (xmlSecKeysMngrPtr mngr,
+                                                                 const char *filename);
 int     xmlSecAppCryptoSimpleKeysMngrSave                       (xmlSecKeysMngrPtr mngr, 
                                                                  const char *filename,
                                                                  xmlSecKeyDataType type);
+int     xmlSecAppCryptoSimpleKeysMngrSaveBinary                 (xmlSecKeysMngrPtr mngr,
+                                                                 const char *filename,
+                                                                 xmlSecKeyDataType type);
+int     xmlSecAppCryptoKeysMngrBinaryKeysLoad                   (xmlSecKeysMngrPtr mngr,
+                                                                 const char *filename);
 int     xmlSecAppCryptoSimpleKeysMngrCertLoad                   (xmlSecKeysMngrPtr mngr, 
                                                                  const char *filename, 
                                                                  xmlSecKeyDataFormat format,
                                                                  xmlSecKeyDataType type);
+int     xmlSecAppCryptoSimpleKeysMngrCrlLoad                    (xmlSecKeysMngrPtr mngr,
+                                                                 const char *filename,
+                                                                 xmlSecKeyDataFormat format);
 int     xmlSecAppCryptoSimpleKeysMngrKeyAndCertsLoad            (xmlSecKeysMngrPtr mngr, 
                                                                  const char *files, 
                                                                  const char* pwd, 
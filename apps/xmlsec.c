@@ -16,6 +16,7 @@
 #include <libxml/tree.h>
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
+#include <libxml/xmlIO.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 
@@ -82,7 +83,8 @@ static const char helpVersion[] =
 
 static const char helpKeys[] =     
     "Usage: xmlsec keys [<options>] <file>\n"
-    "Creates a new XML keys file <file>\n";
+    "Creates a new XML keys file <file> (or a binary keys file\n"
+    "if --binary-keys option is specified)\n";
     
 static const char helpSign[] =     
     "Usage: xmlsec sign [<options>] <file>\n"
@@ -233,6 +235,30 @@ static xmlSecAppCmdLineParam genKeyParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam binaryKeysParam = { 
+    xmlSecAppCmdLineTopicKeysMngr,
+    "--binary-keys",
+    NULL,
+    "--binary-keys"
+    "\n\tsave keys in the binary memory mapped keys file format"
+    "\n\t(\"keys\" command only)",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam binaryKeysFileParam = { 
+    xmlSecAppCmdLineTopicKeysMngr,
+    "--binary-keys-file",
+    NULL,
+    "--binary-keys-file <file>"
+    "\n\tload keys from binary keys <file> created with \"--binary-keys\""
+    "\n\toption (the other keys can not be loaded in this case)",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam keysFileParam = { 
     xmlSecAppCmdLineTopicKeysMngr,
     "--keys-file",
@@ -244,6 +270,31 @@ static xmlSecAppCmdLineParam keysFileParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam reloadKeysFileParam = { 
+    xmlSecAppCmdLineTopicKeysMngr,
+    "--reload-keys-file",
+    NULL,
+    "--reload-keys-file <file>"
+    "\n\treload keys from XML <file> replacing all the keys loaded"
+    "\n\twith \"--keys-file\" and \"--gen-key\" options",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam reloadKeysAfterFirstFileParam = { 
+    xmlSecAppCmdLineTopicKeysMngr,
+    "--reload-keys-after-first-file",
+    NULL,
+    "--reload-keys-after-first-file"
+    "\n\treload keys from \"--reload-keys-file\" only after the first file"
+    "\n\tis processed, replacing all the keys loaded before"
+    "\n\t(useful to check the keys caches invalidation)",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam privkeyParam = { 
     xmlSecAppCmdLineTopicKeysMngr,
     "--privkey-pem",
@@ -391,6 +442,68 @@ static xmlSecAppCmdLineParam enabledRetrievalMethodUrisParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam keyInfoReadAllParam = { 
+    xmlSecAppCmdLineTopicKeysMngr,
+    "--keyinfo-read-all",
+    NULL,
+    "--keyinfo-read-all"
+    "\n\tread all <dsig:KeyInfo> element children even if"
+    "\n\tthe key is already found",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam copyKeysParam = { 
+    xmlSecAppCmdLineTopicKeysMngr,
+    "--copy-keys",
+    NULL,
+    "--copy-keys"
+    "\n\tcopy the keys found for <dsig:KeyName> element instead of"
+    "\n\tsharing them with the keys manager",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam keyInfoCacheParam = { 
+    xmlSecAppCmdLineTopicKeysMngr,
+    "--keyinfo-cache",
+    NULL,
+    "--keyinfo-cache"
+    "\n\tcache the keys resolved from <dsig:KeyInfo> elements"
+    "\n\tfor the next processed files",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam keyInfoCacheTtlParam = { 
+    xmlSecAppCmdLineTopicKeysMngr,
+    "--keyinfo-cache-ttl",
+    NULL,
+    "--keyinfo-cache-ttl <seconds>"
+    "\n\tthe time to live for the keys in the <dsig:KeyInfo> cache"
+    "\n\t(0 means the keys never expire)",
+    xmlSecAppCmdLineParamTypeNumber,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+#ifndef XMLSEC_NO_XMLENC
+static xmlSecAppCmdLineParam encKeyCacheParam = { 
+    xmlSecAppCmdLineTopicKeysMngr,
+    "--enc-key-cache",
+    NULL,
+    "--enc-key-cache"
+    "\n\tcache the keys decrypted from <enc:EncryptedKey> elements"
+    "\n\tfor the next processed files",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+#endif /* XMLSEC_NO_XMLENC */
+
 /****************************************************************
  *
  * Common params
@@ -409,6 +522,20 @@ static xmlSecAppCmdLineParam sessionKeyParam = {
     NULL
 };    
 
+static xmlSecAppCmdLineParam offloadParam = { 
+    xmlSecAppCmdLineTopicDSigSign | xmlSecAppCmdLineTopicDSigVerify | 
+    xmlSecAppCmdLineTopicEncDecrypt,
+    "--offload",
+    NULL,
+    "--offload"
+    "\n\trun the final step of the asymmetric key transforms (sign, verify"
+    "\n\tor private key decrypt) through the offload callback and report"
+    "\n\tthe offloaded transforms",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};    
+
 static xmlSecAppCmdLineParam outputParam = { 
     xmlSecAppCmdLineTopicDSigCommon | 
     xmlSecAppCmdLineTopicEncCommon,
@@ -554,6 +681,32 @@ static xmlSecAppCmdLineParam storeSignaturesParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam preDigestFileParam = { 
+    xmlSecAppCmdLineTopicDSigCommon,
+    "--pre-digest-file",
+    NULL,
+    "--pre-digest-file <file>"
+    "\n\twrite the result of <dsig:Reference/> elements processing just"
+    "\n\tbefore calculating digest to <file> as it is produced instead of"
+    "\n\tstoring it in memory",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam preSignFileParam = { 
+    xmlSecAppCmdLineTopicDSigCommon,
+    "--pre-sign-file",
+    NULL,
+    "--pre-sign-file <file>"
+    "\n\twrite the result of <dsig:SignedInfo/> element processing just"
+    "\n\tbefore calculating signature to <file> as it is produced instead"
+    "\n\tof storing it in memory",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam enabledRefUrisParam = { 
     xmlSecAppCmdLineTopicDSigCommon,
     "--enabled-reference-uris",
@@ -581,6 +734,19 @@ static xmlSecAppCmdLineParam enableVisa3DHackParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam verifyManifestRefParam = { 
+    xmlSecAppCmdLineTopicDSigVerify,
+    "--verify-manifest-reference",
+    NULL,
+    "--verify-manifest-reference <uri>"
+    "\n\tdo not digest the <dsig:Manifest> references while verifying the"
+    "\n\tsignature and verify only the reference with the given URI"
+    "\n\tattribute afterwards (the reference must be valid)",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagMultipleValues,
+    NULL
+};
+
 #endif /* XMLSEC_NO_XMLDSIG */
 
 /****************************************************************
@@ -623,6 +789,32 @@ static xmlSecAppCmdLineParam xmlDataParam = {
     xmlSecAppCmdLineParamFlagNone,
     NULL
 };
+
+static xmlSecAppCmdLineParam allNodesParam = { 
+    xmlSecAppCmdLineTopicEncEncrypt | xmlSecAppCmdLineTopicEncDecrypt,
+    "--all-nodes",
+    NULL,
+    "--all-nodes"
+    "\n\tencrypt all the nodes selected with \"--node-name\" in the XML data"
+    "\n\twith one key or decrypt all the <enc:EncryptedData> nodes"
+    "\n\tin the document",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam streamOutputParam = { 
+    xmlSecAppCmdLineTopicEncEncrypt | xmlSecAppCmdLineTopicEncDecrypt,
+    "--stream-output",
+    NULL,
+    "--stream-output"
+    "\n\twrite the <enc:EncryptedData> element with the data encrypted"
+    "\n\tfrom \"--binary-data\" file or the decrypted data directly"
+    "\n\tto the output (the document is not updated)",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
 #endif /* XMLSEC_NO_XMLENC */
 
 
@@ -709,6 +901,40 @@ static xmlSecAppCmdLineParam untrustedDerParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam crlParam = { 
+    xmlSecAppCmdLineTopicX509Certs,
+    "--crl-pem",
+    "--crl",
+    "--crl-pem <file>"
+    "\n\tload CRL from PEM file <file>",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagMultipleValues,
+    NULL
+};
+
+static xmlSecAppCmdLineParam crlDerParam = { 
+    xmlSecAppCmdLineTopicX509Certs,
+    "--crl-der",
+    NULL,
+    "--crl-der <file>"
+    "\n\tload CRL from DER file <file>",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagMultipleValues,
+    NULL
+};
+
+static xmlSecAppCmdLineParam crlsAfterFirstFileParam = { 
+    xmlSecAppCmdLineTopicX509Certs,
+    "--crls-after-first-file",
+    NULL,
+    "--crls-after-first-file"
+    "\n\tload the CRLs only after the first file is processed"
+    "\n\t(useful to check the keys caches invalidation)",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam verificationTimeParam = { 
     xmlSecAppCmdLineTopicX509Certs,
     "--verification-time",
@@ -750,8 +976,11 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
     &ignoreManifestsParam,
     &storeReferencesParam,
     &storeSignaturesParam,
+    &preDigestFileParam,
+    &preSignFileParam,
     &enabledRefUrisParam,
     &enableVisa3DHackParam,
+    &verifyManifestRefParam,
 #endif /* XMLSEC_NO_XMLDSIG */
 
     /* enc params */
@@ -759,10 +988,13 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
     &binaryDataParam,
     &xmlDataParam,
     &enabledCipherRefUrisParam,
+    &allNodesParam,
+    &streamOutputParam,
 #endif /* XMLSEC_NO_XMLENC */
              
     /* common dsig and enc parameters */
     &sessionKeyParam,    
+    &offloadParam,
     &outputParam,
     &printDebugParam,
     &printXmlDebugParam,    
@@ -775,8 +1007,19 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
     /* Keys Manager params */
     &enabledKeyDataParam,
     &enabledRetrievalMethodUrisParam,
+    &keyInfoReadAllParam,
+    &copyKeysParam,
+    &keyInfoCacheParam,
+    &keyInfoCacheTtlParam,
+#ifndef XMLSEC_NO_XMLENC
+    &encKeyCacheParam,
+#endif /* XMLSEC_NO_XMLENC */
     &genKeyParam,
     &keysFileParam,
+    &reloadKeysFileParam,
+    &reloadKeysAfterFirstFileParam,
+    &binaryKeysParam,
+    &binaryKeysFileParam,
     &privkeyParam,
     &privkeyDerParam,
     &pkcs8PemParam,
@@ -801,6 +1044,9 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
     &untrustedParam,
     &trustedDerParam,
     &untrustedDerParam,
+    &crlParam,
+    &crlDerParam,
+    &crlsAfterFirstFileParam,
     &verificationTimeParam,
     &depthParam,    
     &X509SkipStrictChecksParam,    
@@ -858,21 +1104,35 @@ static void                     xmlSecAppPrintHelp              (xmlSecAppComman
 static int                      xmlSecAppInit                   (void);
 static void                     xmlSecAppShutdown               (void);
 static int                      xmlSecAppLoadKeys               (void);
+static int                      xmlSecAppReloadKeys             (int firstFileDone);
+static int                      xmlSecAppLoadCrls               (int firstFileDone);
 static int                      xmlSecAppPrepareKeyInfoReadCtx  (xmlSecKeyInfoCtxPtr ctx);
 
 #ifndef XMLSEC_NO_XMLDSIG
 static int                      xmlSecAppSignFile               (const char* filename);
 static int                      xmlSecAppVerifyFile             (const char* filename);
+static int                      xmlSecAppVerifyManifestReferences(xmlSecDSigCtxPtr dsigCtx);
 #ifndef XMLSEC_NO_TMPL_TEST
 static int                      xmlSecAppSignTmpl               (void);
 #endif /* XMLSEC_NO_TMPL_TEST */
 static int                      xmlSecAppPrepareDSigCtx         (xmlSecDSigCtxPtr dsigCtx);
+static int                      xmlSecAppPreDigestCallback      (xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize);
+static int                      xmlSecAppPreSignCallback        (xmlSecDSigCtxPtr dsigCtx,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize);
 static void                     xmlSecAppPrintDSigCtx           (xmlSecDSigCtxPtr dsigCtx);
 #endif /* XMLSEC_NO_XMLDSIG */
 
 #ifndef XMLSEC_NO_XMLENC
 static int                      xmlSecAppEncryptFile            (const char* filename);
 static int                      xmlSecAppDecryptFile            (const char* filename);
+static int                      xmlSecAppEncryptAllNodes        (xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 xmlDocPtr doc);
+static int                      xmlSecAppDecryptAllNodes        (xmlSecEncCtxPtr encCtx,
+                                                                 xmlDocPtr doc);
 #ifndef XMLSEC_NO_TMPL_TEST
 static int                      xmlSecAppEncryptTmpl            (void);
 #endif /* XMLSEC_NO_TMPL_TEST */
@@ -890,6 +1150,13 @@ static FILE*                    xmlSecAppOpenFile               (const char* fil
 static void                     xmlSecAppCloseFile              (FILE* file);
 static int                      xmlSecAppWriteResult            (xmlDocPtr doc,
                                                                  xmlSecBufferPtr buffer);
+static int                      xmlSecAppOffloadCallback        (xmlSecTransformPtr transform,
+                                                                 xmlSecTransformOffloadWorkMethod work,
+                                                                 void* workData,
+                                                                 void* context);
+static int                      xmlSecAppWriteFileCallback      (void* context,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize);
 static int                      xmlSecAppAddIDAttr              (xmlNodePtr cur,
                                                                  const xmlChar* attr,
                                                                  const xmlChar* node,
@@ -898,6 +1165,8 @@ static int                      xmlSecAppAddIDAttr              (xmlNodePtr cur,
 xmlSecKeysMngrPtr gKeysMngr = NULL;
 int repeats = 1;
 int print_debug = 0;
+FILE* pre_digest_file = NULL;
+FILE* pre_sign_file = NULL;
 clock_t total_time = 0;
 const char* xmlsec_crypto = NULL;
 const char* tmp = NULL;
@@ -1026,7 +1295,12 @@ int main(int argc, const char **argv) {
             break;          
         case xmlSecAppCommandKeys:
             for(i = pos; i < argc; ++i) {
-                if(xmlSecAppCryptoSimpleKeysMngrSave(gKeysMngr, argv[i], xmlSecKeyDataTypeAny) < 0) {
+                if(xmlSecAppCmdLineParamIsSet(&binaryKeysParam)) {
+                    if(xmlSecAppCryptoSimpleKeysMngrSaveBinary(gKeysMngr, argv[i], xmlSecKeyDataTypeAny) < 0) {
+                        fprintf(stderr, "Error: failed to save keys to binary file \"%s\"\n", argv[i]);
+                        goto fail;
+                    }
+                } else if(xmlSecAppCryptoSimpleKeysMngrSave(gKeysMngr, argv[i], xmlSecKeyDataTypeAny) < 0) {
                     fprintf(stderr, "Error: failed to save keys to file \"%s\"\n", argv[i]);
                     goto fail;
                 }
@@ -1047,6 +1321,12 @@ int main(int argc, const char **argv) {
                     fprintf(stderr, "Error: failed to verify file \"%s\"\n", argv[i]);
                     goto fail;
                 }
+                if(xmlSecAppLoadCrls(1) < 0) {
+                    goto fail;
+                }
+                if(xmlSecAppReloadKeys(1) < 0) {
+                    goto fail;
+                }
             }
             break;
 #ifndef XMLSEC_NO_TMPL_TEST
@@ -1074,6 +1354,12 @@ int main(int argc, const char **argv) {
                     fprintf(stderr, "Error: failed to decrypt file \"%s\"\n", argv[i]);
                     goto fail;
                 }
+                if(xmlSecAppLoadCrls(1) < 0) {
+                    goto fail;
+                }
+                if(xmlSecAppReloadKeys(1) < 0) {
+                    goto fail;
+                }
             }
             break;
 #ifndef XMLSEC_NO_TMPL_TEST
@@ -1105,6 +1391,14 @@ int main(int argc, const char **argv) {
 success:
     res = 0;
 fail:
+    if(pre_digest_file != NULL) {
+        xmlSecAppCloseFile(pre_digest_file);
+        pre_digest_file = NULL;
+    }
+    if(pre_sign_file != NULL) {
+        xmlSecAppCloseFile(pre_sign_file);
+        pre_sign_file = NULL;
+    }
     if(gKeysMngr != NULL) {
         xmlSecKeysMngrDestroy(gKeysMngr);
         gKeysMngr = NULL;
@@ -1212,6 +1506,10 @@ xmlSecAppVerifyFile(const char* filename) {
         fprintf(stderr,"Error: signature failed \n");
         goto done;
     }
+    if(xmlSecAppVerifyManifestReferences(&dsigCtx) < 0) {
+        fprintf(stderr,"Error: manifest references verification failed \n");
+        goto done;
+    }
     total_time += clock() - start_time;    
 
     if((repeats <= 1) && (dsigCtx.status != xmlSecDSigStatusSucceeded)){ 
@@ -1283,6 +1581,42 @@ done:
     return(res);
 }
 
+static int
+xmlSecAppVerifyManifestReferences(xmlSecDSigCtxPtr dsigCtx) {
+    xmlSecAppCmdLineValuePtr value;
+    xmlSecDSigStatus status, status2;
+    int ret, ret2;
+
+    for(value = verifyManifestRefParam.value; value != NULL; value = value->next) {
+        if(value->strValue == NULL) {
+            fprintf(stderr, "Error: invalid value for option \"%s\".\n",
+                    verifyManifestRefParam.fullName);
+            return(-1);
+        }
+
+        /* the second call returns the cached result and must agree with the first one */
+        status = status2 = xmlSecDSigStatusUnknown;
+        ret = xmlSecDSigCtxVerifyManifestReferenceByUri(dsigCtx, BAD_CAST value->strValue, &status);
+        ret2 = xmlSecDSigCtxVerifyManifestReferenceByUri(dsigCtx, BAD_CAST value->strValue, &status2);
+        if(((ret < 0) != (ret2 < 0)) || ((ret >= 0) && (status != status2))) {
+            fprintf(stderr, "Error: inconsistent results for manifest reference \"%s\"\n",
+                    value->strValue);
+            return(-1);
+        }
+        if(ret < 0) {
+            fprintf(stderr, "Error: failed to verify manifest reference \"%s\"\n",
+                    value->strValue);
+            return(-1);
+        }
+        fprintf(stderr, "Manifest Reference \"%s\": %s\n", value->strValue,
+                (status == xmlSecDSigStatusSucceeded) ? "OK" : "FAIL");
+        if(status != xmlSecDSigStatusSucceeded) {
+            return(-1);
+        }
+    }
+    return(0);
+}
+
 #ifndef XMLSEC_NO_TMPL_TEST
 static int 
 xmlSecAppSignTmpl(void) {
@@ -1414,6 +1748,13 @@ xmlSecAppPrepareDSigCtx(xmlSecDSigCtxPtr dsigCtx) {
         return(-1);
     }
 
+    if(xmlSecAppCmdLineParamIsSet(&offloadParam)) {
+        if(xmlSecTransformCtxSetOffloadCallback(&(dsigCtx->transformCtx), xmlSecAppOffloadCallback, NULL) < 0) {
+            fprintf(stderr, "Error: failed to set the offload callback\n");
+            return(-1);
+        }
+    }
+
     if(xmlSecAppCmdLineParamGetString(&sessionKeyParam) != NULL) {
         dsigCtx->signKey = xmlSecAppCryptoKeyGenerate(xmlSecAppCmdLineParamGetString(&sessionKeyParam),
                                 NULL, xmlSecKeyDataTypeSession);
@@ -1437,9 +1778,40 @@ xmlSecAppPrepareDSigCtx(xmlSecDSigCtxPtr dsigCtx) {
         dsigCtx->flags |= XMLSEC_DSIG_FLAGS_STORE_SIGNATURE; 
         print_debug = 1;
     }
+    if(xmlSecAppCmdLineParamGetString(&preDigestFileParam) != NULL) {
+        /* all the files processed write to the same output */
+        if(pre_digest_file == NULL) {
+            pre_digest_file = xmlSecAppOpenFile(xmlSecAppCmdLineParamGetString(&preDigestFileParam));
+            if(pre_digest_file == NULL) {
+                return(-1);
+            }
+        }
+        if(xmlSecDSigCtxSetPreDigestCallback(dsigCtx, xmlSecAppPreDigestCallback) < 0) {
+            fprintf(stderr, "Error: failed to set the pre-digest callback\n");
+            return(-1);
+        }
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_STORE_SIGNEDINFO_REFERENCES |
+                          XMLSEC_DSIG_FLAGS_STORE_MANIFEST_REFERENCES; 
+    }
+    if(xmlSecAppCmdLineParamGetString(&preSignFileParam) != NULL) {
+        if(pre_sign_file == NULL) {
+            pre_sign_file = xmlSecAppOpenFile(xmlSecAppCmdLineParamGetString(&preSignFileParam));
+            if(pre_sign_file == NULL) {
+                return(-1);
+            }
+        }
+        if(xmlSecDSigCtxSetPreSignCallback(dsigCtx, xmlSecAppPreSignCallback) < 0) {
+            fprintf(stderr, "Error: failed to set the pre-sign callback\n");
+            return(-1);
+        }
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_STORE_SIGNATURE; 
+    }
     if(xmlSecAppCmdLineParamIsSet(&enableVisa3DHackParam)) {
         dsigCtx->flags |= XMLSEC_DSIG_FLAGS_USE_VISA3D_HACK; 
     }
+    if(xmlSecAppCmdLineParamIsSet(&verifyManifestRefParam)) {
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_LAZY_MANIFESTS; 
+    }
     
     if(xmlSecAppCmdLineParamGetStringList(&enabledRefUrisParam) != NULL) {
         dsigCtx->enabledReferenceUris = xmlSecAppGetUriType(
@@ -1454,6 +1826,22 @@ xmlSecAppPrepareDSigCtx(xmlSecDSigCtxPtr dsigCtx) {
     return(0);
 }
 
+static int
+xmlSecAppPreDigestCallback(xmlSecDSigReferenceCtxPtr dsigRefCtx, const xmlSecByte* data, xmlSecSize dataSize) {
+    if(dsigRefCtx == NULL) {
+        return(-1);
+    }
+    return(xmlSecAppWriteFileCallback(pre_digest_file, data, dataSize));
+}
+
+static int
+xmlSecAppPreSignCallback(xmlSecDSigCtxPtr dsigCtx, const xmlSecByte* data, xmlSecSize dataSize) {
+    if(dsigCtx == NULL) {
+        return(-1);
+    }
+    return(xmlSecAppWriteFileCallback(pre_sign_file, data, dataSize));
+}
+
 static void
 xmlSecAppPrintDSigCtx(xmlSecDSigCtxPtr dsigCtx) { 
     if(dsigCtx == NULL) {
@@ -1484,6 +1872,7 @@ xmlSecAppEncryptFile(const char* filename) {
     xmlDocPtr doc = NULL;
     xmlNodePtr startTmplNode;
     clock_t start_time;
+    int streamed = 0;
     int res = -1;
 
     if(filename == NULL) {
@@ -1513,7 +1902,37 @@ xmlSecAppEncryptFile(const char* filename) {
         goto done;
     }
 
-    if(xmlSecAppCmdLineParamGetString(&binaryDataParam) != NULL) {
+    if((xmlSecAppCmdLineParamGetString(&binaryDataParam) != NULL) && 
+       xmlSecAppCmdLineParamIsSet(&streamOutputParam)) {
+        FILE* f;
+        xmlOutputBufferPtr output;
+
+        f = xmlSecAppOpenFile(xmlSecAppCmdLineParamGetString(&outputParam));
+        if(f == NULL) {
+            goto done;
+        }
+        output = xmlOutputBufferCreateFile(f, NULL);
+        if(output == NULL) {
+            fprintf(stderr, "Error: failed to create output buffer\n");
+            xmlSecAppCloseFile(f);
+            goto done;
+        }
+
+        /* encrypt and write the result */
+        start_time = clock();            
+        if(xmlSecEncCtxUriEncryptToOutput(&encCtx, startTmplNode, BAD_CAST xmlSecAppCmdLineParamGetString(&binaryDataParam), output) < 0) {
+            fprintf(stderr, "Error: failed to encrypt file \"%s\"\n", 
+                    xmlSecAppCmdLineParamGetString(&binaryDataParam));
+            xmlOutputBufferClose(output);
+            xmlSecAppCloseFile(f);
+            goto done;
+        }
+        total_time += clock() - start_time;    
+
+        xmlOutputBufferClose(output);
+        xmlSecAppCloseFile(f);
+        streamed = 1;
+    } else if(xmlSecAppCmdLineParamGetString(&binaryDataParam) != NULL) {
         /* encrypt */
         start_time = clock();            
         if(xmlSecEncCtxUriEncrypt(&encCtx, startTmplNode, BAD_CAST xmlSecAppCmdLineParamGetString(&binaryDataParam)) < 0) {
@@ -1533,7 +1952,13 @@ xmlSecAppEncryptFile(const char* filename) {
 
         /* encrypt */
         start_time = clock();            
-        if(xmlSecEncCtxXmlEncrypt(&encCtx, startTmplNode, data->startNode) < 0) {
+        if(xmlSecAppCmdLineParamIsSet(&allNodesParam)) {
+            if(xmlSecAppEncryptAllNodes(&encCtx, startTmplNode, data->doc) < 0) {
+                fprintf(stderr, "Error: failed to encrypt xml file \"%s\"\n", 
+                        xmlSecAppCmdLineParamGetString(&xmlDataParam));
+                goto done;
+            }
+        } else if(xmlSecEncCtxXmlEncrypt(&encCtx, startTmplNode, data->startNode) < 0) {
             fprintf(stderr, "Error: failed to encrypt xml file \"%s\"\n", 
                     xmlSecAppCmdLineParamGetString(&xmlDataParam));
             goto done;
@@ -1545,7 +1970,7 @@ xmlSecAppEncryptFile(const char* filename) {
     }
     
     /* print out result only once per execution */
-    if(repeats <= 1) {
+    if((repeats <= 1) && (streamed == 0)) {
         if(encCtx.resultReplaced) {
             if(xmlSecAppWriteResult((data != NULL) ? data->doc : doc, NULL) < 0) {
                 goto done;
@@ -1579,6 +2004,7 @@ xmlSecAppDecryptFile(const char* filename) {
     xmlSecAppXmlDataPtr data = NULL;
     xmlSecEncCtx encCtx;
     clock_t start_time;
+    int streamed = 0;
     int res = -1;
 
     if(filename == NULL) {
@@ -1601,15 +2027,49 @@ xmlSecAppDecryptFile(const char* filename) {
         goto done;
     }
 
-    start_time = clock();  
-    if(xmlSecEncCtxDecrypt(&encCtx, data->startNode) < 0) {
-        fprintf(stderr, "Error: failed to decrypt file\n");
-        goto done;
+    if(xmlSecAppCmdLineParamIsSet(&streamOutputParam)) {
+        FILE* f;
+
+        if(xmlSecAppCmdLineParamIsSet(&allNodesParam)) {
+            fprintf(stderr, "Error: \"%s\" option can not be used with \"%s\" option\n",
+                    streamOutputParam.fullName, allNodesParam.fullName);
+            goto done;
+        }
+
+        f = xmlSecAppOpenFile(xmlSecAppCmdLineParamGetString(&outputParam));
+        if(f == NULL) {
+            goto done;
+        }
+
+        /* decrypt and write the result */
+        start_time = clock();  
+        if(xmlSecEncCtxDecryptToCallback(&encCtx, data->startNode, xmlSecAppWriteFileCallback, f) < 0) {
+            fprintf(stderr, "Error: failed to decrypt file\n");
+            xmlSecAppCloseFile(f);
+            goto done;
+        }
+        total_time += clock() - start_time;    
+
+        fflush(f);
+        xmlSecAppCloseFile(f);
+        streamed = 1;
+    } else {
+        start_time = clock();  
+        if(xmlSecEncCtxDecrypt(&encCtx, data->startNode) < 0) {
+            fprintf(stderr, "Error: failed to decrypt file\n");
+            goto done;
+        }
+        if(xmlSecAppCmdLineParamIsSet(&allNodesParam)) {
+            if(xmlSecAppDecryptAllNodes(&encCtx, data->doc) < 0) {
+                fprintf(stderr, "Error: failed to decrypt file\n");
+                goto done;
+            }
+        }
+        total_time += clock() - start_time;    
     }
-    total_time += clock() - start_time;    
     
     /* print out result only once per execution */
-    if(repeats <= 1) {
+    if((repeats <= 1) && (streamed == 0)) {
         if(encCtx.resultReplaced) {
             if(xmlSecAppWriteResult(data->doc, NULL) < 0) {
                 goto done;
@@ -1635,6 +2095,111 @@ done:
     return(res);
 }
 
+static int
+xmlSecAppEncryptAllNodes(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlDocPtr doc) {
+    xmlNodePtr* nodes = NULL;
+    xmlNodePtr* newNodes;
+    xmlSecSize nodesSize = 0;
+    xmlSecSize nodesMaxSize = 0;
+    xmlNodePtr cur;
+    xmlChar* buf;
+    xmlChar* name;
+    xmlChar* ns;
+    int res = -1;
+
+    if(xmlSecAppCmdLineParamGetString(&nodeNameParam) == NULL) {
+        fprintf(stderr, "Error: \"%s\" option requires \"%s\" option\n",
+                allNodesParam.fullName, nodeNameParam.fullName);
+        return(-1);
+    }
+
+    buf = xmlStrdup(BAD_CAST xmlSecAppCmdLineParamGetString(&nodeNameParam));
+    if(buf == NULL) {
+        fprintf(stderr, "Error: failed to duplicate node \"%s\"\n", 
+                xmlSecAppCmdLineParamGetString(&nodeNameParam));
+        return(-1);
+    }
+    name = (xmlChar*)strrchr((char*)buf, ':');
+    if(name != NULL) {
+        (*(name++)) = '\0';
+        ns = buf;
+    } else {
+        name = buf;
+        ns = NULL;
+    }
+
+    /* the nodes are not nested: continue the search after each found node */
+    cur = xmlDocGetRootElement(doc);
+    while(cur != NULL) {
+        if(xmlSecCheckNodeName(cur, name, ns)) {
+            if(nodesSize >= nodesMaxSize) {
+                nodesMaxSize = 2 * nodesMaxSize + 8;
+                newNodes = (xmlNodePtr*)xmlRealloc(nodes, nodesMaxSize * sizeof(xmlNodePtr));
+                if(newNodes == NULL) {
+                    fprintf(stderr, "Error: failed to allocate nodes list\n");
+                    goto done;
+                }
+                nodes = newNodes;
+            }
+            nodes[nodesSize++] = cur;
+        } else if(xmlSecGetNextElementNode(cur->children) != NULL) {
+            cur = xmlSecGetNextElementNode(cur->children);
+            continue;
+        }
+
+        while((cur != NULL) && (xmlSecGetNextElementNode(cur->next) == NULL)) {
+            cur = (cur->parent != NULL && cur->parent->type == XML_ELEMENT_NODE) ? cur->parent : NULL;
+        }
+        if(cur != NULL) {
+            cur = xmlSecGetNextElementNode(cur->next);
+        }
+    }
+    if(nodesSize == 0) {
+        fprintf(stderr, "Error: failed to find node with name=\"%s\"\n", name);
+        goto done;
+    }
+
+    if(xmlSecEncCtxXmlEncryptNodes(encCtx, tmpl, nodes, nodesSize) < 0) {
+        fprintf(stderr, "Error: failed to encrypt %d nodes\n", (int)nodesSize);
+        goto done;
+    }
+    res = 0;
+
+done:
+    if(nodes != NULL) {
+        xmlFree(nodes);
+    }
+    xmlFree(buf);
+    return(res);
+}
+
+static int
+xmlSecAppDecryptAllNodes(xmlSecEncCtxPtr encCtx, xmlDocPtr doc) {
+    xmlNodePtr cur;
+
+    /* the first node is already decrypted and replaced */
+    if(!encCtx->resultReplaced) {
+        fprintf(stderr, "Error: \"%s\" option requires <enc:EncryptedData> nodes of XML element or content type\n",
+                allNodesParam.fullName);
+        return(-1);
+    }
+
+    cur = xmlSecFindNode(xmlDocGetRootElement(doc), xmlSecNodeEncryptedData, xmlSecEncNs);
+    while(cur != NULL) {
+        xmlSecEncCtxReset(encCtx);
+        if(xmlSecEncCtxDecrypt(encCtx, cur) < 0) {
+            return(-1);
+        }
+        if(!encCtx->resultReplaced) {
+            fprintf(stderr, "Error: \"%s\" option requires <enc:EncryptedData> nodes of XML element or content type\n",
+                    allNodesParam.fullName);
+            return(-1);
+        }
+        cur = xmlSecFindNode(xmlDocGetRootElement(doc), xmlSecNodeEncryptedData, xmlSecEncNs);
+    }
+    return(0);
+}
+
 #ifndef XMLSEC_NO_TMPL_TEST
 static int 
 xmlSecAppEncryptTmpl(void) {
@@ -1734,6 +2299,13 @@ xmlSecAppPrepareEncCtx(xmlSecEncCtxPtr encCtx) {
         return(-1);
     }
 
+    if(xmlSecAppCmdLineParamIsSet(&offloadParam)) {
+        if(xmlSecTransformCtxSetOffloadCallback(&(encCtx->transformCtx), xmlSecAppOffloadCallback, NULL) < 0) {
+            fprintf(stderr, "Error: failed to set the offload callback\n");
+            return(-1);
+        }
+    }
+
     if(xmlSecAppCmdLineParamGetString(&sessionKeyParam) != NULL) {
         encCtx->encKey = xmlSecAppCryptoKeyGenerate(xmlSecAppCmdLineParamGetString(&sessionKeyParam),
                                 NULL, xmlSecKeyDataTypeSession);
@@ -1812,6 +2384,13 @@ xmlSecAppPrepareKeyInfoReadCtx(xmlSecKeyInfoCtxPtr keyInfoCtx) {
         return(-1);
     }
 
+    if(xmlSecAppCmdLineParamIsSet(&keyInfoReadAllParam)) {
+        keyInfoCtx->flags |= XMLSEC_KEYINFO_FLAGS_DONT_STOP_ON_KEY_FOUND;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&copyKeysParam)) {
+        keyInfoCtx->flags |= XMLSEC_KEYINFO_FLAGS_KEYNAME_COPY_KEYS;
+    }
+
 #ifndef XMLSEC_NO_X509
     if(xmlSecAppCmdLineParamIsSet(&verificationTimeParam)) {
         keyInfoCtx->certsVerificationTime = xmlSecAppCmdLineParamGetTime(&verificationTimeParam, 0);
@@ -1883,6 +2462,15 @@ xmlSecAppLoadKeys(void) {
         return(-1);
     }    
 
+    /* read binary keys file, it replaces the keys store */
+    if(xmlSecAppCmdLineParamGetString(&binaryKeysFileParam) != NULL) {
+        if(xmlSecAppCryptoKeysMngrBinaryKeysLoad(gKeysMngr, xmlSecAppCmdLineParamGetString(&binaryKeysFileParam)) < 0) {
+            fprintf(stderr, "Error: failed to load binary keys file \"%s\".\n", 
+                    xmlSecAppCmdLineParamGetString(&binaryKeysFileParam));
+            return(-1);
+        }
+    }
+
     /* generate new key file */
     for(value = genKeyParam.value; value != NULL; value = value->next) {
         if(value->strValue == NULL) {
@@ -1905,6 +2493,11 @@ xmlSecAppLoadKeys(void) {
         }       
     }
 
+    /* replace the keys unless asked to wait for the first file */
+    if(xmlSecAppReloadKeys(0) < 0) {
+        return(-1);
+    }
+
     /* read all private keys */
     for(value = privkeyParam.value; value != NULL; value = value->next) {
         if(value->strValue == NULL) {
@@ -2156,6 +2749,109 @@ xmlSecAppLoadKeys(void) {
 
 #endif /* XMLSEC_NO_X509 */    
 
+    /* read all crls unless asked to wait for the first file */
+    if(xmlSecAppLoadCrls(0) < 0) {
+        return(-1);
+    }
+
+    /* cache the keys resolved from <dsig:KeyInfo/> */
+    if(xmlSecAppCmdLineParamIsSet(&keyInfoCacheParam)) {
+        xmlSecKeyDataStorePtr cache;
+
+        cache = xmlSecKeyDataStoreCreate(xmlSecKeyInfoCacheStoreId);
+        if(cache == NULL) {
+            fprintf(stderr, "Error: failed to create keyinfo cache.\n");
+            return(-1);
+        }
+        if(xmlSecAppCmdLineParamIsSet(&keyInfoCacheTtlParam) &&
+           (xmlSecKeyInfoCacheStoreSetTtl(cache, xmlSecAppCmdLineParamGetInt(&keyInfoCacheTtlParam, 0)) < 0)) {
+            fprintf(stderr, "Error: invalid value for option \"%s\".\n", keyInfoCacheTtlParam.fullName);
+            xmlSecKeyDataStoreDestroy(cache);
+            return(-1);
+        }
+        if(xmlSecKeysMngrAdoptDataStore(gKeysMngr, cache) < 0) {
+            fprintf(stderr, "Error: failed to adopt keyinfo cache.\n");
+            xmlSecKeyDataStoreDestroy(cache);
+            return(-1);
+        }
+    }
+
+#ifndef XMLSEC_NO_XMLENC
+    /* cache the keys decrypted from <enc:EncryptedKey/> */
+    if(xmlSecAppCmdLineParamIsSet(&encKeyCacheParam)) {
+        xmlSecKeyDataStorePtr cache;
+
+        cache = xmlSecKeyDataStoreCreate(xmlSecKeyDataStoreEncryptedKeyCacheId);
+        if(cache == NULL) {
+            fprintf(stderr, "Error: failed to create encrypted key cache.\n");
+            return(-1);
+        }
+        if(xmlSecKeysMngrAdoptDataStore(gKeysMngr, cache) < 0) {
+            fprintf(stderr, "Error: failed to adopt encrypted key cache.\n");
+            xmlSecKeyDataStoreDestroy(cache);
+            return(-1);
+        }
+    }
+#endif /* XMLSEC_NO_XMLENC */
+
+    return(0);
+}
+
+/* reloads the keys once: either with the keys or after the first processed file */
+static int
+xmlSecAppReloadKeys(int firstFileDone) {
+    static int reloaded = 0;
+
+    if((reloaded != 0) || (xmlSecAppCmdLineParamGetString(&reloadKeysFileParam) == NULL) ||
+       (xmlSecAppCmdLineParamIsSet(&reloadKeysAfterFirstFileParam) != firstFileDone)) {
+        return(0);
+    }
+    reloaded = 1;
+
+    if(xmlSecAppCryptoSimpleKeysMngrReload(gKeysMngr, xmlSecAppCmdLineParamGetString(&reloadKeysFileParam)) < 0) {
+        fprintf(stderr, "Error: failed to reload xml keys file \"%s\".\n", 
+                xmlSecAppCmdLineParamGetString(&reloadKeysFileParam));
+        return(-1);
+    }
+    return(0);
+}
+
+/* loads the crls once: either with the keys or after the first processed file */
+static int
+xmlSecAppLoadCrls(int firstFileDone) {
+#ifndef XMLSEC_NO_X509
+    static int loaded = 0;
+    xmlSecAppCmdLineValuePtr value;
+
+    if((loaded != 0) || (xmlSecAppCmdLineParamIsSet(&crlsAfterFirstFileParam) != firstFileDone)) {
+        return(0);
+    }
+    loaded = 1;
+
+    for(value = crlParam.value; value != NULL; value = value->next) {
+        if(value->strValue == NULL) {
+            fprintf(stderr, "Error: invalid value for option \"%s\".\n", crlParam.fullName);
+            return(-1);
+        } else if(xmlSecAppCryptoSimpleKeysMngrCrlLoad(gKeysMngr,
+                    value->strValue, xmlSecKeyDataFormatPem) < 0) {
+            fprintf(stderr, "Error: failed to load crl from \"%s\".\n",
+                    value->strValue);
+            return(-1);
+        }
+    }
+    for(value = crlDerParam.value; value != NULL; value = value->next) {
+        if(value->strValue == NULL) {
+            fprintf(stderr, "Error: invalid value for option \"%s\".\n", crlDerParam.fullName);
+            return(-1);
+        } else if(xmlSecAppCryptoSimpleKeysMngrCrlLoad(gKeysMngr,
+                    value->strValue, xmlSecKeyDataFormatDer) < 0) {
+            fprintf(stderr, "Error: failed to load crl from \"%s\".\n",
+                    value->strValue);
+            return(-1);
+        }
+    }
+#endif /* XMLSEC_NO_X509 */
+
     return(0);
 }
 
@@ -2738,6 +3434,34 @@ xmlSecAppWriteResult(xmlDocPtr doc, xmlSecBufferPtr buffer) {
     return(0);
 }
 
+static int 
+xmlSecAppOffloadCallback(xmlSecTransformPtr transform, xmlSecTransformOffloadWorkMethod work,
+                         void* workData, void* context ATTRIBUTE_UNUSED) {
+    if((transform == NULL) || (work == NULL)) {
+        return(-1);
+    }
+
+    /* the command line tool has no executor: run the work right away */
+    fprintf(stderr, "Offloaded transform \"%s\"\n", 
+            (transform->id->name != NULL) ? (const char*)transform->id->name : "unknown");
+    work(workData);
+    return(0);
+}
+
+static int 
+xmlSecAppWriteFileCallback(void* context, const xmlSecByte* data, xmlSecSize dataSize) {
+    FILE* f = (FILE*)context;
+
+    if(f == NULL) {
+        return(-1);
+    }
+    if((dataSize > 0) && (fwrite(data, dataSize, 1, f) != 1)) {
+        fprintf(stderr, "Error: failed to write the result\n"); 
+        return(-1);
+    }
+    return(0);
+}
+
 static int  
 xmlSecAppAddIDAttr(xmlNodePtr node, const xmlChar* attrName, const xmlChar* nodeName, const xmlChar* nsHref) {
     xmlAttrPtr attr, tmpAttr;
@@ -161,6 +161,27 @@ XMLSEC_EXPORT xmlSecTransformId                 xmlSecTransformAes192CbcGetKlass
  */
 #define xmlSecTransformAes256CbcId              xmlSecTransformAes256CbcGetKlass()
 XMLSEC_EXPORT xmlSecTransformId                 xmlSecTransformAes256CbcGetKlass(void);
+/**
+ * xmlSecTransformAes128GcmId:
+ *
+ * The AES128 GCM cipher transform klass.
+ */
+#define xmlSecTransformAes128GcmId              xmlSecTransformAes128GcmGetKlass()
+XMLSEC_EXPORT xmlSecTransformId                 xmlSecTransformAes128GcmGetKlass(void);
+/**
+ * xmlSecTransformAes192GcmId:
+ *
+ * The AES192 GCM cipher transform klass.
+ */
+#define xmlSecTransformAes192GcmId              xmlSecTransformAes192GcmGetKlass()
+XMLSEC_EXPORT xmlSecTransformId                 xmlSecTransformAes192GcmGetKlass(void);
+/**
+ * xmlSecTransformAes256GcmId:
+ *
+ * The AES256 GCM cipher transform klass.
+ */
+#define xmlSecTransformAes256GcmId              xmlSecTransformAes256GcmGetKlass()
+XMLSEC_EXPORT xmlSecTransformId                 xmlSecTransformAes256GcmGetKlass(void);
 /**
  * xmlSecTransformKWAes128Id:
  *
@@ -479,6 +500,9 @@ XMLSEC_EXPORT int                               xmlSecCryptoAppKeysMngrCertLoadM
                                                                                  xmlSecSize dataSize,
                                                                                  xmlSecKeyDataFormat format,
                                                                                  xmlSecKeyDataType type);
+XMLSEC_EXPORT int                               xmlSecCryptoAppKeysMngrCrlLoad  (xmlSecKeysMngrPtr mngr,
+                                                                                 const char *filename,
+                                                                                 xmlSecKeyDataFormat format);
 XMLSEC_EXPORT xmlSecKeyPtr                      xmlSecCryptoAppKeyLoad          (const char *filename,
                                                                                  xmlSecKeyDataFormat format,
                                                                                  const char *pwd,
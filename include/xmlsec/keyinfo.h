@@ -154,6 +154,24 @@ typedef enum {
  */
 #define XMLSEC_KEYINFO_FLAGS_X509DATA_SKIP_STRICT_CHECKS        0x00004000
 
+/**
+ * XMLSEC_KEYINFO_FLAGS_KEYNAME_COPY_KEYS:
+ *
+ * If the flag is set then the key found for <dsig:KeyName /> element
+ * is copied from the keys manager (see #xmlSecKeysMngrFindKey). Otherwise
+ * the key is shared with the keys manager (see #xmlSecKeysMngrFindKeyShared)
+ * and copied only if it is modified.
+ */
+#define XMLSEC_KEYINFO_FLAGS_KEYNAME_COPY_KEYS                  0x00008000
+
+/**
+ * XMLSEC_KEYINFO_FLAGS_KEYNAME_DONT_FIND_KEY:
+ *
+ * If the flag is set then <dsig:KeyName /> element only sets the key name
+ * and the key is not searched in the keys manager.
+ */
+#define XMLSEC_KEYINFO_FLAGS_KEYNAME_DONT_FIND_KEY              0x00010000
+
 /**
  * xmlSecKeyInfoCtx:
  * @userData:           the pointer to user data (xmlsec and xmlsec-crypto
@@ -275,6 +293,19 @@ XMLSEC_EXPORT xmlSecKeyDataId           xmlSecKeyDataRetrievalMethodGetKlass(voi
  */
 #define xmlSecKeyDataEncryptedKeyId     xmlSecKeyDataEncryptedKeyGetKlass()
 XMLSEC_EXPORT xmlSecKeyDataId           xmlSecKeyDataEncryptedKeyGetKlass(void);
+
+/**
+ * xmlSecKeyDataStoreEncryptedKeyCacheId:
+ *
+ * The <enc:EncryptedKey> unwrap cache klass (adopt it in the keys manager
+ * with #xmlSecKeysMngrAdoptDataStore to enable caching).
+ */
+#define xmlSecKeyDataStoreEncryptedKeyCacheId   xmlSecKeyDataStoreEncryptedKeyCacheGetKlass()
+XMLSEC_EXPORT xmlSecKeyDataStoreId      xmlSecKeyDataStoreEncryptedKeyCacheGetKlass(void);
+XMLSEC_EXPORT int                       xmlSecKeyDataStoreEncryptedKeyCacheSetLimits(xmlSecKeyDataStorePtr store,
+                                                                         xmlSecSize maxSize,
+                                                                         unsigned int ttl);
+XMLSEC_EXPORT void                      xmlSecKeyDataStoreEncryptedKeyCacheFlush(xmlSecKeyDataStorePtr store);
 #endif /* XMLSEC_NO_XMLENC */
 
 #ifdef __cplusplus
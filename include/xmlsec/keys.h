@@ -191,6 +191,10 @@ XMLSEC_EXPORT void              xmlSecKeyEmpty          (xmlSecKeyPtr key);
 XMLSEC_EXPORT xmlSecKeyPtr      xmlSecKeyDuplicate      (xmlSecKeyPtr key);
 XMLSEC_EXPORT int               xmlSecKeyCopy           (xmlSecKeyPtr keyDst,
                                                          xmlSecKeyPtr keySrc);
+XMLSEC_EXPORT int               xmlSecKeyCopyShared     (xmlSecKeyPtr keyDst,
+                                                         xmlSecKeyPtr keySrc);
+XMLSEC_EXPORT xmlSecKeyPtr      xmlSecKeyReference      (xmlSecKeyPtr key);
+XMLSEC_EXPORT int               xmlSecKeyIsShared       (xmlSecKeyPtr key);
 
 XMLSEC_EXPORT const xmlChar*    xmlSecKeyGetName        (xmlSecKeyPtr key);
 XMLSEC_EXPORT int               xmlSecKeySetName        (xmlSecKeyPtr key,
@@ -706,6 +706,7 @@ struct _xmlSecKeyDataStore {
 
 XMLSEC_EXPORT xmlSecKeyDataStorePtr xmlSecKeyDataStoreCreate    (xmlSecKeyDataStoreId id);
 XMLSEC_EXPORT void              xmlSecKeyDataStoreDestroy       (xmlSecKeyDataStorePtr store);
+XMLSEC_EXPORT unsigned long     xmlSecKeyDataStoreGetGeneration (xmlSecKeyDataStorePtr store);
 
 /**
  * xmlSecKeyDataStoreGetName:
@@ -779,6 +780,18 @@ typedef int                     (*xmlSecKeyDataStoreInitializeMethod)   (xmlSecK
  */
 typedef void                    (*xmlSecKeyDataStoreFinalizeMethod)     (xmlSecKeyDataStorePtr store);
 
+/**
+ * xmlSecKeyDataStoreGetGenerationMethod:
+ * @store:              the data store.
+ *
+ * Key data store specific method to get the number that changes every
+ * time the store content changes (for example, when a certificate or
+ * a CRL is added).
+ *
+ * Returns: the store generation number.
+ */
+typedef unsigned long           (*xmlSecKeyDataStoreGetGenerationMethod)(xmlSecKeyDataStorePtr store);
+
 /**
  * xmlSecKeyDataStoreKlass:
  * @klassSize:          the data store klass size.
@@ -786,7 +799,7 @@ typedef void                    (*xmlSecKeyDataStoreFinalizeMethod)     (xmlSecK
  * @name:               the store's name.
  * @initialize:         the store's initialization method.
  * @finalize:           the store's finalization (destroy) method.
- * @reserved0:          reserved for the future.
+ * @getGeneration:      the store's generation method (optional).
  * @reserved1:          reserved for the future.
  *
  * The data store id (klass).
@@ -802,8 +815,10 @@ struct _xmlSecKeyDataStoreKlass {
     xmlSecKeyDataStoreInitializeMethod  initialize;
     xmlSecKeyDataStoreFinalizeMethod    finalize;
 
+    /* the content changes tracking */
+    xmlSecKeyDataStoreGetGenerationMethod getGeneration;
+
     /* for the future */
-    void*                               reserved0;
     void*                               reserved1;
 };
 
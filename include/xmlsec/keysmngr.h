@@ -38,6 +38,9 @@ XMLSEC_EXPORT void                      xmlSecKeysMngrDestroy           (xmlSecK
 XMLSEC_EXPORT xmlSecKeyPtr              xmlSecKeysMngrFindKey           (xmlSecKeysMngrPtr mngr,
                                                                          const xmlChar* name,
                                                                          xmlSecKeyInfoCtxPtr keyInfoCtx);
+XMLSEC_EXPORT xmlSecKeyPtr              xmlSecKeysMngrFindKeyShared     (xmlSecKeysMngrPtr mngr,
+                                                                         const xmlChar* name,
+                                                                         xmlSecKeyInfoCtxPtr keyInfoCtx);
 
 XMLSEC_EXPORT int                       xmlSecKeysMngrAdoptKeysStore    (xmlSecKeysMngrPtr mngr,
                                                                          xmlSecKeyStorePtr store);
@@ -47,6 +50,7 @@ XMLSEC_EXPORT int                       xmlSecKeysMngrAdoptDataStore    (xmlSecK
                                                                          xmlSecKeyDataStorePtr store);
 XMLSEC_EXPORT xmlSecKeyDataStorePtr     xmlSecKeysMngrGetDataStore      (xmlSecKeysMngrPtr mngr,
                                                                          xmlSecKeyDataStoreId id);
+XMLSEC_EXPORT unsigned long             xmlSecKeysMngrGetGeneration     (xmlSecKeysMngrPtr mngr);
 
 /**
  * xmlSecGetKeyCallback:
@@ -106,6 +110,9 @@ XMLSEC_EXPORT void              xmlSecKeyStoreDestroy           (xmlSecKeyStoreP
 XMLSEC_EXPORT xmlSecKeyPtr      xmlSecKeyStoreFindKey           (xmlSecKeyStorePtr store,
                                                                  const xmlChar* name,
                                                                  xmlSecKeyInfoCtxPtr keyInfoCtx);
+XMLSEC_EXPORT xmlSecKeyPtr      xmlSecKeyStoreFindKeyShared     (xmlSecKeyStorePtr store,
+                                                                 const xmlChar* name,
+                                                                 xmlSecKeyInfoCtxPtr keyInfoCtx);
 /**
  * xmlSecKeyStoreGetName:
  * @store:              the pointer to store.
@@ -185,7 +192,9 @@ typedef void                    (*xmlSecKeyStoreFinalizeMethod)         (xmlSecK
  * @keyInfoCtx:         the pointer to key info context.
  *
  * Keys store specific find method. The caller is responsible for destroying
- * the returned key using #xmlSecKeyDestroy method.
+ * the returned key using #xmlSecKeyDestroy method. The method might return
+ * a reference to the key kept in the store (see #xmlSecKeyReference),
+ * #xmlSecKeyStoreFindKey copies such keys for the caller.
  *
  * Returns: the pointer to a key or NULL if key is not found or an error occurs.
  */
@@ -250,10 +259,64 @@ XMLSEC_EXPORT int                       xmlSecSimpleKeysStoreAdoptKey   (xmlSecK
 XMLSEC_EXPORT int                       xmlSecSimpleKeysStoreLoad       (xmlSecKeyStorePtr store,
                                                                          const char *uri,
                                                                          xmlSecKeysMngrPtr keysMngr);
+XMLSEC_EXPORT int                       xmlSecSimpleKeysStoreReload     (xmlSecKeyStorePtr store,
+                                                                         const char *uri,
+                                                                         xmlSecKeysMngrPtr keysMngr);
 XMLSEC_EXPORT int                       xmlSecSimpleKeysStoreSave       (xmlSecKeyStorePtr store,
                                                                          const char *filename,
                                                                          xmlSecKeyDataType type);
 XMLSEC_EXPORT xmlSecPtrListPtr          xmlSecSimpleKeysStoreGetKeys    (xmlSecKeyStorePtr store);
+XMLSEC_EXPORT unsigned long             xmlSecSimpleKeysStoreGetGeneration(xmlSecKeyStorePtr store);
+
+/****************************************************************************
+ *
+ * Binary Keys Store
+ *
+ ***************************************************************************/
+/**
+ * xmlSecBinaryKeysStoreId:
+ *
+ * A read-only binary (memory mapped) keys store klass id.
+ */
+#define xmlSecBinaryKeysStoreId         xmlSecBinaryKeysStoreGetKlass()
+XMLSEC_EXPORT xmlSecKeyStoreId          xmlSecBinaryKeysStoreGetKlass   (void);
+XMLSEC_EXPORT int                       xmlSecBinaryKeysStoreLoad       (xmlSecKeyStorePtr store,
+                                                                         const char *filename);
+XMLSEC_EXPORT int                       xmlSecBinaryKeysStoreSaveKeys   (xmlSecPtrListPtr keys,
+                                                                         const char *filename,
+                                                                         xmlSecKeyDataType type,
+                                                                         xmlSecKeysMngrPtr keysMngr);
+
+/****************************************************************************
+ *
+ * KeyInfo Cache Store
+ *
+ ***************************************************************************/
+/**
+ * xmlSecKeyInfoCacheStoreId:
+ *
+ * The <dsig:KeyInfo/> resolution cache klass id.
+ */
+#define xmlSecKeyInfoCacheStoreId       xmlSecKeyInfoCacheStoreGetKlass()
+XMLSEC_EXPORT xmlSecKeyDataStoreId      xmlSecKeyInfoCacheStoreGetKlass (void);
+XMLSEC_EXPORT int                       xmlSecKeyInfoCacheStoreSetTtl   (xmlSecKeyDataStorePtr store,
+                                                                         long ttl);
+XMLSEC_EXPORT int                       xmlSecKeyInfoCacheStoreSetMaxSize(xmlSecKeyDataStorePtr store,
+                                                                         xmlSecSize maxSize);
+XMLSEC_EXPORT void                      xmlSecKeyInfoCacheStoreEmpty    (xmlSecKeyDataStorePtr store);
+XMLSEC_EXPORT int                       xmlSecKeyInfoCacheStoreSetMissTtl(xmlSecKeyDataStorePtr store,
+                                                                         long ttl);
+XMLSEC_EXPORT xmlSecKeyPtr              xmlSecKeyInfoCacheStoreFindKey  (xmlSecKeyDataStorePtr store,
+                                                                         xmlNodePtr keyInfoNode,
+                                                                         xmlSecKeyInfoCtxPtr keyInfoCtx,
+                                                                         int* miss);
+XMLSEC_EXPORT int                       xmlSecKeyInfoCacheStoreAddKey   (xmlSecKeyDataStorePtr store,
+                                                                         xmlNodePtr keyInfoNode,
+                                                                         xmlSecKeyInfoCtxPtr keyInfoCtx,
+                                                                         xmlSecKeyPtr key);
+XMLSEC_EXPORT int                       xmlSecKeyInfoCacheStoreAddMiss  (xmlSecKeyDataStorePtr store,
+                                                                         xmlNodePtr keyInfoNode,
+                                                                         xmlSecKeyInfoCtxPtr keyInfoCtx);
 
 
 #ifdef __cplusplus
@@ -36,6 +36,25 @@ extern "C" {
 XMLSEC_EXPORT xmlSecTransformId xmlSecTransformMemBufGetKlass           (void);
 XMLSEC_EXPORT xmlSecBufferPtr   xmlSecTransformMemBufGetBuffer          (xmlSecTransformPtr transform);
 
+/**
+ * xmlSecTransformMemBufWriteCallback:
+ * @context:            the user context passed to #xmlSecTransformMemBufSetWriteCallback.
+ * @data:               the data chunk.
+ * @dataSize:           the data chunk size.
+ *
+ * The memory buffer transform write callback. If set, it is called for
+ * each data chunk that goes through the transform instead of storing
+ * the data in the transform's buffer.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+typedef int             (*xmlSecTransformMemBufWriteCallback)           (void* context,
+                                                                         const xmlSecByte* data,
+                                                                         xmlSecSize dataSize);
+XMLSEC_EXPORT int       xmlSecTransformMemBufSetWriteCallback           (xmlSecTransformPtr transform,
+                                                                         xmlSecTransformMemBufWriteCallback callback,
+                                                                         void* context);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -222,6 +222,19 @@ typedef int                     (*xmlSecCryptoAppKeysMngrCertLoadMemoryMethod)(x
                                                                          xmlSecSize dataSize,
                                                                          xmlSecKeyDataFormat format,
                                                                          xmlSecKeyDataType type);
+/**
+ * xmlSecCryptoAppKeysMngrCrlLoadMethod:
+ * @mngr:               the keys manager.
+ * @filename:           the CRL file.
+ * @format:             the CRL file format.
+ *
+ * Reads CRL from @filename and adds it to the keys manager X509 store.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+typedef int                     (*xmlSecCryptoAppKeysMngrCrlLoadMethod)(xmlSecKeysMngrPtr mngr,
+                                                                         const char *filename,
+                                                                         xmlSecKeyDataFormat format);
 /**
  * xmlSecCryptoAppKeyLoadMethod:
  * @filename:           the key filename.
@@ -346,6 +359,9 @@ typedef int                     (*xmlSecCryptoAppKeyCertLoadMemoryMethod)(xmlSec
  * @transformAes128CbcGetKlass: the method to get pointer to AES 128 encryption transform.
  * @transformAes192CbcGetKlass: the method to get pointer to AES 192 encryption transform.
  * @transformAes256CbcGetKlass: the method to get pointer to AES 256 encryption transform.
+ * @transformAes128GcmGetKlass: the method to get pointer to AES 128 GCM encryption transform.
+ * @transformAes192GcmGetKlass: the method to get pointer to AES 192 GCM encryption transform.
+ * @transformAes256GcmGetKlass: the method to get pointer to AES 256 GCM encryption transform.
  * @transformKWAes128GetKlass:  the method to get pointer to AES 128 key wrapper transform.
  * @transformKWAes192GetKlass:  the method to get pointer to AES 192 key wrapper transform.
  * @transformKWAes256GetKlass:  the method to get pointer to AES 256 key wrapper transform.
@@ -402,6 +418,7 @@ typedef int                     (*xmlSecCryptoAppKeyCertLoadMemoryMethod)(xmlSec
  * @cryptoAppKeyCertLoad:       the cert file load method.
  * @cryptoAppKeyCertLoadMemory: the memory cert load method.
  * @cryptoAppDefaultPwdCallback:the default password callback.
+ * @cryptoAppKeysMngrCrlLoad:   the default keys manager file CRL load method.
  *
  * The list of crypto engine functions, key data and transform classes.
  */
@@ -431,6 +448,9 @@ struct _xmlSecCryptoDLFunctions {
     xmlSecCryptoTransformGetKlassMethod          transformAes128CbcGetKlass;
     xmlSecCryptoTransformGetKlassMethod          transformAes192CbcGetKlass;
     xmlSecCryptoTransformGetKlassMethod          transformAes256CbcGetKlass;
+    xmlSecCryptoTransformGetKlassMethod          transformAes128GcmGetKlass;
+    xmlSecCryptoTransformGetKlassMethod          transformAes192GcmGetKlass;
+    xmlSecCryptoTransformGetKlassMethod          transformAes256GcmGetKlass;
     xmlSecCryptoTransformGetKlassMethod          transformKWAes128GetKlass;
     xmlSecCryptoTransformGetKlassMethod          transformKWAes192GetKlass;
     xmlSecCryptoTransformGetKlassMethod          transformKWAes256GetKlass;
@@ -489,6 +509,7 @@ struct _xmlSecCryptoDLFunctions {
     xmlSecCryptoAppKeyCertLoadMethod             cryptoAppKeyCertLoad;
     xmlSecCryptoAppKeyCertLoadMemoryMethod       cryptoAppKeyCertLoadMemory;
     void*                                        cryptoAppDefaultPwdCallback;
+    xmlSecCryptoAppKeysMngrCrlLoadMethod         cryptoAppKeysMngrCrlLoad;
 };
 
 #include <libxml/xmlstring.h>
@@ -0,0 +1,96 @@
+/**
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Atomic operations and spin locks helpers
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2016 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_PRIVATE_ATOMIC_H__
+#define __XMLSEC_PRIVATE_ATOMIC_H__
+
+#ifndef XMLSEC_PRIVATE
+#error "xmlsec/private/atomic.h file contains private xmlsec definitions and should not be used outside xmlsec or xmlsec-$crypto libraries"
+#endif /* XMLSEC_PRIVATE */
+
+/*
+ * The counters and locks are "long volatile", the pointers are "void* volatile"
+ * (or any other pointer type). The INC/DEC operations return the new value,
+ * the CAS operations return non zero if the value was swapped. A pointer
+ * published with CAS_PTR is read with LOAD_PTR (acquire semantics) so the
+ * object it points to is seen fully initialized.
+ *
+ * The shared stores and caches rely on these operations for thread safety.
+ * A compiler without atomics is only supported in the single threaded mode
+ * (XMLSEC_NO_THREADS defined) and never silently.
+ */
+#if defined(XMLSEC_NO_THREADS)
+
+#define XMLSEC_ATOMIC_INC(ptr)                          (++(*(ptr)))
+#define XMLSEC_ATOMIC_DEC(ptr)                          (--(*(ptr)))
+#define XMLSEC_ATOMIC_CAS(ptr, oldVal, newVal) \
+    (((*(ptr)) == (oldVal)) ? (((*(ptr)) = (newVal)), 1) : 0)
+#define XMLSEC_ATOMIC_CAS_PTR(ptr, oldVal, newVal) \
+    XMLSEC_ATOMIC_CAS((ptr), (oldVal), (newVal))
+#define XMLSEC_ATOMIC_LOAD_PTR(ptr)                     (*(ptr))
+#define XMLSEC_ATOMIC_YIELD()
+
+#elif defined(__GNUC__)
+
+#include <sched.h>
+
+#define XMLSEC_ATOMIC_INC(ptr)                          __sync_add_and_fetch((ptr), 1)
+#define XMLSEC_ATOMIC_DEC(ptr)                          __sync_sub_and_fetch((ptr), 1)
+#define XMLSEC_ATOMIC_CAS(ptr, oldVal, newVal) \
+    __sync_bool_compare_and_swap((ptr), (oldVal), (newVal))
+#define XMLSEC_ATOMIC_CAS_PTR(ptr, oldVal, newVal) \
+    __sync_bool_compare_and_swap((ptr), (oldVal), (newVal))
+#if defined(__ATOMIC_ACQUIRE)
+#define XMLSEC_ATOMIC_LOAD_PTR(ptr)                     __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#else  /* defined(__ATOMIC_ACQUIRE) */
+#define XMLSEC_ATOMIC_LOAD_PTR(ptr)                     __sync_val_compare_and_swap((ptr), NULL, NULL)
+#endif /* defined(__ATOMIC_ACQUIRE) */
+#if defined(_WIN32)
+#include <windows.h>
+#define XMLSEC_ATOMIC_YIELD()                           SwitchToThread()
+#else  /* defined(_WIN32) */
+#define XMLSEC_ATOMIC_YIELD()                           sched_yield()
+#endif /* defined(_WIN32) */
+
+#elif defined(_MSC_VER)
+
+#include <windows.h>
+
+#define XMLSEC_ATOMIC_INC(ptr)                          InterlockedIncrement((ptr))
+#define XMLSEC_ATOMIC_DEC(ptr)                          InterlockedDecrement((ptr))
+#define XMLSEC_ATOMIC_CAS(ptr, oldVal, newVal) \
+    (InterlockedCompareExchange((ptr), (newVal), (oldVal)) == (oldVal))
+#define XMLSEC_ATOMIC_CAS_PTR(ptr, oldVal, newVal) \
+    (InterlockedCompareExchangePointer((PVOID volatile*)(ptr), (PVOID)(newVal), (PVOID)(oldVal)) == (PVOID)(oldVal))
+#define XMLSEC_ATOMIC_LOAD_PTR(ptr) \
+    InterlockedCompareExchangePointer((PVOID volatile*)(ptr), NULL, NULL)
+#define XMLSEC_ATOMIC_YIELD()                           SwitchToThread()
+
+#else  /* defined(XMLSEC_NO_THREADS) */
+
+#error "xmlsec needs atomic operations for this compiler, define XMLSEC_NO_THREADS to build a single threaded library"
+
+#endif /* defined(XMLSEC_NO_THREADS) */
+
+/*
+ * The spin lock is a "long volatile" set to 0 when unlocked. The locks are
+ * only held for a few memory operations.
+ */
+#define XMLSEC_SPIN_LOCK(lock) \
+    do { \
+        while(!XMLSEC_ATOMIC_CAS((lock), 0, 1)) { \
+            XMLSEC_ATOMIC_YIELD(); \
+        } \
+    } while(0)
+
+#define XMLSEC_SPIN_UNLOCK(lock) \
+    ((void)XMLSEC_ATOMIC_CAS((lock), 1, 0))
+
+#endif /* __XMLSEC_PRIVATE_ATOMIC_H__ */
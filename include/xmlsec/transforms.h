@@ -35,6 +35,15 @@ typedef const struct _xmlSecTransformKlass              xmlSecTransformKlass,
  */
 #define XMLSEC_TRANSFORM_BINARY_CHUNK                   1024
 
+/**
+ * XMLSEC_TRANSFORM_URI_BINARY_CHUNK:
+ *
+ * The binary data chunks size used to read data from an external URI
+ * (for example, a detached reference to a local file). Large external
+ * files are read in big blocks to avoid the per-chunk I/O overhead.
+ */
+#define XMLSEC_TRANSFORM_URI_BINARY_CHUNK               65536
+
 /**********************************************************************
  *
  * High-level functions
@@ -269,6 +278,54 @@ typedef unsigned int                            xmlSecTransformUsage;
  */
 typedef int             (*xmlSecTransformCtxPreExecuteCallback)         (xmlSecTransformCtxPtr transformCtx);
 
+/**
+ * xmlSecTransformCtxResultCallback:
+ * @context:            the user context (see #xmlSecTransformCtxSetResultCallback).
+ * @data:               the result data chunk.
+ * @dataSize:           the result data chunk size.
+ *
+ * The callback called for each chunk of the transforms chain result.
+ * If set, the result is streamed to the callback instead of being
+ * stored in the result buffer.
+ *
+ * Returns: 0 on success and a negative value otherwise (in this case,
+ * transforms execution stops).
+ */
+typedef int             (*xmlSecTransformCtxResultCallback)             (void* context,
+                                                                         const xmlSecByte* data,
+                                                                         xmlSecSize dataSize);
+
+/**
+ * xmlSecTransformOffloadWorkMethod:
+ * @workData:           the work data (opaque for the application).
+ *
+ * Performs the offloaded transform step. The result is stored in @workData.
+ */
+typedef void            (*xmlSecTransformOffloadWorkMethod)             (void* workData);
+
+/**
+ * xmlSecTransformCtxOffloadCallback:
+ * @transform:          the pointer to transform that requests the offload.
+ * @work:               the work method.
+ * @workData:           the data for @work.
+ * @context:            the user context (see #xmlSecTransformCtxSetOffloadCallback).
+ *
+ * The callback called for the final step (sign, verify or private key
+ * decrypt) of the asymmetric key transforms (RSA, DSA, ECDSA, GOST, ...).
+ * The application hands the @work over to its executor, which must call
+ * @work with @workData exactly once (on any thread). The callback returns
+ * after @work completed: for example, it blocks the current thread or
+ * suspends the current coroutine until the executor signals completion.
+ * The transform must not be used by another thread in the meantime.
+ *
+ * Returns: 0 if @work was executed or a negative value if it was not
+ * submitted (in this case, transforms execution stops).
+ */
+typedef int             (*xmlSecTransformCtxOffloadCallback)            (xmlSecTransformPtr transform,
+                                                                         xmlSecTransformOffloadWorkMethod work,
+                                                                         void* workData,
+                                                                         void* context);
+
 /**
  * XMLSEC_TRANSFORMCTX_FLAGS_USE_VISA3D_HACK:
  *
@@ -301,7 +358,8 @@ typedef int             (*xmlSecTransformCtxPreExecuteCallback)         (xmlSecT
  * @xptrExpr:           the xpointer expression from data source URI (if any).
  * @first:              the first transform in the chain.
  * @last:               the last transform in the chain.
- * @reserved0:          reserved for the future.
+ * @reserved0:          the private callbacks data (see #xmlSecTransformCtxSetResultCallback
+ *                      and #xmlSecTransformCtxSetOffloadCallback), never touch it.
  * @reserved1:          reserved for the future.
  *
  * The transform execution context.
@@ -335,6 +393,14 @@ XMLSEC_EXPORT void                      xmlSecTransformCtxFinalize      (xmlSecT
 XMLSEC_EXPORT void                      xmlSecTransformCtxReset         (xmlSecTransformCtxPtr ctx);
 XMLSEC_EXPORT int                       xmlSecTransformCtxCopyUserPref  (xmlSecTransformCtxPtr dst,
                                                                          xmlSecTransformCtxPtr src);
+XMLSEC_EXPORT int                       xmlSecTransformCtxSetResultCallback(xmlSecTransformCtxPtr ctx,
+                                                                         xmlSecTransformCtxResultCallback callback,
+                                                                         void* context);
+XMLSEC_EXPORT int                       xmlSecTransformCtxSetOffloadCallback(xmlSecTransformCtxPtr ctx,
+                                                                         xmlSecTransformCtxOffloadCallback callback,
+                                                                         void* context);
+XMLSEC_EXPORT xmlSecTransformCtxOffloadCallback xmlSecTransformCtxGetOffloadCallback(xmlSecTransformCtxPtr ctx,
+                                                                         void** context);
 XMLSEC_EXPORT int                       xmlSecTransformCtxSetUri        (xmlSecTransformCtxPtr ctx,
                                                                          const xmlChar* uri,
                                                                          xmlNodePtr hereNode);
@@ -386,7 +452,7 @@ XMLSEC_EXPORT void                      xmlSecTransformCtxDebugXmlDump  (xmlSecT
  * @inNodes:            the input XML nodes.
  * @outNodes:           the output XML nodes.
  * @reserved0:          reserved for the future.
- * @reserved1:          reserved for the future.
+ * @reserved1:          the private offload flag (see #xmlSecTransformSetKey), never touch it.
  *
  * The transform structure.
  */
@@ -54,6 +54,42 @@ typedef enum {
  *
  *************************************************************************/
 
+/**
+ * xmlSecDSigCtxPreSignCallback:
+ * @dsigCtx:            the pointer to <dsig:Signature/> processing context.
+ * @data:               the pre-signature data chunk.
+ * @dataSize:           the pre-signature data chunk size.
+ *
+ * The callback called for each chunk of <dsig:SignedInfo/> data right before
+ * the signature transform (valid only if #XMLSEC_DSIG_FLAGS_STORE_SIGNATURE
+ * flag is set). If the callback is set then the data are passed to it
+ * instead of being stored in the pre-sign buffer.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+typedef int             (*xmlSecDSigCtxPreSignCallback)         (xmlSecDSigCtxPtr dsigCtx,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize);
+
+/**
+ * xmlSecDSigReferenceCtxPreDigestCallback:
+ * @dsigRefCtx:         the pointer to <dsig:Reference/> processing context.
+ * @data:               the pre-digest data chunk.
+ * @dataSize:           the pre-digest data chunk size.
+ *
+ * The callback called for each chunk of <dsig:Reference/> data right before
+ * the digest transform (valid only if either
+ * #XMLSEC_DSIG_FLAGS_STORE_SIGNEDINFO_REFERENCES or
+ * #XMLSEC_DSIG_FLAGS_STORE_MANIFEST_REFERENCES flags are set). If the callback
+ * is set then the data are passed to it instead of being stored in the
+ * pre-digest buffer.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+typedef int             (*xmlSecDSigReferenceCtxPreDigestCallback)(xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize);
+
 /**
  * XMLSEC_DSIG_FLAGS_IGNORE_MANIFESTS:
  *
@@ -94,6 +130,17 @@ typedef enum {
  */
 #define XMLSEC_DSIG_FLAGS_USE_VISA3D_HACK                       0x00000010
 
+/**
+ * XMLSEC_DSIG_FLAGS_LAZY_MANIFESTS:
+ *
+ * If this flag is set then <dsig:Reference/> children of <dsig:Manifest/>
+ * nodes are only read during verification but not digested. Use
+ * #xmlSecDSigCtxVerifyManifestReference or
+ * #xmlSecDSigCtxVerifyManifestReferenceByUri to verify the references
+ * the application actually cares about.
+ */
+#define XMLSEC_DSIG_FLAGS_LAZY_MANIFESTS                        0x00000020
+
 /**
  * xmlSecDSigCtx:
  * @userData:                   the pointer to user data (xmlsec and xmlsec-crypto libraries
@@ -123,7 +170,8 @@ typedef enum {
  * @id:                         the pointer to Id attribute of <dsig:Signature/> node.
  * @signedInfoReferences:       the list of references in <dsig:SignedInfo/> node.
  * @manifestReferences:         the list of references in <dsig:Manifest/> nodes.
- * @reserved0:                  reserved for the future.
+ * @reserved0:                  the private callbacks data (see #xmlSecDSigCtxSetPreSignCallback
+ *                              and #xmlSecDSigCtxSetPreDigestCallback), never touch it.
  * @reserved1:                  reserved for the future.
  *
  * XML DSig processing context.
@@ -176,6 +224,16 @@ XMLSEC_EXPORT int               xmlSecDSigCtxEnableReferenceTransform(xmlSecDSig
 XMLSEC_EXPORT int               xmlSecDSigCtxEnableSignatureTransform(xmlSecDSigCtxPtr dsigCtx,
                                                                 xmlSecTransformId transformId);
 XMLSEC_EXPORT xmlSecBufferPtr   xmlSecDSigCtxGetPreSignBuffer   (xmlSecDSigCtxPtr dsigCtx);
+XMLSEC_EXPORT int               xmlSecDSigCtxSetPreSignCallback (xmlSecDSigCtxPtr dsigCtx,
+                                                                 xmlSecDSigCtxPreSignCallback callback);
+XMLSEC_EXPORT int               xmlSecDSigCtxSetPreDigestCallback(xmlSecDSigCtxPtr dsigCtx,
+                                                                 xmlSecDSigReferenceCtxPreDigestCallback callback);
+XMLSEC_EXPORT int               xmlSecDSigCtxVerifyManifestReference(xmlSecDSigCtxPtr dsigCtx,
+                                                                 xmlSecSize pos,
+                                                                 xmlSecDSigStatus* status);
+XMLSEC_EXPORT int               xmlSecDSigCtxVerifyManifestReferenceByUri(xmlSecDSigCtxPtr dsigCtx,
+                                                                 const xmlChar* uri,
+                                                                 xmlSecDSigStatus* status);
 XMLSEC_EXPORT void              xmlSecDSigCtxDebugDump          (xmlSecDSigCtxPtr dsigCtx,
                                                                  FILE* output);
 XMLSEC_EXPORT void              xmlSecDSigCtxDebugXmlDump       (xmlSecDSigCtxPtr dsigCtx,
@@ -217,7 +275,8 @@ typedef enum  {
  * @id:                         the <dsig:Reference/> node ID attribute.
  * @uri:                        the <dsig:Reference/> node URI attribute.
  * @type:                       the <dsig:Reference/> node Type attribute.
- * @reserved0:                  reserved for the future.
+ * @reserved0:                  the private <dsig:Reference/> node (see
+ *                              #xmlSecDSigCtxVerifyManifestReference).
  * @reserved1:                  reserved for the future.
  *
  * The <dsig:Reference/> processing context.
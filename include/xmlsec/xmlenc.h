@@ -141,13 +141,30 @@ XMLSEC_EXPORT int               xmlSecEncCtxBinaryEncrypt       (xmlSecEncCtxPtr
 XMLSEC_EXPORT int               xmlSecEncCtxXmlEncrypt          (xmlSecEncCtxPtr encCtx,
                                                                  xmlNodePtr tmpl,
                                                                  xmlNodePtr node);
+XMLSEC_EXPORT int               xmlSecEncCtxXmlEncryptNodes     (xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 xmlNodePtr* nodes,
+                                                                 xmlSecSize nodesSize);
 XMLSEC_EXPORT int               xmlSecEncCtxUriEncrypt          (xmlSecEncCtxPtr encCtx,
                                                                  xmlNodePtr tmpl,
                                                                  const xmlChar *uri);
+XMLSEC_EXPORT int               xmlSecEncCtxBinaryEncryptToOutput(xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize,
+                                                                 xmlOutputBufferPtr output);
+XMLSEC_EXPORT int               xmlSecEncCtxUriEncryptToOutput  (xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 const xmlChar *uri,
+                                                                 xmlOutputBufferPtr output);
 XMLSEC_EXPORT int               xmlSecEncCtxDecrypt             (xmlSecEncCtxPtr encCtx,
                                                                  xmlNodePtr node);
 XMLSEC_EXPORT xmlSecBufferPtr   xmlSecEncCtxDecryptToBuffer     (xmlSecEncCtxPtr encCtx,
                                                                  xmlNodePtr node                );
+XMLSEC_EXPORT int               xmlSecEncCtxDecryptToCallback   (xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr node,
+                                                                 xmlSecTransformCtxResultCallback callback,
+                                                                 void* context);
 XMLSEC_EXPORT void              xmlSecEncCtxDebugDump           (xmlSecEncCtxPtr encCtx,
                                                                  FILE* output);
 XMLSEC_EXPORT void              xmlSecEncCtxDebugXmlDump        (xmlSecEncCtxPtr encCtx,
@@ -0,0 +1,1453 @@
+/**
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Binary Keys Store.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2016 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#include "globals.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define XMLSEC_BINARY_KEYS_STORE_MMAP   1
+#endif /* defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP) */
+
+#include <libxml/tree.h>
+#include <libxml/parser.h>
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/xmltree.h>
+#include <xmlsec/buffer.h>
+#include <xmlsec/list.h>
+#include <xmlsec/keys.h>
+#include <xmlsec/keyinfo.h>
+#include <xmlsec/keysmngr.h>
+#include <xmlsec/errors.h>
+#include <xmlsec/private/atomic.h>
+
+/****************************************************************************
+ *
+ * Binary Keys Store
+ *
+ * The keys file is mapped in memory (or read in one piece when mmap() is
+ * not available) and only the header and the records table are checked
+ * at load time. Every record carries everything #xmlSecKeyMatch looks at
+ * (name, key data id, type, usage and size), so the lookups never decode
+ * keys that do not match. A key is decoded the first time it is found
+ * and kept until the store is destroyed.
+ *
+ * All numbers are 32 bit unsigned little endian integers:
+ *
+ *   header:    "XMLSECK1", version, records number, records offset,
+ *              strings offset, strings size, values offset, values size,
+ *              reserved (0)
+ *   record:    name offset (or 0xFFFFFFFF for unnamed keys), name size,
+ *              key data id name offset, key data id name size, key type,
+ *              key usage, key size in bits, value encoding, value offset,
+ *              value size, position in the original keys list
+ *
+ * The strings and values offsets in the records are relative to the
+ * beginning of the corresponding section. The value is either the key
+ * data binary representation (#xmlSecKeyDataBinRead) or a standalone
+ * <dsig:KeyInfo/> document. The records are sorted by name (unnamed
+ * keys first) and then by position so a named lookup is a binary search
+ * and returns the same key as the simple keys store would.
+ *
+ ***************************************************************************/
+#define XMLSEC_BINARY_KEYS_STORE_MAGIC                  "XMLSECK1"
+#define XMLSEC_BINARY_KEYS_STORE_MAGIC_SIZE             8
+#define XMLSEC_BINARY_KEYS_STORE_VERSION                1
+#define XMLSEC_BINARY_KEYS_STORE_HEADER_SIZE            (XMLSEC_BINARY_KEYS_STORE_MAGIC_SIZE + 8 * 4)
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_SIZE            (11 * 4)
+#define XMLSEC_BINARY_KEYS_STORE_NO_NAME                0xFFFFFFFFU
+#define XMLSEC_BINARY_KEYS_STORE_NO_POS                 ((xmlSecSize)-1)
+
+#define XMLSEC_BINARY_KEYS_STORE_ENCODING_BINARY        1
+#define XMLSEC_BINARY_KEYS_STORE_ENCODING_KEYINFO       2
+
+/* header fields */
+#define XMLSEC_BINARY_KEYS_STORE_HEADER_VERSION         0
+#define XMLSEC_BINARY_KEYS_STORE_HEADER_RECORDS_NUMBER  1
+#define XMLSEC_BINARY_KEYS_STORE_HEADER_RECORDS_OFFSET  2
+#define XMLSEC_BINARY_KEYS_STORE_HEADER_STRINGS_OFFSET  3
+#define XMLSEC_BINARY_KEYS_STORE_HEADER_STRINGS_SIZE    4
+#define XMLSEC_BINARY_KEYS_STORE_HEADER_VALUES_OFFSET   5
+#define XMLSEC_BINARY_KEYS_STORE_HEADER_VALUES_SIZE     6
+
+/* record fields */
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_OFFSET     0
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_SIZE       1
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_ID_OFFSET       2
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_ID_SIZE         3
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_TYPE            4
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_USAGE           5
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_BITS            6
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_ENCODING        7
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_VALUE_OFFSET    8
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_VALUE_SIZE      9
+#define XMLSEC_BINARY_KEYS_STORE_RECORD_POSITION        10
+
+#define xmlSecBinaryKeysStoreHeaderGet(ctx, field) \
+    xmlSecBinaryKeysStoreGetUInt32((ctx)->data + XMLSEC_BINARY_KEYS_STORE_MAGIC_SIZE + 4 * (field))
+#define xmlSecBinaryKeysStoreRecordGet(ctx, pos, field) \
+    xmlSecBinaryKeysStoreGetUInt32((ctx)->records + XMLSEC_BINARY_KEYS_STORE_RECORD_SIZE * (pos) + 4 * (field))
+
+typedef struct _xmlSecBinaryKeysStoreCtx {
+    xmlSecByte*                 data;           /* the keys file content */
+    xmlSecSize                  dataSize;
+    int                         mapped;         /* data is mmap()-ed rather than allocated */
+    const xmlSecByte*           records;
+    xmlSecSize                  recordsNumber;
+    const xmlSecByte*           strings;
+    const xmlSecByte*           values;
+    xmlSecKeyPtr volatile*      keys;           /* keys decoded on the first lookup */
+} xmlSecBinaryKeysStoreCtx, *xmlSecBinaryKeysStoreCtxPtr;
+
+#define xmlSecBinaryKeysStoreSize \
+        (sizeof(xmlSecKeyStore) + sizeof(xmlSecBinaryKeysStoreCtx))
+#define xmlSecBinaryKeysStoreGetCtx(store) \
+    ((xmlSecKeyStoreCheckSize((store), xmlSecBinaryKeysStoreSize)) ? \
+        (xmlSecBinaryKeysStoreCtxPtr)(((xmlSecByte*)(store)) + sizeof(xmlSecKeyStore)) : \
+        (xmlSecBinaryKeysStoreCtxPtr)NULL)
+
+/* the record as it is being written */
+typedef struct _xmlSecBinaryKeysStoreRecord {
+    const xmlChar*              name;
+    xmlSecSize                  fields[XMLSEC_BINARY_KEYS_STORE_RECORD_SIZE / 4];
+} xmlSecBinaryKeysStoreRecord, *xmlSecBinaryKeysStoreRecordPtr;
+
+static int                      xmlSecBinaryKeysStoreInitialize (xmlSecKeyStorePtr store);
+static void                     xmlSecBinaryKeysStoreFinalize   (xmlSecKeyStorePtr store);
+static xmlSecKeyPtr             xmlSecBinaryKeysStoreFindKey    (xmlSecKeyStorePtr store,
+                                                                 const xmlChar* name,
+                                                                 xmlSecKeyInfoCtxPtr keyInfoCtx);
+
+static int                      xmlSecBinaryKeysStoreReadFile   (xmlSecKeyStorePtr store,
+                                                                 xmlSecBinaryKeysStoreCtxPtr ctx,
+                                                                 const char* filename);
+static int                      xmlSecBinaryKeysStoreCheckFile  (xmlSecKeyStorePtr store,
+                                                                 xmlSecBinaryKeysStoreCtxPtr ctx);
+static void                     xmlSecBinaryKeysStoreUnload     (xmlSecBinaryKeysStoreCtxPtr ctx);
+static xmlSecSize               xmlSecBinaryKeysStoreFindRecord (xmlSecBinaryKeysStoreCtxPtr ctx,
+                                                                 const xmlChar* name,
+                                                                 xmlSecKeyReqPtr keyReq);
+static int                      xmlSecBinaryKeysStoreMatchRecord(xmlSecBinaryKeysStoreCtxPtr ctx,
+                                                                 xmlSecSize pos,
+                                                                 xmlSecKeyReqPtr keyReq);
+static int                      xmlSecBinaryKeysStoreCompareRecordName
+                                                                (xmlSecBinaryKeysStoreCtxPtr ctx,
+                                                                 xmlSecSize pos,
+                                                                 const xmlSecByte* name,
+                                                                 xmlSecSize nameSize);
+static xmlSecKeyPtr             xmlSecBinaryKeysStoreGetKey     (xmlSecKeyStorePtr store,
+                                                                 xmlSecBinaryKeysStoreCtxPtr ctx,
+                                                                 xmlSecSize pos,
+                                                                 xmlSecKeysMngrPtr keysMngr);
+static xmlSecKeyPtr             xmlSecBinaryKeysStoreDecodeKey  (xmlSecSize encoding,
+                                                                 xmlSecKeyDataId dataId,
+                                                                 const xmlSecByte* value,
+                                                                 xmlSecSize valueSize,
+                                                                 xmlSecKeysMngrPtr keysMngr);
+static int                      xmlSecBinaryKeysStoreEncodeKey  (xmlSecKeyPtr key,
+                                                                 xmlSecKeyDataType type,
+                                                                 xmlSecBufferPtr values,
+                                                                 xmlSecSize* encoding);
+static int                      xmlSecBinaryKeysStoreAddString  (xmlSecBufferPtr strings,
+                                                                 const xmlChar* str,
+                                                                 xmlSecSize* offset,
+                                                                 xmlSecSize* size);
+static int                      xmlSecBinaryKeysStoreCompareRecords
+                                                                (const void* record1,
+                                                                 const void* record2);
+static int                      xmlSecBinaryKeysStoreCompareNames
+                                                                (const xmlSecByte* name1,
+                                                                 xmlSecSize nameSize1,
+                                                                 const xmlSecByte* name2,
+                                                                 xmlSecSize nameSize2);
+static xmlSecSize               xmlSecBinaryKeysStoreGetUInt32  (const xmlSecByte* buf);
+static int                      xmlSecBinaryKeysStoreAppendUInt32
+                                                                (xmlSecBufferPtr buf,
+                                                                 xmlSecSize val);
+
+static xmlSecKeyStoreKlass xmlSecBinaryKeysStoreKlass = {
+    sizeof(xmlSecKeyStoreKlass),
+    xmlSecBinaryKeysStoreSize,
+
+    /* data */
+    BAD_CAST "binary-keys-store",               /* const xmlChar* name; */
+
+    /* constructors/destructor */
+    xmlSecBinaryKeysStoreInitialize,            /* xmlSecKeyStoreInitializeMethod initialize; */
+    xmlSecBinaryKeysStoreFinalize,              /* xmlSecKeyStoreFinalizeMethod finalize; */
+    xmlSecBinaryKeysStoreFindKey,               /* xmlSecKeyStoreFindKeyMethod findKey; */
+
+    /* reserved for the future */
+    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* void* reserved1; */
+};
+
+/**
+ * xmlSecBinaryKeysStoreGetKlass:
+ *
+ * The binary keys store klass: a read-only keys store that looks up
+ * keys directly in a memory mapped keys file created with
+ * #xmlSecBinaryKeysStoreSaveKeys.
+ *
+ * Returns: binary keys store klass.
+ */
+xmlSecKeyStoreId
+xmlSecBinaryKeysStoreGetKlass(void) {
+    return(&xmlSecBinaryKeysStoreKlass);
+}
+
+/**
+ * xmlSecBinaryKeysStoreLoad:
+ * @store:              the pointer to binary keys store.
+ * @filename:           the filename.
+ *
+ * Maps the keys file created with #xmlSecBinaryKeysStoreSaveKeys in memory.
+ * Only the file structure is checked here, the keys are decoded when
+ * they are found for the first time. The keys file can be loaded only once
+ * and it should be done before @store is used from several threads.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecBinaryKeysStoreLoad(xmlSecKeyStorePtr store, const char *filename) {
+    xmlSecBinaryKeysStoreCtxPtr ctx;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecBinaryKeysStoreId), -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    ctx = xmlSecBinaryKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    if(ctx->data != NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_OPERATION,
+                    "keys file is already loaded");
+        return(-1);
+    }
+
+    ret = xmlSecBinaryKeysStoreReadFile(store, ctx, filename);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "xmlSecBinaryKeysStoreReadFile",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "filename=%s",
+                    xmlSecErrorsSafeString(filename));
+        return(-1);
+    }
+
+    ret = xmlSecBinaryKeysStoreCheckFile(store, ctx);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "xmlSecBinaryKeysStoreCheckFile",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "filename=%s",
+                    xmlSecErrorsSafeString(filename));
+        xmlSecBinaryKeysStoreUnload(ctx);
+        return(-1);
+    }
+
+    if(ctx->recordsNumber > 0) {
+        ctx->keys = (xmlSecKeyPtr volatile*)xmlMalloc(sizeof(xmlSecKeyPtr) * ctx->recordsNumber);
+        if(ctx->keys == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                        NULL,
+                        XMLSEC_ERRORS_R_MALLOC_FAILED,
+                        "size=%d", (int)ctx->recordsNumber);
+            xmlSecBinaryKeysStoreUnload(ctx);
+            return(-1);
+        }
+        memset((void*)ctx->keys, 0, sizeof(xmlSecKeyPtr) * ctx->recordsNumber);
+    }
+    return(0);
+}
+
+/**
+ * xmlSecBinaryKeysStoreSaveKeys:
+ * @keys:               the pointer to keys list (see #xmlSecSimpleKeysStoreGetKeys).
+ * @filename:           the filename.
+ * @type:               the saved keys type (public, private, ...).
+ * @keysMngr:           the pointer to associated keys manager used to read
+ *                      the written keys back.
+ *
+ * Writes @keys in the binary keys file that can be loaded in the
+ * binary keys store with #xmlSecBinaryKeysStoreLoad. Every key is
+ * read back after it is written so the records describe exactly the
+ * key that the store will return; keys that can not be read back (for
+ * example, keys of a different @type) are skipped.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecBinaryKeysStoreSaveKeys(xmlSecPtrListPtr keys, const char *filename,
+                              xmlSecKeyDataType type, xmlSecKeysMngrPtr keysMngr) {
+    xmlSecBinaryKeysStoreRecordPtr records = NULL;
+    xmlSecSize recordsNumber = 0;
+    xmlSecBuffer strings, values, file;
+    xmlSecKeyPtr key, readKey;
+    xmlSecKeyDataPtr value;
+    xmlSecSize keysSize, i, j;
+    xmlSecSize valueOffset, encoding;
+    xmlSecSize recordsOffset, stringsOffset, valuesOffset;
+    FILE* f;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(xmlSecPtrListCheckId(keys, xmlSecKeyPtrListId), -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    ret = xmlSecBufferInitialize(&strings, 0);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecBufferInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    ret = xmlSecBufferInitialize(&values, 0);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecBufferInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecBufferFinalize(&strings);
+        return(-1);
+    }
+    ret = xmlSecBufferInitialize(&file, 0);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecBufferInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecBufferFinalize(&values);
+        xmlSecBufferFinalize(&strings);
+        return(-1);
+    }
+
+    keysSize = xmlSecPtrListGetSize(keys);
+    if(keysSize > 0) {
+        records = (xmlSecBinaryKeysStoreRecordPtr)xmlMalloc(sizeof(xmlSecBinaryKeysStoreRecord) * keysSize);
+        if(records == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                        NULL,
+                        XMLSEC_ERRORS_R_MALLOC_FAILED,
+                        "size=%d", (int)keysSize);
+            goto done;
+        }
+        memset(records, 0, sizeof(xmlSecBinaryKeysStoreRecord) * keysSize);
+    }
+
+    for(i = 0; i < keysSize; ++i) {
+        key = (xmlSecKeyPtr)xmlSecPtrListGetItem(keys, i);
+        if(!xmlSecKeyIsValid(key)) {
+            continue;
+        }
+
+        valueOffset = xmlSecBufferGetSize(&values);
+        ret = xmlSecBinaryKeysStoreEncodeKey(key, type, &values, &encoding);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                        "xmlSecBinaryKeysStoreEncodeKey",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "key=%s",
+                        xmlSecErrorsSafeString(xmlSecKeyGetName(key)));
+            goto done;
+        }
+
+        /* read the key back exactly as the store will do it */
+        value = xmlSecKeyGetValue(key);
+        readKey = xmlSecBinaryKeysStoreDecodeKey(encoding, value->id,
+                        xmlSecBufferGetData(&values) + valueOffset,
+                        xmlSecBufferGetSize(&values) - valueOffset,
+                        keysMngr);
+        if(readKey == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                        "xmlSecBinaryKeysStoreDecodeKey",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "key=%s",
+                        xmlSecErrorsSafeString(xmlSecKeyGetName(key)));
+            goto done;
+        }
+        if(!xmlSecKeyIsValid(readKey)) {
+            /* nothing was written for this key type, just ignore it */
+            xmlSecKeyDestroy(readKey);
+            xmlSecBufferRemoveTail(&values, xmlSecBufferGetSize(&values) - valueOffset);
+            continue;
+        }
+
+        records[recordsNumber].name = xmlSecKeyGetName(key);
+        if(records[recordsNumber].name != NULL) {
+            ret = xmlSecBinaryKeysStoreAddString(&strings, records[recordsNumber].name,
+                        &(records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_OFFSET]),
+                        &(records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_SIZE]));
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                            "xmlSecBinaryKeysStoreAddString",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                xmlSecKeyDestroy(readKey);
+                goto done;
+            }
+        } else {
+            records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_OFFSET] = XMLSEC_BINARY_KEYS_STORE_NO_NAME;
+            records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_SIZE] = 0;
+        }
+
+        ret = xmlSecBinaryKeysStoreAddString(&strings, xmlSecKeyDataGetName(xmlSecKeyGetValue(readKey)),
+                    &(records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_ID_OFFSET]),
+                    &(records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_ID_SIZE]));
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                        "xmlSecBinaryKeysStoreAddString",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            xmlSecKeyDestroy(readKey);
+            goto done;
+        }
+
+        records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_TYPE] = xmlSecKeyGetType(readKey);
+        records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_USAGE] = key->usage;
+        records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_BITS] = xmlSecKeyDataGetSize(xmlSecKeyGetValue(readKey));
+        records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_ENCODING] = encoding;
+        records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_VALUE_OFFSET] = valueOffset;
+        records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_VALUE_SIZE] = xmlSecBufferGetSize(&values) - valueOffset;
+        records[recordsNumber].fields[XMLSEC_BINARY_KEYS_STORE_RECORD_POSITION] = i;
+        ++recordsNumber;
+
+        xmlSecKeyDestroy(readKey);
+    }
+
+    if(recordsNumber > 1) {
+        qsort(records, recordsNumber, sizeof(xmlSecBinaryKeysStoreRecord),
+              xmlSecBinaryKeysStoreCompareRecords);
+    }
+
+    /* header */
+    recordsOffset = XMLSEC_BINARY_KEYS_STORE_HEADER_SIZE;
+    stringsOffset = recordsOffset + XMLSEC_BINARY_KEYS_STORE_RECORD_SIZE * recordsNumber;
+    valuesOffset  = stringsOffset + xmlSecBufferGetSize(&strings);
+
+    ret = xmlSecBufferAppend(&file, (const xmlSecByte*)XMLSEC_BINARY_KEYS_STORE_MAGIC,
+                             XMLSEC_BINARY_KEYS_STORE_MAGIC_SIZE);
+    if((ret < 0) ||
+       (xmlSecBinaryKeysStoreAppendUInt32(&file, XMLSEC_BINARY_KEYS_STORE_VERSION) < 0) ||
+       (xmlSecBinaryKeysStoreAppendUInt32(&file, recordsNumber) < 0) ||
+       (xmlSecBinaryKeysStoreAppendUInt32(&file, recordsOffset) < 0) ||
+       (xmlSecBinaryKeysStoreAppendUInt32(&file, stringsOffset) < 0) ||
+       (xmlSecBinaryKeysStoreAppendUInt32(&file, xmlSecBufferGetSize(&strings)) < 0) ||
+       (xmlSecBinaryKeysStoreAppendUInt32(&file, valuesOffset) < 0) ||
+       (xmlSecBinaryKeysStoreAppendUInt32(&file, xmlSecBufferGetSize(&values)) < 0) ||
+       (xmlSecBinaryKeysStoreAppendUInt32(&file, 0) < 0)) {
+
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecBufferAppend",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+
+    /* records */
+    for(i = 0; i < recordsNumber; ++i) {
+        for(j = 0; j < XMLSEC_BINARY_KEYS_STORE_RECORD_SIZE / 4; ++j) {
+            ret = xmlSecBinaryKeysStoreAppendUInt32(&file, records[i].fields[j]);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                            "xmlSecBinaryKeysStoreAppendUInt32",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                goto done;
+            }
+        }
+    }
+
+    /* strings and values */
+    ret = xmlSecBufferAppend(&file, xmlSecBufferGetData(&strings), xmlSecBufferGetSize(&strings));
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecBufferAppend",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "size=%d", (int)xmlSecBufferGetSize(&strings));
+        goto done;
+    }
+    ret = xmlSecBufferAppend(&file, xmlSecBufferGetData(&values), xmlSecBufferGetSize(&values));
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecBufferAppend",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "size=%d", (int)xmlSecBufferGetSize(&values));
+        goto done;
+    }
+
+    /* now write result */
+    f = fopen(filename, "wb");
+    if(f == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "fopen",
+                    XMLSEC_ERRORS_R_IO_FAILED,
+                    "filename=%s;errno=%d",
+                    xmlSecErrorsSafeString(filename),
+                    errno);
+        goto done;
+    }
+    if(fwrite(xmlSecBufferGetData(&file), 1, xmlSecBufferGetSize(&file), f) != xmlSecBufferGetSize(&file)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "fwrite",
+                    XMLSEC_ERRORS_R_IO_FAILED,
+                    "filename=%s;errno=%d",
+                    xmlSecErrorsSafeString(filename),
+                    errno);
+        fclose(f);
+        goto done;
+    }
+    if(fclose(f) != 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "fclose",
+                    XMLSEC_ERRORS_R_IO_FAILED,
+                    "filename=%s;errno=%d",
+                    xmlSecErrorsSafeString(filename),
+                    errno);
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(records != NULL) {
+        xmlFree(records);
+    }
+    xmlSecBufferFinalize(&file);
+    xmlSecBufferFinalize(&values);
+    xmlSecBufferFinalize(&strings);
+    return(res);
+}
+
+static int
+xmlSecBinaryKeysStoreInitialize(xmlSecKeyStorePtr store) {
+    xmlSecBinaryKeysStoreCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecBinaryKeysStoreId), -1);
+
+    ctx = xmlSecBinaryKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    memset(ctx, 0, sizeof(xmlSecBinaryKeysStoreCtx));
+    return(0);
+}
+
+static void
+xmlSecBinaryKeysStoreFinalize(xmlSecKeyStorePtr store) {
+    xmlSecBinaryKeysStoreCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyStoreCheckId(store, xmlSecBinaryKeysStoreId));
+
+    ctx = xmlSecBinaryKeysStoreGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    xmlSecBinaryKeysStoreUnload(ctx);
+}
+
+static xmlSecKeyPtr
+xmlSecBinaryKeysStoreFindKey(xmlSecKeyStorePtr store, const xmlChar* name,
+                             xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecBinaryKeysStoreCtxPtr ctx;
+    xmlSecKeyPtr key;
+    xmlSecSize pos;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecBinaryKeysStoreId), NULL);
+    xmlSecAssert2(keyInfoCtx != NULL, NULL);
+
+    ctx = xmlSecBinaryKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    pos = xmlSecBinaryKeysStoreFindRecord(ctx, name, &(keyInfoCtx->keyReq));
+    if(pos == XMLSEC_BINARY_KEYS_STORE_NO_POS) {
+        return(NULL);
+    }
+
+    key = xmlSecBinaryKeysStoreGetKey(store, ctx, pos, keyInfoCtx->keysMngr);
+    if(key == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "xmlSecBinaryKeysStoreGetKey",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "name=%s",
+                    xmlSecErrorsSafeString(name));
+        return(NULL);
+    }
+    return(xmlSecKeyReference(key));
+}
+
+static int
+xmlSecBinaryKeysStoreReadFile(xmlSecKeyStorePtr store, xmlSecBinaryKeysStoreCtxPtr ctx,
+                              const char* filename) {
+#ifdef XMLSEC_BINARY_KEYS_STORE_MMAP
+    struct stat st;
+    void* data;
+    int fd;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->data == NULL, -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "open",
+                    XMLSEC_ERRORS_R_IO_FAILED,
+                    "filename=%s;errno=%d",
+                    xmlSecErrorsSafeString(filename),
+                    errno);
+        return(-1);
+    }
+    if(fstat(fd, &st) != 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "fstat",
+                    XMLSEC_ERRORS_R_IO_FAILED,
+                    "filename=%s;errno=%d",
+                    xmlSecErrorsSafeString(filename),
+                    errno);
+        close(fd);
+        return(-1);
+    }
+    if((st.st_size < XMLSEC_BINARY_KEYS_STORE_HEADER_SIZE) ||
+       ((off_t)((xmlSecSize)st.st_size) != st.st_size)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_SIZE,
+                    "filename=%s;size=%ld",
+                    xmlSecErrorsSafeString(filename),
+                    (long)st.st_size);
+        close(fd);
+        return(-1);
+    }
+
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "mmap",
+                    XMLSEC_ERRORS_R_IO_FAILED,
+                    "filename=%s;errno=%d",
+                    xmlSecErrorsSafeString(filename),
+                    errno);
+        close(fd);
+        return(-1);
+    }
+    close(fd);
+
+    ctx->data     = (xmlSecByte*)data;
+    ctx->dataSize = (xmlSecSize)st.st_size;
+    ctx->mapped   = 1;
+    return(0);
+#else  /* XMLSEC_BINARY_KEYS_STORE_MMAP */
+    xmlSecByte* data;
+    long size;
+    FILE* f;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->data == NULL, -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    f = fopen(filename, "rb");
+    if(f == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "fopen",
+                    XMLSEC_ERRORS_R_IO_FAILED,
+                    "filename=%s;errno=%d",
+                    xmlSecErrorsSafeString(filename),
+                    errno);
+        return(-1);
+    }
+    if((fseek(f, 0, SEEK_END) != 0) || ((size = ftell(f)) < 0) || (fseek(f, 0, SEEK_SET) != 0)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "fseek",
+                    XMLSEC_ERRORS_R_IO_FAILED,
+                    "filename=%s;errno=%d",
+                    xmlSecErrorsSafeString(filename),
+                    errno);
+        fclose(f);
+        return(-1);
+    }
+    if((size < XMLSEC_BINARY_KEYS_STORE_HEADER_SIZE) || ((long)((xmlSecSize)size) != size)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_SIZE,
+                    "filename=%s;size=%ld",
+                    xmlSecErrorsSafeString(filename),
+                    size);
+        fclose(f);
+        return(-1);
+    }
+
+    data = (xmlSecByte*)xmlMalloc((size_t)size);
+    if(data == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_MALLOC_FAILED,
+                    "size=%ld", size);
+        fclose(f);
+        return(-1);
+    }
+    if(fread(data, 1, (size_t)size, f) != (size_t)size) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "fread",
+                    XMLSEC_ERRORS_R_IO_FAILED,
+                    "filename=%s;errno=%d",
+                    xmlSecErrorsSafeString(filename),
+                    errno);
+        xmlFree(data);
+        fclose(f);
+        return(-1);
+    }
+    fclose(f);
+
+    ctx->data     = data;
+    ctx->dataSize = (xmlSecSize)size;
+    ctx->mapped   = 0;
+    return(0);
+#endif /* XMLSEC_BINARY_KEYS_STORE_MMAP */
+}
+
+static int
+xmlSecBinaryKeysStoreCheckFile(xmlSecKeyStorePtr store, xmlSecBinaryKeysStoreCtxPtr ctx) {
+    xmlSecSize recordsOffset, stringsOffset, stringsSize, valuesOffset, valuesSize;
+    xmlSecSize offset, size, encoding, pos;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->data != NULL, -1);
+
+    if((ctx->dataSize < XMLSEC_BINARY_KEYS_STORE_HEADER_SIZE) ||
+       (memcmp(ctx->data, XMLSEC_BINARY_KEYS_STORE_MAGIC, XMLSEC_BINARY_KEYS_STORE_MAGIC_SIZE) != 0)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_FORMAT,
+                    "not a binary keys file");
+        return(-1);
+    }
+    if(xmlSecBinaryKeysStoreHeaderGet(ctx, XMLSEC_BINARY_KEYS_STORE_HEADER_VERSION) != XMLSEC_BINARY_KEYS_STORE_VERSION) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_FORMAT,
+                    "version=%d;expected=%d",
+                    (int)xmlSecBinaryKeysStoreHeaderGet(ctx, XMLSEC_BINARY_KEYS_STORE_HEADER_VERSION),
+                    XMLSEC_BINARY_KEYS_STORE_VERSION);
+        return(-1);
+    }
+
+    ctx->recordsNumber = xmlSecBinaryKeysStoreHeaderGet(ctx, XMLSEC_BINARY_KEYS_STORE_HEADER_RECORDS_NUMBER);
+    recordsOffset = xmlSecBinaryKeysStoreHeaderGet(ctx, XMLSEC_BINARY_KEYS_STORE_HEADER_RECORDS_OFFSET);
+    stringsOffset = xmlSecBinaryKeysStoreHeaderGet(ctx, XMLSEC_BINARY_KEYS_STORE_HEADER_STRINGS_OFFSET);
+    stringsSize   = xmlSecBinaryKeysStoreHeaderGet(ctx, XMLSEC_BINARY_KEYS_STORE_HEADER_STRINGS_SIZE);
+    valuesOffset  = xmlSecBinaryKeysStoreHeaderGet(ctx, XMLSEC_BINARY_KEYS_STORE_HEADER_VALUES_OFFSET);
+    valuesSize    = xmlSecBinaryKeysStoreHeaderGet(ctx, XMLSEC_BINARY_KEYS_STORE_HEADER_VALUES_SIZE);
+
+    if((recordsOffset > ctx->dataSize) ||
+       (ctx->recordsNumber > (ctx->dataSize - recordsOffset) / XMLSEC_BINARY_KEYS_STORE_RECORD_SIZE) ||
+       (stringsOffset > ctx->dataSize) || (stringsSize > ctx->dataSize - stringsOffset) ||
+       (valuesOffset > ctx->dataSize) || (valuesSize > ctx->dataSize - valuesOffset)) {
+
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_SIZE,
+                    "records or data sections are out of the file bounds");
+        return(-1);
+    }
+    ctx->records = ctx->data + recordsOffset;
+    ctx->strings = ctx->data + stringsOffset;
+    ctx->values  = ctx->data + valuesOffset;
+
+    for(pos = 0; pos < ctx->recordsNumber; ++pos) {
+        offset = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_OFFSET);
+        size   = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_SIZE);
+        if(((offset == XMLSEC_BINARY_KEYS_STORE_NO_NAME) && (size != 0)) ||
+           ((offset != XMLSEC_BINARY_KEYS_STORE_NO_NAME) && ((offset > stringsSize) || (size > stringsSize - offset)))) {
+            break;
+        }
+
+        offset = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_ID_OFFSET);
+        size   = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_ID_SIZE);
+        if((size == 0) || (offset > stringsSize) || (size > stringsSize - offset)) {
+            break;
+        }
+
+        offset = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_VALUE_OFFSET);
+        size   = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_VALUE_SIZE);
+        if((offset > valuesSize) || (size > valuesSize - offset)) {
+            break;
+        }
+
+        encoding = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_ENCODING);
+        if((encoding != XMLSEC_BINARY_KEYS_STORE_ENCODING_BINARY) &&
+           (encoding != XMLSEC_BINARY_KEYS_STORE_ENCODING_KEYINFO)) {
+            break;
+        }
+
+        /* binary search relies on the records order */
+        if(pos > 0) {
+            int cmp;
+
+            offset = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_OFFSET);
+            size   = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_SIZE);
+            cmp = xmlSecBinaryKeysStoreCompareRecordName(ctx, pos - 1,
+                    (offset != XMLSEC_BINARY_KEYS_STORE_NO_NAME) ? ctx->strings + offset : NULL,
+                    size);
+            if((cmp > 0) || ((cmp == 0) &&
+               (xmlSecBinaryKeysStoreRecordGet(ctx, pos - 1, XMLSEC_BINARY_KEYS_STORE_RECORD_POSITION) >=
+                xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_POSITION)))) {
+                break;
+            }
+        }
+    }
+    if(pos < ctx->recordsNumber) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_FORMAT,
+                    "record=%d is invalid", (int)pos);
+        return(-1);
+    }
+    return(0);
+}
+
+static void
+xmlSecBinaryKeysStoreUnload(xmlSecBinaryKeysStoreCtxPtr ctx) {
+    xmlSecSize pos;
+
+    xmlSecAssert(ctx != NULL);
+
+    if(ctx->keys != NULL) {
+        for(pos = 0; pos < ctx->recordsNumber; ++pos) {
+            if(ctx->keys[pos] != NULL) {
+                xmlSecKeyDestroy(ctx->keys[pos]);
+            }
+        }
+        xmlFree((void*)ctx->keys);
+    }
+    if(ctx->data != NULL) {
+#ifdef XMLSEC_BINARY_KEYS_STORE_MMAP
+        if(ctx->mapped) {
+            munmap(ctx->data, ctx->dataSize);
+        } else {
+            xmlFree(ctx->data);
+        }
+#else  /* XMLSEC_BINARY_KEYS_STORE_MMAP */
+        xmlFree(ctx->data);
+#endif /* XMLSEC_BINARY_KEYS_STORE_MMAP */
+    }
+    memset(ctx, 0, sizeof(xmlSecBinaryKeysStoreCtx));
+}
+
+static xmlSecSize
+xmlSecBinaryKeysStoreFindRecord(xmlSecBinaryKeysStoreCtxPtr ctx, const xmlChar* name,
+                                xmlSecKeyReqPtr keyReq) {
+    xmlSecSize nameSize, pos, first, last, middle;
+    xmlSecSize res, resPosition, position;
+
+    xmlSecAssert2(ctx != NULL, XMLSEC_BINARY_KEYS_STORE_NO_POS);
+    xmlSecAssert2(keyReq != NULL, XMLSEC_BINARY_KEYS_STORE_NO_POS);
+
+    if(name == NULL) {
+        /* any key matches: take the first matching key in the original order */
+        res = XMLSEC_BINARY_KEYS_STORE_NO_POS;
+        resPosition = XMLSEC_BINARY_KEYS_STORE_NO_POS;
+        for(pos = 0; pos < ctx->recordsNumber; ++pos) {
+            position = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_POSITION);
+            if((position < resPosition) && (xmlSecBinaryKeysStoreMatchRecord(ctx, pos, keyReq) == 1)) {
+                res = pos;
+                resPosition = position;
+            }
+        }
+        return(res);
+    }
+
+    /* find the first record with this name */
+    nameSize = xmlStrlen(name);
+    first = 0;
+    last = ctx->recordsNumber;
+    while(first < last) {
+        middle = first + (last - first) / 2;
+        if(xmlSecBinaryKeysStoreCompareRecordName(ctx, middle, name, nameSize) < 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    /* records with the same name are in the original order */
+    for(pos = first; pos < ctx->recordsNumber; ++pos) {
+        if(xmlSecBinaryKeysStoreCompareRecordName(ctx, pos, name, nameSize) != 0) {
+            break;
+        }
+        if(xmlSecBinaryKeysStoreMatchRecord(ctx, pos, keyReq) == 1) {
+            return(pos);
+        }
+    }
+    return(XMLSEC_BINARY_KEYS_STORE_NO_POS);
+}
+
+/* same checks as xmlSecKeyReqMatchKey() but on the record fields */
+static int
+xmlSecBinaryKeysStoreMatchRecord(xmlSecBinaryKeysStoreCtxPtr ctx, xmlSecSize pos,
+                                 xmlSecKeyReqPtr keyReq) {
+    xmlSecSize bits;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(pos < ctx->recordsNumber, -1);
+    xmlSecAssert2(keyReq != NULL, -1);
+
+    if((keyReq->keyType != xmlSecKeyDataTypeUnknown) &&
+       ((xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_TYPE) & keyReq->keyType) == 0)) {
+        return(0);
+    }
+    if((keyReq->keyUsage != xmlSecKeyDataUsageUnknown) &&
+       ((xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_USAGE) & keyReq->keyUsage) == 0)) {
+        return(0);
+    }
+    if(keyReq->keyId != xmlSecKeyDataIdUnknown) {
+        xmlSecSize offset, size;
+
+        offset = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_ID_OFFSET);
+        size   = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_ID_SIZE);
+        if((keyReq->keyId->name == NULL) ||
+           ((xmlSecSize)xmlStrlen(keyReq->keyId->name) != size) ||
+           (memcmp(ctx->strings + offset, keyReq->keyId->name, size) != 0)) {
+            return(0);
+        }
+    }
+    bits = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_BITS);
+    if((keyReq->keyBitsSize > 0) && (bits > 0) && (bits < keyReq->keyBitsSize)) {
+        return(0);
+    }
+    return(1);
+}
+
+static int
+xmlSecBinaryKeysStoreCompareRecordName(xmlSecBinaryKeysStoreCtxPtr ctx, xmlSecSize pos,
+                                       const xmlSecByte* name, xmlSecSize nameSize) {
+    xmlSecSize offset, size;
+
+    xmlSecAssert2(ctx != NULL, 0);
+    xmlSecAssert2(pos < ctx->recordsNumber, 0);
+
+    offset = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_OFFSET);
+    size   = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_SIZE);
+    return(xmlSecBinaryKeysStoreCompareNames(
+                (offset != XMLSEC_BINARY_KEYS_STORE_NO_NAME) ? ctx->strings + offset : NULL,
+                size, name, nameSize));
+}
+
+static xmlSecKeyPtr
+xmlSecBinaryKeysStoreGetKey(xmlSecKeyStorePtr store, xmlSecBinaryKeysStoreCtxPtr ctx,
+                            xmlSecSize pos, xmlSecKeysMngrPtr keysMngr) {
+    xmlSecKeyDataId dataId = xmlSecKeyDataIdUnknown;
+    xmlSecKeyPtr key;
+    xmlSecSize offset, size, encoding;
+    xmlChar* str;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(ctx->keys != NULL, NULL);
+    xmlSecAssert2(pos < ctx->recordsNumber, NULL);
+
+    key = ctx->keys[pos];
+    if(key != NULL) {
+        return(key);
+    }
+
+    encoding = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_ENCODING);
+    if(encoding == XMLSEC_BINARY_KEYS_STORE_ENCODING_BINARY) {
+        offset = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_ID_OFFSET);
+        size   = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_ID_SIZE);
+        str = xmlStrndup(ctx->strings + offset, size);
+        if(str == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                        "xmlStrndup",
+                        XMLSEC_ERRORS_R_STRDUP_FAILED,
+                        "size=%d", (int)size);
+            return(NULL);
+        }
+        dataId = xmlSecKeyDataIdListFindByName(xmlSecKeyDataIdsGet(), str, xmlSecKeyDataUsageAny);
+        if(dataId == xmlSecKeyDataIdUnknown) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                        "xmlSecKeyDataIdListFindByName",
+                        XMLSEC_ERRORS_R_KEY_DATA_NOT_FOUND,
+                        "name=%s",
+                        xmlSecErrorsSafeString(str));
+            xmlFree(str);
+            return(NULL);
+        }
+        xmlFree(str);
+    }
+
+    key = xmlSecBinaryKeysStoreDecodeKey(encoding, dataId,
+                ctx->values + xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_VALUE_OFFSET),
+                xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_VALUE_SIZE),
+                keysMngr);
+    if(key == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "xmlSecBinaryKeysStoreDecodeKey",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "record=%d", (int)pos);
+        return(NULL);
+    }
+    if(!xmlSecKeyIsValid(key)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_KEY_DATA,
+                    "record=%d", (int)pos);
+        xmlSecKeyDestroy(key);
+        return(NULL);
+    }
+
+    offset = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_OFFSET);
+    if(offset != XMLSEC_BINARY_KEYS_STORE_NO_NAME) {
+        size = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_SIZE);
+        str = xmlStrndup(ctx->strings + offset, size);
+        if(str == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                        "xmlStrndup",
+                        XMLSEC_ERRORS_R_STRDUP_FAILED,
+                        "size=%d", (int)size);
+            xmlSecKeyDestroy(key);
+            return(NULL);
+        }
+
+        ret = xmlSecKeySetName(key, str);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                        "xmlSecKeySetName",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "name=%s",
+                        xmlSecErrorsSafeString(str));
+            xmlFree(str);
+            xmlSecKeyDestroy(key);
+            return(NULL);
+        }
+        xmlFree(str);
+    }
+    key->usage = xmlSecBinaryKeysStoreRecordGet(ctx, pos, XMLSEC_BINARY_KEYS_STORE_RECORD_USAGE);
+
+    /* somebody else could decode the same key in the meantime */
+    if(!XMLSEC_ATOMIC_CAS_PTR(&(ctx->keys[pos]), NULL, key)) {
+        xmlSecKeyDestroy(key);
+        key = ctx->keys[pos];
+    }
+    return(key);
+}
+
+static xmlSecKeyPtr
+xmlSecBinaryKeysStoreDecodeKey(xmlSecSize encoding, xmlSecKeyDataId dataId,
+                               const xmlSecByte* value, xmlSecSize valueSize,
+                               xmlSecKeysMngrPtr keysMngr) {
+    xmlSecKeyInfoCtx keyInfoCtx;
+    xmlSecKeyPtr key;
+    xmlDocPtr doc;
+    xmlNodePtr root;
+    int ret;
+
+    xmlSecAssert2(value != NULL, NULL);
+
+    key = xmlSecKeyCreate();
+    if(key == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecKeyCreate",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(NULL);
+    }
+
+    ret = xmlSecKeyInfoCtxInitialize(&keyInfoCtx, NULL);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecKeyInfoCtxInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecKeyDestroy(key);
+        return(NULL);
+    }
+
+    keyInfoCtx.mode           = xmlSecKeyInfoModeRead;
+    keyInfoCtx.keysMngr       = keysMngr;
+    keyInfoCtx.flags          = XMLSEC_KEYINFO_FLAGS_DONT_STOP_ON_KEY_FOUND |
+                                XMLSEC_KEYINFO_FLAGS_X509DATA_DONT_VERIFY_CERTS;
+    keyInfoCtx.keyReq.keyId   = xmlSecKeyDataIdUnknown;
+    keyInfoCtx.keyReq.keyType = xmlSecKeyDataTypeAny;
+    keyInfoCtx.keyReq.keyUsage= xmlSecKeyDataUsageAny;
+
+    switch(encoding) {
+    case XMLSEC_BINARY_KEYS_STORE_ENCODING_BINARY:
+        xmlSecAssert2(dataId != xmlSecKeyDataIdUnknown, NULL);
+
+        ret = xmlSecKeyDataBinRead(dataId, key, value, valueSize, &keyInfoCtx);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                        "xmlSecKeyDataBinRead",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "data=%s",
+                        xmlSecErrorsSafeString(xmlSecKeyDataKlassGetName(dataId)));
+            xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+            xmlSecKeyDestroy(key);
+            return(NULL);
+        }
+        break;
+    case XMLSEC_BINARY_KEYS_STORE_ENCODING_KEYINFO:
+        doc = xmlReadMemory((const char*)value, (int)valueSize, NULL, NULL, XML_PARSE_NONET);
+        if(doc == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                        "xmlReadMemory",
+                        XMLSEC_ERRORS_R_XML_FAILED,
+                        "size=%d", (int)valueSize);
+            xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+            xmlSecKeyDestroy(key);
+            return(NULL);
+        }
+
+        root = xmlDocGetRootElement(doc);
+        if(!xmlSecCheckNodeName(root, xmlSecNodeKeyInfo, xmlSecDSigNs)) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                        xmlSecErrorsSafeString(xmlSecNodeGetName(root)),
+                        XMLSEC_ERRORS_R_INVALID_NODE,
+                        "expected-node=%s",
+                        xmlSecErrorsSafeString(xmlSecNodeKeyInfo));
+            xmlFreeDoc(doc);
+            xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+            xmlSecKeyDestroy(key);
+            return(NULL);
+        }
+
+        ret = xmlSecKeyInfoNodeRead(root, key, &keyInfoCtx);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                        "xmlSecKeyInfoNodeRead",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            xmlFreeDoc(doc);
+            xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+            xmlSecKeyDestroy(key);
+            return(NULL);
+        }
+        xmlFreeDoc(doc);
+        break;
+    default:
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_FORMAT,
+                    "encoding=%d", (int)encoding);
+        xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+        xmlSecKeyDestroy(key);
+        return(NULL);
+    }
+
+    xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+    return(key);
+}
+
+static int
+xmlSecBinaryKeysStoreEncodeKey(xmlSecKeyPtr key, xmlSecKeyDataType type,
+                               xmlSecBufferPtr values, xmlSecSize* encoding) {
+    xmlSecKeyInfoCtx keyInfoCtx;
+    xmlSecKeyDataPtr value;
+    xmlSecKeyDataPtr data;
+    xmlSecPtrListPtr idsList;
+    xmlSecKeyDataId dataId;
+    xmlSecSize idsSize, j;
+    xmlSecByte* buf = NULL;
+    xmlSecSize bufSize = 0;
+    xmlChar* mem = NULL;
+    int memSize = 0;
+    xmlDocPtr doc;
+    xmlNodePtr root;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyIsValid(key), -1);
+    xmlSecAssert2(values != NULL, -1);
+    xmlSecAssert2(encoding != NULL, -1);
+
+    ret = xmlSecKeyInfoCtxInitialize(&keyInfoCtx, NULL);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecKeyInfoCtxInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    keyInfoCtx.mode                 = xmlSecKeyInfoModeWrite;
+    keyInfoCtx.keyReq.keyId         = xmlSecKeyDataIdUnknown;
+    keyInfoCtx.keyReq.keyType       = type;
+    keyInfoCtx.keyReq.keyUsage      = xmlSecKeyDataUsageAny;
+
+    /* the key value alone is stored in its binary form if possible */
+    value = xmlSecKeyGetValue(key);
+    if((value->id->binRead != NULL) && (value->id->binWrite != NULL) &&
+       ((key->dataList == NULL) || (xmlSecPtrListGetSize(key->dataList) == 0))) {
+
+        ret = xmlSecKeyDataBinWrite(value->id, key, &buf, &bufSize, &keyInfoCtx);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                        "xmlSecKeyDataBinWrite",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "data=%s",
+                        xmlSecErrorsSafeString(xmlSecKeyDataGetName(value)));
+            xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+            return(-1);
+        }
+        if(buf != NULL) {
+            ret = xmlSecBufferAppend(values, buf, bufSize);
+            memset(buf, 0, bufSize);
+            xmlFree(buf);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                            "xmlSecBufferAppend",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            "size=%d", (int)bufSize);
+                xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+                return(-1);
+            }
+            xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+            (*encoding) = XMLSEC_BINARY_KEYS_STORE_ENCODING_BINARY;
+            return(0);
+        }
+    }
+
+    /* otherwise write <dsig:KeyInfo/> without the key name (it is in the record) */
+    doc = xmlSecCreateTree(xmlSecNodeKeyInfo, xmlSecDSigNs);
+    if(doc == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecCreateTree",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+        return(-1);
+    }
+    root = xmlDocGetRootElement(doc);
+
+    idsList = xmlSecKeyDataIdsGet();
+    xmlSecAssert2(idsList != NULL, -1);
+
+    idsSize = xmlSecPtrListGetSize(idsList);
+    for(j = 0; j < idsSize; ++j) {
+        dataId = (xmlSecKeyDataId)xmlSecPtrListGetItem(idsList, j);
+        xmlSecAssert2(dataId != xmlSecKeyDataIdUnknown, -1);
+
+        if(dataId->dataNodeName == NULL) {
+            continue;
+        }
+
+        data = xmlSecKeyGetData(key, dataId);
+        if(data == NULL) {
+            continue;
+        }
+
+        if(xmlSecAddChild(root, dataId->dataNodeName, dataId->dataNodeNs) == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                        "xmlSecAddChild",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "node=%s",
+                        xmlSecErrorsSafeString(dataId->dataNodeName));
+            xmlFreeDoc(doc);
+            xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+            return(-1);
+        }
+    }
+
+    ret = xmlSecKeyInfoNodeWrite(root, key, &keyInfoCtx);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecKeyInfoNodeWrite",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlFreeDoc(doc);
+        xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+        return(-1);
+    }
+    xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+
+    xmlDocDumpMemory(doc, &mem, &memSize);
+    xmlFreeDoc(doc);
+    if((mem == NULL) || (memSize <= 0)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlDocDumpMemory",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        if(mem != NULL) {
+            xmlFree(mem);
+        }
+        return(-1);
+    }
+
+    ret = xmlSecBufferAppend(values, mem, (xmlSecSize)memSize);
+    memset(mem, 0, memSize);
+    xmlFree(mem);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecBufferAppend",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "size=%d", memSize);
+        return(-1);
+    }
+
+    (*encoding) = XMLSEC_BINARY_KEYS_STORE_ENCODING_KEYINFO;
+    return(0);
+}
+
+static int
+xmlSecBinaryKeysStoreAddString(xmlSecBufferPtr strings, const xmlChar* str,
+                               xmlSecSize* offset, xmlSecSize* size) {
+    int ret;
+
+    xmlSecAssert2(strings != NULL, -1);
+    xmlSecAssert2(str != NULL, -1);
+    xmlSecAssert2(offset != NULL, -1);
+    xmlSecAssert2(size != NULL, -1);
+
+    (*offset) = xmlSecBufferGetSize(strings);
+    (*size) = xmlStrlen(str);
+
+    ret = xmlSecBufferAppend(strings, str, (*size));
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreKlassGetName(xmlSecBinaryKeysStoreId)),
+                    "xmlSecBufferAppend",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "size=%d", (int)(*size));
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecBinaryKeysStoreCompareRecords(const void* record1, const void* record2) {
+    const xmlSecBinaryKeysStoreRecord* r1 = (const xmlSecBinaryKeysStoreRecord*)record1;
+    const xmlSecBinaryKeysStoreRecord* r2 = (const xmlSecBinaryKeysStoreRecord*)record2;
+    int cmp;
+
+    cmp = xmlSecBinaryKeysStoreCompareNames(
+                r1->name, r1->fields[XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_SIZE],
+                r2->name, r2->fields[XMLSEC_BINARY_KEYS_STORE_RECORD_NAME_SIZE]);
+    if(cmp != 0) {
+        return(cmp);
+    }
+    if(r1->fields[XMLSEC_BINARY_KEYS_STORE_RECORD_POSITION] < r2->fields[XMLSEC_BINARY_KEYS_STORE_RECORD_POSITION]) {
+        return(-1);
+    } else if(r1->fields[XMLSEC_BINARY_KEYS_STORE_RECORD_POSITION] > r2->fields[XMLSEC_BINARY_KEYS_STORE_RECORD_POSITION]) {
+        return(1);
+    }
+    return(0);
+}
+
+/* unnamed (NULL) keys go first, then the names bytes order */
+static int
+xmlSecBinaryKeysStoreCompareNames(const xmlSecByte* name1, xmlSecSize nameSize1,
+                                  const xmlSecByte* name2, xmlSecSize nameSize2) {
+    int cmp;
+
+    if(name1 == NULL) {
+        return((name2 == NULL) ? 0 : -1);
+    } else if(name2 == NULL) {
+        return(1);
+    }
+
+    cmp = memcmp(name1, name2, (nameSize1 < nameSize2) ? nameSize1 : nameSize2);
+    if(cmp != 0) {
+        return(cmp);
+    }
+    if(nameSize1 < nameSize2) {
+        return(-1);
+    } else if(nameSize1 > nameSize2) {
+        return(1);
+    }
+    return(0);
+}
+
+static xmlSecSize
+xmlSecBinaryKeysStoreGetUInt32(const xmlSecByte* buf) {
+    xmlSecAssert2(buf != NULL, 0);
+
+    return(((xmlSecSize)buf[0]) |
+           (((xmlSecSize)buf[1]) << 8) |
+           (((xmlSecSize)buf[2]) << 16) |
+           (((xmlSecSize)buf[3]) << 24));
+}
+
+static int
+xmlSecBinaryKeysStoreAppendUInt32(xmlSecBufferPtr buf, xmlSecSize val) {
+    xmlSecByte bytes[4];
+
+    xmlSecAssert2(buf != NULL, -1);
+
+    bytes[0] = (xmlSecByte)(val & 0xFF);
+    bytes[1] = (xmlSecByte)((val >> 8) & 0xFF);
+    bytes[2] = (xmlSecByte)((val >> 16) & 0xFF);
+    bytes[3] = (xmlSecByte)((val >> 24) & 0xFF);
+    return(xmlSecBufferAppend(buf, bytes, sizeof(bytes)));
+}
@@ -73,8 +73,10 @@ static xmlSecKeyDataStoreKlass xmlSecGnuTLSX509StoreKlass = {
     xmlSecGnuTLSX509StoreInitialize,            /* xmlSecKeyDataStoreInitializeMethod initialize; */
     xmlSecGnuTLSX509StoreFinalize,              /* xmlSecKeyDataStoreFinalizeMethod finalize; */
 
+    /* content changes tracking */
+    NULL,                                       /* xmlSecKeyDataStoreGetGenerationMethod getGeneration; */
+
     /* reserved for the future */
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -45,6 +45,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <libxml/tree.h>
 
@@ -57,6 +58,7 @@
 #include <xmlsec/xmlenc.h>
 #include <xmlsec/keyinfo.h>
 #include <xmlsec/errors.h>
+#include <xmlsec/private/atomic.h>
 
 
 /**************************************************************************
@@ -730,25 +732,26 @@ xmlSecKeyDataNameXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePtr node,
     }
 
     /* try to find key in the manager */
-    if((xmlSecKeyGetValue(key) == NULL) && (keyInfoCtx->keysMngr != NULL)) {
+    if((xmlSecKeyGetValue(key) == NULL) && (keyInfoCtx->keysMngr != NULL) &&
+       ((keyInfoCtx->flags & XMLSEC_KEYINFO_FLAGS_KEYNAME_DONT_FIND_KEY) == 0)) {
         xmlSecKeyPtr tmpKey;
 
-        tmpKey = xmlSecKeysMngrFindKey(keyInfoCtx->keysMngr, newName, keyInfoCtx);
+        if((keyInfoCtx->flags & XMLSEC_KEYINFO_FLAGS_KEYNAME_COPY_KEYS) != 0) {
+            tmpKey = xmlSecKeysMngrFindKey(keyInfoCtx->keysMngr, newName, keyInfoCtx);
+        } else {
+            tmpKey = xmlSecKeysMngrFindKeyShared(keyInfoCtx->keysMngr, newName, keyInfoCtx);
+        }
         if(tmpKey != NULL) {
             /* erase any current information in the key */
             xmlSecKeyEmpty(key);
 
-            /* TODO: since we will destroy tmpKey anyway, we can easily
-             * just re-assign key data values. It'll save use some memory
-             * malloc/free
-             */
-
-            /* and copy what we've found */
-            ret = xmlSecKeyCopy(key, tmpKey);
+            /* and share what we've found (the key data is copied only
+             * if the key is modified later) */
+            ret = xmlSecKeyCopyShared(key, tmpKey);
             if(ret < 0) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecKeyDataKlassGetName(id)),
-                            "xmlSecKeyCopy",
+                            "xmlSecKeyCopyShared",
                             XMLSEC_ERRORS_R_XMLSEC_FAILED,
                             XMLSEC_ERRORS_NO_MESSAGE);
                 xmlSecKeyDestroy(tmpKey);
@@ -1346,6 +1349,19 @@ static int      xmlSecKeyDataEncryptedKeyXmlWrite       (xmlSecKeyDataId id,
                                                          xmlNodePtr node,
                                                          xmlSecKeyInfoCtxPtr keyInfoCtx);
 
+static int      xmlSecEncryptedKeyCacheGetId            (xmlNodePtr node,
+                                                         xmlSecEncCtxPtr encCtx,
+                                                         xmlSecBufferPtr id);
+static int      xmlSecEncryptedKeyCacheFind             (xmlSecKeyDataStorePtr store,
+                                                         xmlSecBufferPtr id,
+                                                         unsigned long generation,
+                                                         xmlSecBufferPtr key);
+static int      xmlSecEncryptedKeyCacheAdd              (xmlSecKeyDataStorePtr store,
+                                                         xmlSecBufferPtr id,
+                                                         unsigned long generation,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize);
+
 
 
 static xmlSecKeyDataKlass xmlSecKeyDataEncryptedKeyKlass = {
@@ -1409,7 +1425,12 @@ xmlSecKeyDataEncryptedKeyGetKlass(void) {
 
 static int
 xmlSecKeyDataEncryptedKeyXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePtr node, xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecKeyDataStorePtr cache = NULL;
+    xmlSecBufferPtr cacheId = NULL;
+    xmlSecBufferPtr cachedKey = NULL;
+    unsigned long generation = 0;
     xmlSecBufferPtr result;
+    int res = -1;
     int ret;
 
     xmlSecAssert2(id == xmlSecKeyDataEncryptedKeyId, -1);
@@ -1442,11 +1463,81 @@ xmlSecKeyDataEncryptedKeyXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePt
                         "xmlSecKeyInfoCtxCreateEncCtx",
                         XMLSEC_ERRORS_R_XMLSEC_FAILED,
                         XMLSEC_ERRORS_NO_MESSAGE);
-            return(-1);
+            goto done;
         }
     }
     xmlSecAssert2(keyInfoCtx->encCtx != NULL, -1);
 
+    /* check if we already unwrapped this key */
+    if(keyInfoCtx->keysMngr != NULL) {
+        cache = xmlSecKeysMngrGetDataStore(keyInfoCtx->keysMngr, xmlSecKeyDataStoreEncryptedKeyCacheId);
+    }
+    if(cache != NULL) {
+        generation = xmlSecKeysMngrGetGeneration(keyInfoCtx->keysMngr);
+
+        cacheId = xmlSecBufferCreate(0);
+        if(cacheId == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataKlassGetName(id)),
+                        "xmlSecBufferCreate",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            goto done;
+        }
+
+        ret = xmlSecEncryptedKeyCacheGetId(node, keyInfoCtx->encCtx, cacheId);
+        xmlSecEncCtxReset(keyInfoCtx->encCtx);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataKlassGetName(id)),
+                        "xmlSecEncryptedKeyCacheGetId",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            goto done;
+        } else if(ret == 0) {
+            /* can't be cached */
+            xmlSecBufferDestroy(cacheId);
+            cacheId = NULL;
+        } else {
+            cachedKey = xmlSecBufferCreate(0);
+            if(cachedKey == NULL) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecKeyDataKlassGetName(id)),
+                            "xmlSecBufferCreate",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                goto done;
+            }
+
+            ret = xmlSecEncryptedKeyCacheFind(cache, cacheId, generation, cachedKey);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecKeyDataKlassGetName(id)),
+                            "xmlSecEncryptedKeyCacheFind",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                goto done;
+            } else if(ret > 0) {
+                ret = xmlSecKeyDataBinRead(keyInfoCtx->keyReq.keyId, key,
+                                       xmlSecBufferGetData(cachedKey),
+                                       xmlSecBufferGetSize(cachedKey),
+                                       keyInfoCtx);
+                if(ret < 0) {
+                    xmlSecError(XMLSEC_ERRORS_HERE,
+                                xmlSecErrorsSafeString(xmlSecKeyDataKlassGetName(id)),
+                                "xmlSecKeyDataBinRead",
+                                XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                                XMLSEC_ERRORS_NO_MESSAGE);
+                    goto done;
+                }
+                --keyInfoCtx->curEncryptedKeyLevel;
+
+                res = 0;
+                goto done;
+            }
+        }
+    }
+
     result = xmlSecEncCtxDecryptToBuffer(keyInfoCtx->encCtx, node);
     if((result == NULL) || (xmlSecBufferGetData(result) == NULL)) {
         /* We might have multiple EncryptedKey elements, encrypted
@@ -1459,9 +1550,10 @@ xmlSecKeyDataEncryptedKeyXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePt
                         "xmlSecEncCtxDecryptToBuffer",
                         XMLSEC_ERRORS_R_XMLSEC_FAILED,
                         XMLSEC_ERRORS_NO_MESSAGE);
-            return(-1);
+            goto done;
         }
-        return(0);
+        res = 0;
+        goto done;
     }
 
     ret = xmlSecKeyDataBinRead(keyInfoCtx->keyReq.keyId, key,
@@ -1474,11 +1566,36 @@ xmlSecKeyDataEncryptedKeyXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePt
                     "xmlSecKeyDataBinRead",
                     XMLSEC_ERRORS_R_XMLSEC_FAILED,
                     XMLSEC_ERRORS_NO_MESSAGE);
-        return(-1);
+        goto done;
     }
     --keyInfoCtx->curEncryptedKeyLevel;
 
-    return(0);
+    /* remember the unwrapped key */
+    if(cacheId != NULL) {
+        ret = xmlSecEncryptedKeyCacheAdd(cache, cacheId, generation,
+                            xmlSecBufferGetData(result),
+                            xmlSecBufferGetSize(result));
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataKlassGetName(id)),
+                        "xmlSecEncryptedKeyCacheAdd",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            goto done;
+        }
+    }
+
+    res = 0;
+
+done:
+    if(cachedKey != NULL) {
+        /* xmlSecBufferDestroy zeroes the data */
+        xmlSecBufferDestroy(cachedKey);
+    }
+    if(cacheId != NULL) {
+        xmlSecBufferDestroy(cacheId);
+    }
+    return(res);
 }
 
 static int
@@ -1566,5 +1683,710 @@ done:
     return(res);
 }
 
+
+/**************************************************************************
+ *
+ * <enc:EncryptedKey/> unwrap cache
+ *
+ *************************************************************************/
+typedef struct _xmlSecEncryptedKeyCacheItem             xmlSecEncryptedKeyCacheItem,
+                                                        *xmlSecEncryptedKeyCacheItemPtr;
+struct _xmlSecEncryptedKeyCacheItem {
+    unsigned int        hash;
+    time_t              created;
+    xmlSecBuffer        id;
+    xmlSecBuffer        key;
+};
+
+typedef struct _xmlSecEncryptedKeyCacheCtx              xmlSecEncryptedKeyCacheCtx,
+                                                        *xmlSecEncryptedKeyCacheCtxPtr;
+struct _xmlSecEncryptedKeyCacheCtx {
+    xmlSecEncryptedKeyCacheItemPtr      items;
+    xmlSecSize                          itemsSize;
+    unsigned int                        ttl;
+    unsigned long                       generation;     /* keys manager generation of the cached keys */
+    long volatile                       lock;
+};
+
+/* xmlSecEncryptedKeyCacheCtx is located after xmlSecKeyDataStore */
+#define xmlSecEncryptedKeyCacheGetCtx(store) \
+    ((xmlSecEncryptedKeyCacheCtxPtr)(((xmlSecByte*)(store)) + \
+                                    sizeof(xmlSecKeyDataStore)))
+#define xmlSecEncryptedKeyCacheSize      \
+    (sizeof(xmlSecKeyDataStore) + sizeof(xmlSecEncryptedKeyCacheCtx))
+
+#define XMLSEC_ENCRYPTED_KEY_CACHE_DEFAULT_SIZE         128
+#define XMLSEC_ENCRYPTED_KEY_CACHE_DEFAULT_TTL          300
+
+static int      xmlSecEncryptedKeyCacheInitialize       (xmlSecKeyDataStorePtr store);
+static void     xmlSecEncryptedKeyCacheFinalize         (xmlSecKeyDataStorePtr store);
+
+static void     xmlSecEncryptedKeyCacheItemsDestroy     (xmlSecEncryptedKeyCacheItemPtr items,
+                                                         xmlSecSize itemsSize);
+static void     xmlSecEncryptedKeyCacheEmpty            (xmlSecEncryptedKeyCacheCtxPtr ctx);
+static void     xmlSecEncryptedKeyCacheLock             (xmlSecEncryptedKeyCacheCtxPtr ctx);
+static void     xmlSecEncryptedKeyCacheUnlock           (xmlSecEncryptedKeyCacheCtxPtr ctx);
+
+static xmlSecKeyDataStoreKlass xmlSecEncryptedKeyCacheKlass = {
+    sizeof(xmlSecKeyDataStoreKlass),
+    xmlSecEncryptedKeyCacheSize,
+
+    /* data */
+    xmlSecNameEncryptedKeyCache,                /* const xmlChar* name; */
+
+    /* constructors/destructor */
+    xmlSecEncryptedKeyCacheInitialize,          /* xmlSecKeyDataStoreInitializeMethod initialize; */
+    xmlSecEncryptedKeyCacheFinalize,            /* xmlSecKeyDataStoreFinalizeMethod finalize; */
+
+    /* content changes tracking */
+    NULL,                                       /* xmlSecKeyDataStoreGetGenerationMethod getGeneration; */
+
+    /* reserved for the future */
+    NULL,                                       /* void* reserved1; */
+};
+
+/**
+ * xmlSecKeyDataStoreEncryptedKeyCacheGetKlass:
+ *
+ * The <enc:EncryptedKey/> unwrap cache klass. If a store of this klass is
+ * adopted by the keys manager then the <enc:EncryptedKey/> decryption
+ * results are cached so the same wrapped key received in different messages
+ * is decrypted only once. The EncryptionMethod and the recipient's key are
+ * still resolved and checked for every message: the cached keys are found
+ * by the CipherValue, the EncryptionMethod and the recipient's key name and
+ * key value digest. All the cached keys are dropped when the keys manager
+ * content changes (see #xmlSecKeysMngrGetGeneration) and zeroed when evicted.
+ * The cache is thread safe.
+ *
+ * Returns: the <enc:EncryptedKey/> unwrap cache klass.
+ */
+xmlSecKeyDataStoreId
+xmlSecKeyDataStoreEncryptedKeyCacheGetKlass(void) {
+    return(&xmlSecEncryptedKeyCacheKlass);
+}
+
+/**
+ * xmlSecKeyDataStoreEncryptedKeyCacheSetLimits:
+ * @store:              the pointer to <enc:EncryptedKey/> unwrap cache.
+ * @maxSize:            the max number of cached keys.
+ * @ttl:                the cached key lifetime in seconds (0 for unlimited).
+ *
+ * Sets the cache limits, all cached keys are dropped.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecKeyDataStoreEncryptedKeyCacheSetLimits(xmlSecKeyDataStorePtr store, xmlSecSize maxSize,
+                                             unsigned int ttl) {
+    xmlSecEncryptedKeyCacheCtxPtr ctx;
+    xmlSecEncryptedKeyCacheItemPtr items, oldItems;
+    xmlSecSize oldItemsSize;
+    xmlSecSize ii;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreEncryptedKeyCacheId), -1);
+    xmlSecAssert2(maxSize > 0, -1);
+
+    ctx = xmlSecEncryptedKeyCacheGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    items = (xmlSecEncryptedKeyCacheItemPtr)xmlMalloc(sizeof(xmlSecEncryptedKeyCacheItem) * maxSize);
+    if(items == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_MALLOC_FAILED,
+                    "size=%d", maxSize);
+        return(-1);
+    }
+    memset(items, 0, sizeof(xmlSecEncryptedKeyCacheItem) * maxSize);
+
+    for(ii = 0; ii < maxSize; ++ii) {
+        ret = xmlSecBufferInitialize(&(items[ii].id), 0);
+        if(ret == 0) {
+            ret = xmlSecBufferInitialize(&(items[ii].key), 0);
+        }
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                        "xmlSecBufferInitialize",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            xmlSecEncryptedKeyCacheItemsDestroy(items, ii + 1);
+            return(-1);
+        }
+    }
+
+    /* swap and destroy the old items outside of the lock */
+    xmlSecEncryptedKeyCacheLock(ctx);
+    oldItems = ctx->items;
+    oldItemsSize = ctx->itemsSize;
+    ctx->items = items;
+    ctx->itemsSize = maxSize;
+    ctx->ttl = ttl;
+    xmlSecEncryptedKeyCacheUnlock(ctx);
+
+    if(oldItems != NULL) {
+        xmlSecEncryptedKeyCacheItemsDestroy(oldItems, oldItemsSize);
+    }
+    return(0);
+}
+
+/**
+ * xmlSecKeyDataStoreEncryptedKeyCacheFlush:
+ * @store:              the pointer to <enc:EncryptedKey/> unwrap cache.
+ *
+ * Removes (and zeroes) all the cached keys. The cache is flushed
+ * automatically when the keys manager content changes, the application
+ * should call this function if the recipient keys are changed by other
+ * means.
+ */
+void
+xmlSecKeyDataStoreEncryptedKeyCacheFlush(xmlSecKeyDataStorePtr store) {
+    xmlSecEncryptedKeyCacheCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreEncryptedKeyCacheId));
+
+    ctx = xmlSecEncryptedKeyCacheGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    xmlSecEncryptedKeyCacheLock(ctx);
+    xmlSecEncryptedKeyCacheEmpty(ctx);
+    xmlSecEncryptedKeyCacheUnlock(ctx);
+}
+
+static int
+xmlSecEncryptedKeyCacheInitialize(xmlSecKeyDataStorePtr store) {
+    xmlSecEncryptedKeyCacheCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreEncryptedKeyCacheId), -1);
+
+    ctx = xmlSecEncryptedKeyCacheGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    memset(ctx, 0, sizeof(xmlSecEncryptedKeyCacheCtx));
+    return(xmlSecKeyDataStoreEncryptedKeyCacheSetLimits(store,
+                XMLSEC_ENCRYPTED_KEY_CACHE_DEFAULT_SIZE,
+                XMLSEC_ENCRYPTED_KEY_CACHE_DEFAULT_TTL));
+}
+
+static void
+xmlSecEncryptedKeyCacheFinalize(xmlSecKeyDataStorePtr store) {
+    xmlSecEncryptedKeyCacheCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreEncryptedKeyCacheId));
+
+    ctx = xmlSecEncryptedKeyCacheGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    if(ctx->items != NULL) {
+        xmlSecEncryptedKeyCacheItemsDestroy(ctx->items, ctx->itemsSize);
+    }
+    memset(ctx, 0, sizeof(xmlSecEncryptedKeyCacheCtx));
+}
+
+static void
+xmlSecEncryptedKeyCacheItemsDestroy(xmlSecEncryptedKeyCacheItemPtr items, xmlSecSize itemsSize) {
+    xmlSecSize ii;
+
+    xmlSecAssert(items != NULL);
+
+    for(ii = 0; ii < itemsSize; ++ii) {
+        /* xmlSecBufferFinalize zeroes the data */
+        xmlSecBufferFinalize(&(items[ii].id));
+        xmlSecBufferFinalize(&(items[ii].key));
+    }
+    xmlFree(items);
+}
+
+/* the caller is responsible for locking the cache */
+static void
+xmlSecEncryptedKeyCacheEmpty(xmlSecEncryptedKeyCacheCtxPtr ctx) {
+    xmlSecSize ii;
+
+    xmlSecAssert(ctx != NULL);
+
+    for(ii = 0; ii < ctx->itemsSize; ++ii) {
+        xmlSecBufferEmpty(&(ctx->items[ii].id));
+        xmlSecBufferEmpty(&(ctx->items[ii].key));
+        ctx->items[ii].hash = 0;
+        ctx->items[ii].created = 0;
+    }
+}
+
+static void
+xmlSecEncryptedKeyCacheLock(xmlSecEncryptedKeyCacheCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+
+    XMLSEC_SPIN_LOCK(&(ctx->lock));
+}
+
+static void
+xmlSecEncryptedKeyCacheUnlock(xmlSecEncryptedKeyCacheCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+
+    XMLSEC_SPIN_UNLOCK(&(ctx->lock));
+}
+
+/* FNV-1a, only used to skip the full id comparison */
+static unsigned int
+xmlSecEncryptedKeyCacheHash(const xmlSecByte* data, xmlSecSize dataSize) {
+    unsigned int hash = 2166136261U;
+    xmlSecSize ii;
+
+    for(ii = 0; ii < dataSize; ++ii) {
+        hash ^= data[ii];
+        hash *= 16777619U;
+    }
+    return(hash);
+}
+
+static int
+xmlSecEncryptedKeyCacheAppendString(xmlSecBufferPtr id, const xmlChar* str) {
+    static const xmlSecByte separator = '\0';
+    int ret;
+
+    xmlSecAssert2(id != NULL, -1);
+
+    if(str != NULL) {
+        ret = xmlSecBufferAppend(id, str, xmlStrlen(str));
+        if(ret < 0) {
+            return(-1);
+        }
+    }
+    return(xmlSecBufferAppend(id, &separator, 1));
+}
+
+static int
+xmlSecEncryptedKeyCacheAppendNode(xmlSecBufferPtr id, xmlNodePtr node) {
+    xmlBufferPtr buf;
+    int ret;
+
+    xmlSecAssert2(id != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    buf = xmlBufferCreate();
+    if(buf == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlBufferCreate",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlNodeDump(buf, node->doc, node, 0, 0);
+    if(ret >= 0) {
+        ret = xmlSecEncryptedKeyCacheAppendString(id, xmlBufferContent(buf));
+    }
+    xmlBufferFree(buf);
+    return((ret >= 0) ? 0 : -1);
+}
+
+/*
+ * Appends SHA-256 digest of @data to @id. Returns 1 on success, 0 if
+ * SHA-256 is not available or a negative value if an error occurs.
+ */
+static int
+xmlSecEncryptedKeyCacheAppendDigest(xmlSecBufferPtr id, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecTransformCtx transformCtx;
+    xmlSecTransformId digestId;
+    xmlSecTransformPtr digest;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(id != NULL, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    digestId = xmlSecTransformIdListFindByHref(xmlSecTransformIdsGet(), xmlSecHrefSha256,
+                                               xmlSecTransformUsageDigestMethod);
+    if(digestId == xmlSecTransformIdUnknown) {
+        return(0);
+    }
+
+    ret = xmlSecTransformCtxInitialize(&transformCtx);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecTransformCtxInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    digest = xmlSecTransformCtxCreateAndAppend(&transformCtx, digestId);
+    if(digest == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecTransformCtxCreateAndAppend",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "transform=%s",
+                    xmlSecErrorsSafeString(xmlSecTransformKlassGetName(digestId)));
+        goto done;
+    }
+    digest->operation = xmlSecTransformOperationSign;
+
+    ret = xmlSecTransformCtxBinaryExecute(&transformCtx, data, dataSize);
+    if((ret < 0) || (transformCtx.result == NULL)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecTransformCtxBinaryExecute",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+
+    ret = xmlSecBufferAppend(id, xmlSecBufferGetData(transformCtx.result),
+                             xmlSecBufferGetSize(transformCtx.result));
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecBufferAppend",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "size=%d", xmlSecBufferGetSize(transformCtx.result));
+        goto done;
+    }
+    res = 1;
+
+done:
+    xmlSecTransformCtxFinalize(&transformCtx);
+    return(res);
+}
+
+/*
+ * Appends the recipient @key identity (the key name and the key value
+ * digest) to @id. Returns 1 on success, 0 if the key value can't be
+ * written out or a negative value if an error occurs.
+ */
+static int
+xmlSecEncryptedKeyCacheAppendKey(xmlSecBufferPtr id, xmlSecKeyPtr key) {
+    xmlSecKeyInfoCtx keyInfoCtx;
+    xmlSecKeyDataPtr value;
+    xmlNodePtr keyValueNode = NULL;
+    xmlNodePtr cur;
+    xmlBufferPtr buf = NULL;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(id != NULL, -1);
+    xmlSecAssert2(key != NULL, -1);
+
+    ret = xmlSecEncryptedKeyCacheAppendString(id, xmlSecKeyGetName(key));
+    if(ret < 0) {
+        return(-1);
+    }
+
+    value = xmlSecKeyGetValue(key);
+    if((value == NULL) || (value->id->xmlWrite == NULL)) {
+        return(0);
+    }
+
+    ret = xmlSecKeyInfoCtxInitialize(&keyInfoCtx, NULL);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeyInfoCtxInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    keyInfoCtx.mode = xmlSecKeyInfoModeWrite;
+    keyInfoCtx.keyReq.keyType = xmlSecKeyDataTypePublic | xmlSecKeyDataTypeSymmetric;
+
+    keyValueNode = xmlNewNode(NULL, xmlSecNodeKeyValue);
+    if(keyValueNode == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlNewNode",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    "node=%s",
+                    xmlSecErrorsSafeString(xmlSecNodeKeyValue));
+        goto done;
+    }
+
+    /* the key that can't be written out is not cached */
+    ret = xmlSecKeyDataXmlWrite(value->id, key, keyValueNode, &keyInfoCtx);
+    if((ret < 0) || (keyValueNode->children == NULL)) {
+        res = 0;
+        goto done;
+    }
+
+    buf = xmlBufferCreate();
+    if(buf == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlBufferCreate",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+
+    ret = xmlNodeDump(buf, NULL, keyValueNode, 0, 0);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlNodeDump",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+
+    res = xmlSecEncryptedKeyCacheAppendDigest(id, xmlBufferContent(buf), xmlBufferLength(buf));
+
+done:
+    /* the symmetric key value is written as is */
+    if(buf != NULL) {
+        memset((xmlChar*)xmlBufferContent(buf), 0, xmlBufferLength(buf));
+        xmlBufferFree(buf);
+    }
+    if(keyValueNode != NULL) {
+        for(cur = keyValueNode->children; cur != NULL; cur = cur->next) {
+            if((cur->type == XML_TEXT_NODE) && (cur->content != NULL)) {
+                memset(cur->content, 0, xmlStrlen(cur->content));
+            }
+        }
+        xmlFreeNode(keyValueNode);
+    }
+    xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+    return(res);
+}
+
+/*
+ * Builds the cache id for <enc:EncryptedKey/> @node. The EncryptionMethod
+ * is read and the recipient's key is resolved with @encCtx exactly like
+ * for the decryption thus the enabled transforms and the key requirements
+ * are enforced for the cached keys too. Returns 1 if the id is created,
+ * 0 if the node can't be cached (e.g. the EncryptionMethod or the recipient
+ * key is not found) or a negative value if an error occurs. The caller is
+ * responsible for resetting @encCtx.
+ */
+static int
+xmlSecEncryptedKeyCacheGetId(xmlNodePtr node, xmlSecEncCtxPtr encCtx, xmlSecBufferPtr id) {
+    xmlNodePtr cipherValueNode;
+    xmlNodePtr encMethodNode;
+    xmlSecTransformPtr encMethod = NULL;
+    xmlSecKeyPtr encKey = NULL;
+    xmlSecKeysMngrPtr keysMngr;
+    xmlChar* content;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(id != NULL, -1);
+
+    cipherValueNode = xmlSecFindChild(node, xmlSecNodeCipherData, xmlSecEncNs);
+    if(cipherValueNode != NULL) {
+        cipherValueNode = xmlSecFindChild(cipherValueNode, xmlSecNodeCipherValue, xmlSecEncNs);
+    }
+    encMethodNode = xmlSecFindChild(node, xmlSecNodeEncryptionMethod, xmlSecEncNs);
+    keysMngr = encCtx->keyInfoReadCtx.keysMngr;
+    if((cipherValueNode == NULL) || (encMethodNode == NULL) ||
+       (keysMngr == NULL) || (keysMngr->getKey == NULL)) {
+        return(0);
+    }
+
+    /* the disabled or unknown algorithms are reported by the decryption */
+    encMethod = xmlSecTransformNodeRead(encMethodNode, xmlSecTransformUsageEncryptionMethod,
+                                        &(encCtx->transformCtx));
+    if(encMethod == NULL) {
+        return(0);
+    }
+    encMethod->operation = xmlSecTransformOperationDecrypt;
+
+    ret = xmlSecTransformSetKeyReq(encMethod, &(encCtx->keyInfoReadCtx.keyReq));
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecTransformSetKeyReq",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "transform=%s",
+                    xmlSecErrorsSafeString(xmlSecTransformGetName(encMethod)));
+        goto done;
+    }
+
+    encKey = (keysMngr->getKey)(xmlSecFindChild(node, xmlSecNodeKeyInfo, xmlSecDSigNs),
+                                &(encCtx->keyInfoReadCtx));
+    if((encKey == NULL) || (!xmlSecKeyMatch(encKey, NULL, &(encCtx->keyInfoReadCtx.keyReq)))) {
+        res = 0;
+        goto done;
+    }
+
+    content = xmlNodeGetContent(cipherValueNode);
+    if(content == NULL) {
+        res = 0;
+        goto done;
+    }
+    ret = xmlSecEncryptedKeyCacheAppendString(id, content);
+    xmlFree(content);
+    if(ret < 0) {
+        goto done;
+    }
+
+    ret = xmlSecEncryptedKeyCacheAppendNode(id, encMethodNode);
+    if(ret < 0) {
+        goto done;
+    }
+
+    res = xmlSecEncryptedKeyCacheAppendKey(id, encKey);
+
+done:
+    if(encKey != NULL) {
+        xmlSecKeyDestroy(encKey);
+    }
+    if(encMethod != NULL) {
+        xmlSecTransformDestroy(encMethod);
+    }
+    return(res);
+}
+
+/*
+ * Copies the cached key for @id to @key. Returns 1 if the key is found,
+ * 0 if it is not or a negative value if an error occurs.
+ */
+static int
+xmlSecEncryptedKeyCacheFind(xmlSecKeyDataStorePtr store, xmlSecBufferPtr id,
+                            unsigned long generation, xmlSecBufferPtr key) {
+    xmlSecEncryptedKeyCacheCtxPtr ctx;
+    xmlSecEncryptedKeyCacheItemPtr item;
+    unsigned int hash;
+    time_t now;
+    xmlSecSize ii;
+    int res = 0;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreEncryptedKeyCacheId), -1);
+    xmlSecAssert2(id != NULL, -1);
+    xmlSecAssert2(key != NULL, -1);
+
+    ctx = xmlSecEncryptedKeyCacheGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    hash = xmlSecEncryptedKeyCacheHash(xmlSecBufferGetData(id), xmlSecBufferGetSize(id));
+    now = time(NULL);
+
+    xmlSecEncryptedKeyCacheLock(ctx);
+    /* the recipient keys might have changed */
+    if(ctx->generation != generation) {
+        xmlSecEncryptedKeyCacheEmpty(ctx);
+        ctx->generation = generation;
+    }
+
+    for(ii = 0; ii < ctx->itemsSize; ++ii) {
+        item = &(ctx->items[ii]);
+        if((item->created == 0) || (item->hash != hash)) {
+            continue;
+        }
+        if((xmlSecBufferGetSize(&(item->id)) != xmlSecBufferGetSize(id)) ||
+           (memcmp(xmlSecBufferGetData(&(item->id)), xmlSecBufferGetData(id), xmlSecBufferGetSize(id)) != 0)) {
+            continue;
+        }
+
+        /* drop expired key */
+        if((ctx->ttl > 0) && (now - item->created >= (time_t)ctx->ttl)) {
+            xmlSecBufferEmpty(&(item->id));
+            xmlSecBufferEmpty(&(item->key));
+            item->hash = 0;
+            item->created = 0;
+            break;
+        }
+
+        ret = xmlSecBufferSetData(key, xmlSecBufferGetData(&(item->key)),
+                                  xmlSecBufferGetSize(&(item->key)));
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                        "xmlSecBufferSetData",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "size=%d", xmlSecBufferGetSize(&(item->key)));
+            res = -1;
+            break;
+        }
+        res = 1;
+        break;
+    }
+    xmlSecEncryptedKeyCacheUnlock(ctx);
+
+    return(res);
+}
+
+static int
+xmlSecEncryptedKeyCacheAdd(xmlSecKeyDataStorePtr store, xmlSecBufferPtr id,
+                           unsigned long generation,
+                           const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecEncryptedKeyCacheCtxPtr ctx;
+    xmlSecEncryptedKeyCacheItemPtr item = NULL;
+    unsigned int hash;
+    xmlSecSize ii;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreEncryptedKeyCacheId), -1);
+    xmlSecAssert2(id != NULL, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ctx = xmlSecEncryptedKeyCacheGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    hash = xmlSecEncryptedKeyCacheHash(xmlSecBufferGetData(id), xmlSecBufferGetSize(id));
+
+    xmlSecEncryptedKeyCacheLock(ctx);
+    /* the recipient keys might have changed */
+    if(ctx->generation != generation) {
+        xmlSecEncryptedKeyCacheEmpty(ctx);
+        ctx->generation = generation;
+    }
+
+    /* use an empty slot or evict the oldest key */
+    for(ii = 0; ii < ctx->itemsSize; ++ii) {
+        if(ctx->items[ii].created == 0) {
+            item = &(ctx->items[ii]);
+            break;
+        }
+        if((item == NULL) || (ctx->items[ii].created < item->created)) {
+            item = &(ctx->items[ii]);
+        }
+    }
+    if(item == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_SIZE,
+                    "size=%d", ctx->itemsSize);
+        goto done;
+    }
+
+    xmlSecBufferEmpty(&(item->id));
+    xmlSecBufferEmpty(&(item->key));
+    item->created = 0;
+
+    ret = xmlSecBufferSetData(&(item->id), xmlSecBufferGetData(id), xmlSecBufferGetSize(id));
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecBufferSetData",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "size=%d", xmlSecBufferGetSize(id));
+        goto done;
+    }
+    ret = xmlSecBufferSetData(&(item->key), data, dataSize);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecBufferSetData",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "size=%d", dataSize);
+        xmlSecBufferEmpty(&(item->id));
+        goto done;
+    }
+    item->hash = hash;
+    item->created = time(NULL);
+    res = 0;
+
+done:
+    xmlSecEncryptedKeyCacheUnlock(ctx);
+    return(res);
+}
+
 #endif /* XMLSEC_NO_XMLENC */
 
@@ -0,0 +1,941 @@
+/**
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * KeyInfo Cache Store.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2016 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#include "globals.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libxml/tree.h>
+#include <libxml/hash.h>
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/xmltree.h>
+#include <xmlsec/buffer.h>
+#include <xmlsec/list.h>
+#include <xmlsec/keys.h>
+#include <xmlsec/keyinfo.h>
+#include <xmlsec/keysmngr.h>
+#include <xmlsec/errors.h>
+#include <xmlsec/private/atomic.h>
+
+/****************************************************************************
+ *
+ * KeyInfo Cache Store
+ *
+ * Remembers the keys resolved by #xmlSecKeysMngrGetKey from <dsig:KeyInfo/>
+ * nodes and the <dsig:KeyInfo/> nodes that were not resolved at all. The
+ * cache id is built from the <dsig:KeyInfo/> content (namespaces, names,
+ * attributes and text of all the nodes, each length prefixed) and from the
+ * key info context fields that change the result (key requirements, flags
+ * and certificates verification time and depth). Only the <dsig:KeyInfo/>
+ * nodes that contain nothing but <dsig:KeyName/>, <dsig:KeyValue/> and
+ * <dsig:X509Data/> are cached: everything else depends on more than the
+ * node content.
+ *
+ * The cached keys are shared with the callers (see #xmlSecKeyReference).
+ * The keys and the misses are kept apart so a flood of unknown keys does
+ * not push the known keys out. An item expires after its TTL, when the key
+ * is out of its validity period or when the keys manager simple keys store
+ * or data stores (certificates, CRLs) change (see #xmlSecKeysMngrGetGeneration).
+ * The oldest item is replaced when the cache is full.
+ *
+ ***************************************************************************/
+#define XMLSEC_KEYINFO_CACHE_DEFAULT_TTL                300
+#define XMLSEC_KEYINFO_CACHE_DEFAULT_MISS_TTL           10
+#define XMLSEC_KEYINFO_CACHE_DEFAULT_MAX_SIZE           256
+#define XMLSEC_KEYINFO_CACHE_MAX_LEVEL                  16
+#define XMLSEC_KEYINFO_CACHE_MAX_ID_SIZE                65536
+#define XMLSEC_KEYINFO_CACHE_NO_POS                     ((xmlSecSize)-1)
+
+typedef struct _xmlSecKeyInfoCacheItem {
+    xmlChar*                    id;
+    xmlSecKeyPtr                key;            /* NULL for a miss */
+    time_t                      expires;        /* 0 if the item never expires */
+    unsigned long               generation;     /* the keys manager generation */
+} xmlSecKeyInfoCacheItem, *xmlSecKeyInfoCacheItemPtr;
+
+typedef struct _xmlSecKeyInfoCacheItems {
+    xmlHashTablePtr             byId;           /* id -> item position + 1 */
+    xmlSecKeyInfoCacheItemPtr   items;
+    xmlSecSize                  maxSize;
+    xmlSecSize                  next;           /* the oldest item position */
+    long                        ttl;
+} xmlSecKeyInfoCacheItems, *xmlSecKeyInfoCacheItemsPtr;
+
+typedef struct _xmlSecKeyInfoCacheStoreCtx {
+    xmlSecKeyInfoCacheItems     keys;
+    xmlSecKeyInfoCacheItems     misses;
+    long volatile               lock;
+} xmlSecKeyInfoCacheStoreCtx, *xmlSecKeyInfoCacheStoreCtxPtr;
+
+#define xmlSecKeyInfoCacheStoreSize \
+        (sizeof(xmlSecKeyDataStore) + sizeof(xmlSecKeyInfoCacheStoreCtx))
+#define xmlSecKeyInfoCacheStoreGetCtx(store) \
+    ((xmlSecKeyDataStoreCheckSize((store), xmlSecKeyInfoCacheStoreSize)) ? \
+        (xmlSecKeyInfoCacheStoreCtxPtr)(((xmlSecByte*)(store)) + sizeof(xmlSecKeyDataStore)) : \
+        (xmlSecKeyInfoCacheStoreCtxPtr)NULL)
+
+static int                      xmlSecKeyInfoCacheStoreInitialize       (xmlSecKeyDataStorePtr store);
+static void                     xmlSecKeyInfoCacheStoreFinalize         (xmlSecKeyDataStorePtr store);
+static int                      xmlSecKeyInfoCacheStoreAdd              (xmlSecKeyDataStorePtr store,
+                                                                         xmlSecKeyInfoCacheItemsPtr items,
+                                                                         xmlNodePtr keyInfoNode,
+                                                                         xmlSecKeyInfoCtxPtr keyInfoCtx,
+                                                                         xmlSecKeyPtr key);
+
+static int                      xmlSecKeyInfoCacheStoreGetId            (xmlNodePtr keyInfoNode,
+                                                                         xmlSecKeyInfoCtxPtr keyInfoCtx,
+                                                                         xmlSecBufferPtr id);
+static int                      xmlSecKeyInfoCacheStoreAppendNode       (xmlSecBufferPtr id,
+                                                                         xmlNodePtr node,
+                                                                         int level);
+static int                      xmlSecKeyInfoCacheStoreAppendString     (xmlSecBufferPtr id,
+                                                                         xmlChar tag,
+                                                                         const xmlChar* str);
+static int                      xmlSecKeyInfoCacheStoreAppendNumber     (xmlSecBufferPtr id,
+                                                                         unsigned long val);
+static unsigned long            xmlSecKeyInfoCacheStoreGetGeneration    (xmlSecKeyInfoCtxPtr keyInfoCtx);
+static int                      xmlSecKeyInfoCacheStoreIsExpired        (xmlSecKeyInfoCacheItemPtr item,
+                                                                         xmlSecKeyInfoCtxPtr keyInfoCtx,
+                                                                         time_t now,
+                                                                         unsigned long generation);
+
+static int                      xmlSecKeyInfoCacheItemsInitialize       (xmlSecKeyInfoCacheItemsPtr items,
+                                                                         xmlSecSize maxSize,
+                                                                         long ttl);
+static void                     xmlSecKeyInfoCacheItemsFinalize         (xmlSecKeyInfoCacheItemsPtr items);
+static void                     xmlSecKeyInfoCacheItemsEmpty            (xmlSecKeyInfoCacheItemsPtr items);
+static xmlSecSize               xmlSecKeyInfoCacheItemsFind             (xmlSecKeyInfoCacheItemsPtr items,
+                                                                         const xmlChar* id);
+static void                     xmlSecKeyInfoCacheItemsRemove           (xmlSecKeyInfoCacheItemsPtr items,
+                                                                         xmlSecSize pos);
+
+static void                     xmlSecKeyInfoCacheStoreLock             (xmlSecKeyInfoCacheStoreCtxPtr ctx);
+static void                     xmlSecKeyInfoCacheStoreUnlock           (xmlSecKeyInfoCacheStoreCtxPtr ctx);
+
+static xmlSecKeyDataStoreKlass xmlSecKeyInfoCacheStoreKlass = {
+    sizeof(xmlSecKeyDataStoreKlass),
+    xmlSecKeyInfoCacheStoreSize,
+
+    /* data */
+    BAD_CAST "keyinfo-cache-store",             /* const xmlChar* name; */
+
+    /* constructors/destructor */
+    xmlSecKeyInfoCacheStoreInitialize,          /* xmlSecKeyDataStoreInitializeMethod initialize; */
+    xmlSecKeyInfoCacheStoreFinalize,            /* xmlSecKeyDataStoreFinalizeMethod finalize; */
+
+    /* content changes tracking */
+    NULL,                                       /* xmlSecKeyDataStoreGetGenerationMethod getGeneration; */
+
+    /* reserved for the future */
+    NULL,                                       /* void* reserved1; */
+};
+
+/**
+ * xmlSecKeyInfoCacheStoreGetKlass:
+ *
+ * The <dsig:KeyInfo/> resolution cache klass. When a store of this klass
+ * is added to the keys manager (see #xmlSecKeysMngrAdoptDataStore),
+ * #xmlSecKeysMngrGetKey returns the key previously resolved from the same
+ * <dsig:KeyInfo/> content instead of reading and verifying it again, and
+ * fails right away for the <dsig:KeyInfo/> content that was not resolved
+ * recently.
+ *
+ * Returns: the KeyInfo cache store klass.
+ */
+xmlSecKeyDataStoreId
+xmlSecKeyInfoCacheStoreGetKlass(void) {
+    return(&xmlSecKeyInfoCacheStoreKlass);
+}
+
+/**
+ * xmlSecKeyInfoCacheStoreSetTtl:
+ * @store:              the pointer to KeyInfo cache store.
+ * @ttl:                the items time to live in seconds (0 means the items
+ *                      never expire).
+ *
+ * Sets the time the resolved keys are kept in the cache (the default is
+ * 300 seconds). Keys that have certificates are also dropped when the
+ * certificates are no longer valid. The new value applies to the items
+ * added after this call.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecKeyInfoCacheStoreSetTtl(xmlSecKeyDataStorePtr store, long ttl) {
+    xmlSecKeyInfoCacheStoreCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyInfoCacheStoreId), -1);
+    xmlSecAssert2(ttl >= 0, -1);
+
+    ctx = xmlSecKeyInfoCacheStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    ctx->keys.ttl = ttl;
+    return(0);
+}
+
+/**
+ * xmlSecKeyInfoCacheStoreSetMissTtl:
+ * @store:              the pointer to KeyInfo cache store.
+ * @ttl:                the misses time to live in seconds (0 disables
+ *                      caching the misses).
+ *
+ * Sets the time the <dsig:KeyInfo/> content that was not resolved to
+ * a key is remembered (the default is 10 seconds). The misses are also
+ * forgotten when keys are added to the keys manager simple keys store.
+ * The new value applies to the misses added after this call.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecKeyInfoCacheStoreSetMissTtl(xmlSecKeyDataStorePtr store, long ttl) {
+    xmlSecKeyInfoCacheStoreCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyInfoCacheStoreId), -1);
+    xmlSecAssert2(ttl >= 0, -1);
+
+    ctx = xmlSecKeyInfoCacheStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    ctx->misses.ttl = ttl;
+    return(0);
+}
+
+/**
+ * xmlSecKeyInfoCacheStoreSetMaxSize:
+ * @store:              the pointer to KeyInfo cache store.
+ * @maxSize:            the max number of cached keys (and, separately,
+ *                      of cached misses).
+ *
+ * Sets the max number of cached keys and misses (the default is 256)
+ * and empties the cache.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecKeyInfoCacheStoreSetMaxSize(xmlSecKeyDataStorePtr store, xmlSecSize maxSize) {
+    xmlSecKeyInfoCacheStoreCtxPtr ctx;
+    xmlSecKeyInfoCacheItems keys, misses, tmp;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyInfoCacheStoreId), -1);
+    xmlSecAssert2(maxSize > 0, -1);
+
+    ctx = xmlSecKeyInfoCacheStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    ret = xmlSecKeyInfoCacheItemsInitialize(&keys, maxSize, ctx->keys.ttl);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecKeyInfoCacheItemsInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "size=%d", (int)maxSize);
+        return(-1);
+    }
+    ret = xmlSecKeyInfoCacheItemsInitialize(&misses, maxSize, ctx->misses.ttl);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecKeyInfoCacheItemsInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "size=%d", (int)maxSize);
+        xmlSecKeyInfoCacheItemsFinalize(&keys);
+        return(-1);
+    }
+
+    /* swap and destroy the old items outside of the lock */
+    xmlSecKeyInfoCacheStoreLock(ctx);
+    memcpy(&tmp, &(ctx->keys), sizeof(tmp));
+    memcpy(&(ctx->keys), &keys, sizeof(keys));
+    memcpy(&keys, &tmp, sizeof(tmp));
+
+    memcpy(&tmp, &(ctx->misses), sizeof(tmp));
+    memcpy(&(ctx->misses), &misses, sizeof(misses));
+    memcpy(&misses, &tmp, sizeof(tmp));
+    xmlSecKeyInfoCacheStoreUnlock(ctx);
+
+    xmlSecKeyInfoCacheItemsFinalize(&keys);
+    xmlSecKeyInfoCacheItemsFinalize(&misses);
+    return(0);
+}
+
+/**
+ * xmlSecKeyInfoCacheStoreEmpty:
+ * @store:              the pointer to KeyInfo cache store.
+ *
+ * Removes all the cached keys and misses, for example, after the trusted
+ * certificates were changed.
+ */
+void
+xmlSecKeyInfoCacheStoreEmpty(xmlSecKeyDataStorePtr store) {
+    xmlSecKeyInfoCacheStoreCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyDataStoreCheckId(store, xmlSecKeyInfoCacheStoreId));
+
+    ctx = xmlSecKeyInfoCacheStoreGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    xmlSecKeyInfoCacheStoreLock(ctx);
+    xmlSecKeyInfoCacheItemsEmpty(&(ctx->keys));
+    xmlSecKeyInfoCacheItemsEmpty(&(ctx->misses));
+    xmlSecKeyInfoCacheStoreUnlock(ctx);
+}
+
+/**
+ * xmlSecKeyInfoCacheStoreFindKey:
+ * @store:              the pointer to KeyInfo cache store.
+ * @keyInfoNode:        the pointer to <dsig:KeyInfo/> node.
+ * @keyInfoCtx:         the pointer to <dsig:KeyInfo/> node processing context.
+ * @miss:               the pointer to the result flag set to 1 if the same
+ *                      @keyInfoNode content was not resolved recently, or NULL.
+ *
+ * Lookups the key resolved before from the same @keyInfoNode content with
+ * the same @keyInfoCtx parameters. The caller is responsible for destroying
+ * the returned key using #xmlSecKeyDestroy method. The returned key is shared
+ * with the cache and thus read-only (see #xmlSecKeyReference).
+ *
+ * Returns: the pointer to a key or NULL if key is not found or an error occurs.
+ */
+xmlSecKeyPtr
+xmlSecKeyInfoCacheStoreFindKey(xmlSecKeyDataStorePtr store, xmlNodePtr keyInfoNode,
+                               xmlSecKeyInfoCtxPtr keyInfoCtx, int* miss) {
+    xmlSecKeyInfoCacheStoreCtxPtr ctx;
+    xmlSecKeyPtr key = NULL;
+    unsigned long generation;
+    xmlSecBuffer id;
+    xmlSecSize pos;
+    time_t now;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyInfoCacheStoreId), NULL);
+    xmlSecAssert2(keyInfoNode != NULL, NULL);
+    xmlSecAssert2(keyInfoCtx != NULL, NULL);
+
+    ctx = xmlSecKeyInfoCacheStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    if(miss != NULL) {
+        (*miss) = 0;
+    }
+
+    ret = xmlSecBufferInitialize(&id, 0);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecBufferInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(NULL);
+    }
+
+    ret = xmlSecKeyInfoCacheStoreGetId(keyInfoNode, keyInfoCtx, &id);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecKeyInfoCacheStoreGetId",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecBufferFinalize(&id);
+        return(NULL);
+    } else if(ret == 0) {
+        /* not cacheable */
+        xmlSecBufferFinalize(&id);
+        return(NULL);
+    }
+
+    now = time(NULL);
+    generation = xmlSecKeyInfoCacheStoreGetGeneration(keyInfoCtx);
+
+    xmlSecKeyInfoCacheStoreLock(ctx);
+    pos = xmlSecKeyInfoCacheItemsFind(&(ctx->keys), xmlSecBufferGetData(&id));
+    if(pos != XMLSEC_KEYINFO_CACHE_NO_POS) {
+        if(xmlSecKeyInfoCacheStoreIsExpired(&(ctx->keys.items[pos]), keyInfoCtx, now, generation)) {
+            xmlSecKeyInfoCacheItemsRemove(&(ctx->keys), pos);
+        } else {
+            key = xmlSecKeyReference(ctx->keys.items[pos].key);
+        }
+    } else {
+        pos = xmlSecKeyInfoCacheItemsFind(&(ctx->misses), xmlSecBufferGetData(&id));
+        if(pos != XMLSEC_KEYINFO_CACHE_NO_POS) {
+            if(xmlSecKeyInfoCacheStoreIsExpired(&(ctx->misses.items[pos]), keyInfoCtx, now, generation)) {
+                xmlSecKeyInfoCacheItemsRemove(&(ctx->misses), pos);
+            } else if(miss != NULL) {
+                (*miss) = 1;
+            }
+        }
+    }
+    xmlSecKeyInfoCacheStoreUnlock(ctx);
+
+    xmlSecBufferFinalize(&id);
+    return(key);
+}
+
+/**
+ * xmlSecKeyInfoCacheStoreAddKey:
+ * @store:              the pointer to KeyInfo cache store.
+ * @keyInfoNode:        the pointer to <dsig:KeyInfo/> node.
+ * @keyInfoCtx:         the pointer to <dsig:KeyInfo/> node processing context.
+ * @key:                the key resolved from @keyInfoNode.
+ *
+ * Adds a reference to @key resolved from @keyInfoNode to the cache if
+ * @keyInfoNode can be cached. After this call @key is shared with the
+ * cache and thus read-only (see #xmlSecKeyReference).
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecKeyInfoCacheStoreAddKey(xmlSecKeyDataStorePtr store, xmlNodePtr keyInfoNode,
+                              xmlSecKeyInfoCtxPtr keyInfoCtx, xmlSecKeyPtr key) {
+    xmlSecKeyInfoCacheStoreCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyInfoCacheStoreId), -1);
+    xmlSecAssert2(xmlSecKeyIsValid(key), -1);
+
+    ctx = xmlSecKeyInfoCacheStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    return(xmlSecKeyInfoCacheStoreAdd(store, &(ctx->keys), keyInfoNode, keyInfoCtx, key));
+}
+
+/**
+ * xmlSecKeyInfoCacheStoreAddMiss:
+ * @store:              the pointer to KeyInfo cache store.
+ * @keyInfoNode:        the pointer to <dsig:KeyInfo/> node.
+ * @keyInfoCtx:         the pointer to <dsig:KeyInfo/> node processing context.
+ *
+ * Remembers that no key was found for @keyInfoNode if @keyInfoNode can
+ * be cached and the misses TTL is not 0 (see #xmlSecKeyInfoCacheStoreSetMissTtl).
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecKeyInfoCacheStoreAddMiss(xmlSecKeyDataStorePtr store, xmlNodePtr keyInfoNode,
+                               xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecKeyInfoCacheStoreCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyInfoCacheStoreId), -1);
+
+    ctx = xmlSecKeyInfoCacheStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    if(ctx->misses.ttl <= 0) {
+        return(0);
+    }
+    return(xmlSecKeyInfoCacheStoreAdd(store, &(ctx->misses), keyInfoNode, keyInfoCtx, NULL));
+}
+
+static int
+xmlSecKeyInfoCacheStoreInitialize(xmlSecKeyDataStorePtr store) {
+    xmlSecKeyInfoCacheStoreCtxPtr ctx;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyInfoCacheStoreId), -1);
+
+    ctx = xmlSecKeyInfoCacheStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    memset(ctx, 0, sizeof(xmlSecKeyInfoCacheStoreCtx));
+
+    ret = xmlSecKeyInfoCacheItemsInitialize(&(ctx->keys),
+                XMLSEC_KEYINFO_CACHE_DEFAULT_MAX_SIZE,
+                XMLSEC_KEYINFO_CACHE_DEFAULT_TTL);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecKeyInfoCacheItemsInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlSecKeyInfoCacheItemsInitialize(&(ctx->misses),
+                XMLSEC_KEYINFO_CACHE_DEFAULT_MAX_SIZE,
+                XMLSEC_KEYINFO_CACHE_DEFAULT_MISS_TTL);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecKeyInfoCacheItemsInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecKeyInfoCacheItemsFinalize(&(ctx->keys));
+        return(-1);
+    }
+    return(0);
+}
+
+static void
+xmlSecKeyInfoCacheStoreFinalize(xmlSecKeyDataStorePtr store) {
+    xmlSecKeyInfoCacheStoreCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyDataStoreCheckId(store, xmlSecKeyInfoCacheStoreId));
+
+    ctx = xmlSecKeyInfoCacheStoreGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    xmlSecKeyInfoCacheItemsFinalize(&(ctx->keys));
+    xmlSecKeyInfoCacheItemsFinalize(&(ctx->misses));
+    memset(ctx, 0, sizeof(xmlSecKeyInfoCacheStoreCtx));
+}
+
+static int
+xmlSecKeyInfoCacheStoreAdd(xmlSecKeyDataStorePtr store, xmlSecKeyInfoCacheItemsPtr items,
+                           xmlNodePtr keyInfoNode, xmlSecKeyInfoCtxPtr keyInfoCtx,
+                           xmlSecKeyPtr key) {
+    xmlSecKeyInfoCacheStoreCtxPtr ctx;
+    unsigned long generation;
+    xmlSecBuffer id;
+    xmlChar* idStr;
+    time_t now;
+    xmlSecSize pos;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyInfoCacheStoreId), -1);
+    xmlSecAssert2(items != NULL, -1);
+    xmlSecAssert2(keyInfoNode != NULL, -1);
+    xmlSecAssert2(keyInfoCtx != NULL, -1);
+
+    ctx = xmlSecKeyInfoCacheStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    ret = xmlSecBufferInitialize(&id, 0);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecBufferInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlSecKeyInfoCacheStoreGetId(keyInfoNode, keyInfoCtx, &id);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecKeyInfoCacheStoreGetId",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecBufferFinalize(&id);
+        return(-1);
+    } else if(ret == 0) {
+        /* not cacheable */
+        xmlSecBufferFinalize(&id);
+        return(0);
+    }
+
+    idStr = xmlStrdup(xmlSecBufferGetData(&id));
+    xmlSecBufferFinalize(&id);
+    if(idStr == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlStrdup",
+                    XMLSEC_ERRORS_R_STRDUP_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    now = time(NULL);
+    generation = xmlSecKeyInfoCacheStoreGetGeneration(keyInfoCtx);
+
+    xmlSecKeyInfoCacheStoreLock(ctx);
+
+    /* somebody else could add the same item in the meantime */
+    if(xmlSecKeyInfoCacheItemsFind(items, idStr) != XMLSEC_KEYINFO_CACHE_NO_POS) {
+        xmlSecKeyInfoCacheStoreUnlock(ctx);
+        xmlFree(idStr);
+        return(0);
+    }
+
+    /* replace the oldest item */
+    pos = items->next;
+    xmlSecKeyInfoCacheItemsRemove(items, pos);
+
+    ret = xmlHashAddEntry(items->byId, idStr, (void*)((size_t)pos + 1));
+    if(ret != 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlHashAddEntry",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecKeyInfoCacheStoreUnlock(ctx);
+        xmlFree(idStr);
+        return(-1);
+    }
+
+    items->items[pos].id            = idStr;
+    items->items[pos].key           = (key != NULL) ? xmlSecKeyReference(key) : NULL;
+    items->items[pos].expires       = (items->ttl > 0) ? now + items->ttl : 0;
+    items->items[pos].generation    = generation;
+    items->next                     = (pos + 1) % items->maxSize;
+
+    xmlSecKeyInfoCacheStoreUnlock(ctx);
+    return(0);
+}
+
+/* returns 1 and the id if the node can be cached, 0 if it can not be cached */
+static int
+xmlSecKeyInfoCacheStoreGetId(xmlNodePtr keyInfoNode, xmlSecKeyInfoCtxPtr keyInfoCtx,
+                             xmlSecBufferPtr id) {
+    xmlNodePtr cur;
+    xmlSecSize size, pos;
+    xmlChar zero = '\0';
+    int ret;
+
+    xmlSecAssert2(keyInfoNode != NULL, -1);
+    xmlSecAssert2(keyInfoCtx != NULL, -1);
+    xmlSecAssert2(id != NULL, -1);
+
+    if((keyInfoCtx->mode != xmlSecKeyInfoModeRead) ||
+       (xmlSecPtrListGetSize(&(keyInfoCtx->keyReq.keyUseWithList)) > 0)) {
+        return(0);
+    }
+
+    /* only the nodes that do not depend on anything else */
+    for(cur = xmlSecGetNextElementNode(keyInfoNode->children); cur != NULL; cur = xmlSecGetNextElementNode(cur->next)) {
+        if(!xmlSecCheckNodeName(cur, xmlSecNodeKeyName, xmlSecDSigNs) &&
+           !xmlSecCheckNodeName(cur, xmlSecNodeKeyValue, xmlSecDSigNs) &&
+           !xmlSecCheckNodeName(cur, xmlSecNodeX509Data, xmlSecDSigNs)) {
+            return(0);
+        }
+    }
+
+    /* the key info context parameters */
+    if((xmlSecKeyInfoCacheStoreAppendNumber(id, (unsigned long)((size_t)keyInfoCtx->keyReq.keyId)) < 0) ||
+       (xmlSecKeyInfoCacheStoreAppendNumber(id, (unsigned long)keyInfoCtx->keyReq.keyType) < 0) ||
+       (xmlSecKeyInfoCacheStoreAppendNumber(id, (unsigned long)keyInfoCtx->keyReq.keyUsage) < 0) ||
+       (xmlSecKeyInfoCacheStoreAppendNumber(id, (unsigned long)keyInfoCtx->keyReq.keyBitsSize) < 0) ||
+       (xmlSecKeyInfoCacheStoreAppendNumber(id, (unsigned long)keyInfoCtx->flags) < 0) ||
+       (xmlSecKeyInfoCacheStoreAppendNumber(id, (unsigned long)keyInfoCtx->flags2) < 0) ||
+#ifndef XMLSEC_NO_X509
+       (xmlSecKeyInfoCacheStoreAppendNumber(id, (unsigned long)keyInfoCtx->certsVerificationTime) < 0) ||
+       (xmlSecKeyInfoCacheStoreAppendNumber(id, (unsigned long)keyInfoCtx->certsVerificationDepth) < 0) ||
+#endif /* XMLSEC_NO_X509 */
+       (xmlSecKeyInfoCacheStoreAppendNumber(id, (unsigned long)((size_t)keyInfoCtx->keysMngr)) < 0)) {
+
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeyInfoCacheStoreAppendNumber",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    size = xmlSecPtrListGetSize(&(keyInfoCtx->enabledKeyData));
+    for(pos = 0; pos < size; ++pos) {
+        ret = xmlSecKeyInfoCacheStoreAppendNumber(id,
+                    (unsigned long)((size_t)xmlSecPtrListGetItem(&(keyInfoCtx->enabledKeyData), pos)));
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecKeyInfoCacheStoreAppendNumber",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+    }
+
+    /* the node content */
+    ret = xmlSecKeyInfoCacheStoreAppendNode(id, keyInfoNode, 0);
+    if(ret <= 0) {
+        return(ret);
+    }
+
+    ret = xmlSecBufferAppend(id, &zero, 1);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecBufferAppend",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    return(1);
+}
+
+static int
+xmlSecKeyInfoCacheStoreAppendNode(xmlSecBufferPtr id, xmlNodePtr node, int level) {
+    xmlNodePtr cur;
+    xmlAttrPtr attr;
+    xmlChar* value;
+    int ret;
+
+    xmlSecAssert2(id != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    if((level > XMLSEC_KEYINFO_CACHE_MAX_LEVEL) ||
+       (xmlSecBufferGetSize(id) > XMLSEC_KEYINFO_CACHE_MAX_ID_SIZE)) {
+        return(0);
+    }
+
+    switch(node->type) {
+    case XML_ELEMENT_NODE:
+        ret = xmlSecKeyInfoCacheStoreAppendString(id, 'E', (node->ns != NULL) ? node->ns->href : NULL);
+        if(ret < 0) {
+            return(-1);
+        }
+        ret = xmlSecKeyInfoCacheStoreAppendString(id, 'N', node->name);
+        if(ret < 0) {
+            return(-1);
+        }
+
+        for(attr = node->properties; attr != NULL; attr = attr->next) {
+            ret = xmlSecKeyInfoCacheStoreAppendString(id, 'A', (attr->ns != NULL) ? attr->ns->href : NULL);
+            if(ret < 0) {
+                return(-1);
+            }
+            ret = xmlSecKeyInfoCacheStoreAppendString(id, 'N', attr->name);
+            if(ret < 0) {
+                return(-1);
+            }
+
+            value = xmlNodeListGetString(node->doc, attr->children, 1);
+            ret = xmlSecKeyInfoCacheStoreAppendString(id, 'V', value);
+            if(value != NULL) {
+                xmlFree(value);
+            }
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+
+        for(cur = node->children; cur != NULL; cur = cur->next) {
+            ret = xmlSecKeyInfoCacheStoreAppendNode(id, cur, level + 1);
+            if(ret <= 0) {
+                return(ret);
+            }
+        }
+        return(xmlSecKeyInfoCacheStoreAppendString(id, 'X', NULL));
+    case XML_TEXT_NODE:
+    case XML_CDATA_SECTION_NODE:
+        return(xmlSecKeyInfoCacheStoreAppendString(id, 'T', node->content));
+    case XML_COMMENT_NODE:
+    case XML_PI_NODE:
+        /* ignored by the <dsig:KeyInfo/> processing */
+        return(1);
+    default:
+        /* entity references and friends: don't bother */
+        return(0);
+    }
+}
+
+/* appends <tag><length in hex>:<string> */
+static int
+xmlSecKeyInfoCacheStoreAppendString(xmlSecBufferPtr id, xmlChar tag, const xmlChar* str) {
+    xmlSecSize size;
+    int ret;
+
+    xmlSecAssert2(id != NULL, -1);
+
+    size = (str != NULL) ? (xmlSecSize)xmlStrlen(str) : 0;
+
+    ret = xmlSecBufferAppend(id, &tag, 1);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecBufferAppend",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlSecKeyInfoCacheStoreAppendNumber(id, (unsigned long)size);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeyInfoCacheStoreAppendNumber",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    if(size > 0) {
+        ret = xmlSecBufferAppend(id, str, size);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecBufferAppend",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "size=%d", (int)size);
+            return(-1);
+        }
+    }
+    return(1);
+}
+
+/* appends <number in hex>: */
+static int
+xmlSecKeyInfoCacheStoreAppendNumber(xmlSecBufferPtr id, unsigned long val) {
+    static const char hex[] = "0123456789abcdef";
+    xmlSecByte buf[2 * sizeof(unsigned long) + 1];
+    xmlSecSize pos = sizeof(buf);
+
+    xmlSecAssert2(id != NULL, -1);
+
+    buf[--pos] = ':';
+    do {
+        buf[--pos] = hex[val & 0x0F];
+        val >>= 4;
+    } while((val != 0) && (pos > 0));
+
+    return(xmlSecBufferAppend(id, buf + pos, sizeof(buf) - pos));
+}
+
+static unsigned long
+xmlSecKeyInfoCacheStoreGetGeneration(xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecAssert2(keyInfoCtx != NULL, 0);
+
+    if(keyInfoCtx->keysMngr == NULL) {
+        return(0);
+    }
+    return(xmlSecKeysMngrGetGeneration(keyInfoCtx->keysMngr));
+}
+
+static int
+xmlSecKeyInfoCacheStoreIsExpired(xmlSecKeyInfoCacheItemPtr item, xmlSecKeyInfoCtxPtr keyInfoCtx,
+                                 time_t now, unsigned long generation) {
+    time_t checkTime = now;
+
+    xmlSecAssert2(item != NULL, 1);
+    xmlSecAssert2(keyInfoCtx != NULL, 1);
+
+    if((item->expires > 0) && (item->expires <= now)) {
+        return(1);
+    }
+
+    /* the keys store was changed since the item was added */
+    if(item->generation != generation) {
+        return(1);
+    }
+
+    /* a miss has no key */
+    if(item->key == NULL) {
+        return(0);
+    }
+
+#ifndef XMLSEC_NO_X509
+    if(keyInfoCtx->certsVerificationTime > 0) {
+        checkTime = keyInfoCtx->certsVerificationTime;
+    }
+#endif /* XMLSEC_NO_X509 */
+
+    /* the key validity period comes from its certificate (if any) */
+    if((item->key->notValidBefore < item->key->notValidAfter) &&
+       ((checkTime < item->key->notValidBefore) || (checkTime > item->key->notValidAfter))) {
+        return(1);
+    }
+    return(0);
+}
+
+static int
+xmlSecKeyInfoCacheItemsInitialize(xmlSecKeyInfoCacheItemsPtr items, xmlSecSize maxSize, long ttl) {
+    xmlSecAssert2(items != NULL, -1);
+    xmlSecAssert2(maxSize > 0, -1);
+
+    memset(items, 0, sizeof(xmlSecKeyInfoCacheItems));
+
+    items->byId = xmlHashCreate(0);
+    if(items->byId == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlHashCreate",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    items->items = (xmlSecKeyInfoCacheItemPtr)xmlMalloc(sizeof(xmlSecKeyInfoCacheItem) * maxSize);
+    if(items->items == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_MALLOC_FAILED,
+                    "size=%d", (int)maxSize);
+        xmlHashFree(items->byId, NULL);
+        items->byId = NULL;
+        return(-1);
+    }
+    memset(items->items, 0, sizeof(xmlSecKeyInfoCacheItem) * maxSize);
+
+    items->maxSize  = maxSize;
+    items->ttl      = ttl;
+    return(0);
+}
+
+static void
+xmlSecKeyInfoCacheItemsFinalize(xmlSecKeyInfoCacheItemsPtr items) {
+    xmlSecAssert(items != NULL);
+
+    if(items->items != NULL) {
+        xmlSecKeyInfoCacheItemsEmpty(items);
+        xmlFree(items->items);
+    }
+    if(items->byId != NULL) {
+        xmlHashFree(items->byId, NULL);
+    }
+    memset(items, 0, sizeof(xmlSecKeyInfoCacheItems));
+}
+
+static void
+xmlSecKeyInfoCacheItemsEmpty(xmlSecKeyInfoCacheItemsPtr items) {
+    xmlSecSize pos;
+
+    xmlSecAssert(items != NULL);
+
+    for(pos = 0; pos < items->maxSize; ++pos) {
+        xmlSecKeyInfoCacheItemsRemove(items, pos);
+    }
+    items->next = 0;
+}
+
+static xmlSecSize
+xmlSecKeyInfoCacheItemsFind(xmlSecKeyInfoCacheItemsPtr items, const xmlChar* id) {
+    size_t pos;
+
+    xmlSecAssert2(items != NULL, XMLSEC_KEYINFO_CACHE_NO_POS);
+    xmlSecAssert2(id != NULL, XMLSEC_KEYINFO_CACHE_NO_POS);
+
+    pos = (size_t)xmlHashLookup(items->byId, id);
+    if((pos == 0) || (pos > items->maxSize)) {
+        return(XMLSEC_KEYINFO_CACHE_NO_POS);
+    }
+    return((xmlSecSize)(pos - 1));
+}
+
+static void
+xmlSecKeyInfoCacheItemsRemove(xmlSecKeyInfoCacheItemsPtr items, xmlSecSize pos) {
+    xmlSecAssert(items != NULL);
+    xmlSecAssert(pos < items->maxSize);
+
+    if(items->items[pos].id != NULL) {
+        xmlHashRemoveEntry(items->byId, items->items[pos].id, NULL);
+        xmlFree(items->items[pos].id);
+    }
+    if(items->items[pos].key != NULL) {
+        xmlSecKeyDestroy(items->items[pos].key);
+    }
+    memset(&(items->items[pos]), 0, sizeof(xmlSecKeyInfoCacheItem));
+}
+
+static void
+xmlSecKeyInfoCacheStoreLock(xmlSecKeyInfoCacheStoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+
+    XMLSEC_SPIN_LOCK(&(ctx->lock));
+}
+
+static void
+xmlSecKeyInfoCacheStoreUnlock(xmlSecKeyInfoCacheStoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+
+    XMLSEC_SPIN_UNLOCK(&(ctx->lock));
+}
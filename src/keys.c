@@ -23,6 +23,7 @@
 #include <xmlsec/transforms.h>
 #include <xmlsec/keyinfo.h>
 #include <xmlsec/errors.h>
+#include <xmlsec/private/atomic.h>
 
 /**************************************************************************
  *
@@ -526,7 +527,23 @@ xmlSecKeyReqDebugXmlDump(xmlSecKeyReqPtr keyReq, FILE* output) {
  *
  * xmlSecKey
  *
+ * The keys are reference counted (see #xmlSecKeyReference); a key with
+ * more than one reference is read-only. A key can also share the name
+ * and key data with another (origin) key (see #xmlSecKeyCopyShared);
+ * these are copied the first time the key is modified.
+ *
  *************************************************************************/
+typedef struct _xmlSecKeyImpl {
+    xmlSecKey                   key;            /* must be the first member */
+    long volatile               refCount;
+    xmlSecKeyPtr                origin;         /* the key we share name/data with */
+} xmlSecKeyImpl, *xmlSecKeyImplPtr;
+
+#define xmlSecKeyGetImpl(key) \
+        ((xmlSecKeyImplPtr)(key))
+
+static int              xmlSecKeyPrepareWrite           (xmlSecKeyPtr key);
+
 /**
  * xmlSecKeyCreate:
  *
@@ -538,24 +555,61 @@ xmlSecKeyReqDebugXmlDump(xmlSecKeyReqPtr keyReq, FILE* output) {
  */
 xmlSecKeyPtr
 xmlSecKeyCreate(void)  {
-    xmlSecKeyPtr key;
+    xmlSecKeyImplPtr impl;
 
     /* Allocate a new xmlSecKey and fill the fields. */
-    key = (xmlSecKeyPtr)xmlMalloc(sizeof(xmlSecKey));
-    if(key == NULL) {
+    impl = (xmlSecKeyImplPtr)xmlMalloc(sizeof(xmlSecKeyImpl));
+    if(impl == NULL) {
         xmlSecError(XMLSEC_ERRORS_HERE,
                     NULL,
                     NULL,
                     XMLSEC_ERRORS_R_MALLOC_FAILED,
-                    "sizeof(xmlSecKey)=%d",
-                    (int)sizeof(xmlSecKey));
+                    "sizeof(xmlSecKeyImpl)=%d",
+                    (int)sizeof(xmlSecKeyImpl));
         return(NULL);
     }
-    memset(key, 0, sizeof(xmlSecKey));
-    key->usage = xmlSecKeyUsageAny;
+    memset(impl, 0, sizeof(xmlSecKeyImpl));
+    impl->key.usage = xmlSecKeyUsageAny;
+    impl->refCount = 1;
+    return(&(impl->key));
+}
+
+/**
+ * xmlSecKeyReference:
+ * @key:                the pointer to key.
+ *
+ * Adds a reference to @key. Each reference is released with
+ * #xmlSecKeyDestroy function. The key is read-only while it has
+ * more than one reference: #xmlSecKeySetName, #xmlSecKeySetValue,
+ * #xmlSecKeyAdoptData and other functions changing the key fail and
+ * the key data must not be modified directly.
+ *
+ * Returns: @key.
+ */
+xmlSecKeyPtr
+xmlSecKeyReference(xmlSecKeyPtr key) {
+    xmlSecAssert2(key != NULL, NULL);
+
+    XMLSEC_ATOMIC_INC(&(xmlSecKeyGetImpl(key)->refCount));
     return(key);
 }
 
+/**
+ * xmlSecKeyIsShared:
+ * @key:                the pointer to key.
+ *
+ * Checks whether @key has more than one reference (and thus is read-only,
+ * see #xmlSecKeyReference).
+ *
+ * Returns: 1 if @key is shared, 0 if not or a negative value if an error occurs.
+ */
+int
+xmlSecKeyIsShared(xmlSecKeyPtr key) {
+    xmlSecAssert2(key != NULL, -1);
+
+    return((xmlSecKeyGetImpl(key)->refCount > 1) ? 1 : 0);
+}
+
 /**
  * xmlSecKeyEmpty:
  * @key:                the pointer to key.
@@ -564,16 +618,34 @@ xmlSecKeyCreate(void)  {
  */
 void
 xmlSecKeyEmpty(xmlSecKeyPtr key) {
+    xmlSecKeyImplPtr impl;
+
     xmlSecAssert(key != NULL);
 
-    if(key->value != NULL) {
-        xmlSecKeyDataDestroy(key->value);
-    }
-    if(key->name != NULL) {
-        xmlFree(key->name);
+    impl = xmlSecKeyGetImpl(key);
+    if(impl->refCount > 1) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_OPERATION,
+                    "the key is shared and can not be changed");
+        return;
     }
-    if(key->dataList != NULL) {
-        xmlSecPtrListDestroy(key->dataList);
+
+    if(impl->origin != NULL) {
+        /* name and data belong to the origin key */
+        xmlSecKeyDestroy(impl->origin);
+        impl->origin = NULL;
+    } else {
+        if(key->value != NULL) {
+            xmlSecKeyDataDestroy(key->value);
+        }
+        if(key->name != NULL) {
+            xmlFree(key->name);
+        }
+        if(key->dataList != NULL) {
+            xmlSecPtrListDestroy(key->dataList);
+        }
     }
 
     memset(key, 0, sizeof(xmlSecKey));
@@ -583,12 +655,18 @@ xmlSecKeyEmpty(xmlSecKeyPtr key) {
  * xmlSecKeyDestroy:
  * @key:                the pointer to key.
  *
- * Destroys the key created using #xmlSecKeyCreate function.
+ * Releases a reference to the key created using #xmlSecKeyCreate function
+ * (see #xmlSecKeyReference) and destroys the key when the last reference
+ * is released.
  */
 void
 xmlSecKeyDestroy(xmlSecKeyPtr key) {
     xmlSecAssert(key != NULL);
 
+    if(XMLSEC_ATOMIC_DEC(&(xmlSecKeyGetImpl(key)->refCount)) > 0) {
+        return;
+    }
+
     xmlSecKeyEmpty(key);
     xmlFree(key);
 }
@@ -607,6 +685,15 @@ xmlSecKeyCopy(xmlSecKeyPtr keyDst, xmlSecKeyPtr keySrc) {
     xmlSecAssert2(keyDst != NULL, -1);
     xmlSecAssert2(keySrc != NULL, -1);
 
+    if(xmlSecKeyGetImpl(keyDst)->refCount > 1) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_OPERATION,
+                    "the key is shared and can not be changed");
+        return(-1);
+    }
+
     /* empty destination */
     xmlSecKeyEmpty(keyDst);
 
@@ -653,6 +740,117 @@ xmlSecKeyCopy(xmlSecKeyPtr keyDst, xmlSecKeyPtr keySrc) {
     return(0);
 }
 
+/**
+ * xmlSecKeyCopyShared:
+ * @keyDst:             the destination key.
+ * @keySrc:             the source key.
+ *
+ * Same as #xmlSecKeyCopy but instead of copying the key name and key data
+ * @keyDst shares them with @keySrc until @keyDst is modified. @keySrc
+ * gets an additional reference and becomes read-only (see
+ * #xmlSecKeyReference) until @keyDst is destroyed, emptied or modified.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecKeyCopyShared(xmlSecKeyPtr keyDst, xmlSecKeyPtr keySrc) {
+    xmlSecKeyPtr origin;
+
+    xmlSecAssert2(keyDst != NULL, -1);
+    xmlSecAssert2(keySrc != NULL, -1);
+    xmlSecAssert2(keyDst != keySrc, -1);
+
+    if(xmlSecKeyGetImpl(keyDst)->refCount > 1) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_OPERATION,
+                    "the key is shared and can not be changed");
+        return(-1);
+    }
+
+    /* share with the key that actually owns the data */
+    origin = xmlSecKeyGetImpl(keySrc)->origin;
+    if(origin == NULL) {
+        origin = keySrc;
+    }
+    xmlSecKeyReference(origin);
+
+    /* empty destination */
+    xmlSecKeyEmpty(keyDst);
+
+    keyDst->name           = origin->name;
+    keyDst->value          = origin->value;
+    keyDst->dataList       = origin->dataList;
+    keyDst->usage          = keySrc->usage;
+    keyDst->notValidBefore = keySrc->notValidBefore;
+    keyDst->notValidAfter  = keySrc->notValidAfter;
+    xmlSecKeyGetImpl(keyDst)->origin = origin;
+    return(0);
+}
+
+/* makes sure the key can be modified: fails for shared keys and copies
+ * the name and key data shared with the origin key */
+static int
+xmlSecKeyPrepareWrite(xmlSecKeyPtr key) {
+    xmlSecKeyImplPtr impl;
+    xmlSecKeyPtr origin;
+    xmlSecKeyUsage usage;
+    time_t notValidBefore, notValidAfter;
+    int ret;
+
+    xmlSecAssert2(key != NULL, -1);
+
+    impl = xmlSecKeyGetImpl(key);
+    if(impl->refCount > 1) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_OPERATION,
+                    "the key is shared and can not be changed");
+        return(-1);
+    }
+    if(impl->origin == NULL) {
+        return(0);
+    }
+
+    /* detach from origin and copy the shared fields (we keep the origin
+     * reference until the copy is done) */
+    origin = impl->origin;
+    usage = key->usage;
+    notValidBefore = key->notValidBefore;
+    notValidAfter = key->notValidAfter;
+    memset(key, 0, sizeof(xmlSecKey));
+    impl->origin = NULL;
+
+    if(xmlSecKeyGetImpl(origin)->refCount == 1) {
+        /* nobody else uses the origin key, just take over its fields */
+        key->name     = origin->name;
+        key->value    = origin->value;
+        key->dataList = origin->dataList;
+        origin->name     = NULL;
+        origin->value    = NULL;
+        origin->dataList = NULL;
+        ret = 0;
+    } else {
+        ret = xmlSecKeyCopy(key, origin);
+    }
+    xmlSecKeyDestroy(origin);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeyCopy",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    key->usage = usage;
+    key->notValidBefore = notValidBefore;
+    key->notValidAfter = notValidAfter;
+    return(0);
+}
+
 /**
  * xmlSecKeyDuplicate:
  * @key:                the pointer to the #xmlSecKey structure.
@@ -761,8 +959,20 @@ xmlSecKeyGetName(xmlSecKeyPtr key) {
  */
 int
 xmlSecKeySetName(xmlSecKeyPtr key, const xmlChar* name) {
+    int ret;
+
     xmlSecAssert2(key != NULL, -1);
 
+    ret = xmlSecKeyPrepareWrite(key);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeyPrepareWrite",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
     if(key->name != NULL) {
         xmlFree(key->name);
         key->name = NULL;
@@ -809,8 +1019,20 @@ xmlSecKeyGetValue(xmlSecKeyPtr key) {
  */
 int
 xmlSecKeySetValue(xmlSecKeyPtr key, xmlSecKeyDataPtr value) {
+    int ret;
+
     xmlSecAssert2(key != NULL, -1);
 
+    ret = xmlSecKeyPrepareWrite(key);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeyPrepareWrite",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
     if(key->value != NULL) {
         xmlSecKeyDataDestroy(key->value);
         key->value = NULL;
@@ -871,6 +1093,16 @@ xmlSecKeyEnsureData(xmlSecKeyPtr key, xmlSecKeyDataId dataId) {
     xmlSecAssert2(key != NULL, NULL);
     xmlSecAssert2(dataId != xmlSecKeyDataIdUnknown, NULL);
 
+    ret = xmlSecKeyPrepareWrite(key);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeyPrepareWrite",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(NULL);
+    }
+
     data = xmlSecKeyGetData(key, dataId);
     if(data != NULL) {
         return(data);
@@ -916,10 +1148,21 @@ int
 xmlSecKeyAdoptData(xmlSecKeyPtr key, xmlSecKeyDataPtr data) {
     xmlSecKeyDataPtr tmp;
     xmlSecSize pos, size;
+    int ret;
 
     xmlSecAssert2(key != NULL, -1);
     xmlSecAssert2(xmlSecKeyDataIsValid(data), -1);
 
+    ret = xmlSecKeyPrepareWrite(key);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecKeyPrepareWrite",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
     /* special cases */
     if(data->id == xmlSecKeyDataValueId) {
         if(key->value != NULL) {
@@ -1320,17 +1563,43 @@ xmlSecKeyReadMemory(xmlSecKeyDataId dataId, const xmlSecByte* data, xmlSecSize d
  * @keyInfoCtx:         the pointer to <dsig:KeyInfo/> node processing context.
  *
  * Reads the <dsig:KeyInfo/> node @keyInfoNode and extracts the key.
+ * If the keys manager has a KeyInfo cache store (#xmlSecKeyInfoCacheStoreId)
+ * then the key resolved from the same <dsig:KeyInfo/> content before is
+ * returned; such key is shared with the cache and thus read-only
+ * (see #xmlSecKeyReference). The same <dsig:KeyInfo/> content that was
+ * not resolved recently fails right away. A key found in the keys
+ * manager keys store shares its name and key data with the store key
+ * until it is modified (see #xmlSecKeyCopyShared).
  *
  * Returns: the pointer to key or NULL if the key is not found or
  * an error occurs.
  */
 xmlSecKeyPtr
 xmlSecKeysMngrGetKey(xmlNodePtr keyInfoNode, xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecKeyDataStorePtr cache = NULL;
     xmlSecKeyPtr key;
+    int miss = 0;
     int ret;
 
     xmlSecAssert2(keyInfoCtx != NULL, NULL);
 
+    /* check if we resolved this <dsig:KeyInfo/> node already */
+    if((keyInfoNode != NULL) && (keyInfoCtx->keysMngr != NULL)) {
+        cache = xmlSecKeysMngrGetDataStore(keyInfoCtx->keysMngr, xmlSecKeyInfoCacheStoreId);
+    }
+    if(cache != NULL) {
+        key = xmlSecKeyInfoCacheStoreFindKey(cache, keyInfoNode, keyInfoCtx, &miss);
+        if(key != NULL) {
+            return(key);
+        } else if(miss != 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        NULL,
+                        XMLSEC_ERRORS_R_KEY_NOT_FOUND,
+                        "cached");
+            return(NULL);
+        }
+    }
 
     /* first try to read data from <dsig:KeyInfo/> node */
     key = xmlSecKeyCreate();
@@ -1358,6 +1627,18 @@ xmlSecKeysMngrGetKey(xmlNodePtr keyInfoNode, xmlSecKeyInfoCtxPtr keyInfoCtx) {
 
         if((xmlSecKeyGetValue(key) != NULL) &&
            (xmlSecKeyMatch(key, NULL, &(keyInfoCtx->keyReq)) != 0)) {
+            if(cache != NULL) {
+                ret = xmlSecKeyInfoCacheStoreAddKey(cache, keyInfoNode, keyInfoCtx, key);
+                if(ret < 0) {
+                    xmlSecError(XMLSEC_ERRORS_HERE,
+                                NULL,
+                                "xmlSecKeyInfoCacheStoreAddKey",
+                                XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                                XMLSEC_ERRORS_NO_MESSAGE);
+                    xmlSecKeyDestroy(key);
+                    return(NULL);
+                }
+            }
             return(key);
         }
     }
@@ -1365,19 +1646,44 @@ xmlSecKeysMngrGetKey(xmlNodePtr keyInfoNode, xmlSecKeyInfoCtxPtr keyInfoCtx) {
 
     /* if we have keys manager, try it */
     if(keyInfoCtx->keysMngr != NULL) {
-        key = xmlSecKeysMngrFindKey(keyInfoCtx->keysMngr, NULL, keyInfoCtx);
-        if(key == NULL) {
+        xmlSecKeyPtr tmpKey;
+
+        tmpKey = xmlSecKeysMngrFindKeyShared(keyInfoCtx->keysMngr, NULL, keyInfoCtx);
+        if(tmpKey == NULL) {
             xmlSecError(XMLSEC_ERRORS_HERE,
                         NULL,
-                        "xmlSecKeysMngrFindKey",
+                        "xmlSecKeysMngrFindKeyShared",
                         XMLSEC_ERRORS_R_XMLSEC_FAILED,
                         XMLSEC_ERRORS_NO_MESSAGE);
-            return(NULL);
+            goto notFound;
         }
-        if(xmlSecKeyGetValue(key) != NULL) {
+        if(xmlSecKeyGetValue(tmpKey) != NULL) {
+            /* the caller gets a key it can modify, the name and key data
+             * are copied from the store key only if it does */
+            key = xmlSecKeyCreate();
+            if(key == NULL) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            NULL,
+                            "xmlSecKeyCreate",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                xmlSecKeyDestroy(tmpKey);
+                return(NULL);
+            }
+            ret = xmlSecKeyCopyShared(key, tmpKey);
+            xmlSecKeyDestroy(tmpKey);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            NULL,
+                            "xmlSecKeyCopyShared",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                xmlSecKeyDestroy(key);
+                return(NULL);
+            }
             return(key);
         }
-        xmlSecKeyDestroy(key);
+        xmlSecKeyDestroy(tmpKey);
     }
 
     xmlSecError(XMLSEC_ERRORS_HERE,
@@ -1385,6 +1691,19 @@ xmlSecKeysMngrGetKey(xmlNodePtr keyInfoNode, xmlSecKeyInfoCtxPtr keyInfoCtx) {
                 NULL,
                 XMLSEC_ERRORS_R_KEY_NOT_FOUND,
                 XMLSEC_ERRORS_NO_MESSAGE);
+
+notFound:
+    /* remember the miss so the next same <dsig:KeyInfo/> node fails fast */
+    if(cache != NULL) {
+        ret = xmlSecKeyInfoCacheStoreAddMiss(cache, keyInfoNode, keyInfoCtx);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecKeyInfoCacheStoreAddMiss",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+        }
+    }
     return(NULL);
 }
 
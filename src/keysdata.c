@@ -1359,6 +1359,28 @@ xmlSecKeyDataStoreDestroy(xmlSecKeyDataStorePtr store) {
     xmlFree(store);
 }
 
+/**
+ * xmlSecKeyDataStoreGetGeneration:
+ * @store:              the pointer to the key data store.
+ *
+ * Gets the number that changes every time the @store content changes
+ * (for example, when a certificate or a CRL is added to the X509 store).
+ * The key lookup caches use it to find out that their results are out
+ * of date.
+ *
+ * Returns: the store generation number or 0 if the store does not
+ * track the changes.
+ */
+unsigned long
+xmlSecKeyDataStoreGetGeneration(xmlSecKeyDataStorePtr store) {
+    xmlSecAssert2(xmlSecKeyDataStoreIsValid(store), 0);
+
+    if(store->id->getGeneration == NULL) {
+        return(0);
+    }
+    return((store->id->getGeneration)(store));
+}
+
 /***********************************************************************
  *
  * Keys Data Store list
@@ -17,6 +17,7 @@
 
 #include <libxml/tree.h>
 #include <libxml/parser.h>
+#include <libxml/hash.h>
 
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/xmltree.h>
@@ -25,6 +26,7 @@
 #include <xmlsec/transforms.h>
 #include <xmlsec/keysmngr.h>
 #include <xmlsec/errors.h>
+#include <xmlsec/private/atomic.h>
 
 /****************************************************************************
  *
@@ -120,6 +122,35 @@ xmlSecKeysMngrFindKey(xmlSecKeysMngrPtr mngr, const xmlChar* name, xmlSecKeyInfo
     return(xmlSecKeyStoreFindKey(store, name, keyInfoCtx));
 }
 
+/**
+ * xmlSecKeysMngrFindKeyShared:
+ * @mngr:               the pointer to keys manager.
+ * @name:               the desired key name.
+ * @keyInfoCtx:         the pointer to <dsig:KeyInfo/> node processing context.
+ *
+ * Same as #xmlSecKeysMngrFindKey but the returned key might be shared
+ * with the keys store instead of being copied and thus read-only
+ * (see #xmlSecKeyReference). The caller is responsible for releasing
+ * the returned key using #xmlSecKeyDestroy method.
+ *
+ * Returns: the pointer to a key or NULL if key is not found or an error occurs.
+ */
+xmlSecKeyPtr
+xmlSecKeysMngrFindKeyShared(xmlSecKeysMngrPtr mngr, const xmlChar* name, xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecKeyStorePtr store;
+
+    xmlSecAssert2(mngr != NULL, NULL);
+    xmlSecAssert2(keyInfoCtx != NULL, NULL);
+
+    store = xmlSecKeysMngrGetKeysStore(mngr);
+    if(store == NULL) {
+        /* no store. is it an error? */
+        return(NULL);
+    }
+
+    return(xmlSecKeyStoreFindKeyShared(store, name, keyInfoCtx));
+}
+
 /**
  * xmlSecKeysMngrAdoptKeysStore:
  * @mngr:               the pointer to keys manager.
@@ -216,6 +247,41 @@ xmlSecKeysMngrGetDataStore(xmlSecKeysMngrPtr mngr, xmlSecKeyDataStoreId id) {
     return(NULL);
 }
 
+/**
+ * xmlSecKeysMngrGetGeneration:
+ * @mngr:               the pointer to keys manager.
+ *
+ * Gets the number that changes every time the keys in the @mngr simple
+ * keys store or the content of the @mngr data stores (for example, the
+ * X509 certificates and CRLs) change. The key lookup caches use it to
+ * find out that their results are out of date.
+ *
+ * Returns: the keys manager generation number.
+ */
+unsigned long
+xmlSecKeysMngrGetGeneration(xmlSecKeysMngrPtr mngr) {
+    xmlSecKeyDataStorePtr tmp;
+    xmlSecSize pos, size;
+    unsigned long res = 0;
+
+    xmlSecAssert2(mngr != NULL, 0);
+
+    if(xmlSecKeyStoreCheckId(mngr->keysStore, xmlSecSimpleKeysStoreId)) {
+        res += xmlSecSimpleKeysStoreGetGeneration(mngr->keysStore);
+    }
+
+    /* the generations only grow so the sum changes with any of them */
+    size = xmlSecPtrListGetSize(&(mngr->storesList));
+    for(pos = 0; pos < size; ++pos) {
+        tmp = (xmlSecKeyDataStorePtr)xmlSecPtrListGetItem(&(mngr->storesList), pos);
+        if(tmp != NULL) {
+            res += xmlSecKeyDataStoreGetGeneration(tmp);
+        }
+    }
+
+    return(res);
+}
+
 /**************************************************************************
  *
  * xmlSecKeyStore functions
@@ -298,6 +364,46 @@ xmlSecKeyStoreDestroy(xmlSecKeyStorePtr store) {
  */
 xmlSecKeyPtr
 xmlSecKeyStoreFindKey(xmlSecKeyStorePtr store, const xmlChar* name, xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecKeyPtr key;
+    xmlSecKeyPtr res;
+
+    xmlSecAssert2(xmlSecKeyStoreIsValid(store), NULL);
+    xmlSecAssert2(store->id->findKey != NULL, NULL);
+    xmlSecAssert2(keyInfoCtx != NULL, NULL);
+
+    key = xmlSecKeyStoreFindKeyShared(store, name, keyInfoCtx);
+    if((key == NULL) || (xmlSecKeyIsShared(key) == 0)) {
+        return(key);
+    }
+
+    /* the caller gets its own copy of the key */
+    res = xmlSecKeyDuplicate(key);
+    if(res == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "xmlSecKeyDuplicate",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+    }
+    xmlSecKeyDestroy(key);
+    return(res);
+}
+
+/**
+ * xmlSecKeyStoreFindKeyShared:
+ * @store:              the pointer to keys store.
+ * @name:               the desired key name.
+ * @keyInfoCtx:         the pointer to <dsig:KeyInfo/> node processing context.
+ *
+ * Same as #xmlSecKeyStoreFindKey but the returned key might be shared
+ * with the store instead of being copied and thus read-only
+ * (see #xmlSecKeyReference). The caller is responsible for releasing
+ * the returned key using #xmlSecKeyDestroy method.
+ *
+ * Returns: the pointer to a key or NULL if key is not found or an error occurs.
+ */
+xmlSecKeyPtr
+xmlSecKeyStoreFindKeyShared(xmlSecKeyStorePtr store, const xmlChar* name, xmlSecKeyInfoCtxPtr keyInfoCtx) {
     xmlSecAssert2(xmlSecKeyStoreIsValid(store), NULL);
     xmlSecAssert2(store->id->findKey != NULL, NULL);
     xmlSecAssert2(keyInfoCtx != NULL, NULL);
@@ -309,21 +415,93 @@ xmlSecKeyStoreFindKey(xmlSecKeyStorePtr store, const xmlChar* name, xmlSecKeyInf
  *
  * Simple Keys Store
  *
- * keys list (xmlSecPtrList) is located after xmlSecKeyStore
+ * The pointer to the current keys (xmlSecSimpleKeysStoreKeys) and the
+ * readers/writer counters are located after xmlSecKeyStore. The lookups
+ * do not take locks: a reader increments the readers counter and waits
+ * only while a writer adds a key or swaps the keys. The writers are
+ * serialized; #xmlSecSimpleKeysStoreLoad and #xmlSecSimpleKeysStoreReload
+ * read the keys into a new xmlSecSimpleKeysStoreKeys object, swap it with
+ * the current one and destroy the old one. The keys still used by the other
+ * threads are kept alive by their references (see #xmlSecKeyReference).
+ *
+ * The keys list is followed by the name and key data id indexes. Each index
+ * maps a key name (or key data id name) to the first matching position in
+ * the list; the positions with the same name (id) are chained in the list
+ * order so the first match is the same as for the linear scan. The lookups
+ * fall back to the linear scan if the list size no longer matches the index
+ * (see #xmlSecSimpleKeysStoreGetKeys).
  *
  ***************************************************************************/
+#define XMLSEC_SIMPLE_KEYS_STORE_NO_POS         ((xmlSecSize)-1)
+
+typedef struct _xmlSecSimpleKeysStoreIndexItem {
+    xmlSecKeyPtr                key;
+    xmlSecSize                  nextByName;
+    xmlSecSize                  lastByName;     /* valid for the first position only */
+    xmlSecSize                  nextById;
+    xmlSecSize                  lastById;       /* valid for the first position only */
+} xmlSecSimpleKeysStoreIndexItem, *xmlSecSimpleKeysStoreIndexItemPtr;
+
+typedef struct _xmlSecSimpleKeysStoreKeys {
+    xmlSecPtrList                       keys;
+    xmlHashTablePtr                     byName;
+    xmlHashTablePtr                     byId;
+    xmlSecSimpleKeysStoreIndexItemPtr   items;
+    xmlSecSize                          itemsMaxSize;
+    xmlSecSize                          itemsSize;
+} xmlSecSimpleKeysStoreKeys, *xmlSecSimpleKeysStoreKeysPtr;
+
+typedef struct _xmlSecSimpleKeysStoreCtx {
+    xmlSecSimpleKeysStoreKeysPtr        keys;
+    long volatile                       readers;        /* lookups in progress */
+    long volatile                       writer;         /* a writer holds the store */
+    long volatile                       exclusive;      /* the writer waits for or changes the keys */
+    long volatile                       generation;     /* changed every time the keys change */
+} xmlSecSimpleKeysStoreCtx, *xmlSecSimpleKeysStoreCtxPtr;
+
 #define xmlSecSimpleKeysStoreSize \
-        (sizeof(xmlSecKeyStore) + sizeof(xmlSecPtrList))
-#define xmlSecSimpleKeysStoreGetList(store) \
+        (sizeof(xmlSecKeyStore) + sizeof(xmlSecSimpleKeysStoreCtx))
+#define xmlSecSimpleKeysStoreGetCtx(store) \
     ((xmlSecKeyStoreCheckSize((store), xmlSecSimpleKeysStoreSize)) ? \
-        (xmlSecPtrListPtr)(((xmlSecByte*)(store)) + sizeof(xmlSecKeyStore)) : \
-        (xmlSecPtrListPtr)NULL)
+        (xmlSecSimpleKeysStoreCtxPtr)(((xmlSecByte*)(store)) + sizeof(xmlSecKeyStore)) : \
+        (xmlSecSimpleKeysStoreCtxPtr)NULL)
 
 static int                      xmlSecSimpleKeysStoreInitialize (xmlSecKeyStorePtr store);
 static void                     xmlSecSimpleKeysStoreFinalize   (xmlSecKeyStorePtr store);
 static xmlSecKeyPtr             xmlSecSimpleKeysStoreFindKey    (xmlSecKeyStorePtr store,
                                                                  const xmlChar* name,
                                                                  xmlSecKeyInfoCtxPtr keyInfoCtx);
+static int                      xmlSecSimpleKeysStoreLoadKeys   (xmlSecKeyStorePtr store,
+                                                                 const char *uri,
+                                                                 xmlSecKeysMngrPtr keysMngr,
+                                                                 int keepCurrent);
+static int                      xmlSecSimpleKeysStoreReadKeys   (xmlSecKeyStorePtr store,
+                                                                 const char *uri,
+                                                                 xmlSecKeysMngrPtr keysMngr,
+                                                                 xmlSecSimpleKeysStoreKeysPtr keys,
+                                                                 int keepCurrent);
+static int                      xmlSecSimpleKeysStoreWriteKeys  (xmlSecKeyStorePtr store,
+                                                                 xmlSecPtrListPtr list,
+                                                                 const char *filename,
+                                                                 xmlSecKeyDataType type);
+
+static void                     xmlSecSimpleKeysStoreReadLock   (xmlSecSimpleKeysStoreCtxPtr ctx);
+static void                     xmlSecSimpleKeysStoreReadUnlock (xmlSecSimpleKeysStoreCtxPtr ctx);
+static void                     xmlSecSimpleKeysStoreWriteLock  (xmlSecSimpleKeysStoreCtxPtr ctx);
+static void                     xmlSecSimpleKeysStoreWriteUnlock(xmlSecSimpleKeysStoreCtxPtr ctx);
+static void                     xmlSecSimpleKeysStoreExclusiveLock  (xmlSecSimpleKeysStoreCtxPtr ctx);
+static void                     xmlSecSimpleKeysStoreExclusiveUnlock(xmlSecSimpleKeysStoreCtxPtr ctx);
+
+static xmlSecSimpleKeysStoreKeysPtr xmlSecSimpleKeysStoreKeysCreate (void);
+static void                     xmlSecSimpleKeysStoreKeysDestroy(xmlSecSimpleKeysStoreKeysPtr keys);
+static int                      xmlSecSimpleKeysStoreKeysAdd    (xmlSecSimpleKeysStoreKeysPtr keys,
+                                                                 xmlSecKeyPtr key);
+static xmlSecKeyPtr             xmlSecSimpleKeysStoreKeysFind   (xmlSecSimpleKeysStoreKeysPtr keys,
+                                                                 const xmlChar* name,
+                                                                 xmlSecKeyInfoCtxPtr keyInfoCtx);
+static int                      xmlSecSimpleKeysStoreIndexKey   (xmlSecSimpleKeysStoreKeysPtr keys,
+                                                                 xmlSecSize pos);
+static int                      xmlSecSimpleKeysStoreReindex    (xmlSecSimpleKeysStoreKeysPtr keys);
 
 static xmlSecKeyStoreKlass xmlSecSimpleKeysStoreKlass = {
     sizeof(xmlSecKeyStoreKlass),
@@ -359,31 +537,40 @@ xmlSecSimpleKeysStoreGetKlass(void) {
  * @store:              the pointer to simple keys store.
  * @key:                the pointer to key.
  *
- * Adds @key to the @store.
+ * Adds @key to the @store. The key is indexed by its name and key data
+ * id, the key name and value must not be changed after the key is adopted.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
 int
 xmlSecSimpleKeysStoreAdoptKey(xmlSecKeyStorePtr store, xmlSecKeyPtr key) {
-    xmlSecPtrListPtr list;
+    xmlSecSimpleKeysStoreCtxPtr ctx;
     int ret;
 
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
     xmlSecAssert2(key != NULL, -1);
 
-    list = xmlSecSimpleKeysStoreGetList(store);
-    xmlSecAssert2(xmlSecPtrListCheckId(list, xmlSecKeyPtrListId), -1);
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->keys != NULL, -1);
+
+    xmlSecSimpleKeysStoreWriteLock(ctx);
+    xmlSecSimpleKeysStoreExclusiveLock(ctx);
+    ret = xmlSecSimpleKeysStoreKeysAdd(ctx->keys, key);
+    if(ret >= 0) {
+        XMLSEC_ATOMIC_INC(&(ctx->generation));
+    }
+    xmlSecSimpleKeysStoreExclusiveUnlock(ctx);
+    xmlSecSimpleKeysStoreWriteUnlock(ctx);
 
-    ret = xmlSecPtrListAdd(list, key);
     if(ret < 0) {
         xmlSecError(XMLSEC_ERRORS_HERE,
                     xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
-                    "xmlSecPtrListAdd",
+                    "xmlSecSimpleKeysStoreKeysAdd",
                     XMLSEC_ERRORS_R_XMLSEC_FAILED,
                     XMLSEC_ERRORS_NO_MESSAGE);
         return(-1);
     }
-
     return(0);
 }
 
@@ -393,22 +580,288 @@ xmlSecSimpleKeysStoreAdoptKey(xmlSecKeyStorePtr store, xmlSecKeyPtr key) {
  * @uri:                the filename.
  * @keysMngr:           the pointer to associated keys manager.
  *
- * Reads keys from an XML file.
+ * Reads keys from an XML file and adds them to the @store. The keys are
+ * read into a copy of the current keys list which then replaces the
+ * current list; the lookups from other threads are not blocked while
+ * the file is read. If an error occurs, the @store is not changed.
+ * If @keysMngr uses this @store, the <dsig:KeyName/> elements in the file
+ * find both the current keys and the keys read earlier from the same file.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
 int
 xmlSecSimpleKeysStoreLoad(xmlSecKeyStorePtr store, const char *uri,
                             xmlSecKeysMngrPtr keysMngr) {
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
+    xmlSecAssert2(uri != NULL, -1);
+
+    return(xmlSecSimpleKeysStoreLoadKeys(store, uri, keysMngr, 1));
+}
+
+/**
+ * xmlSecSimpleKeysStoreReload:
+ * @store:              the pointer to simple keys store.
+ * @uri:                the filename.
+ * @keysMngr:           the pointer to associated keys manager.
+ *
+ * Reads keys from an XML file and atomically replaces all the keys in
+ * the @store with them (e.g. for keys rotation). The lookups from other
+ * threads see either the old or the new keys and the old keys returned
+ * by these lookups stay valid until destroyed. If an error occurs,
+ * the @store is not changed. The <dsig:KeyName/> elements in the file
+ * only name the new keys, they are not looked up in the current keys.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecSimpleKeysStoreReload(xmlSecKeyStorePtr store, const char *uri,
+                            xmlSecKeysMngrPtr keysMngr) {
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
+    xmlSecAssert2(uri != NULL, -1);
+
+    return(xmlSecSimpleKeysStoreLoadKeys(store, uri, keysMngr, 0));
+}
+
+/**
+ * xmlSecSimpleKeysStoreSave:
+ * @store:              the pointer to simple keys store.
+ * @filename:           the filename.
+ * @type:               the saved keys type (public, private, ...).
+ *
+ * Writes keys from @store to an XML file.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecSimpleKeysStoreSave(xmlSecKeyStorePtr store, const char *filename, xmlSecKeyDataType type) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->keys != NULL, -1);
+
+    /* the writer lock keeps the keys list, the lookups can go on */
+    xmlSecSimpleKeysStoreWriteLock(ctx);
+    ret = xmlSecSimpleKeysStoreWriteKeys(store, &(ctx->keys->keys), filename, type);
+    xmlSecSimpleKeysStoreWriteUnlock(ctx);
+
+    return(ret);
+}
+
+/**
+ * xmlSecSimpleKeysStoreGetKeys:
+ * @store:              the pointer to simple keys store.
+ *
+ * Gets list of keys from simple keys store. The list is replaced by
+ * #xmlSecSimpleKeysStoreLoad and #xmlSecSimpleKeysStoreReload and
+ * must not be used while other threads change the @store. The keys added
+ * or removed directly in this list are not indexed and the store falls
+ * back to the linear scan until the next #xmlSecSimpleKeysStoreAdoptKey
+ * call rebuilds the index.
+ *
+ * Returns: pointer to the list of keys stored in the keys store or NULL
+ * if an error occurs.
+ */
+xmlSecPtrListPtr
+xmlSecSimpleKeysStoreGetKeys(xmlSecKeyStorePtr store) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), NULL);
+
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(ctx->keys != NULL, NULL);
+
+    return(&(ctx->keys->keys));
+}
+
+/**
+ * xmlSecSimpleKeysStoreGetGeneration:
+ * @store:              the pointer to simple keys store.
+ *
+ * Gets the number that changes every time keys are added to @store or
+ * replaced (see #xmlSecSimpleKeysStoreAdoptKey, #xmlSecSimpleKeysStoreLoad
+ * and #xmlSecSimpleKeysStoreReload). The key lookup caches use it to find
+ * out that their results are out of date.
+ *
+ * Returns: the keys generation number.
+ */
+unsigned long
+xmlSecSimpleKeysStoreGetGeneration(xmlSecKeyStorePtr store) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), 0);
+
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, 0);
+
+    return((unsigned long)ctx->generation);
+}
+
+static int
+xmlSecSimpleKeysStoreInitialize(xmlSecKeyStorePtr store) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
+
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    memset(ctx, 0, sizeof(xmlSecSimpleKeysStoreCtx));
+
+    ctx->keys = xmlSecSimpleKeysStoreKeysCreate();
+    if(ctx->keys == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "xmlSecSimpleKeysStoreKeysCreate",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    return(0);
+}
+
+static void
+xmlSecSimpleKeysStoreFinalize(xmlSecKeyStorePtr store) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId));
+
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    if(ctx->keys != NULL) {
+        xmlSecSimpleKeysStoreKeysDestroy(ctx->keys);
+    }
+    memset(ctx, 0, sizeof(xmlSecSimpleKeysStoreCtx));
+}
+
+static xmlSecKeyPtr
+xmlSecSimpleKeysStoreFindKey(xmlSecKeyStorePtr store, const xmlChar* name,
+                            xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
+    xmlSecKeyPtr key;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), NULL);
+    xmlSecAssert2(keyInfoCtx != NULL, NULL);
+
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    xmlSecSimpleKeysStoreReadLock(ctx);
+    key = xmlSecSimpleKeysStoreKeysFind(ctx->keys, name, keyInfoCtx);
+    if(key != NULL) {
+        xmlSecKeyReference(key);
+    }
+    xmlSecSimpleKeysStoreReadUnlock(ctx);
+
+    return(key);
+}
+
+static int
+xmlSecSimpleKeysStoreLoadKeys(xmlSecKeyStorePtr store, const char *uri,
+                              xmlSecKeysMngrPtr keysMngr, int keepCurrent) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
+    xmlSecSimpleKeysStoreKeysPtr newKeys;
+    xmlSecSimpleKeysStoreKeysPtr oldKeys;
+    xmlSecKeyPtr key;
+    xmlSecSize pos, size;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
+    xmlSecAssert2(uri != NULL, -1);
+
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->keys != NULL, -1);
+
+    newKeys = xmlSecSimpleKeysStoreKeysCreate();
+    if(newKeys == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "xmlSecSimpleKeysStoreKeysCreate",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    /* the current keys can't change while we hold the writer lock */
+    xmlSecSimpleKeysStoreWriteLock(ctx);
+
+    if(keepCurrent) {
+        size = xmlSecPtrListGetSize(&(ctx->keys->keys));
+        for(pos = 0; pos < size; ++pos) {
+            key = (xmlSecKeyPtr)xmlSecPtrListGetItem(&(ctx->keys->keys), pos);
+            if(key == NULL) {
+                continue;
+            }
+
+            ret = xmlSecSimpleKeysStoreKeysAdd(newKeys, xmlSecKeyReference(key));
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                            "xmlSecSimpleKeysStoreKeysAdd",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                xmlSecKeyDestroy(key);
+                xmlSecSimpleKeysStoreWriteUnlock(ctx);
+                xmlSecSimpleKeysStoreKeysDestroy(newKeys);
+                return(-1);
+            }
+        }
+    }
+
+    ret = xmlSecSimpleKeysStoreReadKeys(store, uri, keysMngr, newKeys, keepCurrent);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    "xmlSecSimpleKeysStoreReadKeys",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "uri=%s",
+                    xmlSecErrorsSafeString(uri));
+        xmlSecSimpleKeysStoreWriteUnlock(ctx);
+        xmlSecSimpleKeysStoreKeysDestroy(newKeys);
+        return(-1);
+    }
+
+    /* swap */
+    xmlSecSimpleKeysStoreExclusiveLock(ctx);
+    oldKeys = ctx->keys;
+    ctx->keys = newKeys;
+    XMLSEC_ATOMIC_INC(&(ctx->generation));
+    xmlSecSimpleKeysStoreExclusiveUnlock(ctx);
+    xmlSecSimpleKeysStoreWriteUnlock(ctx);
+
+    /* no lookups use the old keys list anymore */
+    xmlSecSimpleKeysStoreKeysDestroy(oldKeys);
+    return(0);
+}
+
+static int
+xmlSecSimpleKeysStoreReadKeys(xmlSecKeyStorePtr store, const char *uri,
+                              xmlSecKeysMngrPtr keysMngr,
+                              xmlSecSimpleKeysStoreKeysPtr keys,
+                              int keepCurrent) {
     xmlDocPtr doc;
     xmlNodePtr root;
     xmlNodePtr cur;
     xmlSecKeyPtr key;
     xmlSecKeyInfoCtx keyInfoCtx;
+    int findInKeys;
     int ret;
 
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
     xmlSecAssert2(uri != NULL, -1);
+    xmlSecAssert2(keys != NULL, -1);
+
+    /* the keys manager would only see the current keys of this store */
+    findInKeys = (keepCurrent && (keysMngr != NULL) &&
+                  (xmlSecKeysMngrGetKeysStore(keysMngr) == store)) ? 1 : 0;
 
     doc = xmlParseFile(uri);
     if(doc == NULL) {
@@ -462,6 +915,11 @@ xmlSecSimpleKeysStoreLoad(xmlSecKeyStorePtr store, const char *uri,
         keyInfoCtx.keysMngr       = keysMngr;
         keyInfoCtx.flags          = XMLSEC_KEYINFO_FLAGS_DONT_STOP_ON_KEY_FOUND |
                                     XMLSEC_KEYINFO_FLAGS_X509DATA_DONT_VERIFY_CERTS;
+        if(!keepCurrent || findInKeys) {
+            /* the current keys are replaced or not yet in the store: don't
+             * look them up in the keys manager */
+            keyInfoCtx.flags     |= XMLSEC_KEYINFO_FLAGS_KEYNAME_DONT_FIND_KEY;
+        }
         keyInfoCtx.keyReq.keyId   = xmlSecKeyDataIdUnknown;
         keyInfoCtx.keyReq.keyType = xmlSecKeyDataTypeAny;
         keyInfoCtx.keyReq.keyUsage= xmlSecKeyDataUsageAny;
@@ -478,14 +936,36 @@ xmlSecSimpleKeysStoreLoad(xmlSecKeyStorePtr store, const char *uri,
             xmlFreeDoc(doc);
             return(-1);
         }
+
+        /* the <dsig:KeyName/> refers to the current keys or the keys read
+         * earlier from this file: both are in the new keys list */
+        if(findInKeys && (xmlSecKeyGetValue(key) == NULL) && (xmlSecKeyGetName(key) != NULL)) {
+            xmlSecKeyPtr tmpKey;
+
+            tmpKey = xmlSecSimpleKeysStoreKeysFind(keys, xmlSecKeyGetName(key), &keyInfoCtx);
+            if(tmpKey != NULL) {
+                ret = xmlSecKeyCopyShared(key, tmpKey);
+                if(ret < 0) {
+                    xmlSecError(XMLSEC_ERRORS_HERE,
+                                xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                                "xmlSecKeyCopyShared",
+                                XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                                XMLSEC_ERRORS_NO_MESSAGE);
+                    xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+                    xmlSecKeyDestroy(key);
+                    xmlFreeDoc(doc);
+                    return(-1);
+                }
+            }
+        }
         xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
 
         if(xmlSecKeyIsValid(key)) {
-            ret = xmlSecSimpleKeysStoreAdoptKey(store, key);
+            ret = xmlSecSimpleKeysStoreKeysAdd(keys, key);
             if(ret < 0) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
-                            "xmlSecSimpleKeysStoreAdoptKey",
+                            "xmlSecSimpleKeysStoreKeysAdd",
                             XMLSEC_ERRORS_R_XMLSEC_FAILED,
                             XMLSEC_ERRORS_NO_MESSAGE);
                 xmlSecKeyDestroy(key);
@@ -511,23 +991,13 @@ xmlSecSimpleKeysStoreLoad(xmlSecKeyStorePtr store, const char *uri,
 
     xmlFreeDoc(doc);
     return(0);
-
 }
 
-/**
- * xmlSecSimpleKeysStoreSave:
- * @store:              the pointer to simple keys store.
- * @filename:           the filename.
- * @type:               the saved keys type (public, private, ...).
- *
- * Writes keys from @store to an XML file.
- *
- * Returns: 0 on success or a negative value if an error occurs.
- */
-int
-xmlSecSimpleKeysStoreSave(xmlSecKeyStorePtr store, const char *filename, xmlSecKeyDataType type) {
+
+static int
+xmlSecSimpleKeysStoreWriteKeys(xmlSecKeyStorePtr store, xmlSecPtrListPtr list,
+                               const char *filename, xmlSecKeyDataType type) {
     xmlSecKeyInfoCtx keyInfoCtx;
-    xmlSecPtrListPtr list;
     xmlSecKeyPtr key;
     xmlSecSize i, keysSize;
     xmlDocPtr doc;
@@ -539,10 +1009,8 @@ xmlSecSimpleKeysStoreSave(xmlSecKeyStorePtr store, const char *filename, xmlSecK
     int ret;
 
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
-    xmlSecAssert2(filename != NULL, -1);
-
-    list = xmlSecSimpleKeysStoreGetList(store);
     xmlSecAssert2(xmlSecPtrListCheckId(list, xmlSecKeyPtrListId), -1);
+    xmlSecAssert2(filename != NULL, -1);
 
     /* create doc */
     doc = xmlSecCreateTree(BAD_CAST "Keys", xmlSecNs);
@@ -664,82 +1132,359 @@ xmlSecSimpleKeysStoreSave(xmlSecKeyStorePtr store, const char *filename, xmlSecK
     return(0);
 }
 
-/**
- * xmlSecSimpleKeysStoreGetKeys:
- * @store:              the pointer to simple keys store.
- *
- * Gets list of keys from simple keys store.
- *
- * Returns: pointer to the list of keys stored in the keys store or NULL
- * if an error occurs.
- */
-xmlSecPtrListPtr
-xmlSecSimpleKeysStoreGetKeys(xmlSecKeyStorePtr store) {
-    xmlSecPtrListPtr list;
+/* the lookups only wait while a writer changes the keys */
+static void
+xmlSecSimpleKeysStoreReadLock(xmlSecSimpleKeysStoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+
+    for(;;) {
+        if(ctx->exclusive == 0) {
+            XMLSEC_ATOMIC_INC(&(ctx->readers));
+            if(ctx->exclusive == 0) {
+                return;
+            }
+            XMLSEC_ATOMIC_DEC(&(ctx->readers));
+        }
+        XMLSEC_ATOMIC_YIELD();
+    }
+}
 
-    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), NULL);
+static void
+xmlSecSimpleKeysStoreReadUnlock(xmlSecSimpleKeysStoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+
+    XMLSEC_ATOMIC_DEC(&(ctx->readers));
+}
+
+/* serializes the writers, the lookups are not blocked */
+static void
+xmlSecSimpleKeysStoreWriteLock(xmlSecSimpleKeysStoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+
+    XMLSEC_SPIN_LOCK(&(ctx->writer));
+}
 
-    list = xmlSecSimpleKeysStoreGetList(store);
-    xmlSecAssert2(xmlSecPtrListCheckId(list, xmlSecKeyPtrListId), NULL);
+static void
+xmlSecSimpleKeysStoreWriteUnlock(xmlSecSimpleKeysStoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
 
-    return list;
+    XMLSEC_SPIN_UNLOCK(&(ctx->writer));
 }
 
-static int
-xmlSecSimpleKeysStoreInitialize(xmlSecKeyStorePtr store) {
-    xmlSecPtrListPtr list;
-    int ret;
+/* the writer (holding the writer lock) blocks new lookups and waits for
+ * the lookups in progress to finish */
+static void
+xmlSecSimpleKeysStoreExclusiveLock(xmlSecSimpleKeysStoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+    xmlSecAssert(ctx->writer != 0);
 
-    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
+    (void)XMLSEC_ATOMIC_CAS(&(ctx->exclusive), 0, 1);
+    while(ctx->readers != 0) {
+        XMLSEC_ATOMIC_YIELD();
+    }
+}
 
-    list = xmlSecSimpleKeysStoreGetList(store);
-    xmlSecAssert2(list != NULL, -1);
+static void
+xmlSecSimpleKeysStoreExclusiveUnlock(xmlSecSimpleKeysStoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
 
-    ret = xmlSecPtrListInitialize(list, xmlSecKeyPtrListId);
+    XMLSEC_SPIN_UNLOCK(&(ctx->exclusive));
+}
+
+static xmlSecSimpleKeysStoreKeysPtr
+xmlSecSimpleKeysStoreKeysCreate(void) {
+    xmlSecSimpleKeysStoreKeysPtr keys;
+    int ret;
+
+    keys = (xmlSecSimpleKeysStoreKeysPtr)xmlMalloc(sizeof(xmlSecSimpleKeysStoreKeys));
+    if(keys == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_MALLOC_FAILED,
+                    "sizeof(xmlSecSimpleKeysStoreKeys)=%d",
+                    (int)sizeof(xmlSecSimpleKeysStoreKeys));
+        return(NULL);
+    }
+    memset(keys, 0, sizeof(xmlSecSimpleKeysStoreKeys));
+
+    ret = xmlSecPtrListInitialize(&(keys->keys), xmlSecKeyPtrListId);
     if(ret < 0) {
         xmlSecError(XMLSEC_ERRORS_HERE,
-                    xmlSecErrorsSafeString(xmlSecKeyStoreGetName(store)),
+                    NULL,
                     "xmlSecPtrListInitialize",
                     XMLSEC_ERRORS_R_XMLSEC_FAILED,
                     "xmlSecKeyPtrListId");
-        return(-1);
+        xmlFree(keys);
+        return(NULL);
     }
 
-    return(0);
+    keys->byName = xmlHashCreate(0);
+    keys->byId = xmlHashCreate(0);
+    if((keys->byName == NULL) || (keys->byId == NULL)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlHashCreate",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecSimpleKeysStoreKeysDestroy(keys);
+        return(NULL);
+    }
+
+    return(keys);
 }
 
 static void
-xmlSecSimpleKeysStoreFinalize(xmlSecKeyStorePtr store) {
-    xmlSecPtrListPtr list;
+xmlSecSimpleKeysStoreKeysDestroy(xmlSecSimpleKeysStoreKeysPtr keys) {
+    xmlSecAssert(keys != NULL);
 
-    xmlSecAssert(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId));
+    if(keys->byName != NULL) {
+        xmlHashFree(keys->byName, NULL);
+    }
+    if(keys->byId != NULL) {
+        xmlHashFree(keys->byId, NULL);
+    }
+    if(keys->items != NULL) {
+        xmlFree(keys->items);
+    }
+    xmlSecPtrListFinalize(&(keys->keys));
+    memset(keys, 0, sizeof(xmlSecSimpleKeysStoreKeys));
+    xmlFree(keys);
+}
+
+static int
+xmlSecSimpleKeysStoreKeysAdd(xmlSecSimpleKeysStoreKeysPtr keys, xmlSecKeyPtr key) {
+    xmlSecSize size;
+    int ret;
+
+    xmlSecAssert2(keys != NULL, -1);
+    xmlSecAssert2(xmlSecPtrListCheckId(&(keys->keys), xmlSecKeyPtrListId), -1);
+    xmlSecAssert2(key != NULL, -1);
+
+    ret = xmlSecPtrListAdd(&(keys->keys), key);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecPtrListAdd",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
 
-    list = xmlSecSimpleKeysStoreGetList(store);
-    xmlSecAssert(list != NULL);
+    /* the key is in the list, index failures only disable the index */
+    size = xmlSecPtrListGetSize(&(keys->keys));
+    if(keys->itemsSize + 1 == size) {
+        ret = xmlSecSimpleKeysStoreIndexKey(keys, size - 1);
+    } else {
+        ret = xmlSecSimpleKeysStoreReindex(keys);
+    }
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecSimpleKeysStoreIndexKey",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "keys index is disabled");
+        keys->itemsSize = XMLSEC_SIMPLE_KEYS_STORE_NO_POS;
+    }
 
-    xmlSecPtrListFinalize(list);
+    return(0);
 }
 
+/* returns the first matching key (not a copy or a reference) */
 static xmlSecKeyPtr
-xmlSecSimpleKeysStoreFindKey(xmlSecKeyStorePtr store, const xmlChar* name,
-                            xmlSecKeyInfoCtxPtr keyInfoCtx) {
-    xmlSecPtrListPtr list;
+xmlSecSimpleKeysStoreKeysFind(xmlSecSimpleKeysStoreKeysPtr keys, const xmlChar* name,
+                              xmlSecKeyInfoCtxPtr keyInfoCtx) {
     xmlSecKeyPtr key;
     xmlSecSize pos, size;
+    size_t first;
 
-    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), NULL);
+    xmlSecAssert2(keys != NULL, NULL);
+    xmlSecAssert2(xmlSecPtrListCheckId(&(keys->keys), xmlSecKeyPtrListId), NULL);
     xmlSecAssert2(keyInfoCtx != NULL, NULL);
 
-    list = xmlSecSimpleKeysStoreGetList(store);
-    xmlSecAssert2(xmlSecPtrListCheckId(list, xmlSecKeyPtrListId), NULL);
+    /* use the index if it is in sync with the list */
+    size = xmlSecPtrListGetSize(&(keys->keys));
+    if((size > 0) && (keys->itemsSize == size) &&
+       ((name != NULL) || (keyInfoCtx->keyReq.keyId != xmlSecKeyDataIdUnknown))) {
+
+        if(name != NULL) {
+            first = (size_t)xmlHashLookup(keys->byName, name);
+        } else {
+            first = (size_t)xmlHashLookup(keys->byId, keyInfoCtx->keyReq.keyId->name);
+        }
+        for(pos = (first > 0) ? (xmlSecSize)(first - 1) : XMLSEC_SIMPLE_KEYS_STORE_NO_POS;
+            pos != XMLSEC_SIMPLE_KEYS_STORE_NO_POS;
+            pos = (name != NULL) ? keys->items[pos].nextByName : keys->items[pos].nextById) {
+
+            key = (xmlSecKeyPtr)xmlSecPtrListGetItem(&(keys->keys), pos);
+            if(key != keys->items[pos].key) {
+                /* the list was changed behind our back */
+                break;
+            }
+            if((key != NULL) && (xmlSecKeyMatch(key, name, &(keyInfoCtx->keyReq)) == 1)) {
+                return(key);
+            }
+        }
+        if(pos == XMLSEC_SIMPLE_KEYS_STORE_NO_POS) {
+            return(NULL);
+        }
+    }
 
-    size = xmlSecPtrListGetSize(list);
     for(pos = 0; pos < size; ++pos) {
-        key = (xmlSecKeyPtr)xmlSecPtrListGetItem(list, pos);
+        key = (xmlSecKeyPtr)xmlSecPtrListGetItem(&(keys->keys), pos);
         if((key != NULL) && (xmlSecKeyMatch(key, name, &(keyInfoCtx->keyReq)) == 1)) {
-            return(xmlSecKeyDuplicate(key));
+            return(key);
         }
     }
     return(NULL);
 }
 
+static int
+xmlSecSimpleKeysStoreIndexAdd(xmlHashTablePtr table, const xmlChar* name,
+                              xmlSecSimpleKeysStoreIndexItemPtr items, xmlSecSize pos,
+                              int byName) {
+    size_t first;
+    xmlSecSize last;
+    int ret;
+
+    xmlSecAssert2(table != NULL, -1);
+    xmlSecAssert2(name != NULL, -1);
+    xmlSecAssert2(items != NULL, -1);
+
+    first = (size_t)xmlHashLookup(table, name);
+    if(first == 0) {
+        /* store pos + 1 so that NULL means "not found" */
+        ret = xmlHashAddEntry(table, name, (void*)((size_t)pos + 1));
+        if(ret != 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlHashAddEntry",
+                        XMLSEC_ERRORS_R_XML_FAILED,
+                        "name=%s",
+                        xmlSecErrorsSafeString(name));
+            return(-1);
+        }
+        if(byName) {
+            items[pos].lastByName = pos;
+        } else {
+            items[pos].lastById = pos;
+        }
+    } else if(byName) {
+        last = items[first - 1].lastByName;
+        items[last].nextByName = pos;
+        items[first - 1].lastByName = pos;
+    } else {
+        last = items[first - 1].lastById;
+        items[last].nextById = pos;
+        items[first - 1].lastById = pos;
+    }
+    return(0);
+}
+
+static int
+xmlSecSimpleKeysStoreIndexKey(xmlSecSimpleKeysStoreKeysPtr keys, xmlSecSize pos) {
+    xmlSecSimpleKeysStoreIndexItemPtr newItems;
+    xmlSecSize newSize;
+    xmlSecKeyPtr key;
+    xmlSecKeyDataPtr value;
+    int ret;
+
+    xmlSecAssert2(keys != NULL, -1);
+    xmlSecAssert2(keys->byName != NULL, -1);
+    xmlSecAssert2(keys->byId != NULL, -1);
+    xmlSecAssert2(keys->itemsSize == pos, -1);
+
+    if(pos >= keys->itemsMaxSize) {
+        newSize = (keys->itemsMaxSize > 0) ? 2 * keys->itemsMaxSize : 64;
+        newItems = (xmlSecSimpleKeysStoreIndexItemPtr)xmlRealloc(keys->items,
+                        sizeof(xmlSecSimpleKeysStoreIndexItem) * newSize);
+        if(newItems == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        NULL,
+                        XMLSEC_ERRORS_R_MALLOC_FAILED,
+                        "sizeof(xmlSecSimpleKeysStoreIndexItem)*%d=%d",
+                        newSize, (int)(sizeof(xmlSecSimpleKeysStoreIndexItem) * newSize));
+            return(-1);
+        }
+        keys->items = newItems;
+        keys->itemsMaxSize = newSize;
+    }
+
+    key = (xmlSecKeyPtr)xmlSecPtrListGetItem(&(keys->keys), pos);
+    keys->items[pos].key         = key;
+    keys->items[pos].nextByName  = XMLSEC_SIMPLE_KEYS_STORE_NO_POS;
+    keys->items[pos].lastByName  = XMLSEC_SIMPLE_KEYS_STORE_NO_POS;
+    keys->items[pos].nextById    = XMLSEC_SIMPLE_KEYS_STORE_NO_POS;
+    keys->items[pos].lastById    = XMLSEC_SIMPLE_KEYS_STORE_NO_POS;
+
+    if((key != NULL) && (xmlSecKeyGetName(key) != NULL)) {
+        ret = xmlSecSimpleKeysStoreIndexAdd(keys->byName, xmlSecKeyGetName(key), keys->items, pos, 1);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecSimpleKeysStoreIndexAdd",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "byName");
+            return(-1);
+        }
+    }
+
+    value = (key != NULL) ? xmlSecKeyGetValue(key) : NULL;
+    if((value != NULL) && (value->id != NULL) && (value->id->name != NULL)) {
+        ret = xmlSecSimpleKeysStoreIndexAdd(keys->byId, value->id->name, keys->items, pos, 0);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecSimpleKeysStoreIndexAdd",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "byId");
+            return(-1);
+        }
+    }
+
+    keys->itemsSize = pos + 1;
+    return(0);
+}
+
+static int
+xmlSecSimpleKeysStoreReindex(xmlSecSimpleKeysStoreKeysPtr keys) {
+    xmlSecSize pos, size;
+    int ret;
+
+    xmlSecAssert2(keys != NULL, -1);
+
+    if(keys->byName != NULL) {
+        xmlHashFree(keys->byName, NULL);
+    }
+    if(keys->byId != NULL) {
+        xmlHashFree(keys->byId, NULL);
+    }
+    keys->itemsSize = 0;
+
+    keys->byName = xmlHashCreate(0);
+    keys->byId = xmlHashCreate(0);
+    if((keys->byName == NULL) || (keys->byId == NULL)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlHashCreate",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    size = xmlSecPtrListGetSize(&(keys->keys));
+    for(pos = 0; pos < size; ++pos) {
+        ret = xmlSecSimpleKeysStoreIndexKey(keys, pos);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecSimpleKeysStoreIndexKey",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "pos=%d", (int)pos);
+            return(-1);
+        }
+    }
+    return(0);
+}
+
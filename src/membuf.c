@@ -29,18 +29,31 @@
  *
  * Memory Buffer Transform
  *
- * xmlSecBuffer is located after xmlSecTransform
+ * xmlSecTransformMemBufCtx is located after xmlSecTransform
  *
  ****************************************************************************/
+typedef struct _xmlSecTransformMemBufCtx                xmlSecTransformMemBufCtx,
+                                                        *xmlSecTransformMemBufCtxPtr;
+struct _xmlSecTransformMemBufCtx {
+    xmlSecBuffer                                buffer;
+    xmlSecTransformMemBufWriteCallback          writeCallback;
+    void*                                       writeCallbackCtx;
+};
+
 #define xmlSecTransformMemBufSize \
-        (sizeof(xmlSecTransform) + sizeof(xmlSecBuffer))
-#define xmlSecTransformMemBufGetBuf(transform) \
+        (sizeof(xmlSecTransform) + sizeof(xmlSecTransformMemBufCtx))
+#define xmlSecTransformMemBufGetCtx(transform) \
     ((xmlSecTransformCheckSize((transform), xmlSecTransformMemBufSize)) ? \
-        (xmlSecBufferPtr)(((xmlSecByte*)(transform)) + sizeof(xmlSecTransform)) : \
-        (xmlSecBufferPtr)NULL)
+        (xmlSecTransformMemBufCtxPtr)(((xmlSecByte*)(transform)) + sizeof(xmlSecTransform)) : \
+        (xmlSecTransformMemBufCtxPtr)NULL)
 
 static int              xmlSecTransformMemBufInitialize         (xmlSecTransformPtr transform);
 static void             xmlSecTransformMemBufFinalize           (xmlSecTransformPtr transform);
+static int              xmlSecTransformMemBufPushBin            (xmlSecTransformPtr transform,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize,
+                                                                 int final,
+                                                                 xmlSecTransformCtxPtr transformCtx);
 static int              xmlSecTransformMemBufExecute            (xmlSecTransformPtr transform,
                                                                  int last,
                                                                  xmlSecTransformCtxPtr transformCtx);
@@ -61,7 +74,7 @@ static xmlSecTransformKlass xmlSecTransformMemBufKlass = {
     NULL,                                       /* xmlSecTransformSetKeyMethod setKey; */
     NULL,                                       /* xmlSecTransformValidateMethod validate; */
     xmlSecTransformDefaultGetDataType,          /* xmlSecTransformGetDataTypeMethod getDataType; */
-    xmlSecTransformDefaultPushBin,              /* xmlSecTransformPushBinMethod pushBin; */
+    xmlSecTransformMemBufPushBin,               /* xmlSecTransformPushBinMethod pushBin; */
     xmlSecTransformDefaultPopBin,               /* xmlSecTransformPopBinMethod popBin; */
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
@@ -93,27 +106,58 @@ xmlSecTransformMemBufGetKlass(void) {
  */
 xmlSecBufferPtr
 xmlSecTransformMemBufGetBuffer(xmlSecTransformPtr transform) {
-    xmlSecBufferPtr buffer;
+    xmlSecTransformMemBufCtxPtr ctx;
 
     xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformMemBufId), NULL);
 
-    buffer = xmlSecTransformMemBufGetBuf(transform);
-    xmlSecAssert2(buffer != NULL, NULL);
+    ctx = xmlSecTransformMemBufGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    return(&(ctx->buffer));
+}
+
+/**
+ * xmlSecTransformMemBufSetWriteCallback:
+ * @transform:          the pointer to memory buffer transform.
+ * @callback:           the write callback (or NULL to store data in the buffer).
+ * @context:            the user context for @callback.
+ *
+ * Sets the callback that receives the data going through the memory buffer
+ * transform chunk by chunk. If the callback is set then the data are not
+ * stored in the transform's buffer, which keeps memory usage bounded for
+ * large inputs. This function must be called before processing starts.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecTransformMemBufSetWriteCallback(xmlSecTransformPtr transform,
+                                      xmlSecTransformMemBufWriteCallback callback,
+                                      void* context) {
+    xmlSecTransformMemBufCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformMemBufId), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusNone, -1);
+
+    ctx = xmlSecTransformMemBufGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
 
-    return(buffer);
+    ctx->writeCallback    = callback;
+    ctx->writeCallbackCtx = context;
+    return(0);
 }
 
 static int
 xmlSecTransformMemBufInitialize(xmlSecTransformPtr transform) {
-    xmlSecBufferPtr buffer;
+    xmlSecTransformMemBufCtxPtr ctx;
     int ret;
 
     xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformMemBufId), -1);
 
-    buffer = xmlSecTransformMemBufGetBuf(transform);
-    xmlSecAssert2(buffer != NULL, -1);
+    ctx = xmlSecTransformMemBufGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
 
-    ret = xmlSecBufferInitialize(buffer, 0);
+    memset(ctx, 0, sizeof(xmlSecTransformMemBufCtx));
+    ret = xmlSecBufferInitialize(&(ctx->buffer), 0);
     if(ret < 0) {
         xmlSecError(XMLSEC_ERRORS_HERE,
                     xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
@@ -127,19 +171,79 @@ xmlSecTransformMemBufInitialize(xmlSecTransformPtr transform) {
 
 static void
 xmlSecTransformMemBufFinalize(xmlSecTransformPtr transform) {
-    xmlSecBufferPtr buffer;
+    xmlSecTransformMemBufCtxPtr ctx;
 
     xmlSecAssert(xmlSecTransformCheckId(transform, xmlSecTransformMemBufId));
 
-    buffer = xmlSecTransformMemBufGetBuf(transform);
-    xmlSecAssert(buffer != NULL);
+    ctx = xmlSecTransformMemBufGetCtx(transform);
+    xmlSecAssert(ctx != NULL);
 
-    xmlSecBufferFinalize(xmlSecTransformMemBufGetBuf(transform));
+    xmlSecBufferFinalize(&(ctx->buffer));
+    memset(ctx, 0, sizeof(xmlSecTransformMemBufCtx));
+}
+
+/*
+ * When the memory buffer is the last transform in the chain (the usual case for
+ * the transforms ctx result), there is no one to pass the data to: store it
+ * (or give it to the write callback) as is instead of going through the input
+ * and output buffers chunk by chunk.
+ */
+static int
+xmlSecTransformMemBufPushBin(xmlSecTransformPtr transform, const xmlSecByte* data,
+                             xmlSecSize dataSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecTransformMemBufCtxPtr ctx;
+    int ret;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformMemBufId), -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    ctx = xmlSecTransformMemBufGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    if((transform->next != NULL) || (transform->status == xmlSecTransformStatusFinished) ||
+       (xmlSecBufferGetSize(&(transform->inBuf)) > 0)) {
+        return(xmlSecTransformDefaultPushBin(transform, data, dataSize, final, transformCtx));
+    }
+
+    if(transform->status == xmlSecTransformStatusNone) {
+        transform->status = xmlSecTransformStatusWorking;
+    }
+
+    if(dataSize > 0) {
+        xmlSecAssert2(data != NULL, -1);
+
+        if(ctx->writeCallback != NULL) {
+            ret = ctx->writeCallback(ctx->writeCallbackCtx, data, dataSize);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
+                            "writeCallback",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            "size=%d", dataSize);
+                return(-1);
+            }
+        } else {
+            ret = xmlSecBufferAppend(&(ctx->buffer), data, dataSize);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
+                            "xmlSecBufferAppend",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            "size=%d", dataSize);
+                return(-1);
+            }
+        }
+    }
+
+    if(final != 0) {
+        transform->status = xmlSecTransformStatusFinished;
+    }
+    return(0);
 }
 
 static int
 xmlSecTransformMemBufExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
-    xmlSecBufferPtr buffer;
+    xmlSecTransformMemBufCtxPtr ctx;
     xmlSecBufferPtr in, out;
     xmlSecSize inSize;
     int ret;
@@ -147,8 +251,8 @@ xmlSecTransformMemBufExecute(xmlSecTransformPtr transform, int last, xmlSecTrans
     xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformMemBufId), -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
-    buffer = xmlSecTransformMemBufGetBuf(transform);
-    xmlSecAssert2(buffer != NULL, -1);
+    ctx = xmlSecTransformMemBufGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
 
     in = &(transform->inBuf);
     out = &(transform->outBuf);
@@ -159,15 +263,29 @@ xmlSecTransformMemBufExecute(xmlSecTransformPtr transform, int last, xmlSecTrans
     }
 
     if(transform->status == xmlSecTransformStatusWorking) {
-        /* just copy everything from in to our buffer and out */
-        ret = xmlSecBufferAppend(buffer, xmlSecBufferGetData(in), inSize);
-        if(ret < 0) {
-            xmlSecError(XMLSEC_ERRORS_HERE,
-                        xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
-                        "xmlSecBufferAppend",
-                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
-                        "size=%d", inSize);
-            return(-1);
+        /* just copy everything from in to our buffer (or callback) and out */
+        if(ctx->writeCallback != NULL) {
+            if(inSize > 0) {
+                ret = ctx->writeCallback(ctx->writeCallbackCtx, xmlSecBufferGetData(in), inSize);
+                if(ret < 0) {
+                    xmlSecError(XMLSEC_ERRORS_HERE,
+                                xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
+                                "writeCallback",
+                                XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                                "size=%d", inSize);
+                    return(-1);
+                }
+            }
+        } else {
+            ret = xmlSecBufferAppend(&(ctx->buffer), xmlSecBufferGetData(in), inSize);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
+                            "xmlSecBufferAppend",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            "size=%d", inSize);
+                return(-1);
+            }
         }
 
         ret = xmlSecBufferAppend(out, xmlSecBufferGetData(in), inSize);
@@ -451,7 +451,7 @@ xmlSecMSCryptoKeysStoreFindKey(xmlSecKeyStorePtr store, const xmlChar* name,
     xmlSecAssert2(((ss != NULL) && (*ss != NULL)), NULL);
 
     /* first try to find key in the simple keys store */
-    key = xmlSecKeyStoreFindKey(*ss, name, keyInfoCtx);
+    key = xmlSecKeyStoreFindKeyShared(*ss, name, keyInfoCtx);
     if (key != NULL) {
         return (key);
     }
@@ -75,8 +75,10 @@ static xmlSecKeyDataStoreKlass xmlSecMSCryptoX509StoreKlass = {
     xmlSecMSCryptoX509StoreInitialize,      /* xmlSecKeyDataStoreInitializeMethod initialize; */
     xmlSecMSCryptoX509StoreFinalize,        /* xmlSecKeyDataStoreFinalizeMethod finalize; */
 
+    /* content changes tracking */
+    NULL,                                   /* xmlSecKeyDataStoreGetGenerationMethod getGeneration; */
+
     /* reserved for the future */
-    NULL,                    /* void* reserved0; */
     NULL,                    /* void* reserved1; */
 };
 
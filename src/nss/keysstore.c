@@ -318,7 +318,7 @@ xmlSecNssKeysStoreFindKey(xmlSecKeyStorePtr store, const xmlChar* name,
     ss = xmlSecNssKeysStoreGetSS(store);
     xmlSecAssert2(((ss != NULL) && (*ss != NULL)), NULL);
 
-    key = xmlSecKeyStoreFindKey(*ss, name, keyInfoCtx);
+    key = xmlSecKeyStoreFindKeyShared(*ss, name, keyInfoCtx);
     if (key != NULL) {
         return (key);
     }
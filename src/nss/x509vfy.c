@@ -94,8 +94,10 @@ static xmlSecKeyDataStoreKlass xmlSecNssX509StoreKlass = {
     xmlSecNssX509StoreInitialize,               /* xmlSecKeyDataStoreInitializeMethod initialize; */
     xmlSecNssX509StoreFinalize,                 /* xmlSecKeyDataStoreFinalizeMethod finalize; */
 
+    /* content changes tracking */
+    NULL,                                       /* xmlSecKeyDataStoreGetGenerationMethod getGeneration; */
+
     /* reserved for the future */
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
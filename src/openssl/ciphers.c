@@ -26,6 +26,13 @@
 #define EVP_CIPHER_CTX_encrypting(x) ((x)->encrypt)
 #endif /* !defined(XMLSEC_OPENSSL_110) */
 
+/* XML Encryption 1.1 AES GCM: 96 bit IV and 128 bit authentication tag */
+#define XMLSEC_OPENSSL_AES_GCM_IV_SIZE          12
+#define XMLSEC_OPENSSL_AES_GCM_TAG_SIZE         16
+
+/* large pushes are encrypted/decrypted directly from the caller's data in strides of this size */
+#define XMLSEC_OPENSSL_EVP_CIPHER_BULK_SIZE     (1024 * 1024)
+
 
 /**************************************************************************
  *
@@ -43,6 +50,7 @@ struct _xmlSecOpenSSLEvpBlockCipherCtx {
     xmlSecByte          key[EVP_MAX_KEY_LENGTH];
     xmlSecByte          iv[EVP_MAX_IV_LENGTH];
     xmlSecByte          pad[2*EVP_MAX_BLOCK_LENGTH];
+    int                 gcmMode;
 };
 
 static int      xmlSecOpenSSLEvpBlockCipherCtxInit      (xmlSecOpenSSLEvpBlockCipherCtxPtr ctx,
@@ -67,6 +75,18 @@ static int      xmlSecOpenSSLEvpBlockCipherCtxFinal     (xmlSecOpenSSLEvpBlockCi
                                                          xmlSecBufferPtr out,
                                                          const xmlChar* cipherName,
                                                          xmlSecTransformCtxPtr transformCtx);
+#ifndef XMLSEC_NO_AES
+static int      xmlSecOpenSSLEvpBlockCipherGCMCtxUpdate (xmlSecOpenSSLEvpBlockCipherCtxPtr ctx,
+                                                         xmlSecBufferPtr in,
+                                                         xmlSecBufferPtr out,
+                                                         const xmlChar* cipherName,
+                                                         xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecOpenSSLEvpBlockCipherGCMCtxFinal  (xmlSecOpenSSLEvpBlockCipherCtxPtr ctx,
+                                                         xmlSecBufferPtr in,
+                                                         xmlSecBufferPtr out,
+                                                         const xmlChar* cipherName,
+                                                         xmlSecTransformCtxPtr transformCtx);
+#endif /* XMLSEC_NO_AES */
 static int
 xmlSecOpenSSLEvpBlockCipherCtxInit(xmlSecOpenSSLEvpBlockCipherCtxPtr ctx,
                                 xmlSecBufferPtr in, xmlSecBufferPtr out,
@@ -88,6 +108,7 @@ xmlSecOpenSSLEvpBlockCipherCtxInit(xmlSecOpenSSLEvpBlockCipherCtxPtr ctx,
     ivLen = EVP_CIPHER_iv_length(ctx->cipher);
     xmlSecAssert2(ivLen > 0, -1);
     xmlSecAssert2((xmlSecSize)ivLen <= sizeof(ctx->iv), -1);
+    xmlSecAssert2((ctx->gcmMode == 0) || (ivLen == XMLSEC_OPENSSL_AES_GCM_IV_SIZE), -1);
 
     if(encrypt) {
         /* generate random iv */
@@ -262,6 +283,12 @@ xmlSecOpenSSLEvpBlockCipherCtxUpdate(xmlSecOpenSSLEvpBlockCipherCtxPtr ctx,
     xmlSecAssert2(out != NULL, -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
+#ifndef XMLSEC_NO_AES
+    if(ctx->gcmMode != 0) {
+        return(xmlSecOpenSSLEvpBlockCipherGCMCtxUpdate(ctx, in, out, cipherName, transformCtx));
+    }
+#endif /* XMLSEC_NO_AES */
+
     blockLen = EVP_CIPHER_block_size(ctx->cipher);
     xmlSecAssert2(blockLen > 0, -1);
 
@@ -335,6 +362,12 @@ xmlSecOpenSSLEvpBlockCipherCtxFinal(xmlSecOpenSSLEvpBlockCipherCtxPtr ctx,
     xmlSecAssert2(out != NULL, -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
+#ifndef XMLSEC_NO_AES
+    if(ctx->gcmMode != 0) {
+        return(xmlSecOpenSSLEvpBlockCipherGCMCtxFinal(ctx, in, out, cipherName, transformCtx));
+    }
+#endif /* XMLSEC_NO_AES */
+
     blockLen = EVP_CIPHER_block_size(ctx->cipher);
     xmlSecAssert2(blockLen > 0, -1);
     xmlSecAssert2(blockLen <= EVP_MAX_BLOCK_LENGTH, -1);
@@ -461,6 +494,192 @@ xmlSecOpenSSLEvpBlockCipherCtxFinal(xmlSecOpenSSLEvpBlockCipherCtxPtr ctx,
 }
 
 
+#ifndef XMLSEC_NO_AES
+/*
+ * AES GCM (http://www.w3.org/TR/xmlenc-core1/#sec-AES-GCM) does not use
+ * padding: the cipher text is IV || encrypted data || authentication tag.
+ * The data is encrypted in one pass as it arrives. On decryption, nothing
+ * is released before the tag is verified: the cipher text is collected
+ * and decrypted in Final() and the plain text is only passed to the next
+ * transform if the authentication tag matches.
+ */
+static int
+xmlSecOpenSSLEvpBlockCipherGCMCtxUpdate(xmlSecOpenSSLEvpBlockCipherCtxPtr ctx,
+                                     xmlSecBufferPtr in, xmlSecBufferPtr out,
+                                     const xmlChar* cipherName,
+                                     xmlSecTransformCtxPtr transformCtx) {
+    xmlSecSize inSize;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->cipherCtx != NULL, -1);
+    xmlSecAssert2(ctx->gcmMode != 0, -1);
+    xmlSecAssert2(ctx->ctxInitialized != 0, -1);
+    xmlSecAssert2(in != NULL, -1);
+    xmlSecAssert2(out != NULL, -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    /* collect everything for Final() on decryption */
+    if(!EVP_CIPHER_CTX_encrypting(ctx->cipherCtx)) {
+        return(0);
+    }
+
+    inSize = xmlSecBufferGetSize(in);
+    if(inSize == 0) {
+        return(0);
+    }
+
+    ret = xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock(ctx, xmlSecBufferGetData(in), (int)inSize, out, cipherName, 0); /* not final */
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(cipherName),
+                    "xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    NULL);
+        return(-1);
+    }
+
+    /* remove the processed data from input */
+    ret = xmlSecBufferRemoveHead(in, inSize);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(cipherName),
+                    "xmlSecBufferRemoveHead",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "size=%d", (int)inSize);
+        return(-1);
+    }
+
+    /* done */
+    return(0);
+}
+
+static int
+xmlSecOpenSSLEvpBlockCipherGCMCtxFinal(xmlSecOpenSSLEvpBlockCipherCtxPtr ctx,
+                                    xmlSecBufferPtr in,
+                                    xmlSecBufferPtr out,
+                                    const xmlChar* cipherName,
+                                    xmlSecTransformCtxPtr transformCtx) {
+    xmlSecByte tag[XMLSEC_OPENSSL_AES_GCM_TAG_SIZE];
+    xmlSecSize inSize;
+    int outLen = 0;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->cipherCtx != NULL, -1);
+    xmlSecAssert2(ctx->gcmMode != 0, -1);
+    xmlSecAssert2(ctx->ctxInitialized != 0, -1);
+    xmlSecAssert2(in != NULL, -1);
+    xmlSecAssert2(out != NULL, -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    inSize = xmlSecBufferGetSize(in);
+    if(EVP_CIPHER_CTX_encrypting(ctx->cipherCtx)) {
+        /* everything was processed in Update() */
+        xmlSecAssert2(inSize == 0, -1);
+
+        /* GCM doesn't output anything on finalization */
+        ret = EVP_CipherFinal(ctx->cipherCtx, tag, &outLen);
+        if(ret != 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(cipherName),
+                        "EVP_CipherFinal",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+        xmlSecAssert2(outLen == 0, -1);
+
+        /* append the authentication tag */
+        ret = EVP_CIPHER_CTX_ctrl(ctx->cipherCtx, EVP_CTRL_GCM_GET_TAG, sizeof(tag), tag);
+        if(ret != 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(cipherName),
+                        "EVP_CIPHER_CTX_ctrl",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        "EVP_CTRL_GCM_GET_TAG");
+            return(-1);
+        }
+
+        ret = xmlSecBufferAppend(out, tag, sizeof(tag));
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(cipherName),
+                        "xmlSecBufferAppend",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "size=%d", (int)sizeof(tag));
+            return(-1);
+        }
+    } else {
+        /* the cipher text is followed by the authentication tag */
+        if(inSize < sizeof(tag)) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(cipherName),
+                        NULL,
+                        XMLSEC_ERRORS_R_INVALID_DATA,
+                        "inSize=%d;tagLen=%d",
+                        (int)inSize, (int)sizeof(tag));
+            return(-1);
+        }
+        memcpy(tag, xmlSecBufferGetData(in) + inSize - sizeof(tag), sizeof(tag));
+
+        if(inSize > sizeof(tag)) {
+            ret = xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock(ctx, xmlSecBufferGetData(in),
+                                                    (int)(inSize - sizeof(tag)),
+                                                    out, cipherName, 0); /* not final */
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(cipherName),
+                            "xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            NULL);
+                xmlSecBufferEmpty(out);
+                return(-1);
+            }
+        }
+
+        ret = EVP_CIPHER_CTX_ctrl(ctx->cipherCtx, EVP_CTRL_GCM_SET_TAG, sizeof(tag), tag);
+        if(ret != 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(cipherName),
+                        "EVP_CIPHER_CTX_ctrl",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        "EVP_CTRL_GCM_SET_TAG");
+            xmlSecBufferEmpty(out);
+            return(-1);
+        }
+
+        /* verify the authentication tag, the plain text is dropped on mismatch */
+        ret = EVP_CipherFinal(ctx->cipherCtx, tag, &outLen);
+        if(ret != 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(cipherName),
+                        "EVP_CipherFinal",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        "authentication tag verification failed");
+            xmlSecBufferEmpty(out);
+            return(-1);
+        }
+        xmlSecAssert2(outLen == 0, -1);
+
+        /* remove the cipher text and the tag from input */
+        ret = xmlSecBufferRemoveHead(in, inSize);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(cipherName),
+                        "xmlSecBufferRemoveHead",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "size=%d", (int)inSize);
+            return(-1);
+        }
+    }
+
+    /* done */
+    return(0);
+}
+#endif /* XMLSEC_NO_AES */
+
+
 /******************************************************************************
  *
  * EVP Block Cipher transforms
@@ -479,6 +698,11 @@ static int      xmlSecOpenSSLEvpBlockCipherSetKeyReq    (xmlSecTransformPtr tran
                                                          xmlSecKeyReqPtr keyReq);
 static int      xmlSecOpenSSLEvpBlockCipherSetKey       (xmlSecTransformPtr transform,
                                                          xmlSecKeyPtr key);
+static int      xmlSecOpenSSLEvpBlockCipherPushBin      (xmlSecTransformPtr transform,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize,
+                                                         int final,
+                                                         xmlSecTransformCtxPtr transformCtx);
 static int      xmlSecOpenSSLEvpBlockCipherExecute      (xmlSecTransformPtr transform,
                                                          int last,
                                                          xmlSecTransformCtxPtr transformCtx);
@@ -497,7 +721,10 @@ xmlSecOpenSSLEvpBlockCipherCheckId(xmlSecTransformPtr transform) {
 #ifndef XMLSEC_NO_AES
     if(xmlSecTransformCheckId(transform, xmlSecOpenSSLTransformAes128CbcId) ||
        xmlSecTransformCheckId(transform, xmlSecOpenSSLTransformAes192CbcId) ||
-       xmlSecTransformCheckId(transform, xmlSecOpenSSLTransformAes256CbcId)) {
+       xmlSecTransformCheckId(transform, xmlSecOpenSSLTransformAes256CbcId) ||
+       xmlSecTransformCheckId(transform, xmlSecOpenSSLTransformAes128GcmId) ||
+       xmlSecTransformCheckId(transform, xmlSecOpenSSLTransformAes192GcmId) ||
+       xmlSecTransformCheckId(transform, xmlSecOpenSSLTransformAes256GcmId)) {
 
        return(1);
     }
@@ -535,6 +762,18 @@ xmlSecOpenSSLEvpBlockCipherInitialize(xmlSecTransformPtr transform) {
     } else if(transform->id == xmlSecOpenSSLTransformAes256CbcId) {
         ctx->cipher     = EVP_aes_256_cbc();
         ctx->keyId      = xmlSecOpenSSLKeyDataAesId;
+    } else if(transform->id == xmlSecOpenSSLTransformAes128GcmId) {
+        ctx->cipher     = EVP_aes_128_gcm();
+        ctx->keyId      = xmlSecOpenSSLKeyDataAesId;
+        ctx->gcmMode    = 1;
+    } else if(transform->id == xmlSecOpenSSLTransformAes192GcmId) {
+        ctx->cipher     = EVP_aes_192_gcm();
+        ctx->keyId      = xmlSecOpenSSLKeyDataAesId;
+        ctx->gcmMode    = 1;
+    } else if(transform->id == xmlSecOpenSSLTransformAes256GcmId) {
+        ctx->cipher     = EVP_aes_256_gcm();
+        ctx->keyId      = xmlSecOpenSSLKeyDataAesId;
+        ctx->gcmMode    = 1;
     } else
 #endif /* XMLSEC_NO_AES */
 
@@ -651,6 +890,169 @@ xmlSecOpenSSLEvpBlockCipherSetKey(xmlSecTransformPtr transform, xmlSecKeyPtr key
     return(0);
 }
 
+/*
+ * Large pushes (e.g. xmlSecTransformCtxBinaryExecute() on a big buffer) bypass
+ * the default chunked processing: the data is encrypted/decrypted directly
+ * from the caller's buffer in XMLSEC_OPENSSL_EVP_CIPHER_BULK_SIZE strides and
+ * each stride is pushed to the next transform at once. Only the cipher
+ * initialization, the tail (the last block for padding or the GCM tag) and
+ * the finalization go through the default processing.
+ */
+static int
+xmlSecOpenSSLEvpBlockCipherPushBin(xmlSecTransformPtr transform, const xmlSecByte* data,
+                                xmlSecSize dataSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecOpenSSLEvpBlockCipherCtxPtr ctx;
+    xmlSecBufferPtr in, out;
+    xmlSecSize blockLen, tailLen, inSize, size, stride;
+    int ret;
+
+    xmlSecAssert2(xmlSecOpenSSLEvpBlockCipherCheckId(transform), -1);
+    xmlSecAssert2((transform->operation == xmlSecTransformOperationEncrypt) || (transform->operation == xmlSecTransformOperationDecrypt), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecOpenSSLEvpBlockCipherSize), -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    ctx = xmlSecOpenSSLEvpBlockCipherGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->cipher != NULL, -1);
+
+    in = &(transform->inBuf);
+    out = &(transform->outBuf);
+
+    /* GCM decryption releases nothing before the authentication tag is verified */
+    if((dataSize <= XMLSEC_TRANSFORM_BINARY_CHUNK) || (transform->next == NULL) ||
+       ((transform->status != xmlSecTransformStatusNone) && (transform->status != xmlSecTransformStatusWorking)) ||
+       ((ctx->gcmMode != 0) && (transform->operation == xmlSecTransformOperationDecrypt))) {
+        return(xmlSecTransformDefaultPushBin(transform, data, dataSize, final, transformCtx));
+    }
+    xmlSecAssert2(data != NULL, -1);
+
+    /* let the default processing initialize the cipher: write or read the iv */
+    if(ctx->ctxInitialized == 0) {
+        size = 0;
+        if(transform->operation == xmlSecTransformOperationDecrypt) {
+            size = (xmlSecSize)EVP_CIPHER_iv_length(ctx->cipher);
+            inSize = xmlSecBufferGetSize(in);
+            xmlSecAssert2(inSize < size, -1);
+            size -= inSize;
+        }
+
+        ret = xmlSecTransformDefaultPushBin(transform, data, size, 0, transformCtx);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
+                        "xmlSecTransformDefaultPushBin",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "size=%d", (int)size);
+            return(-1);
+        }
+        xmlSecAssert2(ctx->ctxInitialized != 0, -1);
+
+        data += size;
+        dataSize -= size;
+    }
+
+    blockLen = EVP_CIPHER_block_size(ctx->cipher);
+    xmlSecAssert2(blockLen > 0, -1);
+    xmlSecAssert2((XMLSEC_OPENSSL_EVP_CIPHER_BULK_SIZE % blockLen) == 0, -1);
+
+    /* the data we need to keep for Final(): at least one byte (the last
+     * block) for the padding, nothing for GCM encryption */
+    tailLen = (ctx->gcmMode != 0) ? 0 : 1;
+    xmlSecAssert2(dataSize > tailLen + blockLen, -1);
+
+    /* complete the buffered block (if any) and process it: there is more data
+     * coming so it is not the tail */
+    inSize = xmlSecBufferGetSize(in);
+    if(inSize > 0) {
+        size = (blockLen - (inSize % blockLen)) % blockLen;
+        ret = xmlSecBufferAppend(in, data, size);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
+                        "xmlSecBufferAppend",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "size=%d", (int)size);
+            return(-1);
+        }
+        data += size;
+        dataSize -= size;
+
+        inSize = xmlSecBufferGetSize(in);
+        ret = xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock(ctx, xmlSecBufferGetData(in), (int)inSize, out,
+                                                xmlSecTransformGetName(transform), 0); /* not final */
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
+                        "xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        NULL);
+            return(-1);
+        }
+
+        ret = xmlSecBufferRemoveHead(in, inSize);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
+                        "xmlSecBufferRemoveHead",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "size=%d", (int)inSize);
+            return(-1);
+        }
+    }
+
+    /* process all complete blocks except the tail directly from the caller's data */
+    size = dataSize - tailLen;
+    size -= (size % blockLen);
+    while(size > 0) {
+        stride = size;
+        if(stride > XMLSEC_OPENSSL_EVP_CIPHER_BULK_SIZE) {
+            stride = XMLSEC_OPENSSL_EVP_CIPHER_BULK_SIZE;
+        }
+
+        ret = xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock(ctx, data, (int)stride, out,
+                                                xmlSecTransformGetName(transform), 0); /* not final */
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
+                        "xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        NULL);
+            return(-1);
+        }
+        data += stride;
+        dataSize -= stride;
+        size -= stride;
+
+        ret = xmlSecTransformPushBin(transform->next,
+                                xmlSecBufferGetData(out),
+                                xmlSecBufferGetSize(out),
+                                0,
+                                transformCtx);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecTransformGetName(transform->next)),
+                        "xmlSecTransformPushBin",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "outSize=%d", (int)xmlSecBufferGetSize(out));
+            return(-1);
+        }
+
+        /* the output buffer keeps its allocation for the next stride */
+        ret = xmlSecBufferSetSize(out, 0);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
+                        "xmlSecBufferSetSize",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "size=0");
+            return(-1);
+        }
+    }
+
+    /* the tail goes through the default processing */
+    return(xmlSecTransformDefaultPushBin(transform, data, dataSize, final, transformCtx));
+}
+
 static int
 xmlSecOpenSSLEvpBlockCipherExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
     xmlSecOpenSSLEvpBlockCipherCtxPtr ctx;
@@ -768,7 +1170,7 @@ static xmlSecTransformKlass xmlSecOpenSSLAes128CbcKlass = {
     xmlSecOpenSSLEvpBlockCipherSetKey,          /* xmlSecTransformSetKeyMethod setKey; */
     NULL,                                       /* xmlSecTransformValidateMethod validate; */
     xmlSecTransformDefaultGetDataType,          /* xmlSecTransformGetDataTypeMethod getDataType; */
-    xmlSecTransformDefaultPushBin,              /* xmlSecTransformPushBinMethod pushBin; */
+    xmlSecOpenSSLEvpBlockCipherPushBin,         /* xmlSecTransformPushBinMethod pushBin; */
     xmlSecTransformDefaultPopBin,               /* xmlSecTransformPopBinMethod popBin; */
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
@@ -807,7 +1209,7 @@ static xmlSecTransformKlass xmlSecOpenSSLAes192CbcKlass = {
     xmlSecOpenSSLEvpBlockCipherSetKey,          /* xmlSecTransformSetKeyMethod setKey; */
     NULL,                                       /* xmlSecTransformValidateMethod validate; */
     xmlSecTransformDefaultGetDataType,          /* xmlSecTransformGetDataTypeMethod getDataType; */
-    xmlSecTransformDefaultPushBin,              /* xmlSecTransformPushBinMethod pushBin; */
+    xmlSecOpenSSLEvpBlockCipherPushBin,         /* xmlSecTransformPushBinMethod pushBin; */
     xmlSecTransformDefaultPopBin,               /* xmlSecTransformPopBinMethod popBin; */
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
@@ -846,7 +1248,7 @@ static xmlSecTransformKlass xmlSecOpenSSLAes256CbcKlass = {
     xmlSecOpenSSLEvpBlockCipherSetKey,          /* xmlSecTransformSetKeyMethod setKey; */
     NULL,                                       /* xmlSecTransformValidateMethod validate; */
     xmlSecTransformDefaultGetDataType,          /* xmlSecTransformGetDataTypeMethod getDataType; */
-    xmlSecTransformDefaultPushBin,              /* xmlSecTransformPushBinMethod pushBin; */
+    xmlSecOpenSSLEvpBlockCipherPushBin,         /* xmlSecTransformPushBinMethod pushBin; */
     xmlSecTransformDefaultPopBin,               /* xmlSecTransformPopBinMethod popBin; */
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
@@ -868,6 +1270,128 @@ xmlSecOpenSSLTransformAes256CbcGetKlass(void) {
     return(&xmlSecOpenSSLAes256CbcKlass);
 }
 
+/*********************************************************************
+ *
+ * AES GCM cipher transforms
+ *
+ ********************************************************************/
+static xmlSecTransformKlass xmlSecOpenSSLAes128GcmKlass = {
+    /* klass/object sizes */
+    sizeof(xmlSecTransformKlass),               /* xmlSecSize klassSize */
+    xmlSecOpenSSLEvpBlockCipherSize,            /* xmlSecSize objSize */
+
+    xmlSecNameAes128Gcm,                        /* const xmlChar* name; */
+    xmlSecHrefAes128Gcm,                        /* const xmlChar* href; */
+    xmlSecTransformUsageEncryptionMethod,       /* xmlSecAlgorithmUsage usage; */
+
+    xmlSecOpenSSLEvpBlockCipherInitialize,      /* xmlSecTransformInitializeMethod initialize; */
+    xmlSecOpenSSLEvpBlockCipherFinalize,        /* xmlSecTransformFinalizeMethod finalize; */
+    NULL,                                       /* xmlSecTransformNodeReadMethod readNode; */
+    NULL,                                       /* xmlSecTransformNodeWriteMethod writeNode; */
+    xmlSecOpenSSLEvpBlockCipherSetKeyReq,       /* xmlSecTransformSetKeyMethod setKeyReq; */
+    xmlSecOpenSSLEvpBlockCipherSetKey,          /* xmlSecTransformSetKeyMethod setKey; */
+    NULL,                                       /* xmlSecTransformValidateMethod validate; */
+    xmlSecTransformDefaultGetDataType,          /* xmlSecTransformGetDataTypeMethod getDataType; */
+    xmlSecOpenSSLEvpBlockCipherPushBin,         /* xmlSecTransformPushBinMethod pushBin; */
+    xmlSecTransformDefaultPopBin,               /* xmlSecTransformPopBinMethod popBin; */
+    NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
+    NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
+    xmlSecOpenSSLEvpBlockCipherExecute,         /* xmlSecTransformExecuteMethod execute; */
+
+    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* void* reserved1; */
+};
+
+/**
+ * xmlSecOpenSSLTransformAes128GcmGetKlass:
+ *
+ * AES 128 GCM encryption transform klass.
+ *
+ * Returns: pointer to AES 128 GCM encryption transform.
+ */
+xmlSecTransformId
+xmlSecOpenSSLTransformAes128GcmGetKlass(void) {
+    return(&xmlSecOpenSSLAes128GcmKlass);
+}
+
+static xmlSecTransformKlass xmlSecOpenSSLAes192GcmKlass = {
+    /* klass/object sizes */
+    sizeof(xmlSecTransformKlass),               /* xmlSecSize klassSize */
+    xmlSecOpenSSLEvpBlockCipherSize,            /* xmlSecSize objSize */
+
+    xmlSecNameAes192Gcm,                        /* const xmlChar* name; */
+    xmlSecHrefAes192Gcm,                        /* const xmlChar* href; */
+    xmlSecTransformUsageEncryptionMethod,       /* xmlSecAlgorithmUsage usage; */
+
+    xmlSecOpenSSLEvpBlockCipherInitialize,      /* xmlSecTransformInitializeMethod initialize; */
+    xmlSecOpenSSLEvpBlockCipherFinalize,        /* xmlSecTransformFinalizeMethod finalize; */
+    NULL,                                       /* xmlSecTransformNodeReadMethod readNode; */
+    NULL,                                       /* xmlSecTransformNodeWriteMethod writeNode; */
+    xmlSecOpenSSLEvpBlockCipherSetKeyReq,       /* xmlSecTransformSetKeyMethod setKeyReq; */
+    xmlSecOpenSSLEvpBlockCipherSetKey,          /* xmlSecTransformSetKeyMethod setKey; */
+    NULL,                                       /* xmlSecTransformValidateMethod validate; */
+    xmlSecTransformDefaultGetDataType,          /* xmlSecTransformGetDataTypeMethod getDataType; */
+    xmlSecOpenSSLEvpBlockCipherPushBin,         /* xmlSecTransformPushBinMethod pushBin; */
+    xmlSecTransformDefaultPopBin,               /* xmlSecTransformPopBinMethod popBin; */
+    NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
+    NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
+    xmlSecOpenSSLEvpBlockCipherExecute,         /* xmlSecTransformExecuteMethod execute; */
+
+    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* void* reserved1; */
+};
+
+/**
+ * xmlSecOpenSSLTransformAes192GcmGetKlass:
+ *
+ * AES 192 GCM encryption transform klass.
+ *
+ * Returns: pointer to AES 192 GCM encryption transform.
+ */
+xmlSecTransformId
+xmlSecOpenSSLTransformAes192GcmGetKlass(void) {
+    return(&xmlSecOpenSSLAes192GcmKlass);
+}
+
+static xmlSecTransformKlass xmlSecOpenSSLAes256GcmKlass = {
+    /* klass/object sizes */
+    sizeof(xmlSecTransformKlass),               /* xmlSecSize klassSize */
+    xmlSecOpenSSLEvpBlockCipherSize,            /* xmlSecSize objSize */
+
+    xmlSecNameAes256Gcm,                        /* const xmlChar* name; */
+    xmlSecHrefAes256Gcm,                        /* const xmlChar* href; */
+    xmlSecTransformUsageEncryptionMethod,       /* xmlSecAlgorithmUsage usage; */
+
+    xmlSecOpenSSLEvpBlockCipherInitialize,      /* xmlSecTransformInitializeMethod initialize; */
+    xmlSecOpenSSLEvpBlockCipherFinalize,        /* xmlSecTransformFinalizeMethod finalize; */
+    NULL,                                       /* xmlSecTransformNodeReadMethod readNode; */
+    NULL,                                       /* xmlSecTransformNodeWriteMethod writeNode; */
+    xmlSecOpenSSLEvpBlockCipherSetKeyReq,       /* xmlSecTransformSetKeyMethod setKeyReq; */
+    xmlSecOpenSSLEvpBlockCipherSetKey,          /* xmlSecTransformSetKeyMethod setKey; */
+    NULL,                                       /* xmlSecTransformValidateMethod validate; */
+    xmlSecTransformDefaultGetDataType,          /* xmlSecTransformGetDataTypeMethod getDataType; */
+    xmlSecOpenSSLEvpBlockCipherPushBin,         /* xmlSecTransformPushBinMethod pushBin; */
+    xmlSecTransformDefaultPopBin,               /* xmlSecTransformPopBinMethod popBin; */
+    NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
+    NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
+    xmlSecOpenSSLEvpBlockCipherExecute,         /* xmlSecTransformExecuteMethod execute; */
+
+    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* void* reserved1; */
+};
+
+/**
+ * xmlSecOpenSSLTransformAes256GcmGetKlass:
+ *
+ * AES 256 GCM encryption transform klass.
+ *
+ * Returns: pointer to AES 256 GCM encryption transform.
+ */
+xmlSecTransformId
+xmlSecOpenSSLTransformAes256GcmGetKlass(void) {
+    return(&xmlSecOpenSSLAes256GcmKlass);
+}
+
 #endif /* XMLSEC_NO_AES */
 
 #ifndef XMLSEC_NO_DES
@@ -888,7 +1412,7 @@ static xmlSecTransformKlass xmlSecOpenSSLDes3CbcKlass = {
     xmlSecOpenSSLEvpBlockCipherSetKey,          /* xmlSecTransformSetKeyMethod setKey; */
     NULL,                                       /* xmlSecTransformValidateMethod validate; */
     xmlSecTransformDefaultGetDataType,          /* xmlSecTransformGetDataTypeMethod getDataType; */
-    xmlSecTransformDefaultPushBin,              /* xmlSecTransformPushBinMethod pushBin; */
+    xmlSecOpenSSLEvpBlockCipherPushBin,         /* xmlSecTransformPushBinMethod pushBin; */
     xmlSecTransformDefaultPopBin,               /* xmlSecTransformPopBinMethod popBin; */
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
@@ -32,6 +32,30 @@
 #define EVP_MD_CTX_md_data(x)  ((x)->md_data)
 #endif /* !defined(XMLSEC_OPENSSL_110) */
 
+/* The EVP_DigestSign*() / EVP_DigestVerify*() API (OpenSSL 1.0.0 and newer) binds the key
+ * to the digest context at init time, the legacy EVP_Sign*() / EVP_Verify*() API used with
+ * OpenSSL 0.9.8 takes it at the final step.
+ */
+#if !defined(XMLSEC_OPENSSL_098)
+#define XMLSEC_OPENSSL_EVP_SIGN_INIT_NAME       "EVP_DigestSignInit"
+#define XMLSEC_OPENSSL_EVP_SIGN_UPDATE          EVP_DigestSignUpdate
+#define XMLSEC_OPENSSL_EVP_SIGN_UPDATE_NAME     "EVP_DigestSignUpdate"
+#define XMLSEC_OPENSSL_EVP_SIGN_FINAL_NAME      "EVP_DigestSignFinal"
+#define XMLSEC_OPENSSL_EVP_VERIFY_INIT_NAME     "EVP_DigestVerifyInit"
+#define XMLSEC_OPENSSL_EVP_VERIFY_UPDATE        EVP_DigestVerifyUpdate
+#define XMLSEC_OPENSSL_EVP_VERIFY_UPDATE_NAME   "EVP_DigestVerifyUpdate"
+#define XMLSEC_OPENSSL_EVP_VERIFY_FINAL_NAME    "EVP_DigestVerifyFinal"
+#else /* !defined(XMLSEC_OPENSSL_098) */
+#define XMLSEC_OPENSSL_EVP_SIGN_INIT_NAME       "EVP_SignInit"
+#define XMLSEC_OPENSSL_EVP_SIGN_UPDATE          EVP_SignUpdate
+#define XMLSEC_OPENSSL_EVP_SIGN_UPDATE_NAME     "EVP_SignUpdate"
+#define XMLSEC_OPENSSL_EVP_SIGN_FINAL_NAME      "EVP_SignFinal"
+#define XMLSEC_OPENSSL_EVP_VERIFY_INIT_NAME     "EVP_VerifyInit"
+#define XMLSEC_OPENSSL_EVP_VERIFY_UPDATE        EVP_VerifyUpdate
+#define XMLSEC_OPENSSL_EVP_VERIFY_UPDATE_NAME   "EVP_VerifyUpdate"
+#define XMLSEC_OPENSSL_EVP_VERIFY_FINAL_NAME    "EVP_VerifyFinal"
+#endif /* !defined(XMLSEC_OPENSSL_098) */
+
 
 /**************************************************************************
  *
@@ -388,18 +412,22 @@ xmlSecOpenSSLEvpSignatureVerify(xmlSecTransformPtr transform,
     xmlSecAssert2(ctx != NULL, -1);
     xmlSecAssert2(ctx->digestCtx != NULL, -1);
 
+#if !defined(XMLSEC_OPENSSL_098)
+    ret = EVP_DigestVerifyFinal(ctx->digestCtx, (xmlSecByte*)data, dataSize);
+#else /* !defined(XMLSEC_OPENSSL_098) */
     ret = EVP_VerifyFinal(ctx->digestCtx, (xmlSecByte*)data, dataSize, ctx->pKey);
+#endif /* !defined(XMLSEC_OPENSSL_098) */
     if(ret < 0) {
         xmlSecError(XMLSEC_ERRORS_HERE,
                     xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
-                    "EVP_VerifyFinal",
+                    XMLSEC_OPENSSL_EVP_VERIFY_FINAL_NAME,
                     XMLSEC_ERRORS_R_CRYPTO_FAILED,
                     XMLSEC_ERRORS_NO_MESSAGE);
         return(-1);
     } else if(ret != 1) {
         xmlSecError(XMLSEC_ERRORS_HERE,
                     xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
-                    "EVP_VerifyFinal",
+                    XMLSEC_OPENSSL_EVP_VERIFY_FINAL_NAME,
                     XMLSEC_ERRORS_R_DATA_NOT_MATCH,
                     "signature do not match");
         transform->status = xmlSecTransformStatusFail;
@@ -441,21 +469,29 @@ xmlSecOpenSSLEvpSignatureExecute(xmlSecTransformPtr transform, int last, xmlSecT
         xmlSecAssert2(outSize == 0, -1);
 
         if(transform->operation == xmlSecTransformOperationSign) {
+#if !defined(XMLSEC_OPENSSL_098)
+            ret = EVP_DigestSignInit(ctx->digestCtx, NULL, ctx->digest, NULL, ctx->pKey);
+#else /* !defined(XMLSEC_OPENSSL_098) */
             ret = EVP_SignInit(ctx->digestCtx, ctx->digest);
+#endif /* !defined(XMLSEC_OPENSSL_098) */
             if(ret != 1) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
-                            "EVP_SignInit",
+                            XMLSEC_OPENSSL_EVP_SIGN_INIT_NAME,
                             XMLSEC_ERRORS_R_CRYPTO_FAILED,
                             XMLSEC_ERRORS_NO_MESSAGE);
                 return(-1);
             }
         } else {
+#if !defined(XMLSEC_OPENSSL_098)
+            ret = EVP_DigestVerifyInit(ctx->digestCtx, NULL, ctx->digest, NULL, ctx->pKey);
+#else /* !defined(XMLSEC_OPENSSL_098) */
             ret = EVP_VerifyInit(ctx->digestCtx, ctx->digest);
+#endif /* !defined(XMLSEC_OPENSSL_098) */
             if(ret != 1) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
-                            "EVP_VerifyInit",
+                            XMLSEC_OPENSSL_EVP_VERIFY_INIT_NAME,
                             XMLSEC_ERRORS_R_CRYPTO_FAILED,
                             XMLSEC_ERRORS_NO_MESSAGE);
                 return(-1);
@@ -468,21 +504,21 @@ xmlSecOpenSSLEvpSignatureExecute(xmlSecTransformPtr transform, int last, xmlSecT
         xmlSecAssert2(outSize == 0, -1);
 
         if(transform->operation == xmlSecTransformOperationSign) {
-            ret = EVP_SignUpdate(ctx->digestCtx, xmlSecBufferGetData(in), inSize);
+            ret = XMLSEC_OPENSSL_EVP_SIGN_UPDATE(ctx->digestCtx, xmlSecBufferGetData(in), inSize);
             if(ret != 1) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
-                            "EVP_SignUpdate",
+                            XMLSEC_OPENSSL_EVP_SIGN_UPDATE_NAME,
                             XMLSEC_ERRORS_R_CRYPTO_FAILED,
                             XMLSEC_ERRORS_NO_MESSAGE);
                 return(-1);
             }
         } else {
-            ret = EVP_VerifyUpdate(ctx->digestCtx, xmlSecBufferGetData(in), inSize);
+            ret = XMLSEC_OPENSSL_EVP_VERIFY_UPDATE(ctx->digestCtx, xmlSecBufferGetData(in), inSize);
             if(ret != 1) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
-                            "EVP_VerifyUpdate",
+                            XMLSEC_OPENSSL_EVP_VERIFY_UPDATE_NAME,
                             XMLSEC_ERRORS_R_CRYPTO_FAILED,
                             XMLSEC_ERRORS_NO_MESSAGE);
                 return(-1);
@@ -503,7 +539,11 @@ xmlSecOpenSSLEvpSignatureExecute(xmlSecTransformPtr transform, int last, xmlSecT
     if((transform->status == xmlSecTransformStatusWorking) && (last != 0)) {
         xmlSecAssert2(outSize == 0, -1);
         if(transform->operation == xmlSecTransformOperationSign) {
+#if !defined(XMLSEC_OPENSSL_098)
+            size_t signSize;
+#else /* !defined(XMLSEC_OPENSSL_098) */
             unsigned int signSize;
+#endif /* !defined(XMLSEC_OPENSSL_098) */
 
             /* for rsa signatures we get size from EVP_PKEY_size() */
             signSize = EVP_PKEY_size(ctx->pKey);
@@ -513,15 +553,19 @@ xmlSecOpenSSLEvpSignatureExecute(xmlSecTransformPtr transform, int last, xmlSecT
                             xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
                             "xmlSecBufferSetMaxSize",
                             XMLSEC_ERRORS_R_XMLSEC_FAILED,
-                            "size=%u", signSize);
+                            "size=%u", (unsigned int)signSize);
                 return(-1);
             }
 
+#if !defined(XMLSEC_OPENSSL_098)
+            ret = EVP_DigestSignFinal(ctx->digestCtx, xmlSecBufferGetData(out), &signSize);
+#else /* !defined(XMLSEC_OPENSSL_098) */
             ret = EVP_SignFinal(ctx->digestCtx, xmlSecBufferGetData(out), &signSize, ctx->pKey);
+#endif /* !defined(XMLSEC_OPENSSL_098) */
             if(ret != 1) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
-                            "EVP_SignFinal",
+                            XMLSEC_OPENSSL_EVP_SIGN_FINAL_NAME,
                             XMLSEC_ERRORS_R_CRYPTO_FAILED,
                             XMLSEC_ERRORS_NO_MESSAGE);
                 return(-1);
@@ -533,7 +577,7 @@ xmlSecOpenSSLEvpSignatureExecute(xmlSecTransformPtr transform, int last, xmlSecT
                             xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
                             "xmlSecBufferSetSize",
                             XMLSEC_ERRORS_R_XMLSEC_FAILED,
-                            "size=%u", signSize);
+                            "size=%u", (unsigned int)signSize);
                 return(-1);
             }
         }
@@ -32,6 +32,7 @@
 #include <xmlsec/errors.h>
 
 #include <xmlsec/openssl/crypto.h>
+#include "private.h"
 
 /* new API from OpenSSL 1.1.0 (https://www.openssl.org/docs/manmaster/crypto/hmac.html):
  *
@@ -346,7 +347,6 @@ static int
 xmlSecOpenSSLHmacSetKey(xmlSecTransformPtr transform, xmlSecKeyPtr key) {
     xmlSecOpenSSLHmacCtxPtr ctx;
     xmlSecKeyDataPtr value;
-    xmlSecBufferPtr buffer;
     int ret;
 
     xmlSecAssert2(xmlSecOpenSSLHmacCheckId(transform), -1);
@@ -363,42 +363,14 @@ xmlSecOpenSSLHmacSetKey(xmlSecTransformPtr transform, xmlSecKeyPtr key) {
     value = xmlSecKeyGetValue(key);
     xmlSecAssert2(xmlSecKeyDataCheckId(value, xmlSecOpenSSLKeyDataHmacId), -1);
 
-    buffer = xmlSecKeyDataBinaryValueGetBuffer(value);
-    xmlSecAssert2(buffer != NULL, -1);
-
-    if(xmlSecBufferGetSize(buffer) == 0) {
+    /* the key data caches the HMAC key schedule */
+    ret = xmlSecOpenSSLKeyDataHmacInitCtx(value, ctx->hmacCtx, ctx->hmacDgst);
+    if(ret < 0) {
         xmlSecError(XMLSEC_ERRORS_HERE,
                     xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
-                    NULL,
-                    XMLSEC_ERRORS_R_INVALID_KEY_DATA_SIZE,
-                    "keySize=0");
-        return(-1);
-    }
-
-    xmlSecAssert2(xmlSecBufferGetData(buffer) != NULL, -1);
-
-#if (defined(XMLSEC_OPENSSL_098))
-    /* no return value in 0.9.8 */
-    HMAC_Init_ex(ctx->hmacCtx,
-                    xmlSecBufferGetData(buffer),
-                    xmlSecBufferGetSize(buffer),
-                    ctx->hmacDgst,
-                    NULL);
-    ret = 1;
-#else  /* (defined(XMLSEC_OPENSSL_098)) */
-    ret = HMAC_Init_ex(ctx->hmacCtx,
-                xmlSecBufferGetData(buffer),
-                xmlSecBufferGetSize(buffer),
-                ctx->hmacDgst,
-                NULL);
-#endif /* (defined(XMLSEC_OPENSSL_098)) */
-
-    if(ret != 1) {
-        xmlSecError(XMLSEC_ERRORS_HERE,
-                    xmlSecErrorsSafeString(xmlSecTransformGetName(transform)),
-                    "HMAC_Init_ex",
-                    XMLSEC_ERRORS_R_CRYPTO_FAILED,
-                    NULL);
+                    "xmlSecOpenSSLKeyDataHmacInitCtx",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
         return(-1);
     }
 
@@ -0,0 +1,45 @@
+/**
+ * XMLSec library
+ *
+ * THIS IS A PRIVATE XMLSEC HEADER FILE
+ * DON'T USE IT IN YOUR APPLICATION
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2016 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_OPENSSL_PRIVATE_H__
+#define __XMLSEC_OPENSSL_PRIVATE_H__
+
+#ifndef XMLSEC_PRIVATE
+#error "private.h file contains private xmlsec definitions and should not be used outside xmlsec or xmlsec-$crypto libraries"
+#endif /* XMLSEC_PRIVATE */
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/keys.h>
+
+#ifndef XMLSEC_NO_HMAC
+#include <openssl/hmac.h>
+#endif /* XMLSEC_NO_HMAC */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/********************************************************************
+ *
+ * HMAC key data
+ *
+ ********************************************************************/
+#ifndef XMLSEC_NO_HMAC
+int                xmlSecOpenSSLKeyDataHmacInitCtx  (xmlSecKeyDataPtr data,
+                                                     HMAC_CTX* hmacCtx,
+                                                     const EVP_MD* hmacDgst);
+#endif /* XMLSEC_NO_HMAC */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_OPENSSL_PRIVATE_H__ */
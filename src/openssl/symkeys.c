@@ -16,6 +16,10 @@
 #include <string.h>
 
 #include <openssl/rand.h>
+#include <openssl/objects.h>
+#ifndef XMLSEC_NO_HMAC
+#include <openssl/hmac.h>
+#endif /* XMLSEC_NO_HMAC */
 
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/xmltree.h>
@@ -23,8 +27,21 @@
 #include <xmlsec/keyinfo.h>
 #include <xmlsec/transforms.h>
 #include <xmlsec/errors.h>
+#include <xmlsec/private/atomic.h>
 
 #include <xmlsec/openssl/crypto.h>
+#include "private.h"
+
+#ifndef XMLSEC_NO_HMAC
+/* new API from OpenSSL 1.1.0 (https://www.openssl.org/docs/manmaster/crypto/hmac.html):
+ *
+ * HMAC_CTX_new() and HMAC_CTX_free() are new in OpenSSL version 1.1.
+ */
+#if !defined(XMLSEC_OPENSSL_110)
+#define HMAC_CTX_new()   ((HMAC_CTX*)calloc(1, sizeof(HMAC_CTX)))
+#define HMAC_CTX_free(x) { HMAC_CTX_cleanup((x)); free((x)); }
+#endif /* !defined(XMLSEC_OPENSSL_110) */
+#endif /* XMLSEC_NO_HMAC */
 
 /*****************************************************************************
  *
@@ -363,10 +380,40 @@ xmlSecOpenSSLKeyDataDesSet(xmlSecKeyDataPtr data, const xmlSecByte* buf, xmlSecS
  *
  * <xmlsec:HMACKeyValue> processing
  *
+ * The HMAC key data also caches the HMAC ctx keyed with the key value
+ * (i.e. the digest state after the inner and outer pads) so the key
+ * schedule is computed only once when the same key data is used for
+ * many messages. The cache is located after the key value buffer.
+ *
  *************************************************************************/
+typedef struct _xmlSecOpenSSLKeyDataHmacCtx     xmlSecOpenSSLKeyDataHmacCtx,
+                                                *xmlSecOpenSSLKeyDataHmacCtxPtr;
+struct _xmlSecOpenSSLKeyDataHmacCtx {
+    const EVP_MD*       hmacDgst;       /* the digest used first time */
+    HMAC_CTX*           hmacCtx;        /* the keyed ctx for hmacDgst */
+};
+
+#define xmlSecOpenSSLKeyDataHmacSize \
+    (xmlSecKeyDataBinarySize + sizeof(xmlSecOpenSSLKeyDataHmacCtx))
+#define xmlSecOpenSSLKeyDataHmacGetCtx(data) \
+    ((xmlSecOpenSSLKeyDataHmacCtxPtr)(((xmlSecByte*)(data)) + xmlSecKeyDataBinarySize))
+
+static int      xmlSecOpenSSLKeyDataHmacInitialize      (xmlSecKeyDataPtr data);
+static int      xmlSecOpenSSLKeyDataHmacDuplicate       (xmlSecKeyDataPtr dst,
+                                                         xmlSecKeyDataPtr src);
+static void     xmlSecOpenSSLKeyDataHmacFinalize        (xmlSecKeyDataPtr data);
+static int      xmlSecOpenSSLKeyDataHmacGenerate        (xmlSecKeyDataPtr data,
+                                                         xmlSecSize sizeBits,
+                                                         xmlSecKeyDataType type);
+static void     xmlSecOpenSSLKeyDataHmacDebugDump       (xmlSecKeyDataPtr data,
+                                                         FILE* output);
+static void     xmlSecOpenSSLKeyDataHmacDebugXmlDump    (xmlSecKeyDataPtr data,
+                                                         FILE* output);
+static void     xmlSecOpenSSLKeyDataHmacResetCtx        (xmlSecKeyDataPtr data);
+
 static xmlSecKeyDataKlass xmlSecOpenSSLKeyDataHmacKlass = {
     sizeof(xmlSecKeyDataKlass),
-    xmlSecKeyDataBinarySize,
+    xmlSecOpenSSLKeyDataHmacSize,
 
     /* data */
     xmlSecNameHMACKeyValue,
@@ -377,10 +424,10 @@ static xmlSecKeyDataKlass xmlSecOpenSSLKeyDataHmacKlass = {
     xmlSecNs,                                   /* const xmlChar* dataNodeNs; */
 
     /* constructors/destructor */
-    xmlSecOpenSSLSymKeyDataInitialize,          /* xmlSecKeyDataInitializeMethod initialize; */
-    xmlSecOpenSSLSymKeyDataDuplicate,           /* xmlSecKeyDataDuplicateMethod duplicate; */
-    xmlSecOpenSSLSymKeyDataFinalize,            /* xmlSecKeyDataFinalizeMethod finalize; */
-    xmlSecOpenSSLSymKeyDataGenerate,            /* xmlSecKeyDataGenerateMethod generate; */
+    xmlSecOpenSSLKeyDataHmacInitialize,         /* xmlSecKeyDataInitializeMethod initialize; */
+    xmlSecOpenSSLKeyDataHmacDuplicate,          /* xmlSecKeyDataDuplicateMethod duplicate; */
+    xmlSecOpenSSLKeyDataHmacFinalize,           /* xmlSecKeyDataFinalizeMethod finalize; */
+    xmlSecOpenSSLKeyDataHmacGenerate,           /* xmlSecKeyDataGenerateMethod generate; */
 
     /* get info */
     xmlSecOpenSSLSymKeyDataGetType,             /* xmlSecKeyDataGetTypeMethod getType; */
@@ -394,8 +441,8 @@ static xmlSecKeyDataKlass xmlSecOpenSSLKeyDataHmacKlass = {
     xmlSecOpenSSLSymKeyDataBinWrite,            /* xmlSecKeyDataBinWriteMethod binWrite; */
 
     /* debug */
-    xmlSecOpenSSLSymKeyDataDebugDump,           /* xmlSecKeyDataDebugDumpMethod debugDump; */
-    xmlSecOpenSSLSymKeyDataDebugXmlDump,        /* xmlSecKeyDataDebugDumpMethod debugXmlDump; */
+    xmlSecOpenSSLKeyDataHmacDebugDump,          /* xmlSecKeyDataDebugDumpMethod debugDump; */
+    xmlSecOpenSSLKeyDataHmacDebugXmlDump,       /* xmlSecKeyDataDebugDumpMethod debugXmlDump; */
 
     /* reserved for the future */
     NULL,                                       /* void* reserved0; */
@@ -435,8 +482,277 @@ xmlSecOpenSSLKeyDataHmacSet(xmlSecKeyDataPtr data, const xmlSecByte* buf, xmlSec
     buffer = xmlSecKeyDataBinaryValueGetBuffer(data);
     xmlSecAssert2(buffer != NULL, -1);
 
+    /* the cached HMAC ctx is keyed with the old value */
+    xmlSecOpenSSLKeyDataHmacResetCtx(data);
+
     return(xmlSecBufferSetData(buffer, buf, bufSize));
 }
 
+/**
+ * xmlSecOpenSSLKeyDataHmacInitCtx:
+ * @data:               the pointer to HMAC key data.
+ * @hmacCtx:            the pointer to a new (not yet used) HMAC ctx.
+ * @hmacDgst:           the HMAC digest.
+ *
+ * Initializes @hmacCtx for computing HMAC with @hmacDgst and the key
+ * value from @data. The HMAC key schedule for the first digest used
+ * with @data is cached in @data and the following calls with the same
+ * digest just copy the cached ctx. The cache is copied by
+ * #xmlSecKeyDataDuplicate and reset by #xmlSecOpenSSLKeyDataHmacSet.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecOpenSSLKeyDataHmacInitCtx(xmlSecKeyDataPtr data, HMAC_CTX* hmacCtx, const EVP_MD* hmacDgst) {
+    xmlSecOpenSSLKeyDataHmacCtxPtr ctx;
+    xmlSecBufferPtr buffer;
+#if !defined(XMLSEC_OPENSSL_098)
+    HMAC_CTX* cachedCtx;
+#endif /* !defined(XMLSEC_OPENSSL_098) */
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataCheckId(data, xmlSecOpenSSLKeyDataHmacId), -1);
+    xmlSecAssert2(xmlSecKeyDataCheckSize(data, xmlSecOpenSSLKeyDataHmacSize), -1);
+    xmlSecAssert2(hmacCtx != NULL, -1);
+    xmlSecAssert2(hmacDgst != NULL, -1);
+
+    ctx = xmlSecOpenSSLKeyDataHmacGetCtx(data);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    buffer = xmlSecKeyDataBinaryValueGetBuffer(data);
+    xmlSecAssert2(buffer != NULL, -1);
+
+    if(xmlSecBufferGetSize(buffer) == 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataGetName(data)),
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_KEY_DATA_SIZE,
+                    "keySize=0");
+        return(-1);
+    }
+    xmlSecAssert2(xmlSecBufferGetData(buffer) != NULL, -1);
+
+#if (defined(XMLSEC_OPENSSL_098))
+    /* no HMAC_CTX_copy() and no return value in 0.9.8 */
+    HMAC_Init_ex(hmacCtx,
+                xmlSecBufferGetData(buffer),
+                xmlSecBufferGetSize(buffer),
+                hmacDgst,
+                NULL);
+#else  /* (defined(XMLSEC_OPENSSL_098)) */
+    /* the key data might be shared between threads (see xmlSecKeyReference):
+     * the first use sets the digest and publishes the keyed ctx, both are
+     * never changed until the key value is changed */
+    cachedCtx = (HMAC_CTX*)XMLSEC_ATOMIC_LOAD_PTR(&(ctx->hmacCtx));
+    if((cachedCtx == NULL) &&
+       (XMLSEC_ATOMIC_CAS_PTR(&(ctx->hmacDgst), NULL, hmacDgst) ||
+        (XMLSEC_ATOMIC_LOAD_PTR(&(ctx->hmacDgst)) == hmacDgst)))
+    {
+        cachedCtx = HMAC_CTX_new();
+        if(cachedCtx == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataGetName(data)),
+                        "HMAC_CTX_new",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+
+        ret = HMAC_Init_ex(cachedCtx,
+                    xmlSecBufferGetData(buffer),
+                    xmlSecBufferGetSize(buffer),
+                    hmacDgst,
+                    NULL);
+        if(ret != 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataGetName(data)),
+                        "HMAC_Init_ex",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            HMAC_CTX_free(cachedCtx);
+            return(-1);
+        }
+
+        /* another thread might have been faster */
+        if(!XMLSEC_ATOMIC_CAS_PTR(&(ctx->hmacCtx), NULL, cachedCtx)) {
+            HMAC_CTX_free(cachedCtx);
+            cachedCtx = (HMAC_CTX*)XMLSEC_ATOMIC_LOAD_PTR(&(ctx->hmacCtx));
+        }
+    }
+
+    if((cachedCtx != NULL) && (ctx->hmacDgst == hmacDgst)) {
+        ret = HMAC_CTX_copy(hmacCtx, cachedCtx);
+        if(ret != 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataGetName(data)),
+                        "HMAC_CTX_copy",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+        return(0);
+    }
+
+    /* the key schedule is cached for another digest */
+    ret = HMAC_Init_ex(hmacCtx,
+                xmlSecBufferGetData(buffer),
+                xmlSecBufferGetSize(buffer),
+                hmacDgst,
+                NULL);
+    if(ret != 1) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataGetName(data)),
+                    "HMAC_Init_ex",
+                    XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+#endif /* (defined(XMLSEC_OPENSSL_098)) */
+
+    return(0);
+}
+
+static int
+xmlSecOpenSSLKeyDataHmacInitialize(xmlSecKeyDataPtr data) {
+    xmlSecOpenSSLKeyDataHmacCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyDataCheckId(data, xmlSecOpenSSLKeyDataHmacId), -1);
+    xmlSecAssert2(xmlSecKeyDataCheckSize(data, xmlSecOpenSSLKeyDataHmacSize), -1);
+
+    ctx = xmlSecOpenSSLKeyDataHmacGetCtx(data);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    memset(ctx, 0, sizeof(xmlSecOpenSSLKeyDataHmacCtx));
+    return(xmlSecOpenSSLSymKeyDataInitialize(data));
+}
+
+static int
+xmlSecOpenSSLKeyDataHmacDuplicate(xmlSecKeyDataPtr dst, xmlSecKeyDataPtr src) {
+#if !defined(XMLSEC_OPENSSL_098)
+    xmlSecOpenSSLKeyDataHmacCtxPtr srcCtx;
+    HMAC_CTX* cachedCtx;
+#endif /* !defined(XMLSEC_OPENSSL_098) */
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataCheckId(dst, xmlSecOpenSSLKeyDataHmacId), -1);
+    xmlSecAssert2(xmlSecKeyDataCheckSize(dst, xmlSecOpenSSLKeyDataHmacSize), -1);
+    xmlSecAssert2(xmlSecKeyDataCheckId(src, xmlSecOpenSSLKeyDataHmacId), -1);
+    xmlSecAssert2(xmlSecKeyDataCheckSize(src, xmlSecOpenSSLKeyDataHmacSize), -1);
+
+    ret = xmlSecOpenSSLSymKeyDataDuplicate(dst, src);
+    if(ret < 0) {
+        return(-1);
+    }
+
+#if !defined(XMLSEC_OPENSSL_098)
+    /* copy the cached key schedule so the duplicate does not compute it again */
+    srcCtx = xmlSecOpenSSLKeyDataHmacGetCtx(src);
+    xmlSecAssert2(srcCtx != NULL, -1);
+
+    cachedCtx = (HMAC_CTX*)XMLSEC_ATOMIC_LOAD_PTR(&(srcCtx->hmacCtx));
+    if(cachedCtx != NULL) {
+        xmlSecOpenSSLKeyDataHmacCtxPtr dstCtx;
+
+        dstCtx = xmlSecOpenSSLKeyDataHmacGetCtx(dst);
+        xmlSecAssert2(dstCtx != NULL, -1);
+
+        xmlSecOpenSSLKeyDataHmacResetCtx(dst);
+        dstCtx->hmacCtx = HMAC_CTX_new();
+        if(dstCtx->hmacCtx == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataGetName(dst)),
+                        "HMAC_CTX_new",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+
+        ret = HMAC_CTX_copy(dstCtx->hmacCtx, cachedCtx);
+        if(ret != 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataGetName(dst)),
+                        "HMAC_CTX_copy",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            xmlSecOpenSSLKeyDataHmacResetCtx(dst);
+            return(-1);
+        }
+        dstCtx->hmacDgst = srcCtx->hmacDgst;
+    }
+#endif /* !defined(XMLSEC_OPENSSL_098) */
+
+    return(0);
+}
+
+static void
+xmlSecOpenSSLKeyDataHmacFinalize(xmlSecKeyDataPtr data) {
+    xmlSecAssert(xmlSecKeyDataCheckId(data, xmlSecOpenSSLKeyDataHmacId));
+    xmlSecAssert(xmlSecKeyDataCheckSize(data, xmlSecOpenSSLKeyDataHmacSize));
+
+    xmlSecOpenSSLKeyDataHmacResetCtx(data);
+    xmlSecOpenSSLSymKeyDataFinalize(data);
+}
+
+static int
+xmlSecOpenSSLKeyDataHmacGenerate(xmlSecKeyDataPtr data, xmlSecSize sizeBits, xmlSecKeyDataType type) {
+    xmlSecAssert2(xmlSecKeyDataCheckId(data, xmlSecOpenSSLKeyDataHmacId), -1);
+    xmlSecAssert2(xmlSecKeyDataCheckSize(data, xmlSecOpenSSLKeyDataHmacSize), -1);
+
+    xmlSecOpenSSLKeyDataHmacResetCtx(data);
+    return(xmlSecOpenSSLSymKeyDataGenerate(data, sizeBits, type));
+}
+
+static void
+xmlSecOpenSSLKeyDataHmacDebugDump(xmlSecKeyDataPtr data, FILE* output) {
+    xmlSecOpenSSLKeyDataHmacCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyDataCheckId(data, xmlSecOpenSSLKeyDataHmacId));
+    xmlSecAssert(xmlSecKeyDataCheckSize(data, xmlSecOpenSSLKeyDataHmacSize));
+    xmlSecAssert(output != NULL);
+
+    ctx = xmlSecOpenSSLKeyDataHmacGetCtx(data);
+    xmlSecAssert(ctx != NULL);
+
+    xmlSecKeyDataBinaryValueDebugDump(data, output);
+    if(XMLSEC_ATOMIC_LOAD_PTR(&(ctx->hmacCtx)) != NULL) {
+        fprintf(output, "=== cached key schedule: %s\n",
+                OBJ_nid2sn(EVP_MD_type(ctx->hmacDgst)));
+    }
+}
+
+static void
+xmlSecOpenSSLKeyDataHmacDebugXmlDump(xmlSecKeyDataPtr data, FILE* output) {
+    xmlSecOpenSSLKeyDataHmacCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyDataCheckId(data, xmlSecOpenSSLKeyDataHmacId));
+    xmlSecAssert(xmlSecKeyDataCheckSize(data, xmlSecOpenSSLKeyDataHmacSize));
+    xmlSecAssert(output != NULL);
+
+    ctx = xmlSecOpenSSLKeyDataHmacGetCtx(data);
+    xmlSecAssert(ctx != NULL);
+
+    xmlSecKeyDataBinaryValueDebugXmlDump(data, output);
+    if(XMLSEC_ATOMIC_LOAD_PTR(&(ctx->hmacCtx)) != NULL) {
+        fprintf(output, "<CachedKeySchedule digest=\"%s\" />\n",
+                OBJ_nid2sn(EVP_MD_type(ctx->hmacDgst)));
+    }
+}
+
+static void
+xmlSecOpenSSLKeyDataHmacResetCtx(xmlSecKeyDataPtr data) {
+    xmlSecOpenSSLKeyDataHmacCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyDataCheckId(data, xmlSecOpenSSLKeyDataHmacId));
+    xmlSecAssert(xmlSecKeyDataCheckSize(data, xmlSecOpenSSLKeyDataHmacSize));
+
+    ctx = xmlSecOpenSSLKeyDataHmacGetCtx(data);
+    xmlSecAssert(ctx != NULL);
+
+    if(ctx->hmacCtx != NULL) {
+        HMAC_CTX_free(ctx->hmacCtx);
+    }
+    memset(ctx, 0, sizeof(xmlSecOpenSSLKeyDataHmacCtx));
+}
+
 #endif /* XMLSEC_NO_HMAC */
 
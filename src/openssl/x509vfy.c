@@ -18,8 +18,10 @@
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <time.h>
 
 #include <libxml/tree.h>
+#include <libxml/hash.h>
 #include <openssl/evp.h>
 #include <openssl/x509.h>
 #include <openssl/x509_vfy.h>
@@ -31,7 +33,10 @@
 #include <xmlsec/keyinfo.h>
 #include <xmlsec/keysmngr.h>
 #include <xmlsec/base64.h>
+#include <xmlsec/buffer.h>
+#include <xmlsec/list.h>
 #include <xmlsec/errors.h>
+#include <xmlsec/private/atomic.h>
 
 #include <xmlsec/openssl/crypto.h>
 #include <xmlsec/openssl/evp.h>
@@ -40,8 +45,93 @@
 /* new API from OpenSSL 1.1.0 */
 #if !defined(XMLSEC_OPENSSL_110)
 #define X509_REVOKED_get0_serialNumber(x) ((x)->serialNumber)
+#define X509_CRL_up_ref(crl)              CRYPTO_add(&((crl)->references), 1, CRYPTO_LOCK_X509_CRL)
 #endif /* !defined(XMLSEC_OPENSSL_110) */
 
+/* the max number of verified CRLs from the documents to remember (the oldest is replaced) */
+#define XMLSEC_OPENSSL_X509_STORE_VERIFIED_CRLS_MAX_SIZE        64
+
+/* the max number of verified chains to remember (the oldest is replaced) */
+#define XMLSEC_OPENSSL_X509_STORE_VERIFIED_CHAINS_MAX_SIZE      64
+
+/* the trusted certs folders can change behind our back: re-verify the chains every hour
+ * even if the certs are not expired and the crls checked for them are not outdated */
+#define XMLSEC_OPENSSL_X509_STORE_VERIFIED_CHAINS_TTL           3600
+
+/* the explicit verification time granularity for the verified chains */
+#define XMLSEC_OPENSSL_X509_STORE_VERIFIED_CHAINS_TIME_BUCKET   3600
+
+/**************************************************************************
+ *
+ * Internal OpenSSL X509 CRL: the CRL with its issuer key and the sorted
+ * revoked serial numbers. It is reference counted so it can be shared
+ * between the store and the verifications in progress.
+ *
+ *************************************************************************/
+typedef struct _xmlSecOpenSSLX509Crl                    xmlSecOpenSSLX509Crl,
+                                                        *xmlSecOpenSSLX509CrlPtr;
+struct _xmlSecOpenSSLX509Crl {
+    long volatile       refs;
+    X509_CRL*           crl;
+    xmlChar*            issuerKey;
+    ASN1_INTEGER**      revoked;                        /* owned by crl */
+    int                 revokedSize;
+    xmlSecByte*         der;                            /* only for the verified crls */
+    int                 derSize;
+    xmlChar*            sigKey;                         /* only for the verified crls */
+};
+
+static xmlSecOpenSSLX509CrlPtr  xmlSecOpenSSLX509CrlCreate              (X509_CRL* crl);
+static xmlSecOpenSSLX509CrlPtr  xmlSecOpenSSLX509CrlReference           (xmlSecOpenSSLX509CrlPtr xcrl);
+static void                     xmlSecOpenSSLX509CrlRelease             (xmlSecOpenSSLX509CrlPtr xcrl);
+static int                      xmlSecOpenSSLX509CrlIsRevoked           (xmlSecOpenSSLX509CrlPtr xcrl,
+                                                                         ASN1_INTEGER* serial);
+static int                      xmlSecOpenSSLX509CrlSerialsCmp          (const void* a,
+                                                                         const void* b);
+
+static xmlSecPtr                xmlSecOpenSSLX509CrlListDuplicateItem   (xmlSecPtr ptr);
+static void                     xmlSecOpenSSLX509CrlListDestroyItem     (xmlSecPtr ptr);
+
+static xmlSecPtrListKlass xmlSecOpenSSLX509CrlListKlass = {
+    BAD_CAST "openssl-x509-crls-list",
+    xmlSecOpenSSLX509CrlListDuplicateItem,      /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    xmlSecOpenSSLX509CrlListDestroyItem,        /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+#define xmlSecOpenSSLX509CrlListId      (&xmlSecOpenSSLX509CrlListKlass)
+
+/**************************************************************************
+ *
+ * Internal OpenSSL X509 chain: the successfully verified chain with
+ * the CRLs checked for its certificates.
+ *
+ *************************************************************************/
+typedef struct _xmlSecOpenSSLX509Chain                  xmlSecOpenSSLX509Chain,
+                                                        *xmlSecOpenSSLX509ChainPtr;
+struct _xmlSecOpenSSLX509Chain {
+    xmlChar*            key;
+    STACK_OF(X509)*     certs;
+    xmlSecPtrList       crls;
+    time_t              expires;
+};
+
+static xmlSecOpenSSLX509ChainPtr xmlSecOpenSSLX509ChainCreate           (STACK_OF(X509)* certs);
+static void                     xmlSecOpenSSLX509ChainDestroy           (xmlSecOpenSSLX509ChainPtr chain);
+static int                      xmlSecOpenSSLX509ChainIsValid           (xmlSecOpenSSLX509ChainPtr chain,
+                                                                         time_t* verificationTime);
+
+static void                     xmlSecOpenSSLX509ChainListDestroyItem   (xmlSecPtr ptr);
+
+static xmlSecPtrListKlass xmlSecOpenSSLX509ChainListKlass = {
+    BAD_CAST "openssl-x509-chains-list",
+    NULL,                                       /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    xmlSecOpenSSLX509ChainListDestroyItem,      /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+#define xmlSecOpenSSLX509ChainListId    (&xmlSecOpenSSLX509ChainListKlass)
+
 /**************************************************************************
  *
  * Internal OpenSSL X509 store CTX
@@ -54,6 +144,29 @@ struct _xmlSecOpenSSLX509StoreCtx {
     STACK_OF(X509)*     untrusted;
     STACK_OF(X509_CRL)* crls;
     X509_VERIFY_PARAM * vpm;
+
+    /* untrusted certs indexes (the certs are owned by the untrusted stack) */
+    xmlHashTablePtr     untrustedBySubject;             /* subject key -> cert */
+    xmlHashTablePtr     untrustedByIssuerSerial;        /* (issuer key, serial) -> cert */
+    xmlHashTablePtr     untrustedBySki;                 /* base64 SKI -> cert */
+    xmlSecPtrList       untrustedIssuers;               /* issuer key of each untrusted cert */
+
+    /* crls index (the crls are owned by the crls stack) */
+    xmlSecPtrList       crlsList;                       /* the first crl for each issuer */
+    xmlHashTablePtr     crlsByIssuer;                   /* issuer key -> xmlSecOpenSSLX509Crl */
+
+    /* the crls from the documents that passed xmlSecOpenSSLX509VerifyCRL() */
+    xmlSecPtrList       verifiedCrlsList;
+    xmlHashTablePtr     verifiedCrlsBySignature;        /* base64 signature -> xmlSecOpenSSLX509Crl */
+    xmlSecSize          verifiedCrlsNext;               /* the oldest crl position when the list is full */
+
+    /* the chains that passed X509_verify_cert() */
+    xmlSecPtrList       verifiedChainsList;
+    xmlHashTablePtr     verifiedChainsByKey;            /* base64 chain key -> xmlSecOpenSSLX509Chain */
+    xmlSecSize          verifiedChainsNext;             /* the oldest chain position when the list is full */
+
+    long volatile       generation;                     /* changes with every store change */
+    long volatile       lock;                           /* protects the verified crls and chains */
 };
 
 /****************************************************************************
@@ -71,6 +184,7 @@ struct _xmlSecOpenSSLX509StoreCtx {
 
 static int              xmlSecOpenSSLX509StoreInitialize        (xmlSecKeyDataStorePtr store);
 static void             xmlSecOpenSSLX509StoreFinalize          (xmlSecKeyDataStorePtr store);
+static unsigned long    xmlSecOpenSSLX509StoreGetGeneration     (xmlSecKeyDataStorePtr store);
 
 static xmlSecKeyDataStoreKlass xmlSecOpenSSLX509StoreKlass = {
     sizeof(xmlSecKeyDataStoreKlass),
@@ -83,22 +197,63 @@ static xmlSecKeyDataStoreKlass xmlSecOpenSSLX509StoreKlass = {
     xmlSecOpenSSLX509StoreInitialize,           /* xmlSecKeyDataStoreInitializeMethod initialize; */
     xmlSecOpenSSLX509StoreFinalize,             /* xmlSecKeyDataStoreFinalizeMethod finalize; */
 
+    /* content changes tracking */
+    xmlSecOpenSSLX509StoreGetGeneration,        /* xmlSecKeyDataStoreGetGenerationMethod getGeneration; */
+
     /* reserved for the future */
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
 static int              xmlSecOpenSSLX509VerifyCRL                      (X509_STORE* xst,
                                                                          X509_CRL *crl );
-static X509*            xmlSecOpenSSLX509FindCert                       (STACK_OF(X509) *certs,
+static X509*            xmlSecOpenSSLX509FindCert                       (xmlSecOpenSSLX509StoreCtxPtr ctx,
                                                                          xmlChar *subjectName,
                                                                          xmlChar *issuerName,
                                                                          xmlChar *issuerSerial,
                                                                          xmlChar *ski);
+static int              xmlSecOpenSSLX509IndexCert                      (xmlSecOpenSSLX509StoreCtxPtr ctx,
+                                                                         X509* cert);
+static int              xmlSecOpenSSLX509StoreVerifyCrl                 (xmlSecOpenSSLX509StoreCtxPtr ctx,
+                                                                         X509_CRL* crl,
+                                                                         xmlSecOpenSSLX509CrlPtr* xcrl);
+static xmlChar*         xmlSecOpenSSLX509StoreGetChainKey               (STACK_OF(X509)* certs,
+                                                                         int certsSize,
+                                                                         X509* leaf,
+                                                                         long generation,
+                                                                         xmlSecKeyInfoCtxPtr keyInfoCtx);
+static int              xmlSecOpenSSLX509StoreFindChain                 (xmlSecOpenSSLX509StoreCtxPtr ctx,
+                                                                         const xmlChar* key,
+                                                                         xmlSecKeyInfoCtxPtr keyInfoCtx);
+static int              xmlSecOpenSSLX509StoreAddChain                  (xmlSecOpenSSLX509StoreCtxPtr ctx,
+                                                                         const xmlChar* key,
+                                                                         STACK_OF(X509)* certs,
+                                                                         xmlHashTablePtr crlsByIssuer,
+                                                                         xmlHashTablePtr crlsByIssuer2,
+                                                                         long generation);
+static void             xmlSecOpenSSLX509StoreChanged                   (xmlSecOpenSSLX509StoreCtxPtr ctx);
+static void             xmlSecOpenSSLX509StoreLock                      (xmlSecOpenSSLX509StoreCtxPtr ctx);
+static void             xmlSecOpenSSLX509StoreUnlock                    (xmlSecOpenSSLX509StoreCtxPtr ctx);
+static int              xmlSecOpenSSLX509IndexAdd                       (xmlHashTablePtr index,
+                                                                         const xmlChar* name,
+                                                                         const xmlChar* name2,
+                                                                         void* data);
+static void             xmlSecOpenSSLX509IndexRemove                    (xmlHashTablePtr index,
+                                                                         const xmlChar* name,
+                                                                         const xmlChar* name2,
+                                                                         void* data);
+static xmlChar*         xmlSecOpenSSLX509NameGetKey                     (X509_NAME* nm);
+static int              xmlSecOpenSSLX509AppendLength                   (xmlSecBufferPtr buf,
+                                                                         unsigned long len);
+static xmlChar*         xmlSecOpenSSLX509SerialGetKey                   (BIGNUM* bn);
 static X509*            xmlSecOpenSSLX509FindNextChainCert              (STACK_OF(X509) *chain,
                                                                          X509 *cert);
-static int              xmlSecOpenSSLX509VerifyCertAgainstCrls          (STACK_OF(X509_CRL) *crls,
-                                                                         X509* cert);
+static int              xmlSecOpenSSLX509IsRevoked                      (xmlHashTablePtr crlsByIssuer,
+                                                                         xmlHashTablePtr crlsByIssuer2,
+                                                                         X509* cert,
+                                                                         const xmlChar* issuerKey);
+static int              xmlSecOpenSSLX509VerifyCertAgainstCrls          (xmlHashTablePtr crlsByIssuer,
+                                                                         X509* cert,
+                                                                         const xmlChar* issuerKey);
 static X509_NAME*       xmlSecOpenSSLX509NameRead                       (xmlSecByte *str,
                                                                          int len);
 static int              xmlSecOpenSSLX509NameStringRead                 (xmlSecByte **str,
@@ -107,11 +262,7 @@ static int              xmlSecOpenSSLX509NameStringRead                 (xmlSecB
                                                                          int resLen,
                                                                          xmlSecByte delim,
                                                                          int ingoreTrailingSpaces);
-static int              xmlSecOpenSSLX509NamesCompare                   (X509_NAME *a,
-                                                                         X509_NAME *b);
 static STACK_OF(X509_NAME_ENTRY)*  xmlSecOpenSSLX509_NAME_ENTRIES_copy  (X509_NAME *a);
-static int              xmlSecOpenSSLX509_NAME_ENTRIES_cmp              (STACK_OF(X509_NAME_ENTRY) * a,
-                                                                         STACK_OF(X509_NAME_ENTRY) * b);
 static int              xmlSecOpenSSLX509_NAME_ENTRY_cmp                (const X509_NAME_ENTRY * const *a,
                                                                          const X509_NAME_ENTRY * const *b);
 
@@ -156,7 +307,7 @@ xmlSecOpenSSLX509StoreFindCert(xmlSecKeyDataStorePtr store, xmlChar *subjectName
     xmlSecAssert2(ctx != NULL, NULL);
 
     if((res == NULL) && (ctx->untrusted != NULL)) {
-        res = xmlSecOpenSSLX509FindCert(ctx->untrusted, subjectName, issuerName, issuerSerial, ski);
+        res = xmlSecOpenSSLX509FindCert(ctx, subjectName, issuerName, issuerSerial, ski);
     }
     return(res);
 }
@@ -177,7 +328,15 @@ xmlSecOpenSSLX509StoreVerify(xmlSecKeyDataStorePtr store, XMLSEC_STACK_OF_X509*
                              XMLSEC_STACK_OF_X509_CRL* crls, xmlSecKeyInfoCtx* keyInfoCtx) {
     xmlSecOpenSSLX509StoreCtxPtr ctx;
     STACK_OF(X509)* certs2 = NULL;
-    STACK_OF(X509_CRL)* crls2 = NULL;
+    xmlSecPtrList crls2;
+    int crls2Initialized = 0;
+    xmlHashTablePtr crls2ByIssuer = NULL;
+    xmlHashTablePtr crlsByIssuer = NULL;
+    int certsSize = 0;
+    int cacheChains = 1;
+    long generation;
+    xmlChar* chainKey = NULL;
+    STACK_OF(X509)* chain = NULL;
     X509 * res = NULL;
     X509 * cert;
     X509 * err_cert = NULL;
@@ -194,95 +353,163 @@ xmlSecOpenSSLX509StoreVerify(xmlSecKeyDataStorePtr store, XMLSEC_STACK_OF_X509*
     xmlSecAssert2(ctx != NULL, NULL);
     xmlSecAssert2(ctx->xst != NULL, NULL);
 
-    /* dup certs */
-    certs2 = sk_X509_dup(certs);
-    if(certs2 == NULL) {
-        xmlSecError(XMLSEC_ERRORS_HERE,
-                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
-                    "sk_X509_dup",
-                    XMLSEC_ERRORS_R_CRYPTO_FAILED,
-                    XMLSEC_ERRORS_NO_MESSAGE);
-        goto done;
-    }
+    /* the chains verified before a store change are not used or remembered */
+    generation = ctx->generation;
 
-    /* add untrusted certs from the store */
-    if(ctx->untrusted != NULL) {
-        for(i = 0; i < sk_X509_num(ctx->untrusted); ++i) {
-            ret = sk_X509_push(certs2, sk_X509_value(ctx->untrusted, i));
-            if(ret < 1) {
-                xmlSecError(XMLSEC_ERRORS_HERE,
-                            xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
-                            "sk_X509_push",
-                            XMLSEC_ERRORS_R_CRYPTO_FAILED,
-                            XMLSEC_ERRORS_NO_MESSAGE);
-                goto done;
-            }
+    /* take the verified crls only */
+    if((crls != NULL) && (sk_X509_CRL_num(crls) > 0)) {
+        xmlSecOpenSSLX509CrlPtr xcrl;
+
+        ret = xmlSecPtrListInitialize(&crls2, xmlSecOpenSSLX509CrlListId);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                        "xmlSecPtrListInitialize",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            goto done;
         }
-    }
+        crls2Initialized = 1;
 
-    /* dup crls but remove all non-verified */
-    if(crls != NULL) {
-        crls2 = sk_X509_CRL_dup(crls);
-        if(crls2 == NULL) {
+        crls2ByIssuer = xmlHashCreate(0);
+        if(crls2ByIssuer == NULL) {
             xmlSecError(XMLSEC_ERRORS_HERE,
                         xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
-                        "sk_X509_CRL_dup",
-                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        "xmlHashCreate",
+                        XMLSEC_ERRORS_R_XML_FAILED,
                         XMLSEC_ERRORS_NO_MESSAGE);
             goto done;
         }
 
-        for(i = 0; i < sk_X509_CRL_num(crls2); ) {
-            ret = xmlSecOpenSSLX509VerifyCRL(ctx->xst, sk_X509_CRL_value(crls2, i));
-            if(ret == 1) {
-                ++i;
+        for(i = 0; i < sk_X509_CRL_num(crls); ++i) {
+            ret = xmlSecOpenSSLX509StoreVerifyCrl(ctx, sk_X509_CRL_value(crls, i), &xcrl);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                            "xmlSecOpenSSLX509StoreVerifyCrl",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                goto done;
             } else if(ret == 0) {
-                (void)sk_X509_CRL_delete(crls2, i);
-            } else {
+                continue;
+            }
+
+            ret = xmlSecPtrListAdd(&crls2, xcrl);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                            "xmlSecPtrListAdd",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                xmlSecOpenSSLX509CrlRelease(xcrl);
+                goto done;
+            }
+
+            /* the first crl for the issuer wins */
+            ret = xmlSecOpenSSLX509IndexAdd(crls2ByIssuer, xcrl->issuerKey, NULL, xcrl);
+            if(ret < 0) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
-                            "xmlSecOpenSSLX509VerifyCRL",
+                            "xmlSecOpenSSLX509IndexAdd",
                             XMLSEC_ERRORS_R_XMLSEC_FAILED,
                             XMLSEC_ERRORS_NO_MESSAGE);
                 goto done;
             }
         }
+
+        if(xmlSecPtrListGetSize(&crls2) == 0) {
+            xmlHashFree(crls2ByIssuer, NULL);
+            crls2ByIssuer = NULL;
+        }
+    }
+    if((ctx->crls != NULL) && (sk_X509_CRL_num(ctx->crls) > 0)) {
+        crlsByIssuer = ctx->crlsByIssuer;
     }
 
-    /* remove all revoked certs */
-    for(i = 0; i < sk_X509_num(certs2);) {
-        cert = sk_X509_value(certs2, i);
+    certs2 = sk_X509_new_null();
+    if(certs2 == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "sk_X509_new_null",
+                    XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
 
-        if(crls2 != NULL) {
-            ret = xmlSecOpenSSLX509VerifyCertAgainstCrls(crls2, cert);
-            if(ret == 0) {
-                (void)sk_X509_delete(certs2, i);
-                continue;
-            } else if(ret != 1) {
+    /* add all the certs but the revoked ones */
+    for(i = 0; i < sk_X509_num(certs); ++i) {
+        cert = sk_X509_value(certs, i);
+
+        if((crls2ByIssuer != NULL) || (crlsByIssuer != NULL)) {
+            xmlChar* issuerKey;
+
+            issuerKey = xmlSecOpenSSLX509NameGetKey(X509_get_issuer_name(cert));
+            if(issuerKey == NULL) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                            "xmlSecOpenSSLX509NameGetKey",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                goto done;
+            }
+            ret = xmlSecOpenSSLX509IsRevoked(crls2ByIssuer, crlsByIssuer, cert, issuerKey);
+            xmlFree(issuerKey);
+            if(ret < 0) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
-                            "xmlSecOpenSSLX509VerifyCertAgainstCrls",
+                            "xmlSecOpenSSLX509IsRevoked",
                             XMLSEC_ERRORS_R_XMLSEC_FAILED,
                             XMLSEC_ERRORS_NO_MESSAGE);
                 goto done;
+            } else if(ret == 1) {
+                continue;
             }
         }
 
-        if(ctx->crls != NULL) {
-            ret = xmlSecOpenSSLX509VerifyCertAgainstCrls(ctx->crls, cert);
-            if(ret == 0) {
-                (void)sk_X509_delete(certs2, i);
-                continue;
-            } else if(ret != 1) {
+        ret = sk_X509_push(certs2, cert);
+        if(ret < 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                        "sk_X509_push",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            goto done;
+        }
+    }
+    certsSize = sk_X509_num(certs2);
+
+    /* the untrusted certs from the store have the issuer keys precomputed */
+    if(ctx->untrusted != NULL) {
+        for(i = 0; i < sk_X509_num(ctx->untrusted); ++i) {
+            cert = sk_X509_value(ctx->untrusted, i);
+
+            if((crls2ByIssuer != NULL) || (crlsByIssuer != NULL)) {
+                ret = xmlSecOpenSSLX509IsRevoked(crls2ByIssuer, crlsByIssuer, cert,
+                            (const xmlChar*)xmlSecPtrListGetItem(&(ctx->untrustedIssuers), i));
+                if(ret < 0) {
+                    xmlSecError(XMLSEC_ERRORS_HERE,
+                                xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                                "xmlSecOpenSSLX509IsRevoked",
+                                XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                                XMLSEC_ERRORS_NO_MESSAGE);
+                    goto done;
+                } else if(ret == 1) {
+                    /* the chain key only covers the untrusted certs from the document */
+                    cacheChains = 0;
+                    continue;
+                }
+            }
+
+            ret = sk_X509_push(certs2, cert);
+            if(ret < 1) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
-                            "xmlSecOpenSSLX509VerifyCertAgainstCrls",
-                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            "sk_X509_push",
+                            XMLSEC_ERRORS_R_CRYPTO_FAILED,
                             XMLSEC_ERRORS_NO_MESSAGE);
                 goto done;
             }
         }
-        ++i;
     }
 
     /* get one cert after another and try to verify */
@@ -291,6 +518,25 @@ xmlSecOpenSSLX509StoreVerify(xmlSecKeyDataStorePtr store, XMLSEC_STACK_OF_X509*
         if(xmlSecOpenSSLX509FindNextChainCert(certs2, cert) == NULL) {
             X509_STORE_CTX xsc;
 
+            if(cacheChains != 0) {
+                if(chainKey != NULL) {
+                    xmlFree(chainKey);
+                }
+                chainKey = xmlSecOpenSSLX509StoreGetChainKey(certs2, certsSize, cert, generation, keyInfoCtx);
+                if(chainKey == NULL) {
+                    xmlSecError(XMLSEC_ERRORS_HERE,
+                                xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                                "xmlSecOpenSSLX509StoreGetChainKey",
+                                XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                                XMLSEC_ERRORS_NO_MESSAGE);
+                    goto done;
+                }
+                if(xmlSecOpenSSLX509StoreFindChain(ctx, chainKey, keyInfoCtx) == 1) {
+                    res = cert;
+                    goto done;
+                }
+            }
+
             X509_STORE_CTX_init (&xsc, ctx->xst, cert, certs2);
             if(keyInfoCtx->certsVerificationTime > 0) {
                 X509_STORE_CTX_set_time(&xsc, 0, keyInfoCtx->certsVerificationTime);
@@ -326,10 +572,25 @@ xmlSecOpenSSLX509StoreVerify(xmlSecKeyDataStorePtr store, XMLSEC_STACK_OF_X509*
             ret         = X509_verify_cert(&xsc);
             err_cert    = X509_STORE_CTX_get_current_cert(&xsc);
             err         = X509_STORE_CTX_get_error(&xsc);
+            if((ret == 1) && (chainKey != NULL)) {
+                chain = X509_STORE_CTX_get1_chain(&xsc);
+            }
 
             X509_STORE_CTX_cleanup (&xsc);
 
             if(ret == 1) {
+                if(chain != NULL) {
+                    /* the chain is verified anyway, just log the error */
+                    if(xmlSecOpenSSLX509StoreAddChain(ctx, chainKey, chain, crls2ByIssuer,
+                                                      crlsByIssuer, generation) < 0) {
+                        xmlSecError(XMLSEC_ERRORS_HERE,
+                                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                                    "xmlSecOpenSSLX509StoreAddChain",
+                                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                                    XMLSEC_ERRORS_NO_MESSAGE);
+                    }
+                    chain = NULL;
+                }
                 res = cert;
                 goto done;
             } else if(ret < 0) {
@@ -411,11 +672,17 @@ xmlSecOpenSSLX509StoreVerify(xmlSecKeyDataStorePtr store, XMLSEC_STACK_OF_X509*
     }
 
 done:
+    if(chainKey != NULL) {
+        xmlFree(chainKey);
+    }
     if(certs2 != NULL) {
         sk_X509_free(certs2);
     }
-    if(crls2 != NULL) {
-        sk_X509_CRL_free(crls2);
+    if(crls2ByIssuer != NULL) {
+        xmlHashFree(crls2ByIssuer, NULL);
+    }
+    if(crls2Initialized != 0) {
+        xmlSecPtrListFinalize(&crls2);
     }
     return(res);
 }
@@ -467,7 +734,21 @@ xmlSecOpenSSLX509StoreAdoptCert(xmlSecKeyDataStorePtr store, X509* cert, xmlSecK
                         XMLSEC_ERRORS_NO_MESSAGE);
             return(-1);
         }
+
+        ret = xmlSecOpenSSLX509IndexCert(ctx, cert);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                        "xmlSecOpenSSLX509IndexCert",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            /* the caller still owns the cert */
+            (void)sk_X509_pop(ctx->untrusted);
+            return(-1);
+        }
     }
+
+    xmlSecOpenSSLX509StoreChanged(ctx);
     return(0);
 }
 
@@ -483,6 +764,7 @@ xmlSecOpenSSLX509StoreAdoptCert(xmlSecKeyDataStorePtr store, X509* cert, xmlSecK
 int
 xmlSecOpenSSLX509StoreAdoptCrl(xmlSecKeyDataStorePtr store, X509_CRL* crl) {
     xmlSecOpenSSLX509StoreCtxPtr ctx;
+    xmlSecOpenSSLX509CrlPtr xcrl;
     int ret;
 
     xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecOpenSSLX509StoreId), -1);
@@ -490,18 +772,68 @@ xmlSecOpenSSLX509StoreAdoptCrl(xmlSecKeyDataStorePtr store, X509_CRL* crl) {
 
     ctx = xmlSecOpenSSLX509StoreGetCtx(store);
     xmlSecAssert2(ctx != NULL, -1);
-        xmlSecAssert2(ctx->crls != NULL, -1);
+    xmlSecAssert2(ctx->crls != NULL, -1);
+    xmlSecAssert2(ctx->crlsByIssuer != NULL, -1);
 
-        ret = sk_X509_CRL_push(ctx->crls, crl);
-        if(ret < 1) {
-            xmlSecError(XMLSEC_ERRORS_HERE,
-                        xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
-                        "sk_X509_CRL_push",
-                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
-                        XMLSEC_ERRORS_NO_MESSAGE);
-            return(-1);
+    /* only the first crl for the issuer is used */
+    xcrl = xmlSecOpenSSLX509CrlCreate(crl);
+    if(xcrl == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecOpenSSLX509CrlCreate",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    if(xmlHashLookup(ctx->crlsByIssuer, xcrl->issuerKey) != NULL) {
+        xmlSecOpenSSLX509CrlRelease(xcrl);
+        xcrl = NULL;
+    }
+
+    ret = sk_X509_CRL_push(ctx->crls, crl);
+    if(ret < 1) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "sk_X509_CRL_push",
+                    XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        if(xcrl != NULL) {
+            xmlSecOpenSSLX509CrlRelease(xcrl);
         }
+        return(-1);
+    }
+    if(xcrl == NULL) {
+        /* the crl is not used: no changes */
+        return(0);
+    }
+
+    ret = xmlSecPtrListAdd(&(ctx->crlsList), xcrl);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecPtrListAdd",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecOpenSSLX509CrlRelease(xcrl);
+        /* the caller still owns the crl */
+        (void)sk_X509_CRL_pop(ctx->crls);
+        return(-1);
+    }
+
+    ret = xmlSecOpenSSLX509IndexAdd(ctx->crlsByIssuer, xcrl->issuerKey, NULL, xcrl);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecOpenSSLX509IndexAdd",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        (void)xmlSecPtrListRemove(&(ctx->crlsList), xmlSecPtrListGetSize(&(ctx->crlsList)) - 1);
+        /* the caller still owns the crl */
+        (void)sk_X509_CRL_pop(ctx->crls);
+        return(-1);
+    }
 
+    xmlSecOpenSSLX509StoreChanged(ctx);
     return (0);
 }
 
@@ -546,6 +878,8 @@ xmlSecOpenSSLX509StoreAddCertsPath(xmlSecKeyDataStorePtr store, const char *path
         );
         return(-1);
     }
+
+    xmlSecOpenSSLX509StoreChanged(ctx);
     return(0);
 }
 
@@ -590,6 +924,8 @@ xmlSecOpenSSLX509StoreAddCertsFile(xmlSecKeyDataStorePtr store, const char *file
         );
         return(-1);
     }
+
+    xmlSecOpenSSLX509StoreChanged(ctx);
     return(0);
 }
 
@@ -597,6 +933,7 @@ static int
 xmlSecOpenSSLX509StoreInitialize(xmlSecKeyDataStorePtr store) {
     const xmlChar* path;
     X509_LOOKUP *lookup = NULL;
+    int ret;
 
     xmlSecOpenSSLX509StoreCtxPtr ctx;
     xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecOpenSSLX509StoreId), -1);
@@ -692,6 +1029,62 @@ xmlSecOpenSSLX509StoreInitialize(xmlSecKeyDataStorePtr store) {
     X509_VERIFY_PARAM_set_depth(ctx->vpm, 9); /* the default cert verification path in openssl */
     X509_STORE_set1_param(ctx->xst, ctx->vpm);
 
+    ctx->untrustedBySubject = xmlHashCreate(0);
+    ctx->untrustedByIssuerSerial = xmlHashCreate(0);
+    ctx->untrustedBySki = xmlHashCreate(0);
+    ctx->crlsByIssuer = xmlHashCreate(0);
+    ctx->verifiedCrlsBySignature = xmlHashCreate(0);
+    ctx->verifiedChainsByKey = xmlHashCreate(0);
+    if((ctx->untrustedBySubject == NULL) || (ctx->untrustedByIssuerSerial == NULL) ||
+       (ctx->untrustedBySki == NULL) || (ctx->crlsByIssuer == NULL) ||
+       (ctx->verifiedCrlsBySignature == NULL) || (ctx->verifiedChainsByKey == NULL)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlHashCreate",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlSecPtrListInitialize(&(ctx->untrustedIssuers), xmlSecStringListId);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecPtrListInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlSecPtrListInitialize(&(ctx->crlsList), xmlSecOpenSSLX509CrlListId);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecPtrListInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlSecPtrListInitialize(&(ctx->verifiedCrlsList), xmlSecOpenSSLX509CrlListId);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecPtrListInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlSecPtrListInitialize(&(ctx->verifiedChainsList), xmlSecOpenSSLX509ChainListId);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecKeyDataStoreGetName(store)),
+                    "xmlSecPtrListInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
 
     return(0);
 }
@@ -717,10 +1110,51 @@ xmlSecOpenSSLX509StoreFinalize(xmlSecKeyDataStorePtr store) {
     if(ctx->vpm != NULL) {
         X509_VERIFY_PARAM_free(ctx->vpm);
     }
+    if(ctx->untrustedBySubject != NULL) {
+        xmlHashFree(ctx->untrustedBySubject, NULL);
+    }
+    if(ctx->untrustedByIssuerSerial != NULL) {
+        xmlHashFree(ctx->untrustedByIssuerSerial, NULL);
+    }
+    if(ctx->untrustedBySki != NULL) {
+        xmlHashFree(ctx->untrustedBySki, NULL);
+    }
+    if(xmlSecPtrListIsValid(&(ctx->untrustedIssuers))) {
+        xmlSecPtrListFinalize(&(ctx->untrustedIssuers));
+    }
+    if(ctx->crlsByIssuer != NULL) {
+        xmlHashFree(ctx->crlsByIssuer, NULL);
+    }
+    if(xmlSecPtrListIsValid(&(ctx->crlsList))) {
+        xmlSecPtrListFinalize(&(ctx->crlsList));
+    }
+    if(ctx->verifiedCrlsBySignature != NULL) {
+        xmlHashFree(ctx->verifiedCrlsBySignature, NULL);
+    }
+    if(xmlSecPtrListIsValid(&(ctx->verifiedCrlsList))) {
+        xmlSecPtrListFinalize(&(ctx->verifiedCrlsList));
+    }
+    if(ctx->verifiedChainsByKey != NULL) {
+        xmlHashFree(ctx->verifiedChainsByKey, NULL);
+    }
+    if(xmlSecPtrListIsValid(&(ctx->verifiedChainsList))) {
+        xmlSecPtrListFinalize(&(ctx->verifiedChainsList));
+    }
 
     memset(ctx, 0, sizeof(xmlSecOpenSSLX509StoreCtx));
 }
 
+static unsigned long
+xmlSecOpenSSLX509StoreGetGeneration(xmlSecKeyDataStorePtr store) {
+    xmlSecOpenSSLX509StoreCtxPtr ctx;
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecOpenSSLX509StoreId), 0);
+
+    ctx = xmlSecOpenSSLX509StoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, 0);
+
+    return((unsigned long)ctx->generation);
+}
+
 
 /*****************************************************************************
  *
@@ -772,18 +1206,19 @@ xmlSecOpenSSLX509VerifyCRL(X509_STORE* xst, X509_CRL *crl ) {
 }
 
 static X509*
-xmlSecOpenSSLX509FindCert(STACK_OF(X509) *certs, xmlChar *subjectName,
+xmlSecOpenSSLX509FindCert(xmlSecOpenSSLX509StoreCtxPtr ctx, xmlChar *subjectName,
                         xmlChar *issuerName, xmlChar *issuerSerial,
                         xmlChar *ski) {
     X509 *cert = NULL;
-    int i;
 
-    xmlSecAssert2(certs != NULL, NULL);
+    xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(ctx->untrustedBySubject != NULL, NULL);
+    xmlSecAssert2(ctx->untrustedByIssuerSerial != NULL, NULL);
+    xmlSecAssert2(ctx->untrustedBySki != NULL, NULL);
 
-    /* todo: may be this is not the fastest way to search certs */
     if(subjectName != NULL) {
         X509_NAME *nm;
-        X509_NAME *subj;
+        xmlChar *subjectKey;
 
         nm = xmlSecOpenSSLX509NameRead(subjectName, xmlStrlen(subjectName));
         if(nm == NULL) {
@@ -796,20 +1231,25 @@ xmlSecOpenSSLX509FindCert(STACK_OF(X509) *certs, xmlChar *subjectName,
             return(NULL);
         }
 
-        for(i = 0; i < sk_X509_num(certs); ++i) {
-            cert = sk_X509_value(certs, i);
-            subj = X509_get_subject_name(cert);
-            if(xmlSecOpenSSLX509NamesCompare(nm, subj) == 0) {
-                X509_NAME_free(nm);
-                return(cert);
-            }
-        }
+        subjectKey = xmlSecOpenSSLX509NameGetKey(nm);
         X509_NAME_free(nm);
+        if(subjectKey == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecOpenSSLX509NameGetKey",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "subject=%s",
+                        xmlSecErrorsSafeString(subjectName));
+            return(NULL);
+        }
+
+        cert = (X509*)xmlHashLookup(ctx->untrustedBySubject, subjectKey);
+        xmlFree(subjectKey);
     } else if((issuerName != NULL) && (issuerSerial != NULL)) {
         X509_NAME *nm;
-        X509_NAME *issuer;
+        xmlChar *issuerKey;
+        xmlChar *serialKey;
         BIGNUM *bn;
-        ASN1_INTEGER *serial;
 
         nm = xmlSecOpenSSLX509NameRead(issuerName, xmlStrlen(issuerName));
         if(nm == NULL) {
@@ -822,6 +1262,18 @@ xmlSecOpenSSLX509FindCert(STACK_OF(X509) *certs, xmlChar *subjectName,
             return(NULL);
         }
 
+        issuerKey = xmlSecOpenSSLX509NameGetKey(nm);
+        X509_NAME_free(nm);
+        if(issuerKey == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecOpenSSLX509NameGetKey",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "issuer=%s",
+                        xmlSecErrorsSafeString(issuerName));
+            return(NULL);
+        }
+
         bn = BN_new();
         if(bn == NULL) {
             xmlSecError(XMLSEC_ERRORS_HERE,
@@ -829,7 +1281,7 @@ xmlSecOpenSSLX509FindCert(STACK_OF(X509) *certs, xmlChar *subjectName,
                         "BN_new",
                         XMLSEC_ERRORS_R_CRYPTO_FAILED,
                         XMLSEC_ERRORS_NO_MESSAGE);
-            X509_NAME_free(nm);
+            xmlFree(issuerKey);
             return(NULL);
         }
         if(BN_dec2bn(&bn, (char*)issuerSerial) == 0) {
@@ -839,152 +1291,1141 @@ xmlSecOpenSSLX509FindCert(STACK_OF(X509) *certs, xmlChar *subjectName,
                         XMLSEC_ERRORS_R_CRYPTO_FAILED,
                         XMLSEC_ERRORS_NO_MESSAGE);
             BN_free(bn);
-            X509_NAME_free(nm);
+            xmlFree(issuerKey);
             return(NULL);
         }
 
-        serial = BN_to_ASN1_INTEGER(bn, NULL);
-        if(serial == NULL) {
+        serialKey = xmlSecOpenSSLX509SerialGetKey(bn);
+        BN_free(bn);
+        if(serialKey == NULL) {
             xmlSecError(XMLSEC_ERRORS_HERE,
                         NULL,
-                        "BN_to_ASN1_INTEGER",
-                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        "xmlSecOpenSSLX509SerialGetKey",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
                         XMLSEC_ERRORS_NO_MESSAGE);
-            BN_free(bn);
-            X509_NAME_free(nm);
+            xmlFree(issuerKey);
             return(NULL);
         }
+
+        cert = (X509*)xmlHashLookup2(ctx->untrustedByIssuerSerial, issuerKey, serialKey);
+        xmlFree(issuerKey);
+        xmlFree(serialKey);
+    } else if(ski != NULL) {
+        xmlChar *skiKey;
+        int len;
+
+        /* our usual trick with base64 decode */
+        len = xmlSecBase64Decode(ski, (xmlSecByte*)ski, xmlStrlen(ski));
+        if(len < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecBase64Decode",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "ski=%s",
+                        xmlSecErrorsSafeString(ski));
+            return(NULL);
+        }
+
+        /* re-encode to get rid of the whitespaces and line breaks */
+        skiKey = xmlSecBase64Encode((xmlSecByte*)ski, len, 0);
+        if(skiKey == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecBase64Encode",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(NULL);
+        }
+
+        cert = (X509*)xmlHashLookup(ctx->untrustedBySki, skiKey);
+        xmlFree(skiKey);
+    }
+
+    return(cert);
+}
+
+/* adds the subject, (issuer, serial) and SKI keys of @cert to the indexes */
+static int
+xmlSecOpenSSLX509IndexCert(xmlSecOpenSSLX509StoreCtxPtr ctx, X509* cert) {
+    xmlChar *subjectKey = NULL;
+    xmlChar *issuerKey = NULL;
+    xmlChar *serialKey = NULL;
+    xmlChar *skiKey = NULL;
+    BIGNUM *bn = NULL;
+    int index;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(cert != NULL, -1);
+
+    subjectKey = xmlSecOpenSSLX509NameGetKey(X509_get_subject_name(cert));
+    if(subjectKey == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecOpenSSLX509NameGetKey",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "subject");
+        goto done;
+    }
+
+    issuerKey = xmlSecOpenSSLX509NameGetKey(X509_get_issuer_name(cert));
+    if(issuerKey == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecOpenSSLX509NameGetKey",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "issuer");
+        goto done;
+    }
+
+    bn = ASN1_INTEGER_to_BN(X509_get_serialNumber(cert), NULL);
+    if(bn == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "ASN1_INTEGER_to_BN",
+                    XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+
+    serialKey = xmlSecOpenSSLX509SerialGetKey(bn);
+    if(serialKey == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecOpenSSLX509SerialGetKey",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+
+    index = X509_get_ext_by_NID(cert, NID_subject_key_identifier, -1);
+    if(index >= 0) {
+        X509_EXTENSION *ext;
+        ASN1_OCTET_STRING *keyId;
+
+        ext = X509_get_ext(cert, index);
+        keyId = (ext != NULL) ? (ASN1_OCTET_STRING*)X509V3_EXT_d2i(ext) : NULL;
+        if((keyId != NULL) && (keyId->length > 0)) {
+            skiKey = xmlSecBase64Encode(keyId->data, keyId->length, 0);
+            if(skiKey == NULL) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            NULL,
+                            "xmlSecBase64Encode",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                ASN1_OCTET_STRING_free(keyId);
+                goto done;
+            }
+        }
+        if(keyId != NULL) {
+            ASN1_OCTET_STRING_free(keyId);
+        }
+    }
+
+    /* the first added cert wins, same as with the linear search */
+    ret = xmlSecOpenSSLX509IndexAdd(ctx->untrustedBySubject, subjectKey, NULL, cert);
+    if(ret < 0) {
+        goto done;
+    }
+    ret = xmlSecOpenSSLX509IndexAdd(ctx->untrustedByIssuerSerial, issuerKey, serialKey, cert);
+    if(ret < 0) {
+        goto done;
+    }
+    if(skiKey != NULL) {
+        ret = xmlSecOpenSSLX509IndexAdd(ctx->untrustedBySki, skiKey, NULL, cert);
+        if(ret < 0) {
+            goto done;
+        }
+    }
+
+    /* keep the issuer key for the revocation checks in xmlSecOpenSSLX509StoreVerify() */
+    ret = xmlSecPtrListAdd(&(ctx->untrustedIssuers), issuerKey);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecPtrListAdd",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+    issuerKey = NULL; /* owned by the list now */
+
+    /* success */
+    res = 0;
+
+done:
+    if(res < 0) {
+        /* do not leave the cert in the indexes, the caller pops it */
+        if(subjectKey != NULL) {
+            xmlSecOpenSSLX509IndexRemove(ctx->untrustedBySubject, subjectKey, NULL, cert);
+        }
+        if((issuerKey != NULL) && (serialKey != NULL)) {
+            xmlSecOpenSSLX509IndexRemove(ctx->untrustedByIssuerSerial, issuerKey, serialKey, cert);
+        }
+        if(skiKey != NULL) {
+            xmlSecOpenSSLX509IndexRemove(ctx->untrustedBySki, skiKey, NULL, cert);
+        }
+    }
+    if(subjectKey != NULL) {
+        xmlFree(subjectKey);
+    }
+    if(issuerKey != NULL) {
+        xmlFree(issuerKey);
+    }
+    if(serialKey != NULL) {
+        xmlFree(serialKey);
+    }
+    if(skiKey != NULL) {
+        xmlFree(skiKey);
+    }
+    if(bn != NULL) {
         BN_free(bn);
+    }
+    return(res);
+}
+
+static int
+xmlSecOpenSSLX509IndexAdd(xmlHashTablePtr index, const xmlChar* name, const xmlChar* name2, void* data) {
+    int ret;
+
+    xmlSecAssert2(index != NULL, -1);
+    xmlSecAssert2(name != NULL, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    if(xmlHashLookup2(index, name, name2) != NULL) {
+        return(0);
+    }
+
+    ret = xmlHashAddEntry2(index, name, name2, data);
+    if(ret != 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlHashAddEntry2",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    return(0);
+}
+
+static void
+xmlSecOpenSSLX509IndexRemove(xmlHashTablePtr index, const xmlChar* name, const xmlChar* name2, void* data) {
+    xmlSecAssert(index != NULL);
+    xmlSecAssert(name != NULL);
+    xmlSecAssert(data != NULL);
+
+    if(xmlHashLookup2(index, name, name2) == data) {
+        xmlHashRemoveEntry2(index, name, name2, NULL);
+    }
+}
+
+/**
+ * xmlSecOpenSSLX509NameGetKey:
+ *
+ * Returns the canonical key for the name: the name entries sorted by
+ * value and then by object (see xmlSecOpenSSLX509_NAME_ENTRY_cmp) and
+ * written as (value, object) pairs, each length prefixed, then base64
+ * encoded. Two names are equal if and only if they have the same key,
+ * the order of the entries in the names does not matter.
+ */
+static xmlChar*
+xmlSecOpenSSLX509NameGetKey(X509_NAME* nm) {
+    STACK_OF(X509_NAME_ENTRY) *entries = NULL;
+    xmlSecBuffer buf;
+    xmlChar *res = NULL;
+    int ii, size;
+    int ret;
+
+    xmlSecAssert2(nm != NULL, NULL);
+
+    ret = xmlSecBufferInitialize(&buf, 256);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecBufferInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(NULL);
+    }
+
+    entries = xmlSecOpenSSLX509_NAME_ENTRIES_copy(nm);
+    if(entries == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecOpenSSLX509_NAME_ENTRIES_copy",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+    sk_X509_NAME_ENTRY_sort(entries);
+
+    /* the entries count first, this also makes the buffer non empty */
+    if(xmlSecOpenSSLX509AppendLength(&buf, sk_X509_NAME_ENTRY_num(entries)) < 0) {
+        goto done;
+    }
+    for(ii = 0; ii < sk_X509_NAME_ENTRY_num(entries); ++ii) {
+        X509_NAME_ENTRY *entry = sk_X509_NAME_ENTRY_value(entries, ii);
+        ASN1_STRING *value = X509_NAME_ENTRY_get_data(entry);
+        ASN1_OBJECT *obj = X509_NAME_ENTRY_get_object(entry);
+        unsigned char *p;
+
+        if(value != NULL) {
+            size = ASN1_STRING_length(value);
+            if(xmlSecOpenSSLX509AppendLength(&buf, size) < 0) {
+                goto done;
+            }
+            if((size > 0) && (xmlSecBufferAppend(&buf, ASN1_STRING_data(value), size) < 0)) {
+                goto done;
+            }
+        } else if(xmlSecOpenSSLX509AppendLength(&buf, 0xFFFFFFFF) < 0) {
+            goto done;
+        }
+
+        size = (obj != NULL) ? i2d_ASN1_OBJECT(obj, NULL) : 0;
+        if(size < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "i2d_ASN1_OBJECT",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            goto done;
+        }
+        if(xmlSecOpenSSLX509AppendLength(&buf, size) < 0) {
+            goto done;
+        }
+        if(size > 0) {
+            ret = xmlSecBufferSetMaxSize(&buf, xmlSecBufferGetSize(&buf) + size);
+            if(ret < 0) {
+                goto done;
+            }
+            p = xmlSecBufferGetData(&buf) + xmlSecBufferGetSize(&buf);
+            i2d_ASN1_OBJECT(obj, &p);
+            xmlSecBufferSetSize(&buf, xmlSecBufferGetSize(&buf) + size);
+        }
+    }
+
+    res = xmlSecBase64Encode(xmlSecBufferGetData(&buf), xmlSecBufferGetSize(&buf), 0);
+    if(res == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecBase64Encode",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+
+done:
+    if(entries != NULL) {
+        sk_X509_NAME_ENTRY_free(entries);
+    }
+    xmlSecBufferFinalize(&buf);
+    return(res);
+}
+
+static int
+xmlSecOpenSSLX509AppendLength(xmlSecBufferPtr buf, unsigned long len) {
+    xmlSecByte bytes[4];
+
+    xmlSecAssert2(buf != NULL, -1);
+
+    bytes[0] = (xmlSecByte)((len >> 24) & 0xFF);
+    bytes[1] = (xmlSecByte)((len >> 16) & 0xFF);
+    bytes[2] = (xmlSecByte)((len >> 8) & 0xFF);
+    bytes[3] = (xmlSecByte)(len & 0xFF);
+    return(xmlSecBufferAppend(buf, bytes, sizeof(bytes)));
+}
+
+/* returns the decimal serial number, same as in <dsig:X509SerialNumber/> */
+static xmlChar*
+xmlSecOpenSSLX509SerialGetKey(BIGNUM* bn) {
+    xmlChar *res;
+    char *str;
+
+    xmlSecAssert2(bn != NULL, NULL);
+
+    str = BN_bn2dec(bn);
+    if(str == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "BN_bn2dec",
+                    XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(NULL);
+    }
+
+    res = xmlStrdup(BAD_CAST str);
+    OPENSSL_free(str);
+    if(res == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlStrdup",
+                    XMLSEC_ERRORS_R_STRDUP_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(NULL);
+    }
+    return(res);
+}
+
+static X509*
+xmlSecOpenSSLX509FindNextChainCert(STACK_OF(X509) *chain, X509 *cert) {
+    unsigned long certSubjHash;
+    int i;
+
+    xmlSecAssert2(chain != NULL, NULL);
+    xmlSecAssert2(cert != NULL, NULL);
+
+    certSubjHash = X509_subject_name_hash(cert);
+    for(i = 0; i < sk_X509_num(chain); ++i) {
+        if((sk_X509_value(chain, i) != cert) &&
+           (X509_issuer_name_hash(sk_X509_value(chain, i)) == certSubjHash)) {
+
+            return(sk_X509_value(chain, i));
+        }
+    }
+    return(NULL);
+}
+
+/* returns 1 if @cert is revoked by a CRL from either index, 0 if it is not or -1 if an error occurs */
+static int
+xmlSecOpenSSLX509IsRevoked(xmlHashTablePtr crlsByIssuer, xmlHashTablePtr crlsByIssuer2,
+                           X509* cert, const xmlChar* issuerKey) {
+    int ret;
+
+    xmlSecAssert2(cert != NULL, -1);
+    xmlSecAssert2(issuerKey != NULL, -1);
+
+    if(crlsByIssuer != NULL) {
+        ret = xmlSecOpenSSLX509VerifyCertAgainstCrls(crlsByIssuer, cert, issuerKey);
+        if(ret == 0) {
+            return(1);
+        } else if(ret != 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecOpenSSLX509VerifyCertAgainstCrls",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+    }
+    if(crlsByIssuer2 != NULL) {
+        ret = xmlSecOpenSSLX509VerifyCertAgainstCrls(crlsByIssuer2, cert, issuerKey);
+        if(ret == 0) {
+            return(1);
+        } else if(ret != 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecOpenSSLX509VerifyCertAgainstCrls",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+static int
+xmlSecOpenSSLX509VerifyCertAgainstCrls(xmlHashTablePtr crlsByIssuer, X509* cert, const xmlChar* issuerKey) {
+    xmlSecOpenSSLX509CrlPtr xcrl;
+    int ret;
+
+    xmlSecAssert2(crlsByIssuer != NULL, -1);
+    xmlSecAssert2(cert != NULL, -1);
+    xmlSecAssert2(issuerKey != NULL, -1);
+
+    /*
+     * Try to retrieve a CRL corresponding to the issuer of
+     * the current certificate
+     */
+    xcrl = (xmlSecOpenSSLX509CrlPtr)xmlHashLookup(crlsByIssuer, issuerKey);
+    if(xcrl == NULL) {
+        /* no crls for this issuer */
+        return(1);
+    }
+
+    /*
+     * Check date of CRL to make sure it's not expired
+     */
+    ret = X509_cmp_current_time(X509_CRL_get_nextUpdate(xcrl->crl));
+    if (ret == 0) {
+        /* crl expired */
+        return(1);
+    }
+
+    /*
+     * Check if the current certificate is revoked by this CRL
+     */
+    if(xmlSecOpenSSLX509CrlIsRevoked(xcrl, X509_get_serialNumber(cert)) != 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_CERT_REVOKED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(0);
+    }
+    return(1);
+}
+
+/* returns 1 and the referenced @xcrl if @crl is valid, 0 if it is not valid or -1 if an error occurs */
+static int
+xmlSecOpenSSLX509StoreVerifyCrl(xmlSecOpenSSLX509StoreCtxPtr ctx, X509_CRL* crl, xmlSecOpenSSLX509CrlPtr* xcrl) {
+    const ASN1_BIT_STRING* signature;
+    xmlChar* sigKey = NULL;
+    xmlSecByte* der = NULL;
+    xmlSecByte* p;
+    int derSize;
+    xmlSecOpenSSLX509CrlPtr res = NULL;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->xst != NULL, -1);
+    xmlSecAssert2(crl != NULL, -1);
+    xmlSecAssert2(xcrl != NULL, -1);
+
+    (*xcrl) = NULL;
+
+    /*
+     * The same crl comes with every document from the same signer. Hashing
+     * a big crl costs as much as verifying it, so the crls are looked up by
+     * the signature value and then compared byte by byte.
+     */
+#if !defined(XMLSEC_OPENSSL_110)
+    signature = crl->signature;
+#else  /* !defined(XMLSEC_OPENSSL_110) */
+    X509_CRL_get0_signature(crl, &signature, NULL);
+#endif /* !defined(XMLSEC_OPENSSL_110) */
+    if((signature == NULL) || (signature->data == NULL) || (signature->length <= 0)) {
+        return(xmlSecOpenSSLX509VerifyCRL(ctx->xst, crl));
+    }
+
+    derSize = i2d_X509_CRL(crl, NULL);
+    if(derSize <= 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "i2d_X509_CRL",
+                    XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    der = (xmlSecByte*)xmlMalloc(derSize);
+    if(der == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_MALLOC_FAILED,
+                    "size=%d", derSize);
+        return(-1);
+    }
+    p = der;
+    if(i2d_X509_CRL(crl, &p) != derSize) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "i2d_X509_CRL",
+                    XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                    "size=%d", derSize);
+        xmlFree(der);
+        return(-1);
+    }
+
+    sigKey = xmlSecBase64Encode(signature->data, signature->length, 0);
+    if(sigKey == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecBase64Encode",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlFree(der);
+        return(-1);
+    }
+
+    xmlSecOpenSSLX509StoreLock(ctx);
+    if(ctx->verifiedCrlsBySignature != NULL) {
+        res = (xmlSecOpenSSLX509CrlPtr)xmlHashLookup(ctx->verifiedCrlsBySignature, sigKey);
+    }
+    if((res != NULL) && (res->derSize == derSize) && (memcmp(res->der, der, derSize) == 0)) {
+        res = xmlSecOpenSSLX509CrlReference(res);
+    } else {
+        res = NULL;
+    }
+    xmlSecOpenSSLX509StoreUnlock(ctx);
+    if(res != NULL) {
+        xmlFree(sigKey);
+        xmlFree(der);
+        (*xcrl) = res;
+        return(1);
+    }
+
+    /* only the valid crls are remembered: trusting more certs can make an invalid crl valid */
+    ret = xmlSecOpenSSLX509VerifyCRL(ctx->xst, crl);
+    if(ret != 1) {
+        xmlFree(sigKey);
+        xmlFree(der);
+        return(ret);
+    }
+
+    res = xmlSecOpenSSLX509CrlCreate(crl);
+    if(res == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecOpenSSLX509CrlCreate",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlFree(sigKey);
+        xmlFree(der);
+        return(-1);
+    }
+    res->der = der;
+    res->derSize = derSize;
+
+    xmlSecOpenSSLX509StoreLock(ctx);
+    if((ctx->verifiedCrlsBySignature != NULL) &&
+       (xmlHashLookup(ctx->verifiedCrlsBySignature, sigKey) == NULL) &&
+       (xmlHashAddEntry(ctx->verifiedCrlsBySignature, sigKey, res) == 0)) {
+        xmlSecOpenSSLX509CrlPtr old;
+        xmlSecSize pos;
+
+        res->sigKey = sigKey;
+        sigKey = NULL;
+        (void)xmlSecOpenSSLX509CrlReference(res);
+
+        if(xmlSecPtrListGetSize(&(ctx->verifiedCrlsList)) < XMLSEC_OPENSSL_X509_STORE_VERIFIED_CRLS_MAX_SIZE) {
+            ret = xmlSecPtrListAdd(&(ctx->verifiedCrlsList), res);
+        } else {
+            /* replace the oldest crl, the verifications in progress hold their own references */
+            pos = ctx->verifiedCrlsNext;
+            ctx->verifiedCrlsNext = (pos + 1) % XMLSEC_OPENSSL_X509_STORE_VERIFIED_CRLS_MAX_SIZE;
+
+            old = (xmlSecOpenSSLX509CrlPtr)xmlSecPtrListGetItem(&(ctx->verifiedCrlsList), pos);
+            if((old != NULL) && (old->sigKey != NULL) &&
+               (xmlHashLookup(ctx->verifiedCrlsBySignature, old->sigKey) == old)) {
+                (void)xmlHashRemoveEntry(ctx->verifiedCrlsBySignature, old->sigKey, NULL);
+            }
+            ret = xmlSecPtrListSet(&(ctx->verifiedCrlsList), res, pos);
+        }
+        if(ret < 0) {
+            (void)xmlHashRemoveEntry(ctx->verifiedCrlsBySignature, res->sigKey, NULL);
+            xmlSecOpenSSLX509CrlRelease(res);
+        }
+    }
+    xmlSecOpenSSLX509StoreUnlock(ctx);
+
+    if(sigKey != NULL) {
+        xmlFree(sigKey);
+    }
+    (*xcrl) = res;
+    return(1);
+}
+
+/*
+ * The chain key: the store generation, the verification time bucket and depth,
+ * the fingerprints of the first @certsSize certs (the ones from the document)
+ * and the fingerprint of the @leaf.
+ */
+static xmlChar*
+xmlSecOpenSSLX509StoreGetChainKey(STACK_OF(X509)* certs, int certsSize, X509* leaf,
+                                  long generation, xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecByte md[EVP_MAX_MD_SIZE];
+    unsigned int mdLen;
+    xmlSecBuffer buf;
+    xmlChar* res = NULL;
+    unsigned long timeBucket = 0;
+    int i;
+    int ret;
+
+    xmlSecAssert2(certs != NULL, NULL);
+    xmlSecAssert2(certsSize <= sk_X509_num(certs), NULL);
+    xmlSecAssert2(leaf != NULL, NULL);
+    xmlSecAssert2(keyInfoCtx != NULL, NULL);
+
+    ret = xmlSecBufferInitialize(&buf, 128);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecBufferInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(NULL);
+    }
+
+    if(keyInfoCtx->certsVerificationTime > 0) {
+        timeBucket = (unsigned long)(keyInfoCtx->certsVerificationTime / XMLSEC_OPENSSL_X509_STORE_VERIFIED_CHAINS_TIME_BUCKET) + 1;
+    }
+    if((xmlSecOpenSSLX509AppendLength(&buf, (unsigned long)generation) < 0) ||
+       (xmlSecOpenSSLX509AppendLength(&buf, timeBucket) < 0) ||
+       (xmlSecOpenSSLX509AppendLength(&buf, (unsigned long)keyInfoCtx->certsVerificationDepth) < 0) ||
+       (xmlSecOpenSSLX509AppendLength(&buf, (unsigned long)certsSize) < 0)) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecOpenSSLX509AppendLength",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+
+    for(i = 0; i <= certsSize; ++i) {
+        X509* cert = (i < certsSize) ? sk_X509_value(certs, i) : leaf;
+
+        mdLen = 0;
+        if(X509_digest(cert, EVP_sha256(), md, &mdLen) != 1) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "X509_digest",
+                        XMLSEC_ERRORS_R_CRYPTO_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            goto done;
+        }
+        ret = xmlSecBufferAppend(&buf, md, mdLen);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecBufferAppend",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "size=%d", (int)mdLen);
+            goto done;
+        }
+    }
+
+    res = xmlSecBase64Encode(xmlSecBufferGetData(&buf), xmlSecBufferGetSize(&buf), 0);
+    if(res == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecBase64Encode",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        goto done;
+    }
+
+done:
+    xmlSecBufferFinalize(&buf);
+    return(res);
+}
+
+/* returns 1 if the chain for @key is verified and still valid or 0 otherwise */
+static int
+xmlSecOpenSSLX509StoreFindChain(xmlSecOpenSSLX509StoreCtxPtr ctx, const xmlChar* key,
+                                xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecOpenSSLX509ChainPtr chain = NULL;
+    time_t verificationTime;
+    int res = 0;
 
+    xmlSecAssert2(ctx != NULL, 0);
+    xmlSecAssert2(key != NULL, 0);
+    xmlSecAssert2(keyInfoCtx != NULL, 0);
 
-        for(i = 0; i < sk_X509_num(certs); ++i) {
-            cert = sk_X509_value(certs, i);
-            if(ASN1_INTEGER_cmp(X509_get_serialNumber(cert), serial) != 0) {
-                continue;
+    verificationTime = keyInfoCtx->certsVerificationTime;
+
+    xmlSecOpenSSLX509StoreLock(ctx);
+    if(ctx->verifiedChainsByKey != NULL) {
+        chain = (xmlSecOpenSSLX509ChainPtr)xmlHashLookup(ctx->verifiedChainsByKey, key);
+    }
+    if(chain != NULL) {
+        res = xmlSecOpenSSLX509ChainIsValid(chain, (verificationTime > 0) ? &verificationTime : NULL);
+    }
+    xmlSecOpenSSLX509StoreUnlock(ctx);
+
+    return(res);
+}
+
+/* takes the ownership of @certs */
+static int
+xmlSecOpenSSLX509StoreAddChain(xmlSecOpenSSLX509StoreCtxPtr ctx, const xmlChar* key, STACK_OF(X509)* certs,
+                               xmlHashTablePtr crlsByIssuer, xmlHashTablePtr crlsByIssuer2,
+                               long generation) {
+    xmlSecOpenSSLX509ChainPtr chain;
+    xmlSecOpenSSLX509CrlPtr xcrl;
+    xmlChar* issuerKey;
+    int i;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(key != NULL, -1);
+    xmlSecAssert2(certs != NULL, -1);
+
+    chain = xmlSecOpenSSLX509ChainCreate(certs);
+    if(chain == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecOpenSSLX509ChainCreate",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    chain->key = xmlStrdup(key);
+    if(chain->key == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_STRDUP_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecOpenSSLX509ChainDestroy(chain);
+        return(-1);
+    }
+
+    /* the chain is re-verified when any of the crls checked for it expires */
+    if((crlsByIssuer != NULL) || (crlsByIssuer2 != NULL)) {
+        for(i = 0; i < sk_X509_num(chain->certs); ++i) {
+            issuerKey = xmlSecOpenSSLX509NameGetKey(X509_get_issuer_name(sk_X509_value(chain->certs, i)));
+            if(issuerKey == NULL) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            NULL,
+                            "xmlSecOpenSSLX509NameGetKey",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                xmlSecOpenSSLX509ChainDestroy(chain);
+                return(-1);
             }
-            issuer = X509_get_issuer_name(cert);
-            if(xmlSecOpenSSLX509NamesCompare(nm, issuer) == 0) {
-                ASN1_INTEGER_free(serial);
-                X509_NAME_free(nm);
-                return(cert);
+
+            ret = 0;
+            if((crlsByIssuer != NULL) &&
+               ((xcrl = (xmlSecOpenSSLX509CrlPtr)xmlHashLookup(crlsByIssuer, issuerKey)) != NULL)) {
+                ret = xmlSecPtrListAdd(&(chain->crls), xmlSecOpenSSLX509CrlReference(xcrl));
+                if(ret < 0) {
+                    xmlSecOpenSSLX509CrlRelease(xcrl);
+                }
+            }
+            if((ret >= 0) && (crlsByIssuer2 != NULL) &&
+               ((xcrl = (xmlSecOpenSSLX509CrlPtr)xmlHashLookup(crlsByIssuer2, issuerKey)) != NULL)) {
+                ret = xmlSecPtrListAdd(&(chain->crls), xmlSecOpenSSLX509CrlReference(xcrl));
+                if(ret < 0) {
+                    xmlSecOpenSSLX509CrlRelease(xcrl);
+                }
+            }
+            xmlFree(issuerKey);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            NULL,
+                            "xmlSecPtrListAdd",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                xmlSecOpenSSLX509ChainDestroy(chain);
+                return(-1);
             }
         }
+    }
 
-        X509_NAME_free(nm);
-        ASN1_INTEGER_free(serial);
-    } else if(ski != NULL) {
-        int len;
-        int index;
-        X509_EXTENSION *ext;
-        ASN1_OCTET_STRING *keyId;
+    xmlSecOpenSSLX509StoreLock(ctx);
+    if(ctx->generation != generation) {
+        /* the store has changed since the chain was verified */
+        xmlSecOpenSSLX509StoreUnlock(ctx);
+        xmlSecOpenSSLX509ChainDestroy(chain);
+        return(0);
+    }
+    ret = -1;
+    if(ctx->verifiedChainsByKey != NULL) {
+        xmlSecOpenSSLX509ChainPtr old;
+        xmlSecSize size, pos;
+
+        size = xmlSecPtrListGetSize(&(ctx->verifiedChainsList));
+        pos = size;
+        old = (xmlSecOpenSSLX509ChainPtr)xmlHashLookup(ctx->verifiedChainsByKey, key);
+        if(old != NULL) {
+            /* replace the expired chain */
+            for(pos = 0; pos < size; ++pos) {
+                if(xmlSecPtrListGetItem(&(ctx->verifiedChainsList), pos) == old) {
+                    break;
+                }
+            }
+        } else if(size >= XMLSEC_OPENSSL_X509_STORE_VERIFIED_CHAINS_MAX_SIZE) {
+            /* replace the oldest chain */
+            pos = ctx->verifiedChainsNext;
+            ctx->verifiedChainsNext = (pos + 1) % XMLSEC_OPENSSL_X509_STORE_VERIFIED_CHAINS_MAX_SIZE;
+            old = (xmlSecOpenSSLX509ChainPtr)xmlSecPtrListGetItem(&(ctx->verifiedChainsList), pos);
+        }
+        if((old != NULL) && (xmlHashLookup(ctx->verifiedChainsByKey, old->key) == old)) {
+            (void)xmlHashRemoveEntry(ctx->verifiedChainsByKey, old->key, NULL);
+        }
 
-        /* our usual trick with base64 decode */
-        len = xmlSecBase64Decode(ski, (xmlSecByte*)ski, xmlStrlen(ski));
-        if(len < 0) {
+        if(pos < size) {
+            ret = xmlSecPtrListSet(&(ctx->verifiedChainsList), chain, pos);
+        } else {
+            ret = xmlSecPtrListAdd(&(ctx->verifiedChainsList), chain);
+        }
+    }
+    if(ret >= 0) {
+        /* if the hash add fails, the list keeps the chain till it is replaced */
+        (void)xmlHashAddEntry(ctx->verifiedChainsByKey, chain->key, chain);
+    }
+    xmlSecOpenSSLX509StoreUnlock(ctx);
+
+    if(ret < 0) {
+        xmlSecOpenSSLX509ChainDestroy(chain);
+        return(-1);
+    }
+    return(0);
+}
+
+/* forgets the verified chains: the verified crls stay valid since the trusted certs are only added */
+static void
+xmlSecOpenSSLX509StoreChanged(xmlSecOpenSSLX509StoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+
+    xmlSecOpenSSLX509StoreLock(ctx);
+    XMLSEC_ATOMIC_INC(&(ctx->generation));
+    if(ctx->verifiedChainsByKey != NULL) {
+        xmlHashFree(ctx->verifiedChainsByKey, NULL);
+    }
+    ctx->verifiedChainsByKey = xmlHashCreate(0);
+    xmlSecPtrListEmpty(&(ctx->verifiedChainsList));
+    ctx->verifiedChainsNext = 0;
+    xmlSecOpenSSLX509StoreUnlock(ctx);
+}
+
+static void
+xmlSecOpenSSLX509StoreLock(xmlSecOpenSSLX509StoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+
+    XMLSEC_SPIN_LOCK(&(ctx->lock));
+}
+
+static void
+xmlSecOpenSSLX509StoreUnlock(xmlSecOpenSSLX509StoreCtxPtr ctx) {
+    xmlSecAssert(ctx != NULL);
+
+    XMLSEC_SPIN_UNLOCK(&(ctx->lock));
+}
+
+/*****************************************************************************
+ *
+ * Internal OpenSSL X509 CRL
+ *
+ *****************************************************************************/
+static xmlSecOpenSSLX509CrlPtr
+xmlSecOpenSSLX509CrlCreate(X509_CRL* crl) {
+    xmlSecOpenSSLX509CrlPtr xcrl;
+    STACK_OF(X509_REVOKED)* revoked;
+    int i;
+
+    xmlSecAssert2(crl != NULL, NULL);
+
+    xcrl = (xmlSecOpenSSLX509CrlPtr)xmlMalloc(sizeof(xmlSecOpenSSLX509Crl));
+    if(xcrl == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_MALLOC_FAILED,
+                    "sizeof(xmlSecOpenSSLX509Crl)=%d",
+                    (int)sizeof(xmlSecOpenSSLX509Crl));
+        return(NULL);
+    }
+    memset(xcrl, 0, sizeof(xmlSecOpenSSLX509Crl));
+    xcrl->refs = 1;
+
+    X509_CRL_up_ref(crl);
+    xcrl->crl = crl;
+
+    xcrl->issuerKey = xmlSecOpenSSLX509NameGetKey(X509_CRL_get_issuer(crl));
+    if(xcrl->issuerKey == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecOpenSSLX509NameGetKey",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecOpenSSLX509CrlRelease(xcrl);
+        return(NULL);
+    }
+
+    revoked = X509_CRL_get_REVOKED(crl);
+    if((revoked != NULL) && (sk_X509_REVOKED_num(revoked) > 0)) {
+        xcrl->revokedSize = sk_X509_REVOKED_num(revoked);
+        xcrl->revoked = (ASN1_INTEGER**)xmlMalloc(sizeof(ASN1_INTEGER*) * xcrl->revokedSize);
+        if(xcrl->revoked == NULL) {
             xmlSecError(XMLSEC_ERRORS_HERE,
                         NULL,
-                        "xmlSecBase64Decode",
-                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
-                        "ski=%s",
-                        xmlSecErrorsSafeString(ski));
+                        NULL,
+                        XMLSEC_ERRORS_R_MALLOC_FAILED,
+                        "size=%d", xcrl->revokedSize);
+            xmlSecOpenSSLX509CrlRelease(xcrl);
             return(NULL);
         }
-        for(i = 0; i < sk_X509_num(certs); ++i) {
-            cert = sk_X509_value(certs, i);
-            index = X509_get_ext_by_NID(cert, NID_subject_key_identifier, -1);
-            if((index >= 0)  && (ext = X509_get_ext(cert, index))) {
-                keyId = X509V3_EXT_d2i(ext);
-                if((keyId != NULL) && (keyId->length == len) &&
-                                    (memcmp(keyId->data, ski, len) == 0)) {
-                    ASN1_OCTET_STRING_free(keyId);
-                    return(cert);
-                }
-                ASN1_OCTET_STRING_free(keyId);
-            }
+        for(i = 0; i < xcrl->revokedSize; ++i) {
+            xcrl->revoked[i] = (ASN1_INTEGER*)X509_REVOKED_get0_serialNumber(sk_X509_REVOKED_value(revoked, i));
         }
+        qsort(xcrl->revoked, xcrl->revokedSize, sizeof(ASN1_INTEGER*), xmlSecOpenSSLX509CrlSerialsCmp);
     }
+    return(xcrl);
+}
 
-    return(NULL);
+static xmlSecOpenSSLX509CrlPtr
+xmlSecOpenSSLX509CrlReference(xmlSecOpenSSLX509CrlPtr xcrl) {
+    xmlSecAssert2(xcrl != NULL, NULL);
+
+    XMLSEC_ATOMIC_INC(&(xcrl->refs));
+    return(xcrl);
 }
 
-static X509*
-xmlSecOpenSSLX509FindNextChainCert(STACK_OF(X509) *chain, X509 *cert) {
-    unsigned long certSubjHash;
-    int i;
+static void
+xmlSecOpenSSLX509CrlRelease(xmlSecOpenSSLX509CrlPtr xcrl) {
+    xmlSecAssert(xcrl != NULL);
 
-    xmlSecAssert2(chain != NULL, NULL);
-    xmlSecAssert2(cert != NULL, NULL);
+    if(XMLSEC_ATOMIC_DEC(&(xcrl->refs)) > 0) {
+        return;
+    }
 
-    certSubjHash = X509_subject_name_hash(cert);
-    for(i = 0; i < sk_X509_num(chain); ++i) {
-        if((sk_X509_value(chain, i) != cert) &&
-           (X509_issuer_name_hash(sk_X509_value(chain, i)) == certSubjHash)) {
+    if(xcrl->crl != NULL) {
+        X509_CRL_free(xcrl->crl);
+    }
+    if(xcrl->issuerKey != NULL) {
+        xmlFree(xcrl->issuerKey);
+    }
+    if(xcrl->revoked != NULL) {
+        xmlFree(xcrl->revoked);
+    }
+    if(xcrl->der != NULL) {
+        xmlFree(xcrl->der);
+    }
+    if(xcrl->sigKey != NULL) {
+        xmlFree(xcrl->sigKey);
+    }
+    memset(xcrl, 0, sizeof(xmlSecOpenSSLX509Crl));
+    xmlFree(xcrl);
+}
 
-            return(sk_X509_value(chain, i));
+/* returns 1 if @serial is in the sorted revoked list, 0 otherwise */
+static int
+xmlSecOpenSSLX509CrlIsRevoked(xmlSecOpenSSLX509CrlPtr xcrl, ASN1_INTEGER* serial) {
+    int lo, hi, mid;
+    int ret;
+
+    xmlSecAssert2(xcrl != NULL, 0);
+    xmlSecAssert2(serial != NULL, 0);
+
+    lo = 0;
+    hi = xcrl->revokedSize;
+    while(lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        ret = ASN1_INTEGER_cmp(xcrl->revoked[mid], serial);
+        if(ret == 0) {
+            return(1);
+        } else if(ret < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
-    return(NULL);
+    return(0);
 }
 
 static int
-xmlSecOpenSSLX509VerifyCertAgainstCrls(STACK_OF(X509_CRL) *crls, X509* cert) {
-    X509_NAME *issuer;
-    X509_CRL *crl = NULL;
-    X509_REVOKED *revoked;
-    int i, n;
+xmlSecOpenSSLX509CrlSerialsCmp(const void* a, const void* b) {
+    return(ASN1_INTEGER_cmp(*(ASN1_INTEGER* const*)a, *(ASN1_INTEGER* const*)b));
+}
+
+static xmlSecPtr
+xmlSecOpenSSLX509CrlListDuplicateItem(xmlSecPtr ptr) {
+    xmlSecAssert2(ptr != NULL, NULL);
+
+    return(xmlSecOpenSSLX509CrlReference((xmlSecOpenSSLX509CrlPtr)ptr));
+}
+
+static void
+xmlSecOpenSSLX509CrlListDestroyItem(xmlSecPtr ptr) {
+    xmlSecAssert(ptr != NULL);
+
+    xmlSecOpenSSLX509CrlRelease((xmlSecOpenSSLX509CrlPtr)ptr);
+}
+
+/*****************************************************************************
+ *
+ * Internal OpenSSL X509 chain
+ *
+ *****************************************************************************/
+/* takes the ownership of @certs */
+static xmlSecOpenSSLX509ChainPtr
+xmlSecOpenSSLX509ChainCreate(STACK_OF(X509)* certs) {
+    xmlSecOpenSSLX509ChainPtr chain;
     int ret;
 
-    xmlSecAssert2(crls != NULL, -1);
-    xmlSecAssert2(cert != NULL, -1);
+    xmlSecAssert2(certs != NULL, NULL);
 
-    /*
-     * Try to retrieve a CRL corresponding to the issuer of
-     * the current certificate
-     */
-    issuer = X509_get_issuer_name(cert);
-    n = sk_X509_CRL_num(crls);
-    for(i = 0; i < n; i++) {
-        crl = sk_X509_CRL_value(crls, i);
-        if(crl == NULL) {
-            continue;
-        }
+    chain = (xmlSecOpenSSLX509ChainPtr)xmlMalloc(sizeof(xmlSecOpenSSLX509Chain));
+    if(chain == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_MALLOC_FAILED,
+                    "sizeof(xmlSecOpenSSLX509Chain)=%d",
+                    (int)sizeof(xmlSecOpenSSLX509Chain));
+        sk_X509_pop_free(certs, X509_free);
+        return(NULL);
+    }
+    memset(chain, 0, sizeof(xmlSecOpenSSLX509Chain));
+    chain->certs = certs;
+    chain->expires = time(NULL) + XMLSEC_OPENSSL_X509_STORE_VERIFIED_CHAINS_TTL;
 
-        if(xmlSecOpenSSLX509NamesCompare(X509_CRL_get_issuer(crl), issuer) == 0) {
-            break;
-        }
+    ret = xmlSecPtrListInitialize(&(chain->crls), xmlSecOpenSSLX509CrlListId);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecPtrListInitialize",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        xmlSecOpenSSLX509ChainDestroy(chain);
+        return(NULL);
     }
-    if((i >= n) || (crl == NULL)){
-        /* no crls for this issuer */
-        return(1);
+    return(chain);
+}
+
+static void
+xmlSecOpenSSLX509ChainDestroy(xmlSecOpenSSLX509ChainPtr chain) {
+    xmlSecAssert(chain != NULL);
+
+    if(chain->key != NULL) {
+        xmlFree(chain->key);
+    }
+    if(chain->certs != NULL) {
+        sk_X509_pop_free(chain->certs, X509_free);
+    }
+    if(xmlSecPtrListIsValid(&(chain->crls))) {
+        xmlSecPtrListFinalize(&(chain->crls));
     }
+    memset(chain, 0, sizeof(xmlSecOpenSSLX509Chain));
+    xmlFree(chain);
+}
 
-    /*
-     * Check date of CRL to make sure it's not expired
-     */
-    ret = X509_cmp_current_time(X509_CRL_get_nextUpdate(crl));
-    if (ret == 0) {
-        /* crl expired */
-        return(1);
+/*
+ * returns 1 if all the certs are valid at @verificationTime (or now) and
+ * none of the crls has expired, 0 otherwise
+ */
+static int
+xmlSecOpenSSLX509ChainIsValid(xmlSecOpenSSLX509ChainPtr chain, time_t* verificationTime) {
+    xmlSecOpenSSLX509CrlPtr xcrl;
+    X509* cert;
+    xmlSecSize size, pos;
+    int i;
+
+    xmlSecAssert2(chain != NULL, 0);
+    xmlSecAssert2(chain->certs != NULL, 0);
+
+    if(time(NULL) >= chain->expires) {
+        return(0);
     }
 
-    /*
-     * Check if the current certificate is revoked by this CRL
-     */
-    n = sk_X509_REVOKED_num(X509_CRL_get_REVOKED(crl));
-    for (i = 0; i < n; i++) {
-        revoked = sk_X509_REVOKED_value(X509_CRL_get_REVOKED(crl), i);
-        if (ASN1_INTEGER_cmp(X509_REVOKED_get0_serialNumber(revoked), X509_get_serialNumber(cert)) == 0) {
-            xmlSecError(XMLSEC_ERRORS_HERE,
-                        NULL,
-                        NULL,
-                        XMLSEC_ERRORS_R_CERT_REVOKED,
-                        XMLSEC_ERRORS_NO_MESSAGE);
+    for(i = 0; i < sk_X509_num(chain->certs); ++i) {
+        cert = sk_X509_value(chain->certs, i);
+        if((X509_cmp_time(X509_get_notBefore(cert), verificationTime) >= 0) ||
+           (X509_cmp_time(X509_get_notAfter(cert), verificationTime) <= 0)) {
+            return(0);
+        }
+    }
+
+    size = xmlSecPtrListGetSize(&(chain->crls));
+    for(pos = 0; pos < size; ++pos) {
+        xcrl = (xmlSecOpenSSLX509CrlPtr)xmlSecPtrListGetItem(&(chain->crls), pos);
+        if((xcrl != NULL) && (X509_CRL_get_nextUpdate(xcrl->crl) != NULL) &&
+           (X509_cmp_time(X509_CRL_get_nextUpdate(xcrl->crl), NULL) <= 0)) {
             return(0);
         }
     }
     return(1);
 }
 
+static void
+xmlSecOpenSSLX509ChainListDestroyItem(xmlSecPtr ptr) {
+    xmlSecAssert(ptr != NULL);
+
+    xmlSecOpenSSLX509ChainDestroy((xmlSecOpenSSLX509ChainPtr)ptr);
+}
+
 static X509_NAME *
 xmlSecOpenSSLX509NameRead(xmlSecByte *str, int len) {
     xmlSecByte name[256];
@@ -1186,83 +2627,6 @@ xmlSecOpenSSLX509_NAME_ENTRIES_copy(X509_NAME * a) {
     return (res);
 }
 
-static
-int xmlSecOpenSSLX509_NAME_ENTRIES_cmp(STACK_OF(X509_NAME_ENTRY)* a,  STACK_OF(X509_NAME_ENTRY)* b) {
-    const X509_NAME_ENTRY *na;
-    const X509_NAME_ENTRY *nb;
-    int ii, ret;
-
-    xmlSecAssert2(a != NULL, -1);
-    xmlSecAssert2(b != NULL, 1);
-
-    if (sk_X509_NAME_ENTRY_num(a) != sk_X509_NAME_ENTRY_num(b)) {
-        return sk_X509_NAME_ENTRY_num(a) - sk_X509_NAME_ENTRY_num(b);
-    }
-
-    for (ii = sk_X509_NAME_ENTRY_num(a) - 1; ii >= 0; --ii) {
-        na = sk_X509_NAME_ENTRY_value(a, ii);
-        nb = sk_X509_NAME_ENTRY_value(b, ii);
-
-        ret = xmlSecOpenSSLX509_NAME_ENTRY_cmp(&na, &nb);
-        if(ret != 0) {
-            return(ret);
-        }
-    }
-
-    return(0);
-}
-
-
-/**
- * xmlSecOpenSSLX509NamesCompare:
- *
- * We have to sort X509_NAME entries to get correct results.
- * This is ugly but OpenSSL does not support it
- */
-static int
-xmlSecOpenSSLX509NamesCompare(X509_NAME *a, X509_NAME *b) {
-    STACK_OF(X509_NAME_ENTRY) *a1 = NULL;
-    STACK_OF(X509_NAME_ENTRY) *b1 = NULL;
-    int ret;
-
-    xmlSecAssert2(a != NULL, -1);
-    xmlSecAssert2(b != NULL, 1);
-
-    a1 = xmlSecOpenSSLX509_NAME_ENTRIES_copy(a);
-    if(a1 == NULL) {
-        xmlSecError(XMLSEC_ERRORS_HERE,
-                    NULL,
-                    "xmlSecOpenSSLX509_NAME_ENTRIES_copy",
-                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
-                    XMLSEC_ERRORS_NO_MESSAGE);
-        return(-1);
-    }
-    b1 = xmlSecOpenSSLX509_NAME_ENTRIES_copy(b);
-    if(b1 == NULL) {
-        xmlSecError(XMLSEC_ERRORS_HERE,
-                    NULL,
-                    "xmlSecOpenSSLX509_NAME_ENTRIES_copy",
-                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
-                    XMLSEC_ERRORS_NO_MESSAGE);
-        sk_X509_NAME_ENTRY_free(a1);
-        return(1);
-    }
-
-    /* sort both */
-    (void)sk_X509_NAME_ENTRY_set_cmp_func(a1, xmlSecOpenSSLX509_NAME_ENTRY_cmp);
-    sk_X509_NAME_ENTRY_sort(a1);
-    (void)sk_X509_NAME_ENTRY_set_cmp_func(b1, xmlSecOpenSSLX509_NAME_ENTRY_cmp);
-    sk_X509_NAME_ENTRY_sort(b1);
-
-    /* actually compare */
-    ret = xmlSecOpenSSLX509_NAME_ENTRIES_cmp(a1, b1);
-
-    /* cleanup */
-    sk_X509_NAME_ENTRY_free(a1);
-    sk_X509_NAME_ENTRY_free(b1);
-    return(ret);
-}
-
 static int
 xmlSecOpenSSLX509_NAME_ENTRY_cmp(const X509_NAME_ENTRY * const *a, const X509_NAME_ENTRY * const *b) {
     ASN1_STRING *a_value, *b_value;
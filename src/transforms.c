@@ -306,6 +306,12 @@ xmlSecTransformIdsRegisterDefault(void) {
     return(0);
 }
 
+static int              xmlSecTransformPumpWithBuffer   (xmlSecTransformPtr left,
+                                                         xmlSecTransformPtr right,
+                                                         xmlSecByte* buf,
+                                                         xmlSecSize bufMaxSize,
+                                                         xmlSecTransformCtxPtr transformCtx);
+
 /**************************************************************************
  *
  * utils
@@ -343,6 +349,21 @@ xmlSecTransformUriTypeCheck(xmlSecTransformUriType type, const xmlChar* uri) {
  *
  *************************************************************************/
 
+/* the callbacks live behind the reserved0 pointer to keep the context layout */
+typedef struct _xmlSecTransformCtxCallbacks     xmlSecTransformCtxCallbacks,
+                                                *xmlSecTransformCtxCallbacksPtr;
+struct _xmlSecTransformCtxCallbacks {
+    xmlSecTransformCtxResultCallback    resultCallback;
+    void*                               resultCallbackCtx;
+    xmlSecTransformCtxOffloadCallback   offloadCallback;
+    void*                               offloadCallbackCtx;
+};
+
+#define xmlSecTransformCtxGetCallbacks(ctx) \
+    ((xmlSecTransformCtxCallbacksPtr)((ctx)->reserved0))
+
+static xmlSecTransformCtxCallbacksPtr   xmlSecTransformCtxEnsureCallbacks   (xmlSecTransformCtxPtr ctx);
+
 /**
  * xmlSecTransformCtxCreate:
  *
@@ -441,6 +462,10 @@ xmlSecTransformCtxFinalize(xmlSecTransformCtxPtr ctx) {
 
     xmlSecTransformCtxReset(ctx);
     xmlSecPtrListFinalize(&(ctx->enabledTransforms));
+    if(ctx->reserved0 != NULL) {
+        memset(ctx->reserved0, 0, sizeof(xmlSecTransformCtxCallbacks));
+        xmlFree(ctx->reserved0);
+    }
     memset(ctx, 0, sizeof(xmlSecTransformCtx));
 }
 
@@ -499,6 +524,20 @@ xmlSecTransformCtxCopyUserPref(xmlSecTransformCtxPtr dst, xmlSecTransformCtxPtr
     dst->enabledUris     = src->enabledUris;
     dst->preExecCallback = src->preExecCallback;
 
+    if(xmlSecTransformCtxGetCallbacks(src) != NULL) {
+        ret = xmlSecTransformCtxSetOffloadCallback(dst,
+                    xmlSecTransformCtxGetCallbacks(src)->offloadCallback,
+                    xmlSecTransformCtxGetCallbacks(src)->offloadCallbackCtx);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecTransformCtxSetOffloadCallback",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+    }
+
     ret = xmlSecPtrListCopy(&(dst->enabledTransforms), &(src->enabledTransforms));
     if(ret < 0) {
         xmlSecError(XMLSEC_ERRORS_HERE,
@@ -784,6 +823,126 @@ xmlSecTransformCtxNodesListRead(xmlSecTransformCtxPtr ctx, xmlNodePtr node, xmlS
     return(0);
 }
 
+/**
+ * xmlSecTransformCtxSetResultCallback:
+ * @ctx:                the pointer to transforms chain processing context.
+ * @callback:           the result callback or NULL to store the result
+ *                      in the result buffer.
+ * @context:            the user context for @callback.
+ *
+ * Sets the callback to stream the transforms chain result to (the result
+ * buffer stays empty in this case).
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+int
+xmlSecTransformCtxSetResultCallback(xmlSecTransformCtxPtr ctx,
+                                    xmlSecTransformCtxResultCallback callback,
+                                    void* context) {
+    xmlSecTransformCtxCallbacksPtr callbacks;
+
+    xmlSecAssert2(ctx != NULL, -1);
+
+    if((callback == NULL) && (xmlSecTransformCtxGetCallbacks(ctx) == NULL)) {
+        return(0);
+    }
+
+    callbacks = xmlSecTransformCtxEnsureCallbacks(ctx);
+    if(callbacks == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecTransformCtxEnsureCallbacks",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    callbacks->resultCallback    = callback;
+    callbacks->resultCallbackCtx = context;
+    return(0);
+}
+
+/**
+ * xmlSecTransformCtxSetOffloadCallback:
+ * @ctx:                the pointer to transforms chain processing context.
+ * @callback:           the offload callback or NULL to run the transforms
+ *                      in the current thread.
+ * @context:            the user context for @callback.
+ *
+ * Sets the callback to run the expensive final step of asymmetric key
+ * transforms in an application executor (see #xmlSecTransformCtxOffloadCallback).
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+int
+xmlSecTransformCtxSetOffloadCallback(xmlSecTransformCtxPtr ctx,
+                                     xmlSecTransformCtxOffloadCallback callback,
+                                     void* context) {
+    xmlSecTransformCtxCallbacksPtr callbacks;
+
+    xmlSecAssert2(ctx != NULL, -1);
+
+    if((callback == NULL) && (xmlSecTransformCtxGetCallbacks(ctx) == NULL)) {
+        return(0);
+    }
+
+    callbacks = xmlSecTransformCtxEnsureCallbacks(ctx);
+    if(callbacks == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecTransformCtxEnsureCallbacks",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    callbacks->offloadCallback    = callback;
+    callbacks->offloadCallbackCtx = context;
+    return(0);
+}
+
+/**
+ * xmlSecTransformCtxGetOffloadCallback:
+ * @ctx:                the pointer to transforms chain processing context.
+ * @context:            the optional pointer to return the user context.
+ *
+ * Gets the callback set with #xmlSecTransformCtxSetOffloadCallback.
+ *
+ * Returns: the offload callback or NULL if it is not set.
+ */
+xmlSecTransformCtxOffloadCallback
+xmlSecTransformCtxGetOffloadCallback(xmlSecTransformCtxPtr ctx, void** context) {
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    if(context != NULL) {
+        (*context) = NULL;
+    }
+    if(xmlSecTransformCtxGetCallbacks(ctx) == NULL) {
+        return(NULL);
+    }
+    if(context != NULL) {
+        (*context) = xmlSecTransformCtxGetCallbacks(ctx)->offloadCallbackCtx;
+    }
+    return(xmlSecTransformCtxGetCallbacks(ctx)->offloadCallback);
+}
+
+static xmlSecTransformCtxCallbacksPtr
+xmlSecTransformCtxEnsureCallbacks(xmlSecTransformCtxPtr ctx) {
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    if(ctx->reserved0 == NULL) {
+        ctx->reserved0 = xmlMalloc(sizeof(xmlSecTransformCtxCallbacks));
+        if(ctx->reserved0 == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        NULL,
+                        XMLSEC_ERRORS_R_MALLOC_FAILED,
+                        "size=%d", (int)sizeof(xmlSecTransformCtxCallbacks));
+            return(NULL);
+        }
+        memset(ctx->reserved0, 0, sizeof(xmlSecTransformCtxCallbacks));
+    }
+    return(xmlSecTransformCtxGetCallbacks(ctx));
+}
+
 /**
  * xmlSecTransformCtxSetUri:
  * @ctx:                the pointer to transforms chain processing context.
@@ -1045,6 +1204,19 @@ xmlSecTransformCtxPrepare(xmlSecTransformCtxPtr ctx, xmlSecTransformDataType inp
                     xmlSecErrorsSafeString(xmlSecTransformKlassGetName(xmlSecTransformMemBufId)));
         return(-1);
     }
+    if((xmlSecTransformCtxGetCallbacks(ctx) != NULL) && (xmlSecTransformCtxGetCallbacks(ctx)->resultCallback != NULL)) {
+        ret = xmlSecTransformMemBufSetWriteCallback(transform,
+                    xmlSecTransformCtxGetCallbacks(ctx)->resultCallback,
+                    xmlSecTransformCtxGetCallbacks(ctx)->resultCallbackCtx);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecTransformMemBufSetWriteCallback",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+    }
 
     firstType = xmlSecTransformGetDataType(ctx->first, xmlSecTransformModePush, ctx);
     if(((firstType & xmlSecTransformDataTypeBin) == 0) &&
@@ -1155,6 +1327,7 @@ xmlSecTransformCtxBinaryExecute(xmlSecTransformCtxPtr ctx,
 int
 xmlSecTransformCtxUriExecute(xmlSecTransformCtxPtr ctx, const xmlChar* uri) {
     xmlSecTransformPtr uriTransform;
+    xmlSecByte* buf;
     int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
@@ -1198,13 +1371,26 @@ xmlSecTransformCtxUriExecute(xmlSecTransformCtxPtr ctx, const xmlChar* uri) {
     }
 
     /* Now we have a choice: we either can push from first transform or pop
-     * from last. Our C14N transforms prefers push, so push data!
+     * from last. Our C14N transforms prefers push, so push data! External
+     * data (e.g. a large detached file) is read in big blocks to avoid
+     * doing I/O one small chunk at a time.
      */
-    ret = xmlSecTransformPump(uriTransform, uriTransform->next, ctx);
+    buf = (xmlSecByte*)xmlMalloc(XMLSEC_TRANSFORM_URI_BINARY_CHUNK);
+    if(buf == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_MALLOC_FAILED,
+                    "size=%d", XMLSEC_TRANSFORM_URI_BINARY_CHUNK);
+        return(-1);
+    }
+    ret = xmlSecTransformPumpWithBuffer(uriTransform, uriTransform->next,
+                                        buf, XMLSEC_TRANSFORM_URI_BINARY_CHUNK, ctx);
+    xmlFree(buf);
     if(ret < 0) {
         xmlSecError(XMLSEC_ERRORS_HERE,
                     NULL,
-                    "xmlSecTransformPump",
+                    "xmlSecTransformPumpWithBuffer",
                     XMLSEC_ERRORS_R_XMLSEC_FAILED,
                     "uri=%s",
                     xmlSecErrorsSafeString(uri));
@@ -1426,6 +1612,14 @@ xmlSecTransformCtxDebugXmlDump(xmlSecTransformCtxPtr ctx, FILE* output) {
  * xmlSecTransform
  *
  *************************************************************************/
+
+/* the transforms with an asymmetric key are marked in the reserved1 pointer
+ * to keep the transform layout: only these are offloaded */
+static char xmlSecTransformAsymmetricKeyMark = 0;
+
+#define xmlSecTransformHasAsymmetricKey(transform) \
+    ((transform)->reserved1 == (void*)&xmlSecTransformAsymmetricKeyMark)
+
 /**
  * xmlSecTransformCreate:
  * @id:                 the transform id to create.
@@ -1637,6 +1831,15 @@ xmlSecTransformNodeRead(xmlNodePtr node, xmlSecTransformUsage usage, xmlSecTrans
  */
 int
 xmlSecTransformPump(xmlSecTransformPtr left, xmlSecTransformPtr right, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecByte buf[XMLSEC_TRANSFORM_BINARY_CHUNK];
+
+    return(xmlSecTransformPumpWithBuffer(left, right, buf, sizeof(buf), transformCtx));
+}
+
+static int
+xmlSecTransformPumpWithBuffer(xmlSecTransformPtr left, xmlSecTransformPtr right,
+                              xmlSecByte* buf, xmlSecSize bufMaxSize,
+                              xmlSecTransformCtxPtr transformCtx) {
     xmlSecTransformDataType leftType;
     xmlSecTransformDataType rightType;
     int ret;
@@ -1674,12 +1877,14 @@ xmlSecTransformPump(xmlSecTransformPtr left, xmlSecTransformPtr right, xmlSecTra
        }
     }  else if(((leftType & xmlSecTransformDataTypeBin) != 0) &&
                ((rightType & xmlSecTransformDataTypeBin) != 0)) {
-        xmlSecByte buf[XMLSEC_TRANSFORM_BINARY_CHUNK];
         xmlSecSize bufSize;
         int final;
 
+        xmlSecAssert2(buf != NULL, -1);
+        xmlSecAssert2(bufMaxSize > 0, -1);
+
         do {
-            ret = xmlSecTransformPopBin(left, buf, sizeof(buf), &bufSize, transformCtx);
+            ret = xmlSecTransformPopBin(left, buf, bufMaxSize, &bufSize, transformCtx);
             if(ret < 0) {
                 xmlSecError(XMLSEC_ERRORS_HERE,
                             xmlSecErrorsSafeString(xmlSecTransformGetName(left)),
@@ -1715,17 +1920,33 @@ xmlSecTransformPump(xmlSecTransformPtr left, xmlSecTransformPtr right, xmlSecTra
  * @transform:          the pointer to transform.
  * @key:                the pointer to key.
  *
- * Sets the transform's key.
+ * Sets the transform's key. The final step of the transforms with an
+ * asymmetric key can be offloaded (see #xmlSecTransformCtxSetOffloadCallback).
  *
  * Returns: 0 on success or a negative value otherwise.
  */
 int
 xmlSecTransformSetKey(xmlSecTransformPtr transform, xmlSecKeyPtr key) {
+    xmlSecKeyDataType keyType;
+    int ret;
+
     xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
     xmlSecAssert2(key != NULL, -1);
 
     if(transform->id->setKey != NULL) {
-        return((transform->id->setKey)(transform, key));
+        ret = (transform->id->setKey)(transform, key);
+        if(ret < 0) {
+            return(ret);
+        }
+    }
+
+    /* decide once if the final step is worth the trip to another thread */
+    keyType = xmlSecKeyGetType(key);
+    if(((keyType & (xmlSecKeyDataTypePublic | xmlSecKeyDataTypePrivate)) != 0) &&
+       ((keyType & xmlSecKeyDataTypeSymmetric) == 0)) {
+        transform->reserved1 = (void*)&xmlSecTransformAsymmetricKeyMark;
+    } else {
+        transform->reserved1 = NULL;
     }
     return(0);
 }
@@ -1755,6 +1976,81 @@ xmlSecTransformSetKeyReq(xmlSecTransformPtr transform, xmlSecKeyReqPtr keyReq) {
     return(0);
 }
 
+/**************************************************************************
+ *
+ * Offloading the final step of asymmetric key transforms to the
+ * application executor (see #xmlSecTransformCtxOffloadCallback)
+ *
+ *************************************************************************/
+typedef struct _xmlSecTransformOffloadWork      xmlSecTransformOffloadWork,
+                                                *xmlSecTransformOffloadWorkPtr;
+struct _xmlSecTransformOffloadWork {
+    xmlSecTransformPtr          transform;
+    xmlSecTransformCtxPtr       transformCtx;
+    int                         last;
+    const xmlSecByte*           data;
+    xmlSecSize                  dataSize;
+    int                         res;
+};
+
+static int
+xmlSecTransformOffloadIsNeeded(xmlSecTransformPtr transform, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecAssert2(xmlSecTransformIsValid(transform), 0);
+    xmlSecAssert2(transformCtx != NULL, 0);
+
+    /* only asymmetric keys operations are worth the trip to another thread
+     * (checked by xmlSecTransformSetKey) */
+    if((xmlSecTransformCtxGetCallbacks(transformCtx) == NULL) ||
+       (xmlSecTransformCtxGetCallbacks(transformCtx)->offloadCallback == NULL) ||
+       ((transform->id->usage & (xmlSecTransformUsageSignatureMethod | xmlSecTransformUsageEncryptionMethod)) == 0) ||
+       !xmlSecTransformHasAsymmetricKey(transform)) {
+        return(0);
+    }
+    return(1);
+}
+
+static void
+xmlSecTransformOffloadExecuteWork(void* workData) {
+    xmlSecTransformOffloadWorkPtr work = (xmlSecTransformOffloadWorkPtr)workData;
+
+    xmlSecAssert(work != NULL);
+
+    work->res = (work->transform->id->execute)(work->transform, work->last, work->transformCtx);
+}
+
+static void
+xmlSecTransformOffloadVerifyWork(void* workData) {
+    xmlSecTransformOffloadWorkPtr work = (xmlSecTransformOffloadWorkPtr)workData;
+
+    xmlSecAssert(work != NULL);
+
+    work->res = (work->transform->id->verify)(work->transform, work->data, work->dataSize, work->transformCtx);
+}
+
+static int
+xmlSecTransformOffload(xmlSecTransformOffloadWorkMethod method, xmlSecTransformOffloadWorkPtr work) {
+    int ret;
+
+    xmlSecAssert2(method != NULL, -1);
+    xmlSecAssert2(work != NULL, -1);
+    xmlSecAssert2(work->transformCtx != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxGetCallbacks(work->transformCtx) != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxGetCallbacks(work->transformCtx)->offloadCallback != NULL, -1);
+
+    work->res = -1;
+    ret = (xmlSecTransformCtxGetCallbacks(work->transformCtx)->offloadCallback)(work->transform, method, work,
+                xmlSecTransformCtxGetCallbacks(work->transformCtx)->offloadCallbackCtx);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    xmlSecErrorsSafeString(xmlSecTransformGetName(work->transform)),
+                    "offloadCallback",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    return(work->res);
+}
+
 /**
  * xmlSecTransformVerify:
  * @transform:          the pointer to transform.
@@ -1775,6 +2071,16 @@ xmlSecTransformVerify(xmlSecTransformPtr transform, const xmlSecByte* data,
     xmlSecAssert2(transform->id->verify != NULL, -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
+    if(xmlSecTransformOffloadIsNeeded(transform, transformCtx)) {
+        xmlSecTransformOffloadWork work;
+
+        memset(&work, 0, sizeof(work));
+        work.transform    = transform;
+        work.transformCtx = transformCtx;
+        work.data         = data;
+        work.dataSize     = dataSize;
+        return(xmlSecTransformOffload(xmlSecTransformOffloadVerifyWork, &work));
+    }
     return((transform->id->verify)(transform, data, dataSize, transformCtx));
 }
 
@@ -1962,6 +2268,18 @@ xmlSecTransformExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCt
     xmlSecAssert2(transform->id->execute != NULL, -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
+    /* the final step of sign and private key decrypt is the expensive one */
+    if((last != 0) && (transform->status != xmlSecTransformStatusFinished) &&
+       ((transform->operation == xmlSecTransformOperationSign) || (transform->operation == xmlSecTransformOperationDecrypt)) &&
+       xmlSecTransformOffloadIsNeeded(transform, transformCtx)) {
+        xmlSecTransformOffloadWork work;
+
+        memset(&work, 0, sizeof(work));
+        work.transform    = transform;
+        work.transformCtx = transformCtx;
+        work.last         = last;
+        return(xmlSecTransformOffload(xmlSecTransformOffloadExecuteWork, &work));
+    }
     return((transform->id->execute)(transform, last, transformCtx));
 }
 
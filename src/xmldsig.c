@@ -47,10 +47,44 @@ static int      xmlSecDSigCtxProcessObjectNode          (xmlSecDSigCtxPtr dsigCt
                                                          xmlNodePtr node);
 static int      xmlSecDSigCtxProcessManifestNode        (xmlSecDSigCtxPtr dsigCtx,
                                                          xmlNodePtr node);
+static void     xmlSecDSigReferenceCtxReadAttributes    (xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                         xmlNodePtr node);
+static int      xmlSecDSigCtxVerifyManifestReferenceCtx (xmlSecDSigCtxPtr dsigCtx,
+                                                         xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                         xmlSecDSigStatus* status);
 
 static int      xmlSecDSigCtxProcessReferences          (xmlSecDSigCtxPtr dsigCtx,
                                                          xmlNodePtr firstReferenceNode);
 
+/* the callbacks live behind the reserved0 pointer to keep the context layout */
+typedef struct _xmlSecDSigCtxCallbacks          xmlSecDSigCtxCallbacks,
+                                                *xmlSecDSigCtxCallbacksPtr;
+struct _xmlSecDSigCtxCallbacks {
+    xmlSecDSigCtxPreSignCallback                preSignCallback;
+    xmlSecDSigReferenceCtxPreDigestCallback     preDigestCallback;
+};
+
+#define xmlSecDSigCtxGetPreSignCallback(dsigCtx) \
+    (((dsigCtx)->reserved0 != NULL) ? \
+        ((xmlSecDSigCtxCallbacksPtr)((dsigCtx)->reserved0))->preSignCallback : NULL)
+#define xmlSecDSigCtxGetPreDigestCallback(dsigCtx) \
+    (((dsigCtx)->reserved0 != NULL) ? \
+        ((xmlSecDSigCtxCallbacksPtr)((dsigCtx)->reserved0))->preDigestCallback : NULL)
+
+/* the <dsig:Reference/> node lives in the reserved0 pointer for the same reason */
+#define xmlSecDSigReferenceCtxGetNode(dsigRefCtx) \
+    ((xmlNodePtr)((dsigRefCtx)->reserved0))
+#define xmlSecDSigReferenceCtxSetNode(dsigRefCtx, node) \
+    ((dsigRefCtx)->reserved0 = (void*)(node))
+
+static xmlSecDSigCtxCallbacksPtr xmlSecDSigCtxEnsureCallbacks   (xmlSecDSigCtxPtr dsigCtx);
+static int      xmlSecDSigCtxPreSignWrite               (void* context,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize);
+static int      xmlSecDSigReferenceCtxPreDigestWrite    (void* context,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize);
+
 /* The ID attribute in XMLDSig is 'Id' */
 static const xmlChar*           xmlSecDSigIds[] = { xmlSecAttrId, NULL };
 
@@ -214,6 +248,10 @@ xmlSecDSigCtxFinalize(xmlSecDSigCtxPtr dsigCtx) {
     if(dsigCtx->id != NULL) {
         xmlFree(dsigCtx->id);
     }
+    if(dsigCtx->reserved0 != NULL) {
+        memset(dsigCtx->reserved0, 0, sizeof(xmlSecDSigCtxCallbacks));
+        xmlFree(dsigCtx->reserved0);
+    }
     memset(dsigCtx, 0, sizeof(xmlSecDSigCtx));
 }
 
@@ -294,6 +332,101 @@ xmlSecDSigCtxGetPreSignBuffer(xmlSecDSigCtxPtr dsigCtx) {
             xmlSecTransformMemBufGetBuffer(dsigCtx->preSignMemBufMethod) : NULL);
 }
 
+/**
+ * xmlSecDSigCtxSetPreSignCallback:
+ * @dsigCtx:            the pointer to <dsig:Signature/> processing context.
+ * @callback:           the callback or NULL to store the data in the pre-sign buffer.
+ *
+ * Sets the callback for the pre-signature data (used instead of the
+ * pre-sign buffer, see #xmlSecDSigCtxPreSignCallback).
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecDSigCtxSetPreSignCallback(xmlSecDSigCtxPtr dsigCtx, xmlSecDSigCtxPreSignCallback callback) {
+    xmlSecDSigCtxCallbacksPtr callbacks;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+
+    if((callback == NULL) && (dsigCtx->reserved0 == NULL)) {
+        return(0);
+    }
+
+    callbacks = xmlSecDSigCtxEnsureCallbacks(dsigCtx);
+    if(callbacks == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecDSigCtxEnsureCallbacks",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    callbacks->preSignCallback = callback;
+    return(0);
+}
+
+/**
+ * xmlSecDSigCtxSetPreDigestCallback:
+ * @dsigCtx:            the pointer to <dsig:Signature/> processing context.
+ * @callback:           the callback or NULL to store the data in the pre-digest buffers.
+ *
+ * Sets the callback for the references pre-digest data (used instead of
+ * the pre-digest buffers, see #xmlSecDSigReferenceCtxPreDigestCallback).
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecDSigCtxSetPreDigestCallback(xmlSecDSigCtxPtr dsigCtx, xmlSecDSigReferenceCtxPreDigestCallback callback) {
+    xmlSecDSigCtxCallbacksPtr callbacks;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+
+    if((callback == NULL) && (dsigCtx->reserved0 == NULL)) {
+        return(0);
+    }
+
+    callbacks = xmlSecDSigCtxEnsureCallbacks(dsigCtx);
+    if(callbacks == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecDSigCtxEnsureCallbacks",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    callbacks->preDigestCallback = callback;
+    return(0);
+}
+
+static xmlSecDSigCtxCallbacksPtr
+xmlSecDSigCtxEnsureCallbacks(xmlSecDSigCtxPtr dsigCtx) {
+    xmlSecAssert2(dsigCtx != NULL, NULL);
+
+    if(dsigCtx->reserved0 == NULL) {
+        dsigCtx->reserved0 = xmlMalloc(sizeof(xmlSecDSigCtxCallbacks));
+        if(dsigCtx->reserved0 == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        NULL,
+                        XMLSEC_ERRORS_R_MALLOC_FAILED,
+                        "size=%d", (int)sizeof(xmlSecDSigCtxCallbacks));
+            return(NULL);
+        }
+        memset(dsigCtx->reserved0, 0, sizeof(xmlSecDSigCtxCallbacks));
+    }
+    return((xmlSecDSigCtxCallbacksPtr)(dsigCtx->reserved0));
+}
+
+static int
+xmlSecDSigCtxPreSignWrite(void* context, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecDSigCtxPtr dsigCtx = (xmlSecDSigCtxPtr)context;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(xmlSecDSigCtxGetPreSignCallback(dsigCtx) != NULL, -1);
+
+    return((xmlSecDSigCtxGetPreSignCallback(dsigCtx))(dsigCtx, data, dataSize));
+}
+
 /**
  * xmlSecDSigCtxSign:
  * @dsigCtx:            the pointer to <dsig:Signature/> processing context.
@@ -763,6 +896,23 @@ xmlSecDSigCtxProcessSignedInfoNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xm
                         XMLSEC_ERRORS_R_XMLSEC_FAILED,
                         "transform=%s",
                         xmlSecErrorsSafeString(xmlSecTransformKlassGetName(xmlSecTransformMemBufId)));
+            return(-1);
+        }
+
+        /* stream data to the user callback instead of storing it */
+        if(xmlSecDSigCtxGetPreSignCallback(dsigCtx) != NULL) {
+            int ret;
+
+            ret = xmlSecTransformMemBufSetWriteCallback(dsigCtx->preSignMemBufMethod,
+                                                xmlSecDSigCtxPreSignWrite, dsigCtx);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            NULL,
+                            "xmlSecTransformMemBufSetWriteCallback",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                return(-1);
+            }
         }
     }
 
@@ -1103,16 +1253,21 @@ xmlSecDSigCtxProcessManifestNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
             return(-1);
         }
 
-        /* process */
-        ret = xmlSecDSigReferenceCtxProcessNode(dsigRefCtx, cur);
-        if(ret < 0) {
-            xmlSecError(XMLSEC_ERRORS_HERE,
-                        NULL,
-                        "xmlSecDSigReferenceCtxProcessNode",
-                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
-                        "node=%s",
-                        xmlSecErrorsSafeString(xmlSecNodeGetName(cur)));
-            return(-1);
+        /* process now or just remember the node for later verification */
+        if(((dsigCtx->flags & XMLSEC_DSIG_FLAGS_LAZY_MANIFESTS) != 0) &&
+           (dsigCtx->operation == xmlSecTransformOperationVerify)) {
+            xmlSecDSigReferenceCtxReadAttributes(dsigRefCtx, cur);
+        } else {
+            ret = xmlSecDSigReferenceCtxProcessNode(dsigRefCtx, cur);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            NULL,
+                            "xmlSecDSigReferenceCtxProcessNode",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            "node=%s",
+                            xmlSecErrorsSafeString(xmlSecNodeGetName(cur)));
+                return(-1);
+            }
         }
 
         /* we don;t care if Reference processing failed because
@@ -1132,6 +1287,143 @@ xmlSecDSigCtxProcessManifestNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
     return(0);
 }
 
+/**
+ * xmlSecDSigCtxVerifyManifestReference:
+ * @dsigCtx:            the pointer to <dsig:Signature/> processing context.
+ * @pos:                the position of <dsig:Reference/> in the list of
+ *                      <dsig:Manifest/> references.
+ * @status:             the pointer to the result reference status.
+ *
+ * Verifies the <dsig:Manifest/> reference at position @pos. The references
+ * are digested on the first call only (see #XMLSEC_DSIG_FLAGS_LAZY_MANIFESTS),
+ * the status is cached in the reference context. The document must be
+ * kept alive until all the needed references are verified.
+ *
+ * The manifest references are only meaningful if the signature itself
+ * was verified: the function fails if @dsigCtx status is not
+ * #xmlSecDSigStatusSucceeded. If the reference processing fails, all the
+ * following calls for the same reference fail as well.
+ *
+ * Returns: 0 on success (the reference status is returned in @status)
+ * or a negative value if an error occurs.
+ */
+int
+xmlSecDSigCtxVerifyManifestReference(xmlSecDSigCtxPtr dsigCtx, xmlSecSize pos,
+                                     xmlSecDSigStatus* status) {
+    xmlSecDSigReferenceCtxPtr dsigRefCtx;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(status != NULL, -1);
+
+    dsigRefCtx = (xmlSecDSigReferenceCtxPtr)xmlSecPtrListGetItem(&(dsigCtx->manifestReferences), pos);
+    if(dsigRefCtx == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecPtrListGetItem",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "pos=%d", (int)pos);
+        return(-1);
+    }
+
+    return(xmlSecDSigCtxVerifyManifestReferenceCtx(dsigCtx, dsigRefCtx, status));
+}
+
+/**
+ * xmlSecDSigCtxVerifyManifestReferenceByUri:
+ * @dsigCtx:            the pointer to <dsig:Signature/> processing context.
+ * @uri:                the <dsig:Reference/> URI attribute value
+ *                      (NULL for reference without URI attribute).
+ * @status:             the pointer to the result reference status.
+ *
+ * Verifies the first <dsig:Manifest/> reference with URI attribute
+ * equal to @uri (see #xmlSecDSigCtxVerifyManifestReference).
+ *
+ * Returns: 0 on success (the reference status is returned in @status)
+ * or a negative value if an error occurs.
+ */
+int
+xmlSecDSigCtxVerifyManifestReferenceByUri(xmlSecDSigCtxPtr dsigCtx, const xmlChar* uri,
+                                          xmlSecDSigStatus* status) {
+    xmlSecDSigReferenceCtxPtr dsigRefCtx;
+    xmlSecSize pos, size;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(status != NULL, -1);
+
+    size = xmlSecPtrListGetSize(&(dsigCtx->manifestReferences));
+    for(pos = 0; pos < size; ++pos) {
+        dsigRefCtx = (xmlSecDSigReferenceCtxPtr)xmlSecPtrListGetItem(&(dsigCtx->manifestReferences), pos);
+        if((dsigRefCtx != NULL) && (xmlStrEqual(dsigRefCtx->uri, uri))) {
+            return(xmlSecDSigCtxVerifyManifestReferenceCtx(dsigCtx, dsigRefCtx, status));
+        }
+    }
+
+    xmlSecError(XMLSEC_ERRORS_HERE,
+                NULL,
+                NULL,
+                XMLSEC_ERRORS_R_INVALID_DATA,
+                "reference uri=%s not found",
+                xmlSecErrorsSafeString(uri));
+    return(-1);
+}
+
+static int
+xmlSecDSigCtxVerifyManifestReferenceCtx(xmlSecDSigCtxPtr dsigCtx, xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                        xmlSecDSigStatus* status) {
+    int ret;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(dsigCtx->operation == xmlSecTransformOperationVerify, -1);
+    xmlSecAssert2(dsigRefCtx != NULL, -1);
+    xmlSecAssert2(dsigRefCtx->dsigCtx == dsigCtx, -1);
+    xmlSecAssert2(status != NULL, -1);
+
+    /* the manifest is covered by the signature only if the signature is valid */
+    if(dsigCtx->status != xmlSecDSigStatusSucceeded) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_STATUS,
+                    "signature status=%d",
+                    (int)dsigCtx->status);
+        return(-1);
+    }
+
+    /* the node is reset if the reference processing failed before */
+    if(xmlSecDSigReferenceCtxGetNode(dsigRefCtx) == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    NULL,
+                    XMLSEC_ERRORS_R_INVALID_DATA,
+                    "reference uri=%s processing failed",
+                    xmlSecErrorsSafeString(dsigRefCtx->uri));
+        return(-1);
+    }
+
+    /* already processed (either eagerly or by the previous call) */
+    if((dsigRefCtx->status != xmlSecDSigStatusUnknown) || (dsigRefCtx->digestMethod != NULL)) {
+        (*status) = dsigRefCtx->status;
+        return(0);
+    }
+
+    ret = xmlSecDSigReferenceCtxProcessNode(dsigRefCtx, xmlSecDSigReferenceCtxGetNode(dsigRefCtx));
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecDSigReferenceCtxProcessNode",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "uri=%s",
+                    xmlSecErrorsSafeString(dsigRefCtx->uri));
+        /* don't try to process the same node again */
+        dsigRefCtx->status = xmlSecDSigStatusInvalid;
+        xmlSecDSigReferenceCtxSetNode(dsigRefCtx, NULL);
+        return(-1);
+    }
+
+    (*status) = dsigRefCtx->status;
+    return(0);
+}
+
 /**
  * xmlSecDSigCtxDebugDump:
  * @dsigCtx:            the pointer to <dsig:Signature/> processing context.
@@ -1468,6 +1760,32 @@ xmlSecDSigReferenceCtxGetPreDigestBuffer(xmlSecDSigReferenceCtxPtr dsigRefCtx) {
             xmlSecTransformMemBufGetBuffer(dsigRefCtx->preDigestMemBufMethod) : NULL);
 }
 
+static int
+xmlSecDSigReferenceCtxPreDigestWrite(void* context, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecDSigReferenceCtxPtr dsigRefCtx = (xmlSecDSigReferenceCtxPtr)context;
+
+    xmlSecAssert2(dsigRefCtx != NULL, -1);
+    xmlSecAssert2(dsigRefCtx->dsigCtx != NULL, -1);
+    xmlSecAssert2(xmlSecDSigCtxGetPreDigestCallback(dsigRefCtx->dsigCtx) != NULL, -1);
+
+    return((xmlSecDSigCtxGetPreDigestCallback(dsigRefCtx->dsigCtx))(dsigRefCtx, data, dataSize));
+}
+
+static void
+xmlSecDSigReferenceCtxReadAttributes(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodePtr node) {
+    xmlSecAssert(dsigRefCtx != NULL);
+    xmlSecAssert(xmlSecDSigReferenceCtxGetNode(dsigRefCtx) == NULL);
+    xmlSecAssert(dsigRefCtx->uri == NULL);
+    xmlSecAssert(dsigRefCtx->id == NULL);
+    xmlSecAssert(dsigRefCtx->type == NULL);
+    xmlSecAssert(node != NULL);
+
+    dsigRefCtx->uri = xmlGetProp(node, xmlSecAttrURI);
+    dsigRefCtx->id  = xmlGetProp(node, xmlSecAttrId);
+    dsigRefCtx->type= xmlGetProp(node, xmlSecAttrType);
+    xmlSecDSigReferenceCtxSetNode(dsigRefCtx, node);
+}
+
 /**
  * xmlSecDSigReferenceCtxProcessNode:
  * @dsigRefCtx:         the pointer to <dsig:Reference/> element processing context.
@@ -1505,10 +1823,10 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
 
     transformCtx = &(dsigRefCtx->transformCtx);
 
-    /* read attributes first */
-    dsigRefCtx->uri = xmlGetProp(node, xmlSecAttrURI);
-    dsigRefCtx->id  = xmlGetProp(node, xmlSecAttrId);
-    dsigRefCtx->type= xmlGetProp(node, xmlSecAttrType);
+    /* read attributes first (unless it was done already for lazy manifest) */
+    if(xmlSecDSigReferenceCtxGetNode(dsigRefCtx) != node) {
+        xmlSecDSigReferenceCtxReadAttributes(dsigRefCtx, node);
+    }
 
     /* set start URI (and check that it is enabled!) */
     ret = xmlSecTransformCtxSetUri(transformCtx, dsigRefCtx->uri, node);
@@ -1559,6 +1877,20 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
                         xmlSecErrorsSafeString(xmlSecTransformKlassGetName(xmlSecTransformMemBufId)));
             return(-1);
         }
+
+        /* stream data to the user callback instead of storing it */
+        if(xmlSecDSigCtxGetPreDigestCallback(dsigRefCtx->dsigCtx) != NULL) {
+            ret = xmlSecTransformMemBufSetWriteCallback(dsigRefCtx->preDigestMemBufMethod,
+                                                xmlSecDSigReferenceCtxPreDigestWrite, dsigRefCtx);
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            NULL,
+                            "xmlSecTransformMemBufSetWriteCallback",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                return(-1);
+            }
+        }
     }
 
     /* next node is required DigestMethod. */
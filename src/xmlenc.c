@@ -19,6 +19,7 @@
 
 #include <libxml/tree.h>
 #include <libxml/parser.h>
+#include <libxml/xmlIO.h>
 
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/buffer.h>
@@ -37,6 +38,21 @@ static int      xmlSecEncCtxCipherDataNodeRead          (xmlSecEncCtxPtr encCtx,
                                                          xmlNodePtr node);
 static int      xmlSecEncCtxCipherReferenceNodeRead     (xmlSecEncCtxPtr encCtx,
                                                          xmlNodePtr node);
+static int      xmlSecEncCtxEncDataNodeStream           (xmlSecEncCtxPtr encCtx,
+                                                         xmlNodePtr tmpl,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize,
+                                                         xmlOutputBufferPtr output);
+static int      xmlSecEncCtxEncDataNodeStreamNode       (xmlSecEncCtxPtr encCtx,
+                                                         xmlNodePtr node,
+                                                         int root,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize,
+                                                         xmlOutputBufferPtr output);
+static int      xmlSecEncCtxDecryptData                 (xmlSecEncCtxPtr encCtx,
+                                                         xmlNodePtr node);
+static int      xmlSecEncCtxCipherValueNodeExecute      (xmlSecEncCtxPtr encCtx,
+                                                         xmlNodePtr node);
 
 /* The ID attribute in XMLEnc is 'Id' */
 static const xmlChar*           xmlSecEncIds[] = { BAD_CAST "Id", NULL };
@@ -527,6 +543,172 @@ xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node)
     return(0);
 }
 
+/**
+ * xmlSecEncCtxXmlEncryptNodes:
+ * @encCtx:             the pointer to <enc:EncryptedData/> processing context.
+ * @tmpl:               the pointer to <enc:EncryptedData/> template node.
+ * @nodes:              the array of nodes for encryption.
+ * @nodesSize:          the number of nodes in @nodes array.
+ *
+ * Encrypts each of @nodes according to a copy of template @tmpl (@tmpl
+ * itself is used for the first node) with the same encryption key. The key
+ * (and the <enc:EncryptedKey/> if any) is looked up and written only once
+ * for the first node; the other <enc:EncryptedData/> nodes get a copy of the
+ * first <dsig:KeyInfo/> node content (with the Id attributes of
+ * <enc:EncryptedKey/> nodes removed). The Id attribute of @tmpl is
+ * only kept for the first node to avoid duplicate IDs in the document.
+ * Each node gets its own IV.
+ *
+ * Only the key lookup and the key wrap are shared: the template copy is
+ * still read (including the IDs registration) and a new transforms chain
+ * is created for every node.
+ *
+ * If an error occurs, the nodes processed before are left encrypted.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxXmlEncryptNodes(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
+                            xmlNodePtr* nodes, xmlSecSize nodesSize) {
+    xmlNodePtr pristineTmpl = NULL;
+    xmlNodePtr firstKeyInfoNode;
+    xmlNodePtr keyInfoNode;
+    xmlNodePtr replacedNodeList;
+    xmlNodePtr cur, tmp;
+    xmlSecKeyPtr key;
+    xmlSecSize ii;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->result == NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(nodes != NULL, -1);
+    xmlSecAssert2(nodesSize > 0, -1);
+
+    /* keep the template for the other nodes */
+    if(nodesSize > 1) {
+        pristineTmpl = xmlDocCopyNode(tmpl, tmpl->doc, 1);
+        if(pristineTmpl == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlDocCopyNode",
+                        XMLSEC_ERRORS_R_XML_FAILED,
+                        "node=%s",
+                        xmlSecErrorsSafeString(xmlSecNodeGetName(tmpl)));
+            return(-1);
+        }
+    }
+
+    ret = xmlSecEncCtxXmlEncrypt(encCtx, tmpl, nodes[0]);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecEncCtxXmlEncrypt",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "pos=0");
+        goto done;
+    }
+    firstKeyInfoNode = encCtx->keyInfoNode;
+
+    for(ii = 1; ii < nodesSize; ++ii) {
+        if(nodes[ii] == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        NULL,
+                        XMLSEC_ERRORS_R_INVALID_DATA,
+                        "node pos=%d is null", (int)ii);
+            goto done;
+        }
+
+        tmpl = xmlDocCopyNode(pristineTmpl, pristineTmpl->doc, 1);
+        if(tmpl == NULL) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlDocCopyNode",
+                        XMLSEC_ERRORS_R_XML_FAILED,
+                        "node=%s",
+                        xmlSecErrorsSafeString(xmlSecNodeGetName(pristineTmpl)));
+            goto done;
+        }
+        xmlUnsetProp(tmpl, xmlSecAttrId);
+
+        /* the key is already known, the <dsig:KeyInfo/> content is copied later */
+        keyInfoNode = NULL;
+        if(firstKeyInfoNode != NULL) {
+            keyInfoNode = xmlSecFindChild(tmpl, xmlSecNodeKeyInfo, xmlSecDSigNs);
+        }
+        if(keyInfoNode != NULL) {
+            while(keyInfoNode->children != NULL) {
+                tmp = keyInfoNode->children;
+                xmlUnlinkNode(tmp);
+                xmlFreeNode(tmp);
+            }
+        }
+
+        /* reset the context but keep the key and the replaced nodes */
+        key = encCtx->encKey;
+        encCtx->encKey = NULL;
+        replacedNodeList = encCtx->replacedNodeList;
+        encCtx->replacedNodeList = NULL;
+        xmlSecEncCtxReset(encCtx);
+        encCtx->encKey = key;
+
+        ret = xmlSecEncCtxXmlEncrypt(encCtx, tmpl, nodes[ii]);
+
+        if(replacedNodeList != NULL) {
+            cur = replacedNodeList;
+            while(cur->next != NULL) {
+                cur = cur->next;
+            }
+            cur->next = encCtx->replacedNodeList;
+            if(encCtx->replacedNodeList != NULL) {
+                encCtx->replacedNodeList->prev = cur;
+            }
+            encCtx->replacedNodeList = replacedNodeList;
+        }
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecEncCtxXmlEncrypt",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        "pos=%d", (int)ii);
+            if(encCtx->resultReplaced == 0) {
+                xmlFreeNode(tmpl);
+            }
+            goto done;
+        }
+
+        if(keyInfoNode != NULL) {
+            for(cur = firstKeyInfoNode->children; cur != NULL; cur = cur->next) {
+                tmp = xmlDocCopyNode(cur, keyInfoNode->doc, 1);
+                if(tmp == NULL) {
+                    xmlSecError(XMLSEC_ERRORS_HERE,
+                                NULL,
+                                "xmlDocCopyNode",
+                                XMLSEC_ERRORS_R_XML_FAILED,
+                                "node=%s",
+                                xmlSecErrorsSafeString(xmlSecNodeGetName(cur)));
+                    goto done;
+                }
+                if(xmlSecCheckNodeName(tmp, xmlSecNodeEncryptedKey, xmlSecEncNs)) {
+                    xmlUnsetProp(tmp, xmlSecAttrId);
+                }
+                xmlAddChild(keyInfoNode, tmp);
+            }
+        }
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(pristineTmpl != NULL) {
+        xmlFreeNode(pristineTmpl);
+    }
+    return(res);
+}
+
 /**
  * xmlSecEncCtxUriEncrypt:
  * @encCtx:             the pointer to <enc:EncryptedData/> processing context.
@@ -600,6 +782,124 @@ xmlSecEncCtxUriEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, const xmlChar *u
     return(0);
 }
 
+/**
+ * xmlSecEncCtxBinaryEncryptToOutput:
+ * @encCtx:             the pointer to <enc:EncryptedData/> processing context.
+ * @tmpl:               the pointer to <enc:EncryptedData/> template node.
+ * @data:               the pointer for binary buffer.
+ * @dataSize:           the @data buffer size.
+ * @output:             the output buffer to write <enc:EncryptedData/> element to.
+ *
+ * Encrypts @data according to template @tmpl and writes the result
+ * <enc:EncryptedData/> element to @output (use #xmlOutputBufferCreateIO
+ * to write to a user callback). The encrypted data is streamed to @output
+ * and is not stored in the template's <enc:CipherValue/> node.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxBinaryEncryptToOutput(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
+                                  const xmlSecByte* data, xmlSecSize dataSize,
+                                  xmlOutputBufferPtr output) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->result == NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(data != NULL, -1);
+    xmlSecAssert2(output != NULL, -1);
+
+    /* initialize context and add ID atributes to the list of known ids */
+    encCtx->operation = xmlSecTransformOperationEncrypt;
+    xmlSecAddIDs(tmpl->doc, tmpl, xmlSecEncIds);
+
+    /* read the template and set encryption method, key, etc. */
+    ret = xmlSecEncCtxEncDataNodeRead(encCtx, tmpl);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecEncCtxEncDataNodeRead",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlSecEncCtxEncDataNodeStream(encCtx, tmpl, data, dataSize, output);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecEncCtxEncDataNodeStream",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "dataSize=%d",
+                    dataSize);
+        return(-1);
+    }
+    return(0);
+}
+
+/**
+ * xmlSecEncCtxUriEncryptToOutput:
+ * @encCtx:             the pointer to <enc:EncryptedData/> processing context.
+ * @tmpl:               the pointer to <enc:EncryptedData/> template node.
+ * @uri:                the URI.
+ * @output:             the output buffer to write <enc:EncryptedData/> element to.
+ *
+ * Encrypts data from @uri according to template @tmpl and writes the result
+ * <enc:EncryptedData/> element to @output (see #xmlSecEncCtxBinaryEncryptToOutput).
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxUriEncryptToOutput(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
+                               const xmlChar *uri, xmlOutputBufferPtr output) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->result == NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(uri != NULL, -1);
+    xmlSecAssert2(output != NULL, -1);
+
+    /* initialize context and add ID atributes to the list of known ids */
+    encCtx->operation = xmlSecTransformOperationEncrypt;
+    xmlSecAddIDs(tmpl->doc, tmpl, xmlSecEncIds);
+
+    /* we need to add input uri transform first */
+    ret = xmlSecTransformCtxSetUri(&(encCtx->transformCtx), uri, tmpl);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecTransformCtxSetUri",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "uri=%s",
+                    xmlSecErrorsSafeString(uri));
+        return(-1);
+    }
+
+    /* read the template and set encryption method, key, etc. */
+    ret = xmlSecEncCtxEncDataNodeRead(encCtx, tmpl);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecEncCtxEncDataNodeRead",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlSecEncCtxEncDataNodeStream(encCtx, tmpl, NULL, 0, output);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecEncCtxEncDataNodeStream",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "uri=%s",
+                    xmlSecErrorsSafeString(uri));
+        return(-1);
+    }
+    return(0);
+}
+
 /**
  * xmlSecEncCtxDecrypt:
  * @encCtx:             the pointer to <enc:EncryptedData/> processing context.
@@ -706,6 +1006,83 @@ xmlSecEncCtxDecryptToBuffer(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
     xmlSecAssert2(encCtx->result == NULL, NULL);
     xmlSecAssert2(node != NULL, NULL);
 
+    ret = xmlSecEncCtxDecryptData(encCtx, node);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecEncCtxDecryptData",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(NULL);
+    }
+
+    encCtx->result = encCtx->transformCtx.result;
+    xmlSecAssert2(encCtx->result != NULL, NULL);
+
+    return(encCtx->result);
+}
+
+/**
+ * xmlSecEncCtxDecryptToCallback:
+ * @encCtx:             the pointer to <enc:EncryptedData/> processing context.
+ * @node:               the pointer to <enc:EncryptedData/> node.
+ * @callback:           the callback to receive decrypted data.
+ * @context:            the user context for @callback.
+ *
+ * Decrypts @node data and streams it to the @callback chunk by chunk
+ * instead of collecting it in the @encCtx buffer. The @node is not replaced.
+ *
+ * The authenticated ciphers (AES GCM) hold back the decrypted data until
+ * the authentication tag is verified, so @callback only receives verified
+ * data for them (and the data is buffered in memory until the end). Other
+ * ciphers pass the data to @callback as it is decrypted: if the function
+ * fails, the application must discard everything @callback received.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxDecryptToCallback(xmlSecEncCtxPtr encCtx, xmlNodePtr node,
+                              xmlSecTransformCtxResultCallback callback, void* context) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->result == NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(callback != NULL, -1);
+
+    ret = xmlSecTransformCtxSetResultCallback(&(encCtx->transformCtx), callback, context);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecTransformCtxSetResultCallback",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlSecEncCtxDecryptData(encCtx, node);
+
+    xmlSecTransformCtxSetResultCallback(&(encCtx->transformCtx), NULL, NULL);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecEncCtxDecryptData",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    encCtx->result = encCtx->transformCtx.result;
+    return(0);
+}
+
+static int
+xmlSecEncCtxDecryptData(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
     /* initialize context and add ID atributes to the list of known ids */
     encCtx->operation = xmlSecTransformOperationDecrypt;
     xmlSecAddIDs(node->doc, node, xmlSecEncIds);
@@ -717,56 +1094,103 @@ xmlSecEncCtxDecryptToBuffer(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
                     "xmlSecEncCtxEncDataNodeRead",
                     XMLSEC_ERRORS_R_XMLSEC_FAILED,
                     XMLSEC_ERRORS_NO_MESSAGE);
-        return(NULL);
+        return(-1);
     }
 
     /* decrypt the data */
     if(encCtx->cipherValueNode != NULL) {
-        xmlChar* data = NULL;
-        xmlSecSize dataSize = 0;
-
-        data = xmlNodeGetContent(encCtx->cipherValueNode);
-        if(data == NULL) {
+        ret = xmlSecEncCtxCipherValueNodeExecute(encCtx, encCtx->cipherValueNode);
+        if(ret < 0) {
             xmlSecError(XMLSEC_ERRORS_HERE,
                         NULL,
-                        xmlSecErrorsSafeString(xmlSecNodeGetName(encCtx->cipherValueNode)),
-                        XMLSEC_ERRORS_R_INVALID_NODE_CONTENT,
+                        "xmlSecEncCtxCipherValueNodeExecute",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
                         XMLSEC_ERRORS_NO_MESSAGE);
-            return(NULL);
+            return(-1);
         }
-        dataSize = xmlStrlen(data);
-
-        ret = xmlSecTransformCtxBinaryExecute(&(encCtx->transformCtx), data, dataSize);
+    } else {
+        ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), node->doc);
         if(ret < 0) {
             xmlSecError(XMLSEC_ERRORS_HERE,
                         NULL,
-                        "xmlSecTransformCtxBinaryExecute",
+                        "xmlSecTransformCtxExecute",
                         XMLSEC_ERRORS_R_XMLSEC_FAILED,
                         XMLSEC_ERRORS_NO_MESSAGE);
-            if(data != NULL) {
-                xmlFree(data);
-            }
-            return(NULL);
+            return(-1);
         }
-        if(data != NULL) {
-            xmlFree(data);
+    }
+
+    return(0);
+}
+
+/* pushes <enc:CipherValue/> text straight from the document nodes instead
+ * of copying the whole (potentially huge) base64 content out first; the
+ * transforms chain processes it in XMLSEC_TRANSFORM_BINARY_CHUNK blocks */
+static int
+xmlSecEncCtxCipherValueNodeExecute(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
+    xmlSecTransformCtxPtr transformCtx;
+    xmlNodePtr cur;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    transformCtx = &(encCtx->transformCtx);
+    xmlSecAssert2(transformCtx->uri == NULL, -1);
+
+    ret = xmlSecTransformCtxPrepare(transformCtx, xmlSecTransformDataTypeBin);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecTransformCtxPrepare",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "type=bin");
+        return(-1);
+    }
+
+    for(cur = node->children; cur != NULL; cur = cur->next) {
+        if((cur->type == XML_TEXT_NODE) || (cur->type == XML_CDATA_SECTION_NODE)) {
+            if(cur->content == NULL) {
+                continue;
+            }
+            ret = xmlSecTransformPushBin(transformCtx->first, cur->content,
+                                         xmlStrlen(cur->content), 0, transformCtx);
+        } else if((cur->type == XML_ENTITY_REF_NODE) || (cur->type == XML_ELEMENT_NODE)) {
+            xmlChar* content;
+
+            content = xmlNodeGetContent(cur);
+            if(content == NULL) {
+                continue;
+            }
+            ret = xmlSecTransformPushBin(transformCtx->first, content,
+                                         xmlStrlen(content), 0, transformCtx);
+            xmlFree(content);
+        } else {
+            continue;
         }
-    } else {
-        ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), node->doc);
         if(ret < 0) {
             xmlSecError(XMLSEC_ERRORS_HERE,
                         NULL,
-                        "xmlSecTransformCtxBinaryExecute",
+                        "xmlSecTransformPushBin",
                         XMLSEC_ERRORS_R_XMLSEC_FAILED,
-                        XMLSEC_ERRORS_NO_MESSAGE);
-            return(NULL);
+                        "node=%s",
+                        xmlSecErrorsSafeString(xmlSecNodeGetName(node)));
+            return(-1);
         }
     }
 
-    encCtx->result = encCtx->transformCtx.result;
-    xmlSecAssert2(encCtx->result != NULL, NULL);
+    ret = xmlSecTransformPushBin(transformCtx->first, NULL, 0, 1, transformCtx);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecTransformPushBin",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "final=1");
+        return(-1);
+    }
 
-    return(encCtx->result);
+    transformCtx->status = xmlSecTransformStatusFinished;
+    return(0);
 }
 
 static int
@@ -943,6 +1367,35 @@ xmlSecEncCtxEncDataNodeRead(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
         return(-1);
     }
 
+    /* the <enc:EncryptedKey/> children are decrypted with the same offload callback */
+    if((encCtx->encKey == NULL) && (xmlSecTransformCtxGetOffloadCallback(&(encCtx->transformCtx), NULL) != NULL)) {
+        xmlSecTransformCtxOffloadCallback offloadCallback;
+        void* offloadCallbackCtx = NULL;
+
+        if(encCtx->keyInfoReadCtx.encCtx == NULL) {
+            ret = xmlSecKeyInfoCtxCreateEncCtx(&(encCtx->keyInfoReadCtx));
+            if(ret < 0) {
+                xmlSecError(XMLSEC_ERRORS_HERE,
+                            NULL,
+                            "xmlSecKeyInfoCtxCreateEncCtx",
+                            XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                            XMLSEC_ERRORS_NO_MESSAGE);
+                return(-1);
+            }
+        }
+        offloadCallback = xmlSecTransformCtxGetOffloadCallback(&(encCtx->transformCtx), &offloadCallbackCtx);
+        ret = xmlSecTransformCtxSetOffloadCallback(&(encCtx->keyInfoReadCtx.encCtx->transformCtx),
+                    offloadCallback, offloadCallbackCtx);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecTransformCtxSetOffloadCallback",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+    }
+
     /* TODO: KeyInfo node != NULL and encKey != NULL */
     if((encCtx->encKey == NULL) && (encCtx->keyInfoReadCtx.keysMngr != NULL)
                         && (encCtx->keyInfoReadCtx.keysMngr->getKey != NULL)) {
@@ -1029,6 +1482,338 @@ xmlSecEncCtxEncDataNodeWrite(xmlSecEncCtxPtr encCtx) {
     return(0);
 }
 
+static int
+xmlSecEncCtxOutputWrite(void* context, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlOutputBufferPtr output = (xmlOutputBufferPtr)context;
+    int ret;
+
+    xmlSecAssert2(output != NULL, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ret = xmlOutputBufferWrite(output, dataSize, (const char*)data);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlOutputBufferWrite",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    "size=%d", dataSize);
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecEncCtxOutputWriteString(xmlOutputBufferPtr output, const xmlChar* str) {
+    int ret;
+
+    xmlSecAssert2(output != NULL, -1);
+    xmlSecAssert2(str != NULL, -1);
+
+    ret = xmlOutputBufferWriteString(output, (const char*)str);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlOutputBufferWriteString",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    return(0);
+}
+
+/* writes ' name="value"' with the value escaped for an attribute */
+static int
+xmlSecEncCtxOutputWriteAttr(xmlOutputBufferPtr output, xmlDocPtr doc,
+                            const xmlChar* prefix, const xmlChar* name,
+                            const xmlChar* value) {
+    xmlBufferPtr buf;
+    int ret;
+
+    xmlSecAssert2(output != NULL, -1);
+    xmlSecAssert2(name != NULL, -1);
+
+    buf = xmlBufferCreate();
+    if(buf == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlBufferCreate",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    xmlBufferWriteChar(buf, " ");
+    if(prefix != NULL) {
+        xmlBufferWriteCHAR(buf, prefix);
+        xmlBufferWriteChar(buf, ":");
+    }
+    xmlBufferWriteCHAR(buf, name);
+    xmlBufferWriteChar(buf, "=\"");
+    if(value != NULL) {
+        xmlAttrSerializeTxtContent(buf, doc, NULL, value);
+    }
+    xmlBufferWriteChar(buf, "\"");
+
+    ret = xmlSecEncCtxOutputWriteString(output, xmlBufferContent(buf));
+    xmlBufferFree(buf);
+    return(ret);
+}
+
+/*
+ * Writes the @node start tag. The namespaces declared on the @node
+ * ancestors are declared on the @root node so the output is
+ * namespace well-formed on its own.
+ */
+static int
+xmlSecEncCtxOutputWriteStartTag(xmlOutputBufferPtr output, xmlNodePtr node, int root) {
+    xmlNsPtr* nsList = NULL;
+    xmlNsPtr ns;
+    xmlAttrPtr attr;
+    xmlChar* value;
+    int res = -1;
+    int ret;
+    int ii;
+
+    xmlSecAssert2(output != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    ret = xmlSecEncCtxOutputWriteString(output, BAD_CAST "<");
+    if((ret >= 0) && (node->ns != NULL) && (node->ns->prefix != NULL)) {
+        ret = xmlSecEncCtxOutputWriteString(output, node->ns->prefix);
+        if(ret >= 0) {
+            ret = xmlSecEncCtxOutputWriteString(output, BAD_CAST ":");
+        }
+    }
+    if(ret >= 0) {
+        ret = xmlSecEncCtxOutputWriteString(output, node->name);
+    }
+    if(ret < 0) {
+        return(-1);
+    }
+
+    /* namespaces: xmlGetNsList() returns the declarations in scope
+     * (including the node's own ones) for the root node */
+    if(root != 0) {
+        nsList = xmlGetNsList(node->doc, node);
+        for(ii = 0; (nsList != NULL) && (nsList[ii] != NULL); ++ii) {
+            ns = nsList[ii];
+            if(xmlStrEqual(ns->prefix, BAD_CAST "xml")) {
+                continue;
+            }
+            ret = xmlSecEncCtxOutputWriteAttr(output, node->doc,
+                        (ns->prefix != NULL) ? BAD_CAST "xmlns" : NULL,
+                        (ns->prefix != NULL) ? ns->prefix : BAD_CAST "xmlns",
+                        ns->href);
+            if(ret < 0) {
+                goto done;
+            }
+        }
+    } else {
+        for(ns = node->nsDef; ns != NULL; ns = ns->next) {
+            ret = xmlSecEncCtxOutputWriteAttr(output, node->doc,
+                        (ns->prefix != NULL) ? BAD_CAST "xmlns" : NULL,
+                        (ns->prefix != NULL) ? ns->prefix : BAD_CAST "xmlns",
+                        ns->href);
+            if(ret < 0) {
+                goto done;
+            }
+        }
+    }
+
+    for(attr = node->properties; attr != NULL; attr = attr->next) {
+        value = xmlNodeGetContent((xmlNodePtr)attr);
+        ret = xmlSecEncCtxOutputWriteAttr(output, node->doc,
+                    (attr->ns != NULL) ? attr->ns->prefix : NULL,
+                    attr->name, value);
+        if(value != NULL) {
+            xmlFree(value);
+        }
+        if(ret < 0) {
+            goto done;
+        }
+    }
+
+    ret = xmlSecEncCtxOutputWriteString(output, BAD_CAST ">");
+    if(ret < 0) {
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(nsList != NULL) {
+        xmlFree(nsList);
+    }
+    return(res);
+}
+
+static int
+xmlSecEncCtxOutputWriteEndTag(xmlOutputBufferPtr output, xmlNodePtr node) {
+    int ret;
+
+    xmlSecAssert2(output != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    ret = xmlSecEncCtxOutputWriteString(output, BAD_CAST "</");
+    if((ret >= 0) && (node->ns != NULL) && (node->ns->prefix != NULL)) {
+        ret = xmlSecEncCtxOutputWriteString(output, node->ns->prefix);
+        if(ret >= 0) {
+            ret = xmlSecEncCtxOutputWriteString(output, BAD_CAST ":");
+        }
+    }
+    if(ret >= 0) {
+        ret = xmlSecEncCtxOutputWriteString(output, node->name);
+    }
+    if(ret >= 0) {
+        ret = xmlSecEncCtxOutputWriteString(output, BAD_CAST ">");
+    }
+    return(ret);
+}
+
+/*
+ * Writes @node to @output. The subtrees without <enc:CipherValue/> node
+ * are serialized as is, the encrypted data (@data or the transform ctx uri
+ * if @data is NULL) is streamed to @output instead of the <enc:CipherValue/>
+ * node content.
+ */
+static int
+xmlSecEncCtxEncDataNodeStreamNode(xmlSecEncCtxPtr encCtx, xmlNodePtr node, int root,
+                                  const xmlSecByte* data, xmlSecSize dataSize,
+                                  xmlOutputBufferPtr output) {
+    xmlNodePtr cur;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->cipherValueNode != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(output != NULL, -1);
+
+    for(cur = encCtx->cipherValueNode; (cur != NULL) && (cur != node); cur = cur->parent);
+    if(cur == NULL) {
+        xmlNodeDumpOutput(output, node->doc, node, 0, 0, NULL);
+        return(0);
+    }
+
+    ret = xmlSecEncCtxOutputWriteStartTag(output, node, root);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecEncCtxOutputWriteStartTag",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "node=%s",
+                    xmlSecErrorsSafeString(xmlSecNodeGetName(node)));
+        return(-1);
+    }
+
+    if(node == encCtx->cipherValueNode) {
+        /* encrypt the data right into the output */
+        ret = xmlSecTransformCtxSetResultCallback(&(encCtx->transformCtx), xmlSecEncCtxOutputWrite, output);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecTransformCtxSetResultCallback",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+        if(data != NULL) {
+            ret = xmlSecTransformCtxBinaryExecute(&(encCtx->transformCtx), data, dataSize);
+        } else {
+            ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), node->doc);
+        }
+        xmlSecTransformCtxSetResultCallback(&(encCtx->transformCtx), NULL, NULL);
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        (data != NULL) ? "xmlSecTransformCtxBinaryExecute" : "xmlSecTransformCtxExecute",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+        encCtx->result = encCtx->transformCtx.result;
+    } else {
+        for(cur = node->children; cur != NULL; cur = cur->next) {
+            ret = xmlSecEncCtxEncDataNodeStreamNode(encCtx, cur, 0, data, dataSize, output);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+    }
+
+    ret = xmlSecEncCtxOutputWriteEndTag(output, node);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecEncCtxOutputWriteEndTag",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    "node=%s",
+                    xmlSecErrorsSafeString(xmlSecNodeGetName(node)));
+        return(-1);
+    }
+    return(0);
+}
+
+/*
+ * Writes the <enc:EncryptedData/> element from template @tmpl to @output
+ * with the encrypted data streamed as the <enc:CipherValue/> node content.
+ * The template itself is not changed (except <enc:KeyInfo/> node).
+ */
+static int
+xmlSecEncCtxEncDataNodeStream(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
+                              const xmlSecByte* data, xmlSecSize dataSize,
+                              xmlOutputBufferPtr output) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->encKey != NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(output != NULL, -1);
+
+    if(encCtx->cipherValueNode == NULL) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    xmlSecErrorsSafeString(xmlSecNodeCipherValue),
+                    XMLSEC_ERRORS_R_NODE_NOT_FOUND,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    /* update <enc:KeyInfo/> node first, it goes before the encrypted data */
+    if(encCtx->keyInfoNode != NULL) {
+        ret = xmlSecKeyInfoNodeWrite(encCtx->keyInfoNode, encCtx->encKey, &(encCtx->keyInfoWriteCtx));
+        if(ret < 0) {
+            xmlSecError(XMLSEC_ERRORS_HERE,
+                        NULL,
+                        "xmlSecKeyInfoNodeWrite",
+                        XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                        XMLSEC_ERRORS_NO_MESSAGE);
+            return(-1);
+        }
+    }
+
+    ret = xmlSecEncCtxEncDataNodeStreamNode(encCtx, tmpl, 1, data, dataSize, output);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlSecEncCtxEncDataNodeStreamNode",
+                    XMLSEC_ERRORS_R_XMLSEC_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+
+    ret = xmlOutputBufferFlush(output);
+    if(ret < 0) {
+        xmlSecError(XMLSEC_ERRORS_HERE,
+                    NULL,
+                    "xmlOutputBufferFlush",
+                    XMLSEC_ERRORS_R_XML_FAILED,
+                    XMLSEC_ERRORS_NO_MESSAGE);
+        return(-1);
+    }
+    return(0);
+}
+
 static int
 xmlSecEncCtxCipherDataNodeRead(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
     xmlNodePtr cur;
@@ -564,12 +564,19 @@ int
 xmlSecReplaceNodeBufferAndReturn(xmlNodePtr node, const xmlSecByte *buffer, xmlSecSize size, xmlNodePtr *replaced) {
     xmlNodePtr results = NULL;
     xmlNodePtr next = NULL;
+    int options = 0;
 
     xmlSecAssert2(node != NULL, -1);
     xmlSecAssert2(node->parent != NULL, -1);
 
+    /* intern the names from the parsed fragment in the document's
+     * dictionary (if any) instead of allocating each of them separately */
+    if((node->doc == NULL) || (node->doc->dict == NULL)) {
+        options |= XML_PARSE_NODICT;
+    }
+
     /* parse buffer in the context of node's parent */
-    if(xmlParseInNodeContext(node->parent, (const char*)buffer, size, XML_PARSE_NODICT, &results) != XML_ERR_OK) {
+    if(xmlParseInNodeContext(node->parent, (const char*)buffer, size, options, &results) != XML_ERR_OK) {
         xmlSecError(XMLSEC_ERRORS_HERE,
                     NULL,
                     "xmlParseInNodeContext",
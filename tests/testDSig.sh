@@ -185,6 +185,22 @@ execDSigTest $res_success \
     "--hmackey $topfolder/keys/hmackey.bin" \
     "--hmackey $topfolder/keys/hmackey.bin"
 
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-manifest-hmac-sha1" \
+    "sha1 hmac-sha1" \
+    "hmac" \
+    "--hmackey $topfolder/keys/hmackey.bin --verify-manifest-reference #object1 --verify-manifest-reference #object2" \
+    "--hmackey $topfolder/keys/hmackey.bin" \
+    "--hmackey $topfolder/keys/hmackey.bin --verify-manifest-reference #object2"
+
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/bad-enveloping-manifest-hmac-sha1" \
+    "sha1 hmac-sha1" \
+    "hmac" \
+    "--hmackey $topfolder/keys/hmackey.bin --verify-manifest-reference #object1"
+
 execDSigTest $res_success \
     "" \
     "aleksey-xmldsig-01/enveloping-sha224-hmac-sha224" \
@@ -284,6 +300,31 @@ execDSigTest $res_success \
     "$priv_key_option $topfolder/keys/rsakey.$priv_key_format --pwd secret123" \
     "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509"
 
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha1-rsa-sha1" \
+    "sha1 rsa-sha1" \
+    "rsa x509" \
+    "--keyinfo-cache --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509 $topfolder/aleksey-xmldsig-01/enveloping-sha1-rsa-sha1.xml"
+
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha1-rsa-sha1-keyname-x509" \
+    "sha1 rsa-sha1" \
+    "rsa x509" \
+    "--pubkey-cert-$cert_format:test-rsa-x509 $topfolder/keys/rsacert.$cert_format --trusted-$cert_format $topfolder/keys/cacert.$cert_format --keyinfo-read-all" \
+    "$priv_key_option:test-rsa-x509 $topfolder/keys/rsakey.$priv_key_format --pwd secret123" \
+    "--pubkey-cert-$cert_format:test-rsa-x509 $topfolder/keys/rsacert.$cert_format --trusted-$cert_format $topfolder/keys/cacert.$cert_format --keyinfo-read-all"
+
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha1-rsa-sha1-keyname-x509" \
+    "sha1 rsa-sha1" \
+    "rsa x509" \
+    "--pubkey-cert-$cert_format:test-rsa-x509 $topfolder/keys/rsacert.$cert_format --trusted-$cert_format $topfolder/keys/cacert.$cert_format --keyinfo-read-all --copy-keys" \
+    "$priv_key_option:test-rsa-x509 $topfolder/keys/rsakey.$priv_key_format --pwd secret123" \
+    "--pubkey-cert-$cert_format:test-rsa-x509 $topfolder/keys/rsacert.$cert_format --trusted-$cert_format $topfolder/keys/cacert.$cert_format --keyinfo-read-all --copy-keys"
+
 execDSigTest $res_success \
     "" \
     "aleksey-xmldsig-01/enveloping-sha224-rsa-sha224" \
@@ -855,6 +896,146 @@ printRes $res_success $?
 fi
 
 
+##########################################################################
+#
+# test offload callback: the asymmetric key transforms go through it,
+# HMAC stays inline
+#
+##########################################################################
+if [ -z "$XMLSEC_TEST_NAME" -o "$XMLSEC_TEST_NAME" = "dsig-offload" ]; then
+echo "Offload callback"
+printf "    Checking required transforms and key data            "
+echo "$xmlsec_app check-transforms $xmlsec_params sha256 rsa-sha256 hmac-sha1" >> $logfile
+$xmlsec_app check-transforms $xmlsec_params sha256 rsa-sha256 hmac-sha1 >> $logfile 2>> $logfile && \
+    $xmlsec_app check-key-data $xmlsec_params rsa x509 hmac >> $logfile 2>> $logfile
+if [ $? = 0 ]; then
+    echo "   OK"
+
+    printf "    Sign with offloaded rsa-sha256                       "
+    rm -f $tmpfile $tmpfile.2
+    echo "$VALGRIND $xmlsec_app sign $xmlsec_params --offload $priv_key_option $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123 --output $tmpfile $topfolder/aleksey-xmldsig-01/enveloping-sha256-rsa-sha256.tmpl" >> $logfile
+    $VALGRIND $xmlsec_app sign $xmlsec_params --offload $priv_key_option $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123 --output $tmpfile $topfolder/aleksey-xmldsig-01/enveloping-sha256-rsa-sha256.tmpl >> $logfile 2> $tmpfile.2
+    res=$?
+    cat $tmpfile.2 >> $logfile
+    if [ $res = 0 ]; then
+        grep -q 'Offloaded transform "rsa-sha256"' $tmpfile.2
+        res=$?
+    fi
+    printRes $res_success $res
+
+    printf "    Verify with offloaded rsa-sha256                     "
+    echo "$VALGRIND $xmlsec_app verify $xmlsec_params --offload --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509 $tmpfile" >> $logfile
+    $VALGRIND $xmlsec_app verify $xmlsec_params --offload --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509 $tmpfile >> $logfile 2> $tmpfile.2
+    res=$?
+    cat $tmpfile.2 >> $logfile
+    if [ $res = 0 ]; then
+        grep -q 'Offloaded transform "rsa-sha256"' $tmpfile.2
+        res=$?
+    fi
+    printRes $res_success $res
+
+    printf "    Verify with inline hmac-sha1                         "
+    echo "$VALGRIND $xmlsec_app verify $xmlsec_params --offload --hmackey $topfolder/keys/hmackey.bin $topfolder/aleksey-xmldsig-01/enveloping-sha1-hmac-sha1.xml" >> $logfile
+    $VALGRIND $xmlsec_app verify $xmlsec_params --offload --hmackey $topfolder/keys/hmackey.bin $topfolder/aleksey-xmldsig-01/enveloping-sha1-hmac-sha1.xml >> $logfile 2> $tmpfile.2
+    res=$?
+    cat $tmpfile.2 >> $logfile
+    if [ $res = 0 ] && grep -q 'Offloaded transform' $tmpfile.2 ; then
+        res=1
+    fi
+    printRes $res_success $res
+    rm -f $tmpfile.2
+else
+    echo " Skip"
+fi
+fi
+
+##########################################################################
+#
+# test HMAC key schedule cache (OpenSSL only): the keys store key is shared
+# with the signatures, the schedule cached for the first digest (sha1) by
+# the first file is seen on the key used for the second file
+#
+##########################################################################
+if [ -z "$XMLSEC_TEST_NAME" -o "$XMLSEC_TEST_NAME" = "dsig-hmac-cache" ]; then
+echo "HMAC key schedule cache"
+printf "    Checking required transforms and key data            "
+echo "$xmlsec_app check-transforms $xmlsec_params sha1 hmac-sha1 sha256 hmac-sha256" >> $logfile
+$xmlsec_app check-transforms $xmlsec_params sha1 hmac-sha1 sha256 hmac-sha256 >> $logfile 2>> $logfile && \
+    $xmlsec_app check-key-data $xmlsec_params hmac >> $logfile 2>> $logfile
+if [ $? = 0 -a "z$crypto" = "zopenssl" ]; then
+    echo "   OK"
+
+    printf "    Verify hmac-sha1 and hmac-sha256 with one store key  "
+    echo "$VALGRIND $xmlsec_app verify $xmlsec_params --hmackey $topfolder/keys/hmackey.bin --print-debug $topfolder/aleksey-xmldsig-01/enveloping-sha1-hmac-sha1.xml $topfolder/aleksey-xmldsig-01/enveloping-sha256-hmac-sha256.xml" >> $logfile
+    $VALGRIND $xmlsec_app verify $xmlsec_params --hmackey $topfolder/keys/hmackey.bin --print-debug $topfolder/aleksey-xmldsig-01/enveloping-sha1-hmac-sha1.xml $topfolder/aleksey-xmldsig-01/enveloping-sha256-hmac-sha256.xml > $tmpfile 2>> $logfile
+    res=$?
+    cat $tmpfile >> $logfile
+    if [ $res = 0 -a "`grep -c '=== cached key schedule: SHA1' $tmpfile`" != "2" ]; then
+        res=1
+    fi
+    printRes $res_success $res
+else
+    echo " Skip"
+fi
+fi
+
+##########################################################################
+#
+# test pre-digest and pre-sign callbacks: the data written to the files
+# are the same as the data stored in the context and the signature does
+# not change
+#
+##########################################################################
+if [ -z "$XMLSEC_TEST_NAME" -o "$XMLSEC_TEST_NAME" = "dsig-pre-digest-file" ]; then
+echo "Pre-digest and pre-sign callbacks"
+printf "    Checking required transforms and key data            "
+echo "$xmlsec_app check-transforms $xmlsec_params sha1 hmac-sha1" >> $logfile
+$xmlsec_app check-transforms $xmlsec_params sha1 hmac-sha1 >> $logfile 2>> $logfile && \
+    $xmlsec_app check-key-data $xmlsec_params hmac >> $logfile 2>> $logfile
+if [ $? = 0 ]; then
+    echo "   OK"
+
+    printf "    Sign with stored data                                "
+    rm -f $tmpfile $tmpfile.2 $tmpfile.3 $tmpfile.4 $tmpfile.5 $tmpfile.6 $tmpfile.7 $tmpfile.8
+    echo "$VALGRIND $xmlsec_app sign $xmlsec_params --hmackey $topfolder/keys/hmackey.bin --store-references --store-signatures --output $tmpfile $topfolder/aleksey-xmldsig-01/enveloping-sha1-hmac-sha1.tmpl" >> $logfile
+    $VALGRIND $xmlsec_app sign $xmlsec_params --hmackey $topfolder/keys/hmackey.bin --store-references --store-signatures --output $tmpfile $topfolder/aleksey-xmldsig-01/enveloping-sha1-hmac-sha1.tmpl > $tmpfile.2 2>> $logfile
+    res=$?
+    if [ $res = 0 ]; then
+        awk '/^== PreDigest data - end buffer$/ { p = 0; next } p { if(n++) printf "\n"; printf "%s", $0 } /^== PreDigest data - start buffer:$/ { p = 1; n = 0 }' $tmpfile.2 > $tmpfile.3
+        awk '/^== PreSigned data - end buffer$/ { p = 0; next } p { if(n++) printf "\n"; printf "%s", $0 } /^== PreSigned data - start buffer:$/ { p = 1; n = 0 }' $tmpfile.2 > $tmpfile.4
+        test -s $tmpfile.3 -a -s $tmpfile.4
+        res=$?
+    fi
+    printRes $res_success $res
+
+    printf "    Sign with pre-digest and pre-sign files              "
+    echo "$VALGRIND $xmlsec_app sign $xmlsec_params --hmackey $topfolder/keys/hmackey.bin --pre-digest-file $tmpfile.5 --pre-sign-file $tmpfile.6 --output $tmpfile.2 $topfolder/aleksey-xmldsig-01/enveloping-sha1-hmac-sha1.tmpl" >> $logfile
+    $VALGRIND $xmlsec_app sign $xmlsec_params --hmackey $topfolder/keys/hmackey.bin --pre-digest-file $tmpfile.5 --pre-sign-file $tmpfile.6 --output $tmpfile.2 $topfolder/aleksey-xmldsig-01/enveloping-sha1-hmac-sha1.tmpl >> $logfile 2>> $logfile
+    res=$?
+    if [ $res = 0 ]; then
+        cmp $tmpfile $tmpfile.2 >> $logfile 2>> $logfile && \
+            cmp $tmpfile.3 $tmpfile.5 >> $logfile 2>> $logfile && \
+            cmp $tmpfile.4 $tmpfile.6 >> $logfile 2>> $logfile
+        res=$?
+    fi
+    printRes $res_success $res
+
+    printf "    Verify with pre-digest and pre-sign files            "
+    echo "$VALGRIND $xmlsec_app verify $xmlsec_params --hmackey $topfolder/keys/hmackey.bin --pre-digest-file $tmpfile.7 --pre-sign-file $tmpfile.8 $tmpfile" >> $logfile
+    $VALGRIND $xmlsec_app verify $xmlsec_params --hmackey $topfolder/keys/hmackey.bin --pre-digest-file $tmpfile.7 --pre-sign-file $tmpfile.8 $tmpfile >> $logfile 2>> $logfile
+    res=$?
+    if [ $res = 0 ]; then
+        cmp $tmpfile.3 $tmpfile.7 >> $logfile 2>> $logfile && \
+            cmp $tmpfile.4 $tmpfile.8 >> $logfile 2>> $logfile
+        res=$?
+    fi
+    printRes $res_success $res
+    rm -f $tmpfile.2 $tmpfile.3 $tmpfile.4 $tmpfile.5 $tmpfile.6 $tmpfile.7 $tmpfile.8
+else
+    echo " Skip"
+fi
+fi
+
 ##########################################################################
 ##########################################################################
 ##########################################################################
@@ -880,6 +1061,13 @@ execDSigTest $res_fail \
     "rsa x509" \
     "--X509-skip-strict-checks --trusted-$cert_format $topfolder/merlin-xmldsig-twenty-three/certs/ca.$cert_format"
 
+execDSigTest $res_fail \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha1-rsa-sha1" \
+    "sha1 rsa-sha1" \
+    "rsa x509" \
+    "--keyinfo-cache --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509 --crl-$cert_format $topfolder/keys/rsacert-revoked-crl.$cert_format --crls-after-first-file $topfolder/aleksey-xmldsig-01/enveloping-sha1-rsa-sha1.xml"
+
 execDSigTest $res_fail \
     "" \
     "aleksey-xmldsig-01/enveloping-expired-cert" \
@@ -894,6 +1082,27 @@ execDSigTest $res_fail \
     "hmac" \
     "--enabled-reference-uris empty --hmackey $topfolder/keys/hmackey.bin --dtd-file $topfolder/aleksey-xmldsig-01/dtd-hmac-91.dtd" 
 
+execDSigTest $res_fail \
+    "" \
+    "aleksey-xmldsig-01/bad-enveloping-manifest-hmac-sha1" \
+    "sha1 hmac-sha1" \
+    "hmac" \
+    "--hmackey $topfolder/keys/hmackey.bin --verify-manifest-reference #object2"
+
+execDSigTest $res_fail \
+    "" \
+    "aleksey-xmldsig-01/bad-enveloping-manifest-hmac-sha1" \
+    "sha1 hmac-sha1" \
+    "hmac" \
+    "--hmackey $topfolder/keys/hmackey.bin --verify-manifest-reference #missing"
+
+execDSigTest $res_fail \
+    "" \
+    "aleksey-xmldsig-01/bad-enveloping-manifest-hmac-sha1-signature" \
+    "sha1 hmac-sha1" \
+    "hmac" \
+    "--hmackey $topfolder/keys/hmackey.bin --verify-manifest-reference #object1"
+
 execDSigTest $res_fail \
     "phaos-xmldsig-three" \
     "signature-rsa-detached-xslt-transform-bad-retrieval-method" \
@@ -31,6 +31,45 @@ execEncTest $res_success \
     "--keys-file $keysfile --binary-data $topfolder/aleksey-xmlenc-01/enc-des3cbc-keyname.data" \
     "--keys-file $keysfile"
 
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-des3cbc-keyname-stream" \
+    "tripledes-cbc" \
+    "" \
+    "--keys-file $keysfile --binary-data $topfolder/aleksey-xmlenc-01/enc-des3cbc-keyname-stream.data --stream-output" \
+    "--keys-file $keysfile"
+
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-des3cbc-keyname" \
+    "tripledes-cbc" \
+    "--keys-file $topfolder/keys/keys.xml --stream-output"
+
+# the keys named "test-des" are AES, HMAC and DES keys: the DES one must be found
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-des3cbc-keyname" \
+    "tripledes-cbc" \
+    "--keys-file $topfolder/keys/keys-same-name.xml"
+
+# NSS uses its own keys store which can not be reloaded
+if [ "z$crypto" != "znss" ] ; then
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-des3cbc-keyname" \
+    "tripledes-cbc" \
+    "--keys-file $topfolder/keys/keys.xml --reload-keys-file $topfolder/keys/keys-same-name.xml"
+fi
+
+# the first file caches the "test-aes256" miss, the keys reload must drop it
+if [ "z$crypto" != "znss" ] ; then
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-aes128cbc-kw-aes256-cache" \
+    "aes128-cbc kw-tripledes kw-aes256" \
+    "--keys-file $topfolder/keys/keys-same-name.xml --reload-keys-file $topfolder/keys/keys.xml --reload-keys-after-first-file --keyinfo-cache --keyinfo-read-all $topfolder/aleksey-xmlenc-01/enc-aes128cbc-kw-des3-aes256-cache.xml"
+fi
+
 execEncTest $res_success \
     "" \
     "aleksey-xmlenc-01/enc-des3cbc-keyname2" \
@@ -69,6 +108,36 @@ execEncTest $res_success \
     "--keys-file $keysfile --binary-data $topfolder/aleksey-xmlenc-01/enc-aes256cbc-keyname.data" \
     "--keys-file $keysfile"
 
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-aes128gcm-keyname" \
+    "aes128-gcm" \
+    "--keys-file $topfolder/keys/keys.xml" \
+    "--keys-file $keysfile --binary-data $topfolder/aleksey-xmlenc-01/enc-aes128gcm-keyname.data" \
+    "--keys-file $keysfile"
+
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-aes128gcm-keyname" \
+    "aes128-gcm" \
+    "--keys-file $topfolder/keys/keys.xml --stream-output"
+
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-aes192gcm-keyname" \
+    "aes192-gcm" \
+    "--keys-file $topfolder/keys/keys.xml" \
+    "--keys-file $keysfile --binary-data $topfolder/aleksey-xmlenc-01/enc-aes192gcm-keyname.data" \
+    "--keys-file $keysfile"
+
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-aes256gcm-keyname" \
+    "aes256-gcm" \
+    "--keys-file $topfolder/keys/keys.xml" \
+    "--keys-file $keysfile --binary-data $topfolder/aleksey-xmlenc-01/enc-aes256gcm-keyname.data" \
+    "--keys-file $keysfile"
+
 execEncTest $res_success \
     "" \
     "aleksey-xmlenc-01/enc-des3cbc-keyname-content" \
@@ -101,6 +170,31 @@ execEncTest $res_success \
     "--keys-file $keysfile  --session-key des-192  --binary-data $topfolder/aleksey-xmlenc-01/enc-des3cbc-aes192-keyname.data" \
     "--keys-file $keysfile"
 
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-aes128cbc-kw-aes192-nodes" \
+    "aes128-cbc kw-aes192" \
+    "--keys-file $topfolder/keys/keys.xml --all-nodes --id-attr:Id http://www.w3.org/2001/04/xmlenc#:EncryptedData" \
+    "--keys-file $keysfile --session-key aes-128 --xml-data $topfolder/aleksey-xmlenc-01/enc-aes128cbc-kw-aes192-nodes.data --node-name Test --all-nodes" \
+    "--keys-file $keysfile --all-nodes --id-attr:Id http://www.w3.org/2001/04/xmlenc#:EncryptedData"
+
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-aes128cbc-kw-aes192-nodes" \
+    "aes128-cbc kw-aes192" \
+    "--keys-file $topfolder/keys/keys.xml --enc-key-cache --all-nodes --id-attr:Id http://www.w3.org/2001/04/xmlenc#:EncryptedData"
+
+# the decrypted element names (some already used in the document) are
+# interned in the document dictionary: the tree must match the original
+# and every name must be freed only once with the document
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-aes128cbc-keyname-dict" \
+    "aes128-cbc" \
+    "--keys-file $topfolder/keys/keys.xml" \
+    "--keys-file $keysfile --xml-data $topfolder/aleksey-xmlenc-01/enc-aes128cbc-keyname-dict.data --node-name Body" \
+    "--keys-file $keysfile"
+
 ##########################################################################
 #
 # merlin-xmlenc-five
@@ -379,6 +473,37 @@ printRes $res_success $?
 fi
 
 
+##########################################################################
+#
+# test offload callback for the <enc:EncryptedKey/> private key decrypt
+#
+##########################################################################
+if [ -z "$XMLSEC_TEST_NAME" -o "$XMLSEC_TEST_NAME" = "enc-offload" ]; then
+echo "Offload callback"
+printf "    Checking required transforms                         "
+echo "$xmlsec_app check-transforms $xmlsec_params aes128-cbc rsa-1_5" >> $logfile
+$xmlsec_app check-transforms $xmlsec_params aes128-cbc rsa-1_5 >> $logfile 2>> $logfile
+if [ $? = 0 ]; then
+    echo "   OK"
+
+    printf "    Decrypt with offloaded rsa-1_5                       "
+    rm -f $tmpfile $tmpfile.2
+    echo "$VALGRIND $xmlsec_app decrypt $xmlsec_params --offload $priv_key_option $topfolder/merlin-xmlenc-five/rsapriv.$priv_key_format --pwd secret --output $tmpfile $topfolder/merlin-xmlenc-five/encrypt-element-aes128-cbc-rsa-1_5.xml" >> $logfile
+    $VALGRIND $xmlsec_app decrypt $xmlsec_params --offload $priv_key_option $topfolder/merlin-xmlenc-five/rsapriv.$priv_key_format --pwd secret --output $tmpfile $topfolder/merlin-xmlenc-five/encrypt-element-aes128-cbc-rsa-1_5.xml >> $logfile 2> $tmpfile.2
+    res=$?
+    cat $tmpfile.2 >> $logfile
+    if [ $res = 0 ]; then
+        diff $topfolder/merlin-xmlenc-five/encrypt-element-aes128-cbc-rsa-1_5.data $tmpfile >> $logfile 2>> $logfile && \
+            grep -q 'Offloaded transform "rsa-1_5"' $tmpfile.2
+        res=$?
+    fi
+    printRes $res_success $res
+    rm -f $tmpfile.2
+else
+    echo " Skip"
+fi
+fi
+
 ##########################################################################
 ##########################################################################
 ##########################################################################
@@ -390,18 +515,45 @@ execEncTest $res_fail \
     "" \
     "--keys-file $topfolder/01-phaos-xmlenc-3/keys.xml"
 
+# "test-aes128" key is not in the reloaded keys file
+if [ "z$crypto" != "znss" ] ; then
+execEncTest $res_fail \
+    "" \
+    "aleksey-xmlenc-01/enc-aes128cbc-keyname" \
+    "aes128-cbc" \
+    "--keys-file $topfolder/keys/keys.xml --reload-keys-file $topfolder/keys/keys-same-name.xml"
+fi
+
 execEncTest $res_fail \
     "" \
     "aleksey-xmlenc-01/enc-aes192cbc-keyname-ref" \
     "" \
     "--keys-file $topfolder/keys/keys.xml --enabled-cipher-reference-uris empty" 
 
+execEncTest $res_fail \
+    "" \
+    "aleksey-xmlenc-01/bad-enc-des3cbc-rsa-oaep-mgf1p-cache" \
+    "tripledes-cbc rsa-oaep-mgf1p" \
+    "$priv_key_option $topfolder/merlin-xmlenc-five/rsapriv.$priv_key_format --pwd secret --enc-key-cache $topfolder/merlin-xmlenc-five/encrypt-data-tripledes-cbc-rsa-oaep-mgf1p.xml"
+
 execEncTest $res_fail \
     "" \
     "01-phaos-xmlenc-3/enc-content-aes256-kt-rsa1_5" \
     "" \
     "--keys-file $topfolder/01-phaos-xmlenc-3/keys.xml --enabled-retrieval-method-uris empty"
 
+execEncTest $res_fail \
+    "" \
+    "aleksey-xmlenc-01/bad-enc-aes128gcm-keyname-tag" \
+    "aes128-gcm" \
+    "--keys-file $topfolder/keys/keys.xml"
+
+execEncTest $res_fail \
+    "" \
+    "aleksey-xmlenc-01/bad-enc-aes128gcm-keyname-tag" \
+    "aes128-gcm" \
+    "--keys-file $topfolder/keys/keys.xml --stream-output"
+
 rm -rf $tmpfile
 
 ##########################################################################
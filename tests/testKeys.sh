@@ -61,6 +61,87 @@ execKeysTest $res_success \
     "test-aes256   " \
     "aes-256 "
 
+##########################################################################
+#
+# test binary keys file (NSS uses its own keys store which can not be
+# saved in the binary format)
+#
+##########################################################################
+if [ "z$crypto" != "znss" ] && [ -z "$XMLSEC_TEST_NAME" -o "$XMLSEC_TEST_NAME" = "binary-keys" ]; then
+binkeysfile=$crypto_config/keys.bin
+rm -f $binkeysfile
+
+echo "Test: binary keys file ($res_success)"
+printf "    Creating binary keys file                             "
+echo "$VALGRIND $xmlsec_app keys --keys-file $keysfile --binary-keys $xmlsec_params $binkeysfile" >> $logfile
+$VALGRIND $xmlsec_app keys --keys-file $keysfile --binary-keys $xmlsec_params $binkeysfile >> $logfile 2>> $logfile
+printRes $res_success $?
+
+printf "    Sign with binary keys file                            "
+echo "$VALGRIND $xmlsec_app sign $xmlsec_params --binary-keys-file $binkeysfile --output $tmpfile $topfolder/aleksey-xmldsig-01/enveloping-sha1-hmac-sha1.tmpl" >> $logfile
+$VALGRIND $xmlsec_app sign $xmlsec_params --binary-keys-file $binkeysfile --output $tmpfile $topfolder/aleksey-xmldsig-01/enveloping-sha1-hmac-sha1.tmpl >> $logfile 2>> $logfile
+printRes $res_success $?
+
+printf "    Verify with XML keys file                             "
+echo "$VALGRIND $xmlsec_app verify $xmlsec_params --keys-file $keysfile $tmpfile" >> $logfile
+$VALGRIND $xmlsec_app verify $xmlsec_params --keys-file $keysfile $tmpfile >> $logfile 2>> $logfile
+printRes $res_success $?
+
+printf "    Encrypt with XML keys file                            "
+echo "$VALGRIND $xmlsec_app encrypt $xmlsec_params --keys-file $keysfile --binary-data $topfolder/aleksey-xmlenc-01/enc-des3cbc-keyname.data --output $tmpfile $topfolder/aleksey-xmlenc-01/enc-des3cbc-keyname.tmpl" >> $logfile
+$VALGRIND $xmlsec_app encrypt $xmlsec_params --keys-file $keysfile --binary-data $topfolder/aleksey-xmlenc-01/enc-des3cbc-keyname.data --output $tmpfile $topfolder/aleksey-xmlenc-01/enc-des3cbc-keyname.tmpl >> $logfile 2>> $logfile
+printRes $res_success $?
+
+printf "    Decrypt with binary keys file                         "
+echo "$VALGRIND $xmlsec_app decrypt $xmlsec_params --binary-keys-file $binkeysfile --output $tmpfile.2 $tmpfile" >> $logfile
+$VALGRIND $xmlsec_app decrypt $xmlsec_params --binary-keys-file $binkeysfile --output $tmpfile.2 $tmpfile >> $logfile 2>> $logfile
+res=$?
+if [ $res = 0 ]; then
+    diff $topfolder/aleksey-xmlenc-01/enc-des3cbc-keyname.data $tmpfile.2 >> $logfile 2>> $logfile
+    res=$?
+fi
+printRes $res_success $res
+
+echo "Test: binary keys file ($res_fail)"
+printf "    Load truncated binary keys file                       "
+head -c 20 $binkeysfile > $tmpfile.2
+echo "$VALGRIND $xmlsec_app decrypt $xmlsec_params --binary-keys-file $tmpfile.2 $tmpfile" >> $logfile
+$VALGRIND $xmlsec_app decrypt $xmlsec_params --binary-keys-file $tmpfile.2 $tmpfile >> $logfile 2>> $logfile
+printRes $res_fail $?
+
+# the first record follows the 40 bytes header, its value offset is at 32
+printf "    Load binary keys file with out of range record        "
+cp -f $binkeysfile $tmpfile.2
+printf '\360\377\377\377' | dd of=$tmpfile.2 bs=1 seek=72 conv=notrunc 2> /dev/null
+echo "$VALGRIND $xmlsec_app decrypt $xmlsec_params --binary-keys-file $tmpfile.2 $tmpfile" >> $logfile
+$VALGRIND $xmlsec_app decrypt $xmlsec_params --binary-keys-file $tmpfile.2 $tmpfile >> $logfile 2>> $logfile
+printRes $res_fail $?
+
+rm -f $tmpfile.2
+fi
+
+##########################################################################
+#
+# the <dsig:KeyName/> in a keys file finds the keys read earlier from
+# the same file (NSS uses its own keys store)
+#
+##########################################################################
+if [ "z$crypto" != "znss" ] && [ -z "$XMLSEC_TEST_NAME" -o "$XMLSEC_TEST_NAME" = "keys-keyname-ref" ]; then
+echo "Test: keys file with key name reference ($res_success)"
+printf "    Load and save keys file                               "
+echo "$VALGRIND $xmlsec_app keys --keys-file $topfolder/keys/keys-keyname-ref.xml $xmlsec_params $tmpfile" >> $logfile
+$VALGRIND $xmlsec_app keys --keys-file $topfolder/keys/keys-keyname-ref.xml $xmlsec_params $tmpfile >> $logfile 2>> $logfile
+res=$?
+if [ $res = 0 ]; then
+    count=`grep -c "HMACKeyValue>" $tmpfile`
+    echo "HMAC keys saved: $count" >> $logfile
+    if [ "z$count" != "z2" ]; then
+        res=1
+    fi
+fi
+printRes $res_success $res
+fi
+
 ##########################################################################
 ##########################################################################
 ##########################################################################